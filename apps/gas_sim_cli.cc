@@ -0,0 +1,147 @@
+#include "gas_container.h"
+#include "profiler.h"
+#include "simulation_snapshot.h"
+#include "software_renderer.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+using idealgas::CollisionSchedule;
+using idealgas::GasContainer;
+using idealgas::PhaseStats;
+using idealgas::Profiler;
+using idealgas::SimulationSnapshot;
+using idealgas::SoftwareRenderer;
+using idealgas::Species;
+using std::string;
+
+namespace {
+
+const int kDefaultNumParticles = 10000;
+const int kDefaultNumFrames = 1000;
+
+//same density as the default 750 x 750 container holding 150 particles
+const float kAreaPerParticle = 750.0f * 750.0f / 150.0f;
+
+//width of exported frames, with the height following the container's shape
+const int kImageWidth = 1024;
+
+/**
+ * Reads a positive integer argument
+ * @param argument
+ * @param value set to the parsed value
+ * @return if the argument was a positive integer
+ */
+bool ParsePositive(const char* argument, long& value) {
+  char* end = nullptr;
+  value = std::strtol(argument, &end, 10);
+  return *argument != '\0' && *end == '\0' && value > 0;
+}
+
+}  // namespace
+
+/**
+ * Runs the simulation without a window and reports how fast it went.
+ * Usage: gas-sim-cli [num_particles] [num_frames] [num_threads] [image_path] [seed] [trace_path]
+ * With an image path such as frames/run.png, every frame is also drawn on the CPU
+ * and written as frames/run_000001.png and so on. Paths ending in .ppm write PPMs.
+ * An empty image path skips drawing. Without a seed, one is picked from the clock
+ * and printed, so the run can be repeated. When built with IDEALGAS_PROFILING, the
+ * time of each phase is printed, and a trace path writes a Chrome trace of the run.
+ */
+int main(int argc, char** argv) {
+  long num_particles = kDefaultNumParticles;
+  long num_frames = kDefaultNumFrames;
+  long num_threads = 1;
+  long seed = long(std::time(0));
+  if (argc > 7 || (argc > 1 && !ParsePositive(argv[1], num_particles)) ||
+      (argc > 2 && !ParsePositive(argv[2], num_frames)) || (argc > 3 && !ParsePositive(argv[3], num_threads)) ||
+      (argc > 5 && !ParsePositive(argv[5], seed))) {
+    std::fprintf(stderr, "usage: %s [num_particles] [num_frames] [num_threads] [image_path] [seed] [trace_path]\n",
+                 argv[0]);
+    return 1;
+  }
+
+  //split the particles between the default species
+  std::vector<std::pair<Species, int>> species_counts;
+  species_counts.emplace_back(Species("white", 1.0, 5.0), int(num_particles - 2 * (num_particles / 3)));
+  species_counts.emplace_back(Species("blue", 3.0, 8.0), int(num_particles / 3));
+  species_counts.emplace_back(Species("red", 5.0, 10.0), int(num_particles / 3));
+  int side = int(std::ceil(std::sqrt(float(num_particles) * kAreaPerParticle)));
+
+  //margins leave room for the histograms in exported frames
+  int margins_left = side * 2 / 5;
+  int margins_top = side / 20;
+  string image_path = argc > 4 ? argv[4] : "";
+
+  auto generation_start = std::chrono::steady_clock::now();
+  GasContainer container(side, side, margins_left, margins_top, species_counts, uint64_t(seed),
+                         size_t(num_threads));
+  double generation_seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - generation_start).count();
+  if (num_threads > 1) {
+    container.SetCollisionSchedule(CollisionSchedule::kCellColored);
+  }
+
+  int image_height = int(float(kImageWidth) * float(side + 2 * margins_top) / float(side + 2 * margins_left));
+  SoftwareRenderer renderer(kImageWidth, std::max(image_height, 1), size_t(num_threads));
+  SimulationSnapshot snapshot;
+  double render_seconds = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (long frame = 0; frame < num_frames; frame++) {
+    container.AdvanceOneFrame();
+    if (!image_path.empty()) {
+      auto render_start = std::chrono::steady_clock::now();
+      snapshot.Capture(container);
+      renderer.Render(snapshot);
+      try {
+        renderer.WriteImage(SoftwareRenderer::GetFramePath(image_path, size_t(frame + 1)));
+      } catch (const std::exception& error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+      }
+      render_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - render_start).count();
+    }
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() - render_seconds;
+
+  std::printf("particles: %ld\n", num_particles);
+  std::printf("frames: %ld\n", num_frames);
+  std::printf("threads: %ld\n", num_threads);
+  std::printf("seed: %ld\n", seed);
+  std::printf("generation seconds: %.3f\n", generation_seconds);
+  std::printf("seconds: %.3f\n", seconds);
+  std::printf("frames/sec: %.1f\n", double(num_frames) / seconds);
+  std::printf("particle-updates/sec: %.0f\n", double(num_frames) * double(num_particles) / seconds);
+  if (!image_path.empty()) {
+    std::printf("render+write seconds: %.3f\n", render_seconds);
+  }
+
+  //averaged over the last frames, since the pressure of a single frame is noisy
+  const idealgas::ObservablesHistory& observables = container.GetObservables();
+  if (observables.Size() > 0) {
+    idealgas::FrameObservables average = observables.GetAverage(observables.Size());
+    std::printf("temperature: %.4g\n", average.temperature);
+    std::printf("pressure: %.4g\n", average.pressure);
+    std::printf("collisions/frame: %.1f particle, %.1f wall\n", average.particle_collisions,
+                average.wall_collisions);
+  }
+
+  std::vector<PhaseStats> phases = Profiler::GetInstance().GetStats();
+  for (size_t i = 0; i < phases.size(); i++) {
+    std::printf("%s ms: p50 %.3f, p99 %.3f, max %.3f\n", phases[i].name.c_str(), phases[i].p50_ms,
+                phases[i].p99_ms, phases[i].max_ms);
+  }
+  if (argc > 6) {
+    try {
+      Profiler::GetInstance().WriteChromeTrace(argv[6]);
+    } catch (const std::exception& error) {
+      std::fprintf(stderr, "%s\n", error.what());
+      return 1;
+    }
+  }
+  return 0;
+}
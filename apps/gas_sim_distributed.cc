@@ -0,0 +1,130 @@
+#include "distributed_container.h"
+#include "socket_transport.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using idealgas::DistributedContainer;
+using idealgas::SocketTransport;
+using idealgas::Species;
+
+namespace {
+
+const int kDefaultNumParticles = 100000;
+const int kDefaultNumFrames = 100;
+const int kDefaultNumRanks = 2;
+
+//same density as the default 750 x 750 container holding 150 particles
+const float kAreaPerParticle = 750.0f * 750.0f / 150.0f;
+
+/**
+ * Reads a positive integer argument
+ * @param argument
+ * @param value set to the parsed value
+ * @return if the argument was a positive integer
+ */
+bool ParsePositive(const char* argument, long& value) {
+  char* end = nullptr;
+  value = std::strtol(argument, &end, 10);
+  return *argument != '\0' && *end == '\0' && value > 0;
+}
+
+}  // namespace
+
+/**
+ * Runs the simulation split between processes on this machine, one per rank, connected
+ * by Unix sockets, and reports how fast it went. Rank 0 prints the results.
+ * Usage: gas-sim-distributed [num_particles] [num_frames] [num_ranks] [seed]
+ */
+int main(int argc, char** argv) {
+  long num_particles = kDefaultNumParticles;
+  long num_frames = kDefaultNumFrames;
+  long num_ranks = kDefaultNumRanks;
+  long seed = long(std::time(0));
+  if (argc > 5 || (argc > 1 && !ParsePositive(argv[1], num_particles)) ||
+      (argc > 2 && !ParsePositive(argv[2], num_frames)) || (argc > 3 && !ParsePositive(argv[3], num_ranks)) ||
+      (argc > 4 && !ParsePositive(argv[4], seed))) {
+    std::fprintf(stderr, "usage: %s [num_particles] [num_frames] [num_ranks] [seed]\n", argv[0]);
+    return 1;
+  }
+
+#ifdef _WIN32
+  std::fprintf(stderr, "Distributed runs are not supported on this platform.\n");
+  return 1;
+#else
+  //split the particles between the default species
+  std::vector<std::pair<Species, int>> species_counts;
+  species_counts.emplace_back(Species("white", 1.0, 5.0), int(num_particles - 2 * (num_particles / 3)));
+  species_counts.emplace_back(Species("blue", 3.0, 8.0), int(num_particles / 3));
+  species_counts.emplace_back(Species("red", 5.0, 10.0), int(num_particles / 3));
+  int side = int(std::ceil(std::sqrt(float(num_particles) * kAreaPerParticle)));
+
+  std::vector<std::shared_ptr<SocketTransport>> group;
+  try {
+    group = SocketTransport::CreateGroup(int(num_ranks));
+  } catch (const std::exception& error) {
+    std::fprintf(stderr, "%s\n", error.what());
+    return 1;
+  }
+
+  //each child keeps only its own rank's sockets, and rank 0 runs in this process
+  int rank = 0;
+  std::vector<pid_t> children;
+  for (int child_rank = 1; child_rank < num_ranks; child_rank++) {
+    pid_t child = fork();
+    if (child < 0) {
+      std::perror("fork");
+      return 1;
+    }
+    if (child == 0) {
+      rank = child_rank;
+      children.clear();
+      break;
+    }
+    children.push_back(child);
+  }
+  std::shared_ptr<SocketTransport> transport = group.at(size_t(rank));
+  group.clear();
+
+  int status = 0;
+  try {
+    DistributedContainer container(side, side, 0, 0, species_counts, uint64_t(seed), transport);
+    auto start = std::chrono::steady_clock::now();
+    for (long frame = 0; frame < num_frames; frame++) {
+      container.AdvanceOneFrame();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (rank == 0) {
+      std::printf("particles: %ld\n", num_particles);
+      std::printf("frames: %ld\n", num_frames);
+      std::printf("ranks: %ld\n", num_ranks);
+      std::printf("seed: %ld\n", seed);
+      std::printf("seconds: %.3f\n", seconds);
+      std::printf("frames/sec: %.1f\n", double(num_frames) / seconds);
+      std::printf("particle-updates/sec: %.0f\n", double(num_frames) * double(num_particles) / seconds);
+    }
+  } catch (const std::exception& error) {
+    std::fprintf(stderr, "rank %d: %s\n", rank, error.what());
+    status = 1;
+  }
+
+  //closing this rank's sockets first lets any rank still waiting on it fail instead of hanging
+  transport.reset();
+  for (size_t i = 0; i < children.size(); i++) {
+    int child_status = 0;
+    waitpid(children[i], &child_status, 0);
+    if (!WIFEXITED(child_status) || WEXITSTATUS(child_status) != 0) {
+      status = 1;
+    }
+  }
+  return status;
+#endif
+}
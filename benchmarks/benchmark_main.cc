@@ -0,0 +1,211 @@
+#include "event_driven_container.h"
+#include "gas_container.h"
+#include "histogram.h"
+#include "particle.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+using idealgas::CollisionSchedule;
+using idealgas::EventDrivenContainer;
+using idealgas::FramePipeline;
+using idealgas::GasContainer;
+using idealgas::Histogram;
+using idealgas::NeighbourListStats;
+using idealgas::Particle;
+using idealgas::Placement;
+using idealgas::SimdKernels;
+using idealgas::SimdLevel;
+using idealgas::Species;
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace {
+
+//each benchmark repeats until it has run for this long, so short ones aren't noise
+const double kMinSeconds = 0.25;
+
+const long kParticleCounts[] = {100, 1000, 10000, 100000, 1000000};
+
+//fraction of the container area covered by particles
+const float kDensities[] = {0.01f, 0.05f, 0.2f};
+
+//the event-driven engine is only timed at this density and below, where it is meant to win
+const float kEventDrivenMaxDensity = 0.01f;
+
+const int kHistogramSegments = 50;
+
+const double kPi = 3.14159265358979323846;
+
+//written to by the particle benchmarks so their results aren't optimised away
+volatile float sink;
+
+/**
+ * The particles every benchmark runs on: the default species, in equal numbers
+ * @param num_particles
+ */
+vector<pair<Species, int>> GetSpeciesCounts(long num_particles) {
+  vector<pair<Species, int>> species_counts;
+  species_counts.emplace_back(Species("white", 1.0, 5.0), int(num_particles - 2 * (num_particles / 3)));
+  species_counts.emplace_back(Species("blue", 3.0, 8.0), int(num_particles / 3));
+  species_counts.emplace_back(Species("red", 5.0, 10.0), int(num_particles / 3));
+  return species_counts;
+}
+
+/**
+ * Gets the side of a square container holding the particles at the given density
+ * @param species_counts
+ * @param density fraction of the area covered by particles
+ */
+int GetContainerSide(const vector<pair<Species, int>>& species_counts, float density) {
+  double particle_area = 0;
+  for (size_t i = 0; i < species_counts.size(); i++) {
+    double radius = species_counts.at(i).first.radius;
+    particle_area += kPi * radius * radius * species_counts.at(i).second;
+  }
+  return int(std::ceil(std::sqrt(particle_area / density)));
+}
+
+/**
+ * Times a function, repeating it until kMinSeconds have passed
+ * @param run the function, doing one frame's worth of work
+ * @return the average seconds per call
+ */
+double Time(const std::function<void()>& run) {
+  long repetitions = 0;
+  double seconds = 0;
+  auto start = std::chrono::steady_clock::now();
+  while (seconds < kMinSeconds) {
+    run();
+    repetitions++;
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  return seconds / double(repetitions);
+}
+
+void Report(const string& name, long num_particles, float density, double seconds) {
+  std::printf("%-28s %10ld %8.2f %14.2f\n", name.c_str(), num_particles, density,
+              seconds * 1e9 / double(num_particles));
+}
+
+void RunBenchmarks(long num_particles, float density) {
+  vector<pair<Species, int>> species_counts = GetSpeciesCounts(num_particles);
+  int side = GetContainerSide(species_counts, density);
+
+  Report("Generation", num_particles, density, Time([&]() {
+    GasContainer container(side, side, 0, 0, species_counts);
+  }));
+  Report("Generation (lattice)", num_particles, density, Time([&]() {
+    GasContainer container(side, side, 0, 0, species_counts, 1, 1, Placement::kJitteredLattice);
+  }));
+  Report("Generation (Poisson disk)", num_particles, density, Time([&]() {
+    GasContainer container(side, side, 0, 0, species_counts, 1, 1, Placement::kPoissonDisk);
+  }));
+
+  GasContainer container(side, side, 0, 0, species_counts);
+  Report("AdvanceOneFrame", num_particles, density, Time([&]() {
+    container.AdvanceOneFrame();
+  }));
+  Report("HandleAllCollisions", num_particles, density, Time([&]() {
+    container.HandleAllCollisions();
+  }));
+
+  //the kernels at scalar and AVX2 level on their own, since the rows above use the best this CPU has
+  GasContainer scalar(side, side, 0, 0, species_counts);
+  scalar.SetSimdLevel(SimdLevel::kScalar);
+  Report("AdvanceOneFrame (scalar)", num_particles, density, Time([&]() {
+    scalar.AdvanceOneFrame();
+  }));
+  if (SimdKernels::GetBestSimdLevel() == SimdLevel::kAvx2) {
+    GasContainer vectorised(side, side, 0, 0, species_counts);
+    vectorised.SetSimdLevel(SimdLevel::kAvx2);
+    Report("AdvanceOneFrame (AVX2)", num_particles, density, Time([&]() {
+      vectorised.AdvanceOneFrame();
+    }));
+  }
+
+  if (density <= kEventDrivenMaxDensity) {
+    EventDrivenContainer event_driven(side, side, 0, 0, container.GetParticles());
+    Report("AdvanceOneFrame (events)", num_particles, density, Time([&]() {
+      event_driven.AdvanceOneFrame();
+    }));
+  }
+
+  GasContainer pipelined(side, side, 0, 0, species_counts);
+  pipelined.SetFramePipeline(FramePipeline::kTaskGraph);
+  Report("AdvanceOneFrame (task graph)", num_particles, density, Time([&]() {
+    pipelined.AdvanceOneFrame();
+  }));
+
+  GasContainer listed(side, side, 0, 0, species_counts);
+  listed.SetCollisionSchedule(CollisionSchedule::kNeighbourList);
+  Report("AdvanceOneFrame (neighbour)", num_particles, density, Time([&]() {
+    listed.AdvanceOneFrame();
+  }));
+  const NeighbourListStats& stats = listed.GetNeighbourListStats();
+  std::printf("%-28s %10ld %8.2f %14.2f\n", "  frames per rebuild", num_particles, density,
+              double(stats.num_passes) / double(std::max(stats.num_rebuilds, size_t(1))));
+
+  //neighbouring particles in the list, so the checks see the container's mix of species
+  vector<Particle> particles = container.GetParticles();
+  Report("HasCollided", num_particles, density, Time([&]() {
+    int collided = 0;
+    for (size_t i = 0; i + 1 < particles.size(); i++) {
+      collided += particles[i].HasCollided(particles[i + 1]);
+    }
+    sink = float(collided);
+  }));
+  Report("GetVelocitiesAfterCollision", num_particles, density, Time([&]() {
+    float total = 0;
+    for (size_t i = 0; i + 1 < particles.size(); i++) {
+      total += particles[i].GetVelocitiesAfterCollision(particles[i + 1]).first.x;
+    }
+    sink = total;
+  }));
+
+  vector<float> velocities;
+  for (size_t i = 0; i < particles.size(); i++) {
+    velocities.push_back(glm::length(particles[i].GetVelocity()));
+  }
+  float max_velocity = *std::max_element(velocities.begin(), velocities.end());
+  float min_velocity = *std::min_element(velocities.begin(), velocities.end());
+  Histogram histogram(velocities, max_velocity, min_velocity, kHistogramSegments);
+  Report("FindVelocityDistribution", num_particles, density, Time([&]() {
+    histogram.Update(velocities);
+    histogram.FindVelocityDistribution();
+  }));
+}
+
+}  // namespace
+
+/**
+ * Times the simulation hot paths over a range of particle counts and densities.
+ * Every result is in nanoseconds per particle per frame, or per call for the
+ * single-particle functions, so engine changes can be compared directly.
+ * Usage: gas-simulation-benchmark [max_particles]
+ */
+int main(int argc, char** argv) {
+  long max_particles = kParticleCounts[sizeof(kParticleCounts) / sizeof(kParticleCounts[0]) - 1];
+  if (argc > 1) {
+    char* end = nullptr;
+    max_particles = std::strtol(argv[1], &end, 10);
+    if (argc > 2 || *end != '\0' || max_particles <= 0) {
+      std::fprintf(stderr, "usage: %s [max_particles]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  std::printf("%-28s %10s %8s %14s\n", "benchmark", "particles", "density", "ns/particle");
+  for (long num_particles : kParticleCounts) {
+    if (num_particles > max_particles) {
+      break;
+    }
+    for (float density : kDensities) {
+      RunBenchmarks(num_particles, density);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "particle_store.h"
+#include "philox.h"
+#include "physics.h"
+#include "spatial_grid.h"
+#include "species_registry.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <utility>
+#include <vector>
+
+namespace idealgas {
+
+using std::pair;
+using std::vector;
+
+/**
+ * A box of gas in any number of dimensions and at any precision. It runs the same physics
+ * as GasContainer's kSequential schedule on the same particle store, grid and particle
+ * generation: touching pairs in index order, then the walls, then every particle moves.
+ * Walls are at 0 and at the box's size along every axis.
+ *
+ * Only BoxContainer<2, float>, <2, double>, <3, float> and <3, double> are compiled, in
+ * box_container.cc. In 2D at float precision it gives exactly the same particles as a
+ * GasContainer with no margins, but GasContainer's vectorised and multithreaded kernels
+ * make it the faster choice there.
+ */
+template <glm::length_t D, typename T>
+class BoxContainer {
+ public:
+  typedef glm::vec<D, T> Vector;
+
+  /**
+   * BoxContainer constructor for an empty box
+   * @param size length of each side
+   * @throws invalid_argument if a side isn't positive
+   */
+  explicit BoxContainer(const Vector& size);
+
+  /**
+   * BoxContainer constructor that generates random particles, like GasContainer's with
+   * Placement::kRandom. Each particle's random numbers come from the seed and its index.
+   * @param size length of each side
+   * @param species_counts each species to generate and how many particles of it
+   * @param seed seed of the random numbers the particles are generated from
+   * @throws invalid_argument if a side isn't positive, or a species doesn't fit
+   */
+  BoxContainer(const Vector& size, const vector<pair<Species, int>>& species_counts, uint64_t seed);
+
+  /**
+   * Gets the id of a species, adding it if it isn't registered yet
+   * @param species
+   */
+  int AddSpecies(const Species& species);
+
+  /**
+   * Adds a particle of a registered species
+   * @param species_id
+   * @param position
+   * @param velocity
+   * @throws invalid_argument if the species isn't registered
+   */
+  void AddParticle(int species_id, const Vector& position, const Vector& velocity);
+
+  size_t Size() const;
+
+  Vector GetSize() const;
+
+  Vector GetPosition(size_t index) const;
+
+  Vector GetVelocity(size_t index) const;
+
+  int GetSpeciesId(size_t index) const;
+
+  const SpeciesRegistry& GetSpeciesRegistry() const;
+
+  /**
+   * Adds up every particle's kinetic energy, in double precision
+   */
+  double GetKineticEnergy() const;
+
+  /**
+   * Resolves every collision, then moves every particle by its velocity
+   */
+  void AdvanceOneFrame();
+
+  /**
+   * Resolves every particle-particle and wall collision, without moving the particles
+   */
+  void HandleAllCollisions();
+
+ private:
+  Vector size_;
+
+  BasicParticleStore<D, T> particles_;
+
+  BasicSpatialGrid<D, T> grid_;
+
+  //GetCollisionCoefficient of every pair of species at this precision, by species id pair
+  vector<T> coefficients_;
+
+  Philox rng_;
+
+  //number of particles generated so far, the index the next one is generated from
+  uint64_t rng_counter_;
+
+  //the touching pairs of the frame being resolved, in the order they are resolved
+  vector<uint32_t> touching_first_;
+  vector<uint32_t> touching_second_;
+
+  /**
+   * Creates random particles of one species
+   * @param species_id
+   * @param num_particles
+   * @throws invalid_argument if the species doesn't fit
+   */
+  void GenerateParticles(int species_id, int num_particles);
+
+  /**
+   * Bounces two touching particles off each other, if they are moving towards each other
+   * @param i
+   * @param j
+   */
+  void ResolveCollision(size_t i, size_t j);
+};
+
+extern template class BoxContainer<2, float>;
+extern template class BoxContainer<2, double>;
+extern template class BoxContainer<3, float>;
+extern template class BoxContainer<3, double>;
+
+typedef BoxContainer<2, float> BoxContainer2f;
+typedef BoxContainer<2, double> BoxContainer2d;
+typedef BoxContainer<3, float> BoxContainer3f;
+typedef BoxContainer<3, double> BoxContainer3d;
+
+}  // namespace idealgas
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "particle_store.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace idealgas {
+
+using std::string;
+using std::vector;
+
+/**
+ * The fixed-size start of a checkpoint file. Every offset is from the start of the
+ * file, and every particle array starts on a Checkpoint::kAlignment boundary, so each
+ * one is a single aligned block that is read straight into the container's arrays.
+ */
+struct CheckpointHeader {
+  char magic[8];
+  uint32_t version;
+
+  //kCheckpointByteOrder as written by the saving machine, to catch files from the other endianness
+  uint32_t byte_order;
+
+  uint64_t num_particles;
+  uint32_t num_species;
+  int32_t length;
+  int32_t height;
+  int32_t margins_left;
+  int32_t margins_top;
+  uint32_t collision_schedule;
+
+  //random generator state of the container
+  uint64_t rng_seed;
+  uint64_t rng_counter;
+
+  //start of the species table: for each species its mass, radius, name length and name, padded to 4 bytes
+  uint64_t species_offset;
+
+  //start of each particle array, in CheckpointArray order
+  uint64_t array_offsets[8];
+
+  uint64_t file_size;
+};
+
+/**
+ * The particle arrays stored in a checkpoint, in file order
+ */
+enum CheckpointArray {
+  kCheckpointX,
+  kCheckpointY,
+  kCheckpointVx,
+  kCheckpointVy,
+  kCheckpointMass,
+  kCheckpointRadius,
+  kCheckpointSpecies,
+  kCheckpointSpeeds,
+  kNumCheckpointArrays
+};
+
+/**
+ * A checkpoint file open for reading. Saving writes a new file in one pass. Loading reads
+ * each particle array into memory the container owns, in one block per array, so it takes
+ * one pass over the particles rather than being instant: the first frame writes every array
+ * anyway, so reading them in place would only move the copy there.
+ */
+class Checkpoint {
+ public:
+
+  /**
+   * Writes a checkpoint file
+   * @param path
+   * @param header the container's geometry, schedule and random state; the rest is filled in
+   * @param particles
+   * @param speeds speed of each particle
+   */
+  static void Save(const string& path, const CheckpointHeader& header, const ParticleStore& particles,
+                   const vector<float>& speeds);
+
+  /**
+   * Opens a checkpoint file, checks its header and layout, and reads its species table
+   * @param path
+   * @throws runtime_error if the file can't be read or isn't a whole checkpoint
+   */
+  explicit Checkpoint(const string& path);
+
+  Checkpoint(const Checkpoint&) = delete;
+
+  Checkpoint& operator=(const Checkpoint&) = delete;
+
+  const CheckpointHeader& GetHeader() const;
+
+  /**
+   * Reads the particle arrays from the file, one block read per array
+   * @param particles replaced with the stored species and particles
+   * @param speeds replaced with the stored speeds
+   * @throws runtime_error if the file can't be read or holds an invalid particle
+   */
+  void Restore(ParticleStore& particles, vector<float>& speeds);
+
+  static const uint32_t kVersion = 1;
+  static const uint32_t kByteOrder = 0x01020304;
+
+  //alignment of every particle array in the file, a cache line
+  static const uint64_t kAlignment = 64;
+
+ private:
+  string path_;
+  std::ifstream file_;
+  uint64_t size_;
+
+  CheckpointHeader header_;
+
+  //the species table, in species id order
+  vector<Species> species_;
+
+  /**
+   * Checks that the header and species table describe a whole checkpoint that fits in the
+   * file, and reads the species table into species_
+   */
+  void Validate();
+
+  /**
+   * Reads bytes from the file
+   * @param offset from the start of the file
+   * @param data
+   * @param size
+   * @throws runtime_error if they can't be read
+   */
+  void Read(uint64_t offset, void* data, uint64_t size);
+};
+
+}  // namespace idealgas
@@ -0,0 +1,273 @@
+#pragma once
+
+#include "histogram.h"
+#include "observables.h"
+#include "philox.h"
+#include "particle_store.h"
+#include "simd_kernels.h"
+#include "spatial_grid.h"
+#include "transport.h"
+#include <memory>
+#include <utility>
+
+namespace idealgas {
+
+using std::vector;
+using std::string;
+
+/**
+ * One rank's part of a container that is split between processes. The container is
+ * cut into slabs of whole grid columns, one per rank, and each rank only stores and
+ * moves the particles in its own slab. Every frame, each rank is sent copies of the
+ * particles in the columns just outside its slab (its halo) by its neighbours, and
+ * particles that move into another slab are handed over to that slab's rank.
+ *
+ * Collisions are resolved in the same order as GasContainer's kCellColored schedule,
+ * one color at a time, and the velocities of particles in the columns two ranks share
+ * are exchanged after every color. So for any number of ranks, the particles and
+ * histograms are the same as a single GasContainer on the kCellColored schedule. The
+ * observables are added up over the ranks in rank order, so every rank gets the same
+ * ones, which match the single GasContainer's up to rounding.
+ */
+class DistributedContainer {
+ public:
+
+  /**
+   * DistributedContainer constructor. Every rank must construct its part at the same
+   * time, with the same arguments. The particles are generated from the seed just like
+   * GasContainer does with Placement::kRandom, and each rank keeps the ones in its slab.
+   * @param length length of the container
+   * @param height height of the container
+   * @param species_counts each species to generate and how many particles of it
+   * @param seed seed of the random numbers the particles are generated from
+   * @param transport connects this rank to the others
+   * @throws invalid_argument if a slab would be less than two grid columns wide, or a species doesn't fit
+   */
+  DistributedContainer(int length, int height, int margins_left, int margins_top,
+                       const vector<pair<Species, int>>& species_counts, uint64_t seed,
+                       std::shared_ptr<Transport> transport);
+
+  /**
+   * Gets the arrays this rank's particles are stored in
+   */
+  const ParticleStore& GetParticleStore() const;
+
+  /**
+   * Gets the id of each of this rank's particles, which is its index in a single-process
+   * GasContainer built from the same species and seed. Ascending.
+   */
+  const vector<uint64_t>& GetParticleIds() const;
+
+  /**
+   * Gets the speed histograms of every rank's particles together, one per species by species id
+   */
+  const vector<Histogram>& GetHistograms() const;
+
+  /**
+   * Gets the observables of every rank's particles together, for each of the latest frames
+   */
+  const ObservablesHistory& GetObservables() const;
+
+  /**
+   * Gets the number of particles on every rank together
+   */
+  size_t GetNumParticles() const;
+
+  /**
+   * Gets the first grid column of this rank's slab
+   */
+  int GetFirstColumn() const;
+
+  /**
+   * Gets one past the last grid column of this rank's slab
+   */
+  int GetEndColumn() const;
+
+  int GetLength() const;
+
+  int GetHeight() const;
+
+  int GetMarginsLeft() const;
+
+  int GetMarginsTop() const;
+
+  const SpeciesRegistry& GetSpeciesRegistry() const;
+
+  /**
+   * Advances this rank's particles by one frame. Every rank must call it at the same time.
+   */
+  void AdvanceOneFrame();
+
+ private:
+
+  /**
+   * What one rank's particles did over a frame, sent with the particles it hands over
+   */
+  struct RankTotals {
+    float min_speed;
+    float max_speed;
+    WallImpulses wall_impulses;
+    double kinetic_energy;
+    double momentum_x;
+    double momentum_y;
+    uint64_t particle_collisions;
+  };
+
+  int container_height_;
+  int container_length_;
+  int margins_top_;
+  int margins_left_;
+  float max_velocity_;
+  float min_velocity_;
+
+  std::shared_ptr<Transport> transport_;
+
+  /**
+   * This rank's particles, ascending by id
+   */
+  ParticleStore particles_;
+  vector<uint64_t> ids_;
+
+  //speed of each of this rank's particles
+  vector<float> velocities_;
+
+  //number of particles on every rank together
+  size_t num_particles_;
+
+  //the grid of the whole container, the same as a single-process GasContainer's
+  float cell_size_;
+  int num_columns_;
+  int num_rows_;
+
+  //rank r's slab is grid columns slab_starts_[r] to slab_starts_[r + 1]
+  vector<int> slab_starts_;
+
+  /**
+   * This rank's particles and its halo together, ascending by id, for the collision pass
+   */
+  ParticleStore work_;
+  vector<uint64_t> work_ids_;
+
+  //grid column of each particle in work_
+  vector<int> work_columns_;
+
+  //index in work_ of each of this rank's particles
+  vector<size_t> work_owned_;
+
+  //indices in work_ of the particles in columns a neighbour also holds, ascending
+  vector<size_t> shared_particles_;
+
+  //the grid over work_, covering the slab and its halo columns
+  SpatialGrid grid_;
+
+  //buffers for the pairs being checked in the collision pass
+  vector<size_t> candidates_;
+  vector<uint32_t> candidate_first_;
+  vector<uint32_t> candidate_second_;
+  vector<uint32_t> colliding_first_;
+  vector<uint32_t> colliding_second_;
+
+  //message buffers, one per rank exchanged with
+  vector<int> exchange_ranks_;
+  vector<vector<uint8_t>> outgoing_;
+  vector<vector<uint8_t>> incoming_;
+
+  SimdKernels kernels_;
+
+  //one histogram per species, by species id
+  vector<Histogram> histograms_;
+
+  //the latest frame's totals of each rank, by rank
+  vector<RankTotals> rank_totals_;
+
+  ObservablesHistory observables_;
+
+  //frames advanced so far
+  uint64_t num_frames_;
+
+  /**
+   * Gets the grid column of the whole container an x coordinate falls in
+   */
+  int GetColumn(float x) const;
+
+  /**
+   * Gets the rank whose slab a grid column is in
+   */
+  int GetOwner(int column) const;
+
+  /**
+   * Gets the columns a rank keeps particles of during the collision pass: its slab and one
+   * column either side
+   * @param rank
+   * @param first set to the first column
+   * @param end set to one past the last column
+   */
+  void GetWorkColumns(int rank, int& first, int& end) const;
+
+  /**
+   * Gets the rank whose collisions change the velocities of a column's particles while one color
+   * is resolved, or -1 if none do
+   * @param column
+   * @param color
+   */
+  int GetWriter(int column, int color) const;
+
+  /**
+   * Sets exchange_ranks_ to the ranks next to this one
+   */
+  void UseNeighbourRanks();
+
+  /**
+   * Sets exchange_ranks_ to every other rank
+   */
+  void UseAllRanks();
+
+  /**
+   * Exchanges outgoing_ with exchange_ranks_ into incoming_
+   */
+  void Exchange();
+
+  /**
+   * Fills work_ with this rank's particles and the halo particles sent by its neighbours,
+   * and rebuilds the grid over them
+   */
+  void GatherHalo();
+
+  /**
+   * Resolves the collisions of every cell of one color in this rank's slab
+   * @param color 0 to 8, as in GasContainer's kCellColored schedule
+   * @return the number of pairs that bounced off each other
+   */
+  size_t ResolveColor(int color);
+
+  /**
+   * Sends the velocities this rank's collisions just changed to the neighbours that also hold
+   * those particles, and takes the ones theirs changed
+   * @param color
+   */
+  void ExchangeVelocities(int color);
+
+  /**
+   * Hands particles that left this rank's slab to their new ranks, takes the ones that moved
+   * into it, sets the velocity range of every rank's particles and fills rank_totals_
+   * @param totals what this rank's particles did over the frame
+   */
+  void MigrateParticles(const RankTotals& totals);
+
+  /**
+   * Adds up rank_totals_ in rank order, and adds the frame to the observables
+   */
+  void RecordObservables();
+
+  /**
+   * Creates the histogram objects and fills them
+   */
+  void SetUpHistograms();
+
+  /**
+   * Counts this rank's speeds, then adds every other rank's counts
+   */
+  void FillHistograms();
+};
+
+}  // namespace idealgas
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "gas_container.h"
+#include "observables.h"
+#include "species_registry.h"
+#include "speed_distribution.h"
+#include "thread_pool.h"
+#include <utility>
+#include <vector>
+
+namespace idealgas {
+
+using std::pair;
+using std::vector;
+
+/**
+ * The parameters of one container in an ensemble
+ */
+struct EnsembleMember {
+
+  /**
+   * EnsembleMember constructor
+   * @param length length of the container
+   * @param height height of the container
+   * @param species_counts each species to generate and how many particles of it
+   * @param seed seed of the random numbers the particles are generated from
+   */
+  EnsembleMember(int length, int height, const vector<pair<Species, int>>& species_counts, uint64_t seed);
+
+  int length;
+  int height;
+  vector<pair<Species, int>> species_counts;
+  uint64_t seed;
+  CollisionSchedule collision_schedule;
+};
+
+/**
+ * Many independent containers stepped together, e.g. for a parameter sweep. Each container
+ * runs on one thread, and the containers are split between the threads of one shared pool,
+ * so small containers don't pay for threads or processes of their own. Containers of up to
+ * kMaxLanedParticles particles are grouped by size, MemberLanes::kNumLanes to a group, and the
+ * wall pass and move of a group run over its members interleaved, so each vector of lanes
+ * holds one particle of every member in the group. After every frame the
+ * members' speeds and observables are combined into ensemble averages. The members don't
+ * count their own speeds, so their speed distributions stay at the first frame. Otherwise
+ * every member gives the same frames as a container run on its own, for any number of threads.
+ */
+class Ensemble {
+ public:
+
+  /**
+   * Ensemble constructor. Generates every member's particles.
+   * @param members
+   * @param num_threads threads the members are split between
+   * @param num_bins bins of the speed distribution, from 0 to the fastest member's top speed
+   * @throws invalid_argument if there are no members, num_bins is 0, or a member's particles don't fit
+   */
+  Ensemble(const vector<EnsembleMember>& members, size_t num_threads, size_t num_bins = kDefaultNumBins);
+
+  Ensemble(const Ensemble&) = delete;
+
+  Ensemble& operator=(const Ensemble&) = delete;
+
+  /**
+   * Advances every member by one frame, then adds the frame to the ensemble averages
+   */
+  void AdvanceOneFrame();
+
+  size_t Size() const;
+
+  const GasContainer& GetMember(size_t index) const;
+
+  /**
+   * Gets every species of every member. Members' species with the same name, mass and
+   * radius are counted as one.
+   */
+  const SpeciesRegistry& GetSpeciesRegistry() const;
+
+  /**
+   * Gets the members' observables combined for each of the latest frames. Temperature and
+   * pressure are those of the members taken as one gas: temperature is weighted by each
+   * member's particles, and each pressure by the length of wall it is measured over. The
+   * rest, like kinetic energy and collision counts, are the mean per member.
+   */
+  const ObservablesHistory& GetObservables() const;
+
+  /**
+   * Gets the speed counts of every member's particles together, for each of the latest frames
+   */
+  const SpeedDistribution& GetSpeedDistribution() const;
+
+  /**
+   * Gets a species' speed counts per member, averaged over the members and the latest frames
+   * @param species_id id in the ensemble's species registry
+   * @param num_frames how many of the latest frames to combine
+   * @param view
+   * @return one value per bin
+   * @throws invalid_argument if the species isn't counted, or num_frames is 0 or more than the frames kept
+   */
+  vector<double> GetAverageDistribution(int species_id, size_t num_frames = 1,
+                                        DistributionView view = DistributionView::kMovingAverage) const;
+
+  static const size_t kDefaultNumBins = 10;
+
+  //most particles a member can have and still share its wall pass with others. Past this, a
+  //member's own wall pass already fills its vectors.
+  static const size_t kMaxLanedParticles = 1024;
+
+ private:
+  vector<GasContainer> members_;
+
+  ThreadPool thread_pool_;
+
+  SimdKernels kernels_;
+
+  //members in each group's lanes, by lane, and the lanes they are interleaved in
+  vector<vector<size_t>> lane_groups_;
+  vector<MemberLanes> lanes_;
+
+  //members too big for the lanes, advanced on their own
+  vector<size_t> solo_members_;
+
+  SpeciesRegistry species_registry_;
+
+  //every member's particles one after another, member i's starting at offsets_[i]
+  vector<size_t> offsets_;
+  vector<int> species_;
+  vector<float> speeds_;
+
+  SpeedDistribution speed_distribution_;
+
+  ObservablesHistory observables_;
+
+  //frames advanced so far
+  uint64_t num_frames_;
+
+  //frames the speed distribution keeps
+  static const size_t kSpeedHistoryFrames = 256;
+
+  /**
+   * Advances one group of members, with their wall passes and moves run together
+   * @param group index in lane_groups_
+   */
+  void AdvanceLaneGroup(size_t group);
+
+  /**
+   * Copies the speeds a member worked out in its wall pass into speeds_
+   * @param index the member
+   */
+  void GatherSpeeds(size_t index);
+
+  /**
+   * Averages the members' latest observables, and counts every particle's speed
+   */
+  void RecordFrame();
+};
+
+}  // namespace idealgas
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "histogram.h"
+#include "particle.h"
+#include "particle_store.h"
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+namespace idealgas {
+
+using std::vector;
+using glm::vec2;
+using std::string;
+
+/**
+ * An alternative to GasContainer that predicts exactly when each collision will
+ * happen and jumps straight from one collision to the next, instead of moving
+ * every particle every frame. Particles move their velocity in distance per
+ * unit of time, and one frame is one unit, so the state is still sampled at
+ * the same frame rate as GasContainer.
+ */
+class EventDrivenContainer {
+ public:
+
+  /**
+   * EventDrivenContainer constructor
+   * @param length length of the container
+   * @param height height of the container
+   * @param particles the particles in the container
+   */
+  EventDrivenContainer(int length, int height, int margins_left, int margins_top, const vector<Particle>& particles);
+
+  /**
+   * Gets the arrays the particles are stored in, for drawing
+   */
+  const ParticleStore& GetParticleStore() const;
+
+  /**
+   * Gets the speed histograms, one per species by species id
+   */
+  const vector<Histogram>& GetHistograms() const;
+
+  int GetLength() const;
+
+  int GetHeight() const;
+
+  int GetMarginsLeft() const;
+
+  int GetMarginsTop() const;
+
+  /**
+   * Processes every collision up to the end of the next frame, then moves all
+   * particles to where they are at that time.
+   */
+  void AdvanceOneFrame();
+
+  /**
+   * Builds Particle values from the state of every particle at the current frame
+   * @return the particles, in the order they were added
+   */
+  vector<Particle> GetParticles();
+
+  /**
+   * Gets the speeds of every particle of one species
+   * @param species_id
+   * @return the speeds, in particle order
+   */
+  vector<float> GetVelocitiesOfSpecies(int species_id);
+
+  const SpeciesRegistry& GetSpeciesRegistry() const;
+
+  /**
+   * Gets the time of the current frame
+   */
+  double GetTime() const;
+
+  /**
+   * Gets how many collisions and cell changes have been processed so far
+   */
+  size_t GetNumEventsProcessed() const;
+
+  bool GetPaused();
+
+  void SetPaused(bool paused);
+
+ private:
+  enum class EventType {
+    //two particles touch
+    kParticle,
+    //a particle touches the left or right wall
+    kWallX,
+    //a particle touches the top or bottom wall
+    kWallY,
+    //a particle moves into a neighbouring cell
+    kCell
+  };
+
+  /**
+   * A predicted event. It is stale, and skipped, if either particle has had an
+   * event since it was predicted.
+   */
+  struct Event {
+    double time;
+    EventType type;
+    uint32_t particle;
+    //the other particle, or the cell being entered for kCell
+    uint32_t other;
+    uint32_t particle_count;
+    uint32_t other_count;
+
+    bool operator>(const Event& event) const;
+  };
+
+  int container_height_;
+  int container_length_;
+  int margins_top_;
+  int margins_left_;
+  float max_velocity_;
+  float min_velocity_;
+  bool paused_;
+
+  //time of the current frame
+  double time_;
+
+  ParticleStore particles_;
+
+  //time each particle's position in particles_ is at
+  vector<double> particle_times_;
+
+  //bumped on every event of a particle, to invalidate its older predictions
+  vector<uint32_t> event_counts_;
+
+  //earliest event first
+  std::priority_queue<Event, vector<Event>, std::greater<Event>> events_;
+  size_t num_events_processed_;
+
+  float cell_size_;
+  int num_columns_;
+  int num_rows_;
+  vector<vector<uint32_t>> cells_;
+  vector<int> particle_cells_;
+
+  //speed of each particle at the current frame
+  vector<float> velocities_;
+
+  //one histogram per species, by species id
+  vector<Histogram> histograms_;
+
+  //when the queue holds more than this many events per particle, it is predicted again from scratch
+  static const size_t kMaxQueuedEventsPerParticle = 32;
+
+  /**
+   * Puts every particle in its cell and predicts every particle's next events
+   */
+  void RebuildEvents();
+
+  /**
+   * Moves a particle to where it is at the given time
+   * @param particle
+   * @param time
+   */
+  void MoveParticleTo(uint32_t particle, double time);
+
+  /**
+   * Predicts the next wall, cell and particle events of a particle, from the given time
+   * @param particle
+   * @param time
+   */
+  void PredictEvents(uint32_t particle, double time);
+
+  /**
+   * Predicts when two particles will touch, from the given time, and queues it
+   * @param particle
+   * @param other
+   * @param time
+   */
+  void PredictCollision(uint32_t particle, uint32_t other, double time);
+
+  /**
+   * Applies an event whose particles have been moved to its time
+   * @param event
+   */
+  void ProcessEvent(const Event& event);
+
+  /**
+   * Pushes an event with the current event counts of its particles
+   */
+  void QueueEvent(double time, EventType type, uint32_t particle, uint32_t other);
+
+  int GetCellCoordinate(float coordinate, float min, int count) const;
+
+  void SetUpHistograms();
+
+  void UpdateHistograms();
+
+  /**
+   * Counts every particle's speed in its species' histogram, in one pass over the particles
+   */
+  void FillHistograms();
+};
+
+}  // namespace idealgas
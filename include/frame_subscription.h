@@ -0,0 +1,192 @@
+#pragma once
+
+#include "observables.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace idealgas {
+
+using std::vector;
+
+/**
+ * What a container does with a frame when a subscriber's ring buffer is full. The
+ * container never waits for a subscriber either way.
+ */
+enum class OverflowPolicy {
+  //the frame is skipped for this subscriber, and counted as dropped
+  kDropFrames,
+  //the frame is skipped and counted too, but the container reports backpressure until
+  //the subscriber catches up, so whatever drives the container can hold off advancing it
+  kBackpressure
+};
+
+/**
+ * Which parts of each frame a subscriber gets, and how many frames it can fall behind
+ */
+struct SubscriptionOptions {
+
+  SubscriptionOptions();
+
+  //every particle's position and species id
+  bool positions;
+
+  //every particle's velocity
+  bool velocities;
+
+  //every species' speed counts, in the container's speed distribution bins
+  bool speed_counts;
+
+  //the frame's energy, momentum, pressure and collision counts
+  bool observables;
+
+  //frames the ring buffer holds
+  size_t capacity;
+
+  OverflowPolicy overflow_policy;
+};
+
+/**
+ * One frame as a subscriber sees it. Only the parts the subscriber asked for are filled in.
+ */
+struct FrameRecord {
+
+  FrameRecord();
+
+  //frames advanced when this was published, counting from 1
+  uint64_t frame;
+
+  //by particle index
+  vector<float> x;
+  vector<float> y;
+  vector<int> species;
+  vector<float> vx;
+  vector<float> vy;
+
+  //by species id, then bin. The bins are of equal width from 0 to max_speed.
+  vector<int> speed_counts;
+  size_t num_bins;
+  float max_speed;
+
+  FrameObservables observables;
+};
+
+/**
+ * A bounded lock-free ring buffer of frames from one container to one consumer. The thread
+ * advancing the container writes frames into it and exactly one other thread reads them, so
+ * neither ever takes a lock or waits for the other. Every slot's buffers are reused, so once
+ * they have grown to the number of particles publishing a frame doesn't allocate.
+ */
+class FrameSubscription {
+ public:
+
+  /**
+   * FrameSubscription constructor
+   * @param options
+   * @param num_particles particles each slot's buffers are reserved for
+   * @param num_speed_counts speed counts each slot's buffer is reserved for
+   * @throws invalid_argument if the capacity is 0
+   */
+  FrameSubscription(const SubscriptionOptions& options, size_t num_particles, size_t num_speed_counts);
+
+  FrameSubscription(const FrameSubscription&) = delete;
+
+  FrameSubscription& operator=(const FrameSubscription&) = delete;
+
+  const SubscriptionOptions& GetOptions() const;
+
+  /**
+   * Gets the oldest frame that hasn't been popped. Only the consumer may call this.
+   * @return the frame, which stays unchanged until Pop, or null if there is none
+   */
+  const FrameRecord* Peek() const;
+
+  /**
+   * Frees the oldest frame's slot for the container to reuse. Only the consumer may call this.
+   * @throws logic_error if there is no frame to pop
+   */
+  void Pop();
+
+  /**
+   * Gets how many frames are waiting to be popped
+   */
+  size_t Size() const;
+
+  /**
+   * Checks if the next frame published would be dropped
+   */
+  bool IsFull() const;
+
+  /**
+   * Gets how many frames were skipped because the ring buffer was full
+   */
+  uint64_t GetDroppedFrames() const;
+
+  /**
+   * Gets the slot the next frame should be written to. Only the container may call this.
+   * @return the slot, or null if the ring buffer is full, in which case the frame is counted as dropped
+   */
+  FrameRecord* BeginWrite();
+
+  /**
+   * Hands the slot from BeginWrite to the consumer. Only the container may call this.
+   */
+  void EndWrite();
+
+ private:
+  SubscriptionOptions options_;
+
+  vector<FrameRecord> records_;
+
+  //frames written, only changed by the container
+  std::atomic<uint64_t> write_count_;
+  std::atomic<uint64_t> dropped_frames_;
+
+  //keeps the two threads' counters on separate cache lines
+  char padding_[64];
+
+  //frames popped, only changed by the consumer
+  std::atomic<uint64_t> read_count_;
+};
+
+/**
+ * The subscriptions of one container. Since each subscription's ring buffer can only be
+ * written by one container, a copy of a container starts with no subscriptions. Assigning
+ * to a container, by copy or by move, keeps exactly the subscriptions it already had, so a
+ * consumer never starts getting another simulation's frames. Moving a container moves them.
+ * The container iterates them while it advances, so they are only added and removed on the
+ * thread that advances it; nothing here takes a lock.
+ */
+class FrameSubscribers {
+ public:
+
+  FrameSubscribers();
+
+  FrameSubscribers(const FrameSubscribers& other);
+
+  FrameSubscribers(FrameSubscribers&& other) = default;
+
+  FrameSubscribers& operator=(const FrameSubscribers& other);
+
+  FrameSubscribers& operator=(FrameSubscribers&& other);
+
+  void Add(const std::shared_ptr<FrameSubscription>& subscription);
+
+  /**
+   * Removes a subscription
+   * @param subscription
+   * @return false if it wasn't added
+   */
+  bool Remove(const std::shared_ptr<FrameSubscription>& subscription);
+
+  size_t Size() const;
+
+  FrameSubscription& At(size_t index) const;
+
+ private:
+  vector<std::shared_ptr<FrameSubscription>> subscriptions_;
+};
+
+}  // namespace idealgas
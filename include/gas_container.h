@@ -1,8 +1,20 @@
 #pragma once
 
-#include "cinder/gl/gl.h"
 #include "particle.h"
+#include "philox.h"
+#include "particle_placer.h"
+#include "particle_store.h"
+#include "frame_subscription.h"
 #include "histogram.h"
+#include "observables.h"
+#include "simd_kernels.h"
+#include "spatial_grid.h"
+#include "speed_distribution.h"
+#include "task_graph.h"
+#include "thread_pool.h"
+#include <ctime>
+#include <limits>
+#include <memory>
 #include <utility>
 
 namespace idealgas {
@@ -11,6 +23,48 @@ using std::vector;
 using glm::vec2;
 using std::string;
 
+/**
+ * The order particle-particle collisions are resolved in
+ */
+enum class CollisionSchedule {
+  //particle index order on one thread, like the original all-pairs loop
+  kSequential,
+  //grid cells in 9 colors, with the cells of one color resolved in parallel.
+  //Gives the same results for any number of threads.
+  kCellColored,
+  //the kSequential order, with each particle's candidates kept in a neighbour list that is
+  //only rebuilt once particles have moved far enough. Gives the same results as kSequential.
+  //Only faster when particles move much less than their radius per frame, so the lists last.
+  kNeighbourList
+};
+
+/**
+ * How the phases of a frame are run on the thread pool
+ */
+enum class FramePipeline {
+  //each phase over every particle, one after another, with the threads waiting for each other
+  //between phases
+  kPhases,
+  //a graph of tasks over chunks of particles, so each chunk is integrated as soon as its walls
+  //are done, and counting the speeds of one frame overlaps the broadphase of the next. Gives the
+  //same particles as kPhases, and the same observables for any number of threads.
+  kTaskGraph
+};
+
+/**
+ * Counters for tuning the neighbour list skin
+ */
+struct NeighbourListStats {
+  //collision passes that used the neighbour lists
+  size_t num_passes;
+
+  //times the lists were rebuilt
+  size_t num_rebuilds;
+
+  //pairs in the current lists
+  size_t num_pairs;
+};
+
 /**
  * The container in which all of the gas particles are contained. This class
  * stores all of the particles and updates them on each frame of the simulation.
@@ -29,9 +83,62 @@ class GasContainer {
   GasContainer(int length, int height, int margins_left, int margins_top, vector<Particle> particles);
 
   /**
-   * Displays the container walls and the current positions of the particles.
+   * GasContainer constructor that generates random particles. Each particle's random
+   * numbers come from the seed and its index, so the same seed gives the same particles
+   * for any number of threads.
+   * @param length length of the container
+   * @param height height of the container
+   * @param species_counts each species to generate and how many particles of it
+   * @param seed seed of the random numbers the particles are generated from
+   * @param num_threads threads to generate on, and to run the simulation on afterwards
+   * @param placement how the particles are placed. Every placement but kRandom keeps them from overlapping.
+   * @throws invalid_argument if the particles don't fit with the placement
+   */
+  GasContainer(int length, int height, int margins_left, int margins_top,
+               const vector<pair<Species, int>>& species_counts, uint64_t seed = kDefaultSeed,
+               size_t num_threads = 1, Placement placement = Placement::kRandom);
+
+  /**
+   * Gets the arrays the particles are stored in, for drawing
+   */
+  const ParticleStore& GetParticleStore() const;
+
+  /**
+   * Gets the speed histograms, one per species by species id. They are only worked out
+   * when asked for, so frames that are never drawn don't pay for them. Although this is
+   * const, working them out writes to the container, so only call it on the thread that
+   * advances the container, e.g. before handing a copy to another thread.
+   */
+  const vector<Histogram>& GetHistograms() const;
+
+  /**
+   * Sets how many of the latest frames the histograms combine. With 1 frame they show the
+   * current speeds between the slowest and fastest particle; with more, they show the
+   * speed distribution's bins, which have the same range every frame so they can be combined.
+   * @param num_frames if fewer frames have been simulated, the histograms combine every one
+   * @param view how the frames are combined
+   * @throws invalid_argument if num_frames is 0 or more than the speed distribution keeps
+   */
+  void SetHistogramWindow(size_t num_frames, DistributionView view = DistributionView::kMovingAverage);
+
+  size_t GetHistogramWindow() const;
+
+  DistributionView GetHistogramView() const;
+
+  /**
+   * Gets every species' speed counts for each of the latest frames, e.g. to export them.
+   * Like GetHistograms, this may first count the last frame's speeds, so only call it on
+   * the thread that advances the container.
    */
-  void Display() const;
+  const SpeedDistribution& GetSpeedDistribution() const;
+
+  int GetLength() const;
+
+  int GetHeight() const;
+
+  int GetMarginsLeft() const;
+
+  int GetMarginsTop() const;
 
   /**
    * Updates the positions and velocities of all particles (based on the rules
@@ -39,16 +146,170 @@ class GasContainer {
    */
   void AdvanceOneFrame();
 
+  /**
+   * Gets the energy, momentum, pressure and collision counts of the latest frames. They are
+   * added up during the collision pass, so reading them costs no extra pass over the particles.
+   */
+  const ObservablesHistory& GetObservables() const;
+
+  /**
+   * Publishes every frame advanced from now on to a new ring buffer, which one other thread
+   * can read frames from without ever holding up AdvanceOneFrame. Only call this on the
+   * thread that advances the container. Assigning another container to this one, e.g. one
+   * from LoadCheckpoint, keeps publishing to the same subscriptions.
+   * @param options which parts of each frame to publish, and what to do when the buffer is full
+   * @return the subscription to read the frames from
+   * @throws invalid_argument if the capacity is 0
+   */
+  std::shared_ptr<FrameSubscription> Subscribe(const SubscriptionOptions& options);
+
+  /**
+   * Stops publishing frames to a subscription. Only call this on the thread that advances the container.
+   * @param subscription
+   * @return false if it isn't subscribed to this container
+   */
+  bool Unsubscribe(const std::shared_ptr<FrameSubscription>& subscription);
+
+  /**
+   * Checks if a subscriber with the kBackpressure policy has fallen so far behind that the
+   * next frame would be dropped for it, so whatever advances the container can wait first
+   */
+  bool IsBackpressured() const;
+
+  /**
+   * Writes the container's geometry, collision schedule, species and particles to a
+   * checkpoint file that LoadCheckpoint can restart from
+   * @param path
+   */
+  void SaveCheckpoint(const string& path) const;
+
+  /**
+   * Builds a container from a checkpoint file. Each particle array is read in one block,
+   * so loading takes one pass over the particles (under half a second for 10 million).
+   * @param path
+   * @return the container, in the state it was saved in
+   */
+  static GasContainer LoadCheckpoint(const string& path);
+
+  /**
+   * Resolves every particle-particle and wall collision, without moving the particles.
+   * Called by AdvanceOneFrame.
+   */
+  void HandleAllCollisions();
+
+  /**
+   * Starts a frame whose wall pass and move are run over several containers at once, by
+   * SimdKernels::ReflectAndIntegrateLanes: resolves the particle-particle collisions, then
+   * copies the particles into one lane. Together with FinishLanedFrame, gives the same frame
+   * as AdvanceOneFrame, except that a paused container is advanced all the same.
+   * @param lanes
+   * @param lane
+   * @throws invalid_argument if there is no such lane, or it has fewer slots than the container has particles
+   */
+  void StartLanedFrame(MemberLanes& lanes, size_t lane);
+
+  /**
+   * Finishes a frame StartLanedFrame started, once the lanes have been run: copies the
+   * particles back, and records the frame
+   * @param lanes
+   * @param lane
+   */
+  void FinishLanedFrame(const MemberLanes& lanes, size_t lane);
+
+  /**
+   * Builds Particle values from the current state of every particle
+   * @return the particles, in the order they were added
+   */
   vector<Particle> GetParticles();
 
+  /**
+   * Gets the speeds of every particle whose species has the given color
+   * @param color
+   * @return the speeds, in particle order
+   */
   vector<float> GetVelocitiesOfParticleColor(const string& color);
 
+  /**
+   * Gets the speeds of every particle of one species
+   * @param species_id
+   * @return the speeds, in particle order
+   */
+  vector<float> GetVelocitiesOfSpecies(int species_id);
+
+  const SpeciesRegistry& GetSpeciesRegistry() const;
+
+  /**
+   * Gets the seed the particles were generated from
+   */
+  uint64_t GetSeed() const;
+
+  /**
+   * Gets every particle's speed as of the last wall pass, in particle order
+   */
+  const vector<float>& GetSpeeds() const;
+
+  /**
+   * Sets whether each frame's speeds are counted in the speed distribution. Something that
+   * counts the speeds itself, like an Ensemble, can turn this off so they aren't counted twice;
+   * the distribution, the histograms over more than 1 frame and published speed counts then
+   * stop changing.
+   * @param enabled
+   */
+  void SetSpeedCounting(bool enabled);
+
+  bool GetSpeedCounting() const;
+
 
   /**
    * Creates the histogram objects and sets them up
    */
   void SetUpHistograms();
 
+  /**
+   * Sets how many threads the simulation runs on
+   * @param num_threads total threads, including the one calling AdvanceOneFrame
+   */
+  void SetNumThreads(size_t num_threads);
+
+  size_t GetNumThreads() const;
+
+  /**
+   * Sets the order collisions are resolved in. Only kCellColored uses more than one thread.
+   * @param schedule
+   */
+  void SetCollisionSchedule(CollisionSchedule schedule);
+
+  /**
+   * Sets how much further apart than touching two particles can be and still be in each other's
+   * neighbour lists. The lists are rebuilt when a particle has moved half of this since the last
+   * rebuild, so a bigger skin means longer lists that are rebuilt less often.
+   * @param skin distance between the particles' edges, at least 0
+   */
+  void SetNeighbourSkin(float skin);
+
+  float GetNeighbourSkin() const;
+
+  /**
+   * Gets how often the neighbour lists have been rebuilt, and how big they are
+   */
+  const NeighbourListStats& GetNeighbourListStats() const;
+
+  /**
+   * Sets the instruction set the per-frame loops use. Every level gives the same results.
+   * @param level lowered to the best one this CPU supports
+   */
+  void SetSimdLevel(SimdLevel level);
+
+  SimdLevel GetSimdLevel() const;
+
+  /**
+   * Sets how the phases of each frame are run
+   * @param pipeline
+   */
+  void SetFramePipeline(FramePipeline pipeline);
+
+  FramePipeline GetFramePipeline() const;
+
   bool GetPaused();
 
   void SetPaused(bool paused);
@@ -60,27 +321,57 @@ class GasContainer {
     int margins_left_;
     float max_velocity_;
     float min_velocity_;
-    Histogram white_histogram_;
-    Histogram blue_histogram_;
-    Histogram red_histogram_;
+
+    //one histogram per species, by species id, worked out again when asked for after a frame.
+    //These and the speed distribution are mutable so const getters can bring them up to date, so
+    //they must only be read on the thread that advances the container.
+    mutable vector<Histogram> histograms_;
+    mutable bool histograms_stale_ = false;
+
+    //mutable so the speeds the task graph left to count can be counted when the distribution is read
+    mutable SpeedDistribution speed_distribution_;
+    mutable bool speeds_pending_ = false;
+    bool speed_counting_ = true;
+    size_t histogram_window_ = 1;
+    DistributionView histogram_view_ = DistributionView::kMovingAverage;
 
     //if the simulation is paused or not
-    bool paused_;
+    bool paused_ = false;
 
+    static const uint64_t kDefaultSeed = 1;
+    static const int kDefaultNeighbourSkin = 4;
     static const int kDefaultNumParticles = 50;
     static const int kDefaultLength = 750;
     static const int kDefaultHeight = 750;
     static const int kDefaultTopMargins = 100;
     static const int kDefaultLeftMargins = 300;
 
-    const Particle kWhiteParticle = Particle("white", 1.0, 5.0);
-    const Particle kBlueParticle = Particle("blue", 3.0, 8.0);
-    const Particle kRedParticle = Particle("red", 5.0, 10.0);
+    //frames the speed distribution keeps
+    static const size_t kSpeedHistoryFrames = 256;
+
+    //the speed distribution's bins go up to this many times the fastest starting speed, since
+    //collisions spread the speeds out from where they started
+    static const int kSpeedRangeScale = 2;
+
+    /**
+     * The species generated by the default constructor
+     */
+    static const vector<Species> kDefaultSpecies;
+
+    /**
+     * Counter-based generator the particles are generated from, keyed by particle index
+     */
+    Philox rng_;
+
+    /**
+     * Number of particles generated so far, the index the next one is generated from
+     */
+    uint64_t rng_counter_ = 0;
 
     /**
-     * The vector we store particles in
+     * The arrays we store particles in
      */
-    vector<Particle> particles_;
+    ParticleStore particles_;
 
     /**
      * Vector storing the velocity of all the particles
@@ -88,26 +379,305 @@ class GasContainer {
     vector<float> velocities_;
 
     /**
-     * Creates random particles and puts them into particles_
+     * Broadphase grid, rebuilt at the start of every collision pass
+     */
+    SpatialGrid grid_;
+
+    /**
+     * Buffers for the pairs being checked by one thread during the collision pass
+     */
+    struct CollisionScratch {
+      vector<size_t> candidates;
+      vector<uint32_t> candidate_first;
+      vector<uint32_t> candidate_second;
+      vector<uint32_t> colliding_first;
+      vector<uint32_t> colliding_second;
+
+      //range of the speeds this thread wrote in the wall pass
+      float min_speed;
+      float max_speed;
+
+      //largest squared distance a particle of this thread moved since the neighbour lists were built
+      float max_displacement_squared;
+
+      //this thread's share of the frame's observables, added up during the collision pass
+      size_t num_particle_collisions;
+      WallImpulses wall_impulses;
+      double kinetic_energy;
+      double momentum_x;
+      double momentum_y;
+    };
+
+    /**
+     * Collision buffers, one per thread
+     */
+    vector<CollisionScratch> collision_scratch_;
+
+    //particles whose candidate pairs are gathered before checking them, in the neighbour list schedule
+    static const size_t kCollisionBlockSize = 1024;
+
+    SimdKernels kernels_;
+
+    CollisionSchedule collision_schedule_ = CollisionSchedule::kSequential;
+
+    float neighbour_skin_ = kDefaultNeighbourSkin;
+
+    /**
+     * Each particle's neighbours with a higher index, ascending, within touching distance plus
+     * the skin. Particle i's are neighbours_[neighbour_starts_[i]] up to neighbours_[neighbour_starts_[i + 1]].
+     */
+    vector<size_t> neighbour_starts_;
+    vector<uint32_t> neighbours_;
+
+    /**
+     * Where the particles were when the neighbour lists were built
+     */
+    vector<float> neighbour_x_;
+    vector<float> neighbour_y_;
+
+    //if the neighbour lists need building before they are next used
+    bool neighbour_lists_stale_ = true;
+
+    NeighbourListStats neighbour_stats_ = NeighbourListStats();
+
+    //frames advanced so far
+    uint64_t num_frames_ = 0;
+
+    FramePipeline frame_pipeline_ = FramePipeline::kPhases;
+
+    /**
+     * The kinds of task a frame is split into by the kTaskGraph pipeline
+     */
+    enum class FrameTaskKind {
+      kCountSpeeds,
+      kRebuildGrid,
+      kResolvePairs,
+      kResolveColorCells,
+      //waits for a group of tasks, so the tasks after it need one dependency instead of one each
+      kJoin,
+      kReflectWalls,
+      kIntegrate
+    };
+
+    struct FrameTask {
+      FrameTaskKind kind;
+      //the color being resolved, for kResolveColorCells
+      int color;
+      //the chunk of particles, or of a color's cells
+      size_t chunk;
+    };
+
+    //the frame as a graph of tasks, and what each one does. Built again when the schedule, the
+    //number of threads or the number of particle chunks changes.
+    TaskGraph frame_graph_;
+    vector<FrameTask> frame_tasks_;
+    CollisionSchedule frame_graph_schedule_ = CollisionSchedule::kSequential;
+    size_t frame_graph_threads_ = 0;
+    size_t frame_graph_chunks_ = 0;
+
+    //the wall pass totals of each particle chunk, added up in chunk order after the graph runs
+    vector<CollisionScratch> chunk_scratch_;
+
+    //particles per chunk of the task graph, the same for any number of threads so the totals are too
+    static const size_t kFrameChunkSize = 4096;
+
+    //chunks each color's cells are split into per thread
+    static const size_t kColorChunksPerThread = 4;
+
+    ObservablesHistory observables_;
+
+    //the ring buffers every frame is published to
+    FrameSubscribers subscribers_;
+
+    /**
+     * Threads shared by the parallel phases, or null when running on one thread
+     */
+    std::shared_ptr<ThreadPool> thread_pool_;
+
+    /**
+     * Creates random particles of every species and puts them into particles_
+     * @param species_counts each species to generate and how many particles of it
+     * @param placement how the particles are placed
+     */
+    void GenerateParticles(const vector<pair<Species, int>>& species_counts, Placement placement);
+
+    /**
+     * Creates random particles of one species and puts them into particles_, in parallel
+     * @param species_id the registered species to generate
      * @param num_particles number of particles to generate
      */
-    void GenerateParticles(int num_blue_particles, int num_white_particles, int num_red_particles);
+    void GenerateParticles(int species_id, int num_particles);
+
+    /**
+     * Handles all collisions using the kCellColored schedule
+     */
+    void HandleCellColoredCollisions();
+
+    /**
+     * Gets how many columns and rows of grid cells have one color
+     * @param color 0 to 8
+     * @param num_color_columns
+     * @param num_color_rows
+     */
+    void GetColorSize(int color, size_t& num_color_columns, size_t& num_color_rows) const;
+
+    /**
+     * Resolves the collisions in some of the cells of one color
+     * @param color 0 to 8
+     * @param begin_cell index of the first cell among the cells of the color
+     * @param end_cell one past the index of the last cell
+     * @param thread_index thread doing the work, for its buffers
+     */
+    void ResolveColorCells(int color, size_t begin_cell, size_t end_cell, size_t thread_index);
+
+    /**
+     * Grows every thread's collision buffers to the largest any thread has needed. Threads take
+     * whichever cells are next, so otherwise each one would keep growing its buffers, and
+     * allocating, until it happened to get the busiest cells.
+     */
+    void EqualizeScratchCapacity();
+
+    /**
+     * Handles all particle-particle collisions using the kNeighbourList schedule
+     */
+    void HandleNeighbourListCollisions();
+
+    /**
+     * Resolves the pairs in every particle's neighbour list, in the kSequential order
+     */
+    void ResolveNeighbourListPairs();
 
-    void GenerateWhiteParticles(int num_particles);
+    /**
+     * Resolves the grid's touching pairs using the kSequential schedule
+     */
+    void ResolveSequentialCollisions();
+
+    /**
+     * Zeroes every thread's collision counts and wall pass totals
+     */
+    void ResetScratch();
 
-    void GenerateBlueParticles(int num_particles);
+    /**
+     * Zeroes the wall impulses, speed range, energy and momentum of a thread or a chunk
+     * @param totals
+     */
+    static void ResetWallTotals(CollisionScratch& totals);
 
-    void GenerateRedParticles(int num_particles);
+    /**
+     * Bounces some particles off the walls, writes their speeds, and adds up their speed range,
+     * energy and momentum
+     * @param begin
+     * @param end
+     * @param totals where the wall impulses and the totals are added
+     */
+    void ReflectWallsRange(size_t begin, size_t end, CollisionScratch& totals);
+
+    /**
+     * Resolves every particle-particle collision, leaving the walls to the caller
+     */
+    void HandleParticleCollisions();
+
+    /**
+     * Runs a frame's collisions and integration as a task graph, for the kTaskGraph pipeline
+     */
+    void RunFrameGraph();
 
     /**
-     * Handles all collisions
+     * Builds the frame's task graph
+     * @param num_chunks chunks the particles are split into
      */
-    void HandleAllCollisions();
+    void BuildFrameGraph(size_t num_chunks);
 
     /**
-     * Will update histograms with new velocities, max and min velocities
+     * Runs one task of the frame's graph
+     * @param task
+     * @param thread_index thread running it, for its buffers
+     */
+    void RunFrameTask(size_t task, size_t thread_index);
+
+    /**
+     * Counts the last frame's speeds in the speed distribution, if the task graph left them to count.
+     * Const so the const getters can call it, but it writes to the mutable members, without a lock.
+     */
+    void CountPendingSpeeds() const;
+
+    /**
+     * Checks if any particle has moved more than half the skin since the neighbour lists were built
+     */
+    bool NeighbourListsNeedRebuild();
+
+    /**
+     * Builds every particle's neighbour list from the grid, and remembers the positions
+     */
+    void RebuildNeighbourLists();
+
+    /**
+     * Checks if two particles are close enough to be in each other's neighbour lists
+     * @param i
+     * @param j
+     */
+    bool IsNeighbour(size_t i, size_t j) const;
+
+    /**
+     * Adds a particle's pairs with its higher-index grid neighbours to the candidate pairs
+     * @param i index of the particle
+     * @param scratch buffers of the thread doing the check
+     */
+    void AppendCandidatePairs(size_t i, CollisionScratch& scratch) const;
+
+    /**
+     * Resolves every candidate pair that is touching, in order
+     * @param scratch buffers of the thread doing the check
+     */
+    void ResolveCandidatePairs(CollisionScratch& scratch);
+
+    /**
+     * Runs a task over [0, count) on the thread pool, or on this thread if there is none
+     * @param count number of indices
+     * @param task called as task(begin, end, thread_index) for each chunk
+     */
+    void ParallelFor(size_t count, const std::function<void(size_t, size_t, size_t)>& task);
+
+    /**
+     * Runs a task over every particle index with ParallelFor
+     * @param task called as task(begin, end, thread_index) for each chunk
+     */
+    void ForEachParticle(const std::function<void(size_t, size_t, size_t)>& task);
+
+    /**
+     * Runs a task graph on the thread pool, or its tasks in order on this thread if there is none
+     * @param graph
+     * @param task called as task(task_number, thread_index) for each task
+     */
+    void RunGraph(const TaskGraph& graph, const std::function<void(size_t, size_t)>& task);
+
+    /**
+     * Sets max_velocity_ and min_velocity_ from velocities_
+     */
+    void UpdateVelocityRange();
+
+    /**
+     * Adds up every thread's share of the observables, in thread order, and records the frame
+     */
+    void RecordObservables();
+
+    /**
+     * Copies the parts of the frame each subscriber asked for into its ring buffer, skipping
+     * subscribers whose buffer is full
+     */
+    void PublishFrame();
+
+    /**
+     * Sets the velocity range from the wall pass, counts the frame's speeds in the speed
+     * distribution, and marks the histograms as out of date
      */
     void UpdateHistograms();
+
+    /**
+     * Counts every particle's speed in its species' histogram, in one pass over the particles,
+     * or combines the speed distribution's frames into them if the window is more than 1 frame
+     */
+    void FillHistograms() const;
 };
 
 }  // namespace idealgas
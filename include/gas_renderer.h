@@ -0,0 +1,58 @@
+#pragma once
+
+#include "cinder/gl/gl.h"
+#include "event_driven_container.h"
+#include "gas_container.h"
+#include "histogram.h"
+#include "simulation_snapshot.h"
+
+namespace idealgas {
+
+using std::vector;
+using glm::vec2;
+
+/**
+ * Draws containers and their histograms with Cinder. The simulation classes only
+ * hold state, so this is the only part of the library that needs a window.
+ */
+class GasRenderer {
+ public:
+
+  /**
+   * Draws the container walls, the current positions of the particles and the histograms
+   * @param container
+   */
+  static void DrawContainer(const GasContainer& container);
+
+  /**
+   * Draws the container walls, the positions of the particles at the current frame
+   * and the histograms
+   * @param container
+   */
+  static void DrawContainer(const EventDrivenContainer& container);
+
+  /**
+   * Draws a frame captured from a container
+   * @param snapshot
+   */
+  static void DrawSnapshot(const SimulationSnapshot& snapshot);
+
+  /**
+   * Draws a histogram
+   * @param histogram
+   * @param corner bottom left corner of the histogram
+   */
+  static void DrawHistogram(const Histogram& histogram, const vec2& corner);
+
+ private:
+
+  /**
+   * Draws the particles, the walls around them and the histograms stacked down the left margin
+   */
+  static void DrawScene(const vector<float>& x, const vector<float>& y, const vector<float>& radius,
+                        const vector<int>& species, const SpeciesRegistry& species_registry,
+                        const vector<Histogram>& histograms, int length, int height, int margins_left,
+                        int margins_top);
+};
+
+}  // namespace idealgas
@@ -4,7 +4,9 @@
 #include "cinder/app/RendererGl.h"
 #include "cinder/gl/gl.h"
 #include "gas_container.h"
+#include "gas_renderer.h"
 #include "particle.h"
+#include "simulation_thread.h"
 
 namespace idealgas {
 
@@ -18,7 +20,6 @@ class IdealGasApp : public ci::app::App {
   IdealGasApp();
 
   void draw() override;
-  void update() override;
 
   /**
    * Used currently to pause the simulation on space press
@@ -31,7 +32,8 @@ class IdealGasApp : public ci::app::App {
   const int kMargin = 100;
 
  private:
-  GasContainer container_;
+  //runs the container off the render thread, so drawing never waits for a frame to simulate
+  SimulationThread simulation_;
 };
 
 }  // namespace idealgas
@@ -1,7 +1,10 @@
 #pragma once
 
-#include "cinder/gl/gl.h"
 #include "particle.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
 
 namespace idealgas {
 
@@ -42,27 +45,58 @@ class Histogram {
    */
   void Update(const vector<float>& new_velocities, float max_velocity, float min_velocity);
 
-  /**
-   * Draws the histogram
-   * @param corner bottom left corner of the histogram
-   */
-  void DrawHistogram(const vec2& corner) const;
-
   /**
    * Sets up the velocity_distribution
    */
   void SetUp();
 
   /**
-   * Gets the frequency of velocities and puts them in velocity_distribution_
+   * Counts the velocities into the bars
    */
   void FindVelocityDistribution();
 
+  /**
+   * Empties every bar and sets a new velocity range, keeping the bars' memory.
+   * Velocities are then counted one at a time with AddVelocity.
+   * @param max_velocity
+   * @param min_velocity
+   */
+  void Reset(float max_velocity, float min_velocity);
+
+  /**
+   * Counts one velocity in the bar it falls in. Velocities above the max velocity aren't counted.
+   * @param velocity
+   */
+  void AddVelocity(float velocity);
+
+  /**
+   * Adds to the height of one bar, to merge in velocities counted by another histogram
+   * with the same velocity range, e.g. on another process. The count can be fractional,
+   * e.g. when the bars are an average over several frames.
+   * @param bar
+   * @param count
+   */
+  void AddCount(int bar, double count);
+
   vector<float> GetVelocities();
 
   float GetBarRange();
 
-  vector<pair<int, int>> GetVelocityDistribution();
+  /**
+   * Gets each bar's number and height, rounded to a whole number of velocities
+   */
+  vector<pair<int, int>> GetVelocityDistribution() const;
+
+  /**
+   * Gets each bar's height, without rounding, for drawing
+   */
+  const vector<double>& GetBarHeights() const;
+
+  const string& GetColor() const;
+
+  int GetLength() const;
+
+  int GetHeight() const;
 
  private:
   string color_;
@@ -78,8 +112,15 @@ class Histogram {
   //the velocity range of each bar on the histogram
   float bar_range_;
 
-  //vector matching bar number to the number of velocities in it
-  vector<pair<int, int>> velocity_distribution_;
+  //the number of velocities in each bar, which is fractional when frames were averaged
+  vector<double> bar_heights_;
+
+  /**
+   * Gets the first bar whose top is at least the velocity, like walking the bars in order would
+   * @param velocity
+   * @return the bar, or num_segments_ if the velocity is above every bar
+   */
+  int GetBar(float velocity) const;
 
 };
 
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace idealgas {
+
+using std::vector;
+
+/**
+ * The thermodynamic state of the gas over one frame, or averaged over a window of frames.
+ * Times are in frames, and Boltzmann's constant is 1.
+ */
+struct FrameObservables {
+  //the last frame this covers, counting from 1
+  uint64_t frame;
+
+  //frames averaged together, 1 for a single frame
+  size_t num_frames;
+
+  double kinetic_energy;
+
+  //kinetic energy per particle, since a particle in 2D has two degrees of freedom
+  double temperature;
+
+  double momentum_x;
+  double momentum_y;
+
+  //momentum each wall took per frame, per unit of its length
+  double pressure_left;
+  double pressure_right;
+  double pressure_top;
+  double pressure_bottom;
+
+  //momentum every wall took per frame, per unit of the container's perimeter
+  double pressure;
+
+  //pairs of particles that bounced off each other per frame
+  double particle_collisions;
+
+  //bounces off a wall per frame
+  double wall_collisions;
+};
+
+/**
+ * Adds every observable but the frame numbers to a running total
+ * @param frame
+ * @param total
+ */
+void AddObservables(const FrameObservables& frame, FrameObservables& total);
+
+/**
+ * Divides every observable but the frame numbers by a count, to turn a total into an average
+ * @param total
+ * @param count
+ */
+void DivideObservables(FrameObservables& total, double count);
+
+/**
+ * The observables of the most recent frames, kept in a ring buffer so adding a frame
+ * never allocates
+ */
+class ObservablesHistory {
+ public:
+
+  /**
+   * ObservablesHistory constructor
+   * @param capacity most frames kept
+   * @throws invalid_argument if the capacity is 0
+   */
+  explicit ObservablesHistory(size_t capacity = kDefaultCapacity);
+
+  /**
+   * Adds a frame, dropping the oldest one if the history is full
+   * @param frame
+   */
+  void Add(const FrameObservables& frame);
+
+  /**
+   * Gets one of the frames kept
+   * @param frames_ago 0 for the latest frame
+   * @throws invalid_argument if that frame isn't kept
+   */
+  const FrameObservables& GetFrame(size_t frames_ago) const;
+
+  /**
+   * Averages the latest frames together, e.g. to smooth out the pressure
+   * @param num_frames how many of the latest frames to average
+   * @throws invalid_argument if num_frames is 0 or more than the frames kept
+   */
+  FrameObservables GetAverage(size_t num_frames) const;
+
+  /**
+   * Gets how many frames are kept
+   */
+  size_t Size() const;
+
+  size_t GetCapacity() const;
+
+  /**
+   * Drops every frame
+   */
+  void Clear();
+
+  static const size_t kDefaultCapacity = 1024;
+
+ private:
+  vector<FrameObservables> frames_;
+
+  //where the next frame goes, and how many frames are kept
+  size_t next_;
+  size_t size_;
+};
+
+}  // namespace idealgas
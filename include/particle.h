@@ -1,6 +1,11 @@
 #pragma once
 
-#include "cinder/gl/gl.h"
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <glm/glm.hpp>
+#include <string>
+#include <utility>
 
 namespace idealgas {
 
@@ -93,21 +98,28 @@ class Particle {
    */
   void InitializeParticle(int container_length, int container_height, int margins_left, int margins_top);
 
+  /**
+   * Picks a random position inside the container, outside the margins, and a random velocity
+   * from 4 random words, the way InitializeParticle does
+   * @param random_words the random words, one each for x, y, x velocity and y velocity
+   * @param radius radius of the particle, at least 1
+   * @param container_length must be more than 2 * radius
+   * @param container_height must be more than 2 * radius
+   * @param margins_left
+   * @param margins_top
+   * @param position set to the position
+   * @param velocity set to the velocity, each component between -radius / 2 and +radius / 2
+   */
+  static void GetRandomState(const std::array<uint32_t, 4>& random_words, float radius, int container_length,
+                             int container_height, int margins_left, int margins_top, vec2& position,
+                             vec2& velocity);
+
   /**
    * Makes a copy of this particle
    * @return the copy
    */
   Particle Copy();
 
-  void DrawParticle() const;
-
- private:
-  vec2 position_;
-  vec2 velocity_;
-  string color_;
-  float mass_;
-  float radius_;
-
   /**
    * Calculates a particle's new velocity after a collision
    * @param velocity1 particle 1 velocity
@@ -116,10 +128,30 @@ class Particle {
    * @param position2 particle 2 position
    * @param mass1 particle 1 mass
    * @param mass2 particle 2 mass
-   * @return a vector of this particle's new velocity
+   * @return a vector of particle 1's new velocity
    */
-  vec2 GetNewVelocity(const vec2& velocity1, const vec2& velocity2, const vec2& position1,
-                      const vec2& position2, const float& mass1, const float& mass2);
+  static vec2 GetNewVelocity(const vec2& velocity1, const vec2& velocity2, const vec2& position1,
+                             const vec2& position2, const float& mass1, const float& mass2);
+
+  /**
+   * Calculates a particle's new velocity after a collision, given the precomputed
+   * mass factor 2 * mass2 / (mass1 + mass2)
+   * @param velocity1 particle 1 velocity
+   * @param velocity2 particle 2 velocity
+   * @param position1 particle 1 position
+   * @param position2 particle 2 position
+   * @param coefficient the mass factor for particle 1 colliding with particle 2
+   * @return a vector of particle 1's new velocity
+   */
+  static vec2 GetNewVelocity(const vec2& velocity1, const vec2& velocity2, const vec2& position1,
+                             const vec2& position2, float coefficient);
+
+ private:
+  vec2 position_;
+  vec2 velocity_;
+  string color_;
+  float mass_;
+  float radius_;
 
 };
 
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "particle_store.h"
+#include "philox.h"
+#include <cstdint>
+#include <vector>
+
+namespace idealgas {
+
+using std::vector;
+
+/**
+ * How generated particles are placed in the container
+ */
+enum class Placement {
+  //uniformly random positions, which can overlap, like InitializeParticle
+  kRandom,
+  //one particle per site of a square lattice, shifted randomly within its site
+  kJitteredLattice,
+  //random positions, each rejected and drawn again if it overlaps an already placed particle
+  kPoissonDisk
+};
+
+/**
+ * Places particles so no two of them overlap, for starting dense gases without a burst
+ * of spurious collisions. Positions are drawn from a counter-based generator, so the same
+ * seed always gives the same placement.
+ */
+class ParticlePlacer {
+ public:
+
+  /**
+   * ParticlePlacer constructor
+   * @param min_x left wall of the container
+   * @param min_y top wall of the container
+   * @param width width of the container
+   * @param height height of the container
+   * @param rng generator the positions are drawn from
+   */
+  ParticlePlacer(float min_x, float min_y, float width, float height, const Philox& rng);
+
+  /**
+   * Moves every particle to a position inside the walls. Velocities are not changed.
+   * @param placement kRandom leaves the particles where they are
+   * @param particles
+   * @throws invalid_argument if the particles don't fit
+   */
+  void Place(Placement placement, ParticleStore& particles) const;
+
+  /**
+   * Gives every particle its own random site of a square lattice sized from the largest
+   * radius, and a random offset that keeps it inside the site. Fits area fractions up to
+   * pi / 4 times the mean particle area over the largest one's.
+   * @param particles
+   * @throws invalid_argument if the lattice sites are smaller than the largest particle
+   */
+  void PlaceOnJitteredLattice(ParticleStore& particles) const;
+
+  /**
+   * Places particles one at a time, largest species first, at random positions that
+   * don't overlap the ones already placed. Positions are drawn in a random grid cell,
+   * and a cell stops being drawn from once kMissesPerCell positions in a row missed in it.
+   * @param particles
+   * @throws invalid_argument if every cell is full before every particle is placed
+   */
+  void PlacePoissonDisk(ParticleStore& particles) const;
+
+ private:
+  float min_x_;
+  float min_y_;
+  float width_;
+  float height_;
+  Philox rng_;
+
+  //counter streams, so each use of the generator gets its own random numbers
+  static const uint64_t kShuffleStream = 1;
+  static const uint64_t kJitterStream = 2;
+  static const uint64_t kDartStream = 3;
+
+  //positions that must miss in a row before a cell counts as full
+  static const int kMissesPerCell = 16;
+
+  //most grid cells per particle, so a dilute gas doesn't make a huge grid
+  static const size_t kMaxCellsPerParticle = 4;
+
+  //cells are numbered in square tiles of kTileCells x kTileCells, so the cells around a
+  //position are close together in memory
+  static const uint32_t kTileCells = 16;
+  static const uint32_t kCellsPerTile = kTileCells * kTileCells;
+
+  /**
+   * A particle placed by PlacePoissonDisk
+   */
+  struct PlacedParticle {
+    float x;
+    float y;
+    float radius;
+
+    //index in PlacementGrid::placed of the next particle in the same cell, or -1
+    int32_t next_in_cell;
+  };
+
+  /**
+   * The particles placed so far, in a list per cell
+   */
+  struct PlacementGrid {
+    int num_columns;
+    int num_rows;
+    int num_tile_columns;
+
+    //index in placed of the last particle placed in each cell, or -1
+    vector<int32_t> cell_heads;
+
+    //placed particles, in the order they were placed
+    vector<PlacedParticle> placed;
+
+    /**
+     * Gets the number of the cell at a column and row
+     */
+    uint32_t GetCell(int column, int row) const;
+
+    /**
+     * Gets the column and row of a cell number
+     */
+    void GetColumnAndRow(uint32_t cell, int& column, int& row) const;
+  };
+
+  /**
+   * Checks if a particle at a position would overlap any particle already placed
+   * @param grid
+   * @param x
+   * @param y
+   * @param radius
+   * @param column column of the cell the position is in
+   * @param row row of the cell the position is in
+   * @return if it overlaps
+   */
+  bool Overlaps(const PlacementGrid& grid, float x, float y, float radius, int column, int row) const;
+
+  /**
+   * Checks if a particle at a position would overlap any particle already placed in one cell
+   * @param grid
+   * @param cell
+   * @param x
+   * @param y
+   * @param radius
+   * @return if it overlaps
+   */
+  bool OverlapsCell(const PlacementGrid& grid, uint32_t cell, float x, float y, float radius) const;
+};
+
+}  // namespace idealgas
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "particle.h"
+#include "philox.h"
+#include "species_registry.h"
+#include <array>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace idealgas {
+
+using std::vector;
+
+/**
+ * Structure-of-arrays storage for all of the particles in a container, in any number of
+ * dimensions and at any precision. Each property lives in its own contiguous array, and
+ * each axis of the positions and velocities in its own array too, indexed by particle, so
+ * the simulation loops only stream the data they actually touch.
+ *
+ * Only BasicParticleStore<2, float>, <2, double>, <3, float> and <3, double> are compiled, in
+ * particle_store.cc. The members that take or give Particle values only exist for ParticleStore,
+ * the 2D float store, since a Particle is one.
+ */
+template <glm::length_t D, typename T>
+struct BasicParticleStore {
+  typedef glm::vec<D, T> Vector;
+
+  BasicParticleStore();
+
+  /**
+   * Builds a store holding copies of the given particles, in the same order
+   * @param particles the particles to store
+   */
+  explicit BasicParticleStore(const vector<Particle>& particles);
+
+  /**
+   * Appends a particle to the end of every array, registering its species if needed
+   * @param particle the particle to add
+   */
+  void Add(const Particle& particle);
+
+  /**
+   * Appends a particle of an already registered species to the end of every array
+   * @param species_id
+   * @param position
+   * @param velocity
+   */
+  void Add(int species_id, const Vector& position, const Vector& velocity);
+
+  /**
+   * Overwrites one particle with a particle of an already registered species
+   * @param index
+   * @param species_id
+   * @param position
+   * @param velocity
+   */
+  void Set(size_t index, int species_id, const Vector& position, const Vector& velocity);
+
+  /**
+   * Reserves room for this many particles in every array
+   * @param num_particles
+   */
+  void Reserve(size_t num_particles);
+
+  /**
+   * Grows or shrinks every array to this many particles. New particles are all zero,
+   * with species id 0, for the caller to fill in.
+   * @param num_particles
+   */
+  void Resize(size_t num_particles);
+
+  size_t Size() const;
+
+  Vector GetPosition(size_t index) const;
+
+  Vector GetVelocity(size_t index) const;
+
+  void SetVelocity(size_t index, const Vector& velocity);
+
+  /**
+   * Builds a Particle value holding the current state of one particle
+   * @param index index of the particle
+   * @return the particle
+   */
+  Particle GetParticle(size_t index) const;
+
+  /**
+   * Picks a random position inside a box, at least a radius from its walls, and a random
+   * velocity, from 2 * D random words: one per axis of the position, then one per axis of
+   * the velocity
+   * @param random_words
+   * @param particle_radius radius of the particle, at least 1
+   * @param lower lowest corner of the box
+   * @param size length of each side, each more than 2 * particle_radius
+   * @param particle_position set to the position
+   * @param particle_velocity set to the velocity, each component between -radius / 2 and +radius / 2
+   */
+  static void GetRandomState(const uint32_t* random_words, T particle_radius, const Vector& lower,
+                             const Vector& size, Vector& particle_position, Vector& particle_velocity);
+
+  /**
+   * Picks a random state like GetRandomState, from the random words of one particle: the
+   * blocks of its index, 4 words per block
+   * @param rng
+   * @param index the particle's index in the random number stream
+   * @param particle_radius
+   * @param lower
+   * @param size
+   * @param particle_position
+   * @param particle_velocity
+   */
+  static void GetRandomState(const Philox& rng, uint64_t index, T particle_radius, const Vector& lower,
+                             const Vector& size, Vector& particle_position, Vector& particle_velocity);
+
+  //each axis of every particle's position and velocity, by axis then particle index
+  std::array<vector<T>, D> position;
+  std::array<vector<T>, D> velocity;
+
+  //copies of each particle's species mass and radius, for the hot loops
+  vector<T> mass;
+  vector<T> radius;
+
+  //species id of each particle
+  vector<int> species;
+
+  SpeciesRegistry species_registry;
+};
+
+typedef BasicParticleStore<2, float> ParticleStore;
+
+template <>
+ParticleStore::BasicParticleStore(const vector<Particle>& particles);
+
+template <>
+void ParticleStore::Add(const Particle& particle);
+
+template <>
+Particle ParticleStore::GetParticle(size_t index) const;
+
+extern template struct BasicParticleStore<2, float>;
+extern template struct BasicParticleStore<2, double>;
+extern template struct BasicParticleStore<3, float>;
+extern template struct BasicParticleStore<3, double>;
+
+}  // namespace idealgas
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace idealgas {
+
+/**
+ * Philox4x32-10 counter-based random number generator. Each 128 bit counter is
+ * hashed with a 64 bit key into 4 random 32 bit words, so any block can be made
+ * on its own without stepping through the ones before it. That lets every
+ * particle get its random numbers from its own index, on whichever thread.
+ */
+class Philox {
+ public:
+
+  /**
+   * Philox constructor
+   * @param seed the key every block is made with
+   */
+  explicit Philox(uint64_t seed);
+
+  uint64_t GetSeed() const;
+
+  /**
+   * Makes the random block of one counter
+   * @param index low 64 bits of the counter, e.g. a particle index
+   * @param stream high 64 bits of the counter, to get more than one block per index
+   * @return 4 random words
+   */
+  std::array<uint32_t, 4> GetBlock(uint64_t index, uint64_t stream = 0) const;
+
+  /**
+   * Runs the 10 Philox rounds on a counter
+   * @param counter
+   * @param key
+   * @return 4 random words
+   */
+  static std::array<uint32_t, 4> Generate(const std::array<uint32_t, 4>& counter,
+                                          const std::array<uint32_t, 2>& key);
+
+  /**
+   * Maps a random word to a float in [0, 1)
+   * @param word
+   * @return the float
+   */
+  static float ToUnitFloat(uint32_t word);
+
+  static const int kRounds = 10;
+
+ private:
+  uint64_t seed_;
+  std::array<uint32_t, 2> key_;
+};
+
+}  // namespace idealgas
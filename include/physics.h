@@ -0,0 +1,69 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace idealgas {
+
+/**
+ * Gets how much of the change in velocity particle 1 takes in a collision with particle 2,
+ * 2 * mass2 / (mass1 + mass2)
+ * @param mass1
+ * @param mass2
+ */
+template <typename T>
+T GetCollisionCoefficient(T mass1, T mass2) {
+  return (2 * mass2) / (mass1 + mass2);
+}
+
+/**
+ * Calculates a particle's new velocity after an elastic collision, in any number of dimensions
+ * @param velocity1 particle 1 velocity
+ * @param velocity2 particle 2 velocity
+ * @param position1 particle 1 position
+ * @param position2 particle 2 position
+ * @param coefficient from GetCollisionCoefficient(mass1, mass2)
+ * @return particle 1's new velocity
+ */
+template <glm::length_t D, typename T>
+glm::vec<D, T> GetVelocityAfterCollision(const glm::vec<D, T>& velocity1, const glm::vec<D, T>& velocity2,
+                                         const glm::vec<D, T>& position1, const glm::vec<D, T>& position2,
+                                         T coefficient) {
+  return velocity1 - (coefficient * (glm::dot((velocity1 - velocity2), (position1 - position2))
+                       / (glm::length(position1 - position2) * glm::length(position1 - position2))))
+                      * (position1 - position2);
+}
+
+/**
+ * Reverses a velocity along one axis, as bouncing off a wall across that axis does
+ * @param velocity
+ * @param axis 0 for x, 1 for y, 2 for z
+ */
+template <glm::length_t D, typename T>
+void ReflectAxis(glm::vec<D, T>& velocity, glm::length_t axis) {
+  velocity[axis] = -velocity[axis];
+}
+
+/**
+ * Bounces a particle off every wall it is touching and moving towards, one axis at a time
+ * @param position
+ * @param velocity
+ * @param radius
+ * @param lower the walls at the low end of each axis
+ * @param upper the walls at the high end of each axis
+ * @return how many walls the particle bounced off
+ */
+template <glm::length_t D, typename T>
+int ReflectOffWalls(const glm::vec<D, T>& position, glm::vec<D, T>& velocity, T radius,
+                    const glm::vec<D, T>& lower, const glm::vec<D, T>& upper) {
+  int num_bounces = 0;
+  for (glm::length_t axis = 0; axis < D; axis++) {
+    if ((position[axis] - radius <= lower[axis] && velocity[axis] < 0) ||
+        (position[axis] + radius >= upper[axis] && velocity[axis] > 0)) {
+      ReflectAxis(velocity, axis);
+      num_bounces++;
+    }
+  }
+  return num_bounces;
+}
+
+}  // namespace idealgas
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace idealgas {
+
+using std::vector;
+using std::string;
+
+/**
+ * Timing statistics of one phase, over the samples still in the profiler's buffers
+ */
+struct PhaseStats {
+  string name;
+  size_t count;
+  double mean_ms;
+  double p50_ms;
+  double p99_ms;
+  double max_ms;
+};
+
+/**
+ * Collects how long each phase of the simulation takes. Every thread records into a
+ * buffer of its own, so timers on different threads never wait on each other, and each
+ * buffer keeps only its most recent kEventsPerThread timings so the statistics roll.
+ *
+ * The timers in the simulation are IDEALGAS_PROFILE_SCOPE macros, which are compiled
+ * out unless IDEALGAS_PROFILING is defined.
+ */
+class Profiler {
+ public:
+
+  /**
+   * Gets the profiler every timer in the program records into
+   */
+  static Profiler& GetInstance();
+
+  Profiler(const Profiler&) = delete;
+
+  Profiler& operator=(const Profiler&) = delete;
+
+  /**
+   * Gets the time in nanoseconds since the profiler was created
+   */
+  int64_t Now() const;
+
+  /**
+   * Records one timing in the calling thread's buffer, overwriting its oldest if it is full
+   * @param name name of the phase, which must outlive the profiler, e.g. a string literal
+   * @param start_ns from Now()
+   * @param end_ns from Now()
+   */
+  void Record(const char* name, int64_t start_ns, int64_t end_ns);
+
+  /**
+   * Gets the statistics of every phase recorded, by name
+   */
+  vector<PhaseStats> GetStats() const;
+
+  /**
+   * Writes every timing still in the buffers as a Chrome trace_event JSON file, which
+   * chrome://tracing and Perfetto can open
+   * @param path
+   * @throws runtime_error if the file can't be written
+   */
+  void WriteChromeTrace(const string& path) const;
+
+  /**
+   * Empties every thread's buffer
+   */
+  void Clear();
+
+  //timings each thread keeps
+  static const size_t kEventsPerThread = 1 << 14;
+
+ private:
+  /**
+   * One timed scope
+   */
+  struct Event {
+    const char* name;
+    int64_t start_ns;
+    int64_t end_ns;
+  };
+
+  /**
+   * The timings of one thread. Only the reader and that thread ever take the lock, so
+   * it is almost never contended.
+   */
+  struct ThreadBuffer {
+    size_t thread_index;
+    std::mutex mutex;
+    vector<Event> events;
+
+    //where the next timing goes, and how many timings have been recorded in total
+    size_t next;
+    size_t num_recorded;
+  };
+
+  int64_t epoch_ns_;
+
+  mutable std::mutex buffers_mutex_;
+
+  //every thread's buffer, kept after the thread exits so its timings can still be read
+  vector<std::shared_ptr<ThreadBuffer>> buffers_;
+
+  Profiler();
+
+  /**
+   * Gets the calling thread's buffer, making it the first time
+   */
+  ThreadBuffer& GetThreadBuffer();
+
+  /**
+   * Copies every timing still in the buffers, with the index of the thread that recorded it
+   */
+  void CopyEvents(vector<Event>& events, vector<size_t>& thread_indices) const;
+};
+
+/**
+ * Records the time from its construction to its destruction as one timing of a phase
+ */
+class ScopedTimer {
+ public:
+
+  /**
+   * ScopedTimer constructor
+   * @param name name of the phase, e.g. a string literal
+   */
+  explicit ScopedTimer(const char* name);
+
+  ~ScopedTimer();
+
+  ScopedTimer(const ScopedTimer&) = delete;
+
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+ private:
+  const char* name_;
+  int64_t start_ns_;
+};
+
+}  // namespace idealgas
+
+#define IDEALGAS_PROFILE_CONCAT_INNER(first, second) first##second
+#define IDEALGAS_PROFILE_CONCAT(first, second) IDEALGAS_PROFILE_CONCAT_INNER(first, second)
+
+#ifdef IDEALGAS_PROFILING
+//times the rest of the enclosing scope as one timing of the named phase
+#define IDEALGAS_PROFILE_SCOPE(name) \
+  ::idealgas::ScopedTimer IDEALGAS_PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#else
+#define IDEALGAS_PROFILE_SCOPE(name) static_cast<void>(0)
+#endif
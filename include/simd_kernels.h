@@ -0,0 +1,184 @@
+#pragma once
+
+#include "particle_store.h"
+#include <cstdint>
+
+namespace idealgas {
+
+using std::vector;
+
+/**
+ * The instruction sets the simulation kernels can run on
+ */
+enum class SimdLevel {
+  kScalar,
+  kSse2,
+  kAvx2
+};
+
+/**
+ * The walls of a container, as coordinates
+ */
+struct WallBounds {
+  float left;
+  float right;
+  float top;
+  float bottom;
+};
+
+/**
+ * The momentum particles gave each wall by bouncing off it, added up over a wall pass
+ */
+struct WallImpulses {
+  double left;
+  double right;
+  double top;
+  double bottom;
+
+  //bounces off any wall. A particle in a corner bounces off two walls at once, and counts twice.
+  size_t num_bounces;
+};
+
+/**
+ * What a wall pass found over one container's particles
+ */
+struct WallPassTotals {
+  WallImpulses wall_impulses;
+  double kinetic_energy;
+  double momentum_x;
+  double momentum_y;
+
+  //infinity and -infinity if the container has no particles
+  float min_speed;
+  float max_speed;
+};
+
+/**
+ * The particles of several small containers, interleaved so that one vector of lanes holds
+ * one particle of each container. A wall pass over a container of a few dozen particles is
+ * mostly the leftover particles that don't fill a vector; interleaved, every vector is full.
+ * Particle k of the container in lane l is at index k * kNumLanes + l of each array. Slots
+ * past a container's last particle are all zero, so they never touch a wall.
+ */
+struct MemberLanes {
+
+  /**
+   * MemberLanes constructor
+   * @param num_slots particles of the largest container the lanes will hold
+   */
+  explicit MemberLanes(size_t num_slots = 0);
+
+  size_t NumSlots() const;
+
+  //containers are laid out one per lane, up to an AVX2 vector of floats
+  static const size_t kNumLanes = 8;
+
+  vector<float> x;
+  vector<float> y;
+  vector<float> vx;
+  vector<float> vy;
+  vector<float> mass;
+  vector<float> radius;
+  vector<float> speeds;
+
+  //per lane: how many particles the lane's container has, its walls, and what the last wall pass found
+  int32_t sizes[kNumLanes];
+  float left[kNumLanes];
+  float right[kNumLanes];
+  float top[kNumLanes];
+  float bottom[kNumLanes];
+  WallPassTotals totals[kNumLanes];
+};
+
+/**
+ * Vectorised versions of the per-frame particle loops, with the instruction set
+ * picked at runtime. Every level gives bit-identical results to the scalar code.
+ */
+class SimdKernels {
+ public:
+
+  /**
+   * SimdKernels constructor
+   * @param level the instruction set to use, lowered to the best one this CPU supports
+   */
+  explicit SimdKernels(SimdLevel level = GetBestSimdLevel());
+
+  /**
+   * Gets the best instruction set this CPU supports
+   */
+  static SimdLevel GetBestSimdLevel();
+
+  SimdLevel GetLevel() const;
+
+  /**
+   * Moves particles [begin, end) by their velocities
+   * @param particles
+   * @param begin
+   * @param end
+   */
+  void Integrate(ParticleStore& particles, size_t begin, size_t end) const;
+
+  /**
+   * Bounces particles [begin, end) off any walls they are touching and moving towards,
+   * and writes their speeds afterwards
+   * @param particles
+   * @param begin
+   * @param end
+   * @param walls
+   * @param speeds speed of each particle, by particle index
+   * @param impulses each bounce's momentum is added to its wall, in particle order, so every level adds up the same
+   */
+  void ReflectWalls(ParticleStore& particles, size_t begin, size_t end, const WallBounds& walls,
+                    float* speeds, WallImpulses& impulses) const;
+
+  /**
+   * Does ReflectWalls and then Integrate for every container in the lanes at once, and adds
+   * up each lane's totals. Each lane gets bit-identical results to running those on its
+   * container alone. Only kAvx2 has a vectorised version; the other levels run the scalar code.
+   * @param lanes
+   */
+  void ReflectAndIntegrateLanes(MemberLanes& lanes) const;
+
+  /**
+   * Keeps the candidate pairs whose particles are touching, in their original order
+   * @param particles
+   * @param first first particle of each candidate pair
+   * @param second second particle of each candidate pair
+   * @param count number of candidate pairs
+   * @param colliding_first filled with the first particle of each touching pair
+   * @param colliding_second filled with the second particle of each touching pair
+   */
+  void FindCollidingPairs(const ParticleStore& particles, const vector<uint32_t>& first,
+                          const vector<uint32_t>& second, size_t count, vector<uint32_t>& colliding_first,
+                          vector<uint32_t>& colliding_second) const;
+
+  /**
+   * Resolves collisions between touching pairs as if one pair was handled at a time,
+   * in order. Runs of pairs that share no particles are resolved together.
+   * @param particles
+   * @param first first particle of each pair
+   * @param second second particle of each pair
+   * @param count number of pairs
+   * @return how many of the pairs were moving towards each other, and so bounced
+   */
+  size_t ResolveCollidingPairs(ParticleStore& particles, const vector<uint32_t>& first,
+                               const vector<uint32_t>& second, size_t count) const;
+
+ private:
+  SimdLevel level_;
+
+  //most pairs resolved together, small enough that checking for shared particles stays cheap
+  static const size_t kMaxBatchPairs = 16;
+
+  /**
+   * Resolves a batch of pairs that share no particles
+   * @param particles
+   * @param first first particle of each pair
+   * @param second second particle of each pair
+   * @param count number of pairs
+   * @return how many of the pairs bounced
+   */
+  size_t ResolveBatch(ParticleStore& particles, const uint32_t* first, const uint32_t* second, size_t count) const;
+};
+
+}  // namespace idealgas
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "event_driven_container.h"
+#include "gas_container.h"
+#include "histogram.h"
+#include "species_registry.h"
+#include "speed_distribution.h"
+#include <vector>
+
+namespace idealgas {
+
+using std::vector;
+
+/**
+ * A copy of everything needed to draw one frame of a container, so it can be
+ * drawn on one thread while the simulation carries on in another.
+ */
+struct SimulationSnapshot {
+
+  SimulationSnapshot();
+
+  /**
+   * Copies the drawable state of a container, reusing this snapshot's memory. Call it on
+   * the thread that advances the container, since reading its speed counts can update them.
+   * @param container
+   */
+  void Capture(const GasContainer& container);
+
+  /**
+   * Copies the drawable state of a container, reusing this snapshot's memory
+   * @param container
+   */
+  void Capture(const EventDrivenContainer& container);
+
+  //the particles, by particle index
+  vector<float> x;
+  vector<float> y;
+  vector<float> radius;
+  vector<int> species;
+
+  SpeciesRegistry species_registry;
+
+  //the latest frames' raw speed counts, so the histograms are only built on the thread that
+  //draws them, and only when it does
+  SpeedDistribution speed_distribution;
+  size_t histogram_window;
+  DistributionView histogram_view;
+
+  //one histogram per species, by species id, from containers that build their own every frame
+  //instead of keeping speed counts
+  vector<Histogram> histograms;
+
+  int length;
+  int height;
+  int margins_left;
+  int margins_top;
+
+  //how many frames had been simulated when this was captured
+  size_t frame;
+
+  /**
+   * Builds one histogram per species, by species id, laid out like the container's. With speed
+   * counts, the bars combine the latest histogram_window frames in the speed distribution's
+   * bins, even for a window of 1 frame, so the speed axis stays put from frame to frame.
+   * Without them, the captured histograms are copied.
+   * @param result replaced with the histograms, reusing its memory
+   */
+  void BuildHistograms(vector<Histogram>& result) const;
+
+ private:
+
+  /**
+   * Copies the particles and geometry of a container
+   */
+  template <typename Container>
+  void CaptureState(const Container& container);
+};
+
+}  // namespace idealgas
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "gas_container.h"
+#include "simulation_snapshot.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace idealgas {
+
+/**
+ * Runs a container on its own thread and publishes a snapshot after every frame
+ * through a triple buffer. One other thread can read the latest snapshot at any
+ * time without waiting for the simulation, and the simulation never waits for it.
+ */
+class SimulationThread {
+ public:
+
+  /**
+   * SimulationThread constructor. Starts simulating straight away.
+   * @param container the container to simulate
+   * @param frames_per_second most frames to simulate per second, or 0 to run as fast as possible
+   */
+  explicit SimulationThread(const GasContainer& container, double frames_per_second = kDefaultFramesPerSecond);
+
+  /**
+   * Stops the simulation and waits for its current frame to finish
+   */
+  ~SimulationThread();
+
+  SimulationThread(const SimulationThread&) = delete;
+
+  SimulationThread& operator=(const SimulationThread&) = delete;
+
+  /**
+   * Gets the newest snapshot. Only one thread may call this.
+   * @return the snapshot, which stays unchanged until the next call
+   */
+  const SimulationSnapshot& GetLatestSnapshot();
+
+  bool GetPaused() const;
+
+  /**
+   * Pauses or resumes the simulation. A paused simulation sleeps until resumed.
+   * @param paused
+   */
+  void SetPaused(bool paused);
+
+  //the frame rate the window app runs at
+  static constexpr double kDefaultFramesPerSecond = 60;
+
+ private:
+  GasContainer container_;
+
+  //time between frames, or zero when not limited
+  std::chrono::steady_clock::duration frame_period_;
+
+  //the three snapshot slots, one being written, one being read and one waiting to be read
+  SimulationSnapshot snapshots_[3];
+
+  //slot being written, only used by the simulation thread
+  int writing_;
+
+  //slot being read, only used by the reading thread
+  int reading_;
+
+  //the waiting slot, plus kFreshSnapshot if it is newer than the one being read
+  std::atomic<int> waiting_;
+
+  static const int kFreshSnapshot = 4;
+  static const int kSlotMask = 3;
+
+  mutable std::mutex mutex_;
+  std::condition_variable state_changed_;
+  bool paused_;
+  bool stopping_;
+
+  std::thread thread_;
+
+  /**
+   * Simulates frames until the object is destroyed
+   */
+  void Run();
+
+  /**
+   * Copies the container into the slot being written and swaps it with the waiting slot
+   * @param frame number of frames simulated so far
+   */
+  void Publish(size_t frame);
+};
+
+}  // namespace idealgas
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "transport.h"
+#include <memory>
+
+namespace idealgas {
+
+using std::vector;
+
+/**
+ * A Transport over Unix domain sockets, for running the ranks of a distributed
+ * simulation as processes or threads on one machine. Every pair of ranks gets its
+ * own connected socket pair, made up front by CreateGroup.
+ */
+class SocketTransport : public Transport {
+ public:
+
+  /**
+   * Connects every pair of a group of ranks. To run each rank in its own process, create
+   * the group and then fork once per rank, with each child keeping only its own transport.
+   * @param num_ranks
+   * @return one transport per rank, by rank
+   * @throws runtime_error if the sockets can't be made, or on Windows
+   */
+  static vector<std::shared_ptr<SocketTransport>> CreateGroup(int num_ranks);
+
+  ~SocketTransport() override;
+
+  SocketTransport(const SocketTransport&) = delete;
+
+  SocketTransport& operator=(const SocketTransport&) = delete;
+
+  int GetRank() const override;
+
+  int GetNumRanks() const override;
+
+  /**
+   * Sends and receives every message at once, writing whatever each socket has room for
+   * while reading whatever has arrived, so big messages never fill both sides' buffers.
+   * Each message is sent as its size followed by its bytes.
+   */
+  void Exchange(const vector<int>& ranks, const vector<vector<uint8_t>>& outgoing,
+                vector<vector<uint8_t>>& incoming) override;
+
+ private:
+  int rank_;
+
+  //socket connected to each rank, by rank, or -1 for this rank
+  vector<int> sockets_;
+
+  /**
+   * SocketTransport constructor
+   * @param rank
+   * @param sockets socket connected to each rank, by rank
+   */
+  SocketTransport(int rank, const vector<int>& sockets);
+};
+
+}  // namespace idealgas
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "simulation_snapshot.h"
+#include "thread_pool.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace idealgas {
+
+using std::string;
+using std::vector;
+
+/**
+ * An 8-bit RGBA color
+ */
+struct Rgba {
+  uint8_t r;
+  uint8_t g;
+  uint8_t b;
+  uint8_t a;
+};
+
+/**
+ * Draws snapshots into an RGBA framebuffer on the CPU, so runs can be turned into
+ * image sequences without a GPU or a window. The image is split into square tiles
+ * that are drawn in parallel, and each tile draws its particles one species at a time.
+ */
+class SoftwareRenderer {
+ public:
+
+  /**
+   * SoftwareRenderer constructor
+   * @param width width of the image in pixels
+   * @param height height of the image in pixels
+   * @param num_threads threads to draw tiles on, including the one calling Render
+   */
+  SoftwareRenderer(int width, int height, size_t num_threads = 1);
+
+  /**
+   * Draws the particles, the container walls and the histograms of a snapshot. The
+   * container and its margins are scaled to fit the image.
+   * @param snapshot
+   */
+  void Render(const SimulationSnapshot& snapshot);
+
+  int GetWidth() const;
+
+  int GetHeight() const;
+
+  /**
+   * Gets the image, as rows of RGBA pixels from the top left
+   */
+  const vector<uint8_t>& GetPixels() const;
+
+  /**
+   * Gets the color of one pixel
+   * @param x
+   * @param y
+   */
+  Rgba GetPixel(int x, int y) const;
+
+  /**
+   * Writes the image as a binary PPM, without alpha
+   * @param path
+   */
+  void WritePpm(const string& path) const;
+
+  /**
+   * Writes the image as an RGBA PNG, stored without compression
+   * @param path
+   */
+  void WritePng(const string& path) const;
+
+  /**
+   * Writes the image as a PNG or PPM, picked by the path's extension
+   * @param path ending in .png or .ppm
+   */
+  void WriteImage(const string& path) const;
+
+  /**
+   * Gets the path of one image in a sequence, with the frame number before the extension
+   * @param path for example "frames/run.png"
+   * @param frame
+   * @return for example "frames/run_000042.png"
+   */
+  static string GetFramePath(const string& path, size_t frame);
+
+  /**
+   * Gets the color of a species from its name, falling back to white for unknown names
+   * @param name
+   */
+  static Rgba GetNamedColor(const string& name);
+
+ private:
+  int width_;
+  int height_;
+
+  //RGBA, row by row
+  vector<uint8_t> pixels_;
+
+  //threads shared by the tiles, or null when drawing on one thread
+  std::shared_ptr<ThreadPool> thread_pool_;
+
+  int num_tile_columns_;
+  int num_tile_rows_;
+
+  //particle indices grouped by species, so each tile draws one species at a time
+  vector<uint32_t> species_order_;
+  vector<size_t> species_starts_;
+
+  //tile_starts_[t] to tile_starts_[t + 1] is the range of tile t in tile_particles_
+  vector<size_t> tile_starts_;
+  vector<uint32_t> tile_particles_;
+  vector<size_t> next_slots_;
+
+  //the color of each species in the snapshot being drawn
+  vector<Rgba> species_colors_;
+
+  //the histograms of the snapshot being drawn, built once per frame rather than per tile
+  vector<Histogram> histograms_;
+
+  //pixels per unit of the snapshot's coordinates
+  float scale_;
+
+  static const int kTileSize = 64;
+
+  /**
+   * Sorts the particles by species, then lists every tile each particle's circle touches
+   * @param snapshot
+   */
+  void BinParticles(const SimulationSnapshot& snapshot);
+
+  /**
+   * Gets the range of tiles a box covers, clamped to the image
+   */
+  void GetTileRange(float min_x, float min_y, float max_x, float max_y, int& first_column, int& first_row,
+                    int& last_column, int& last_row) const;
+
+  /**
+   * Draws everything that touches one tile
+   * @param snapshot
+   * @param tile
+   */
+  void RenderTile(const SimulationSnapshot& snapshot, size_t tile);
+
+  /**
+   * Fills the pixels whose centers are inside a rectangle, clipped to a tile
+   */
+  void FillRect(float x0, float y0, float x1, float y1, const Rgba& color, int tile_x0, int tile_y0, int tile_x1,
+                int tile_y1);
+
+  /**
+   * Draws the one pixel wide outline just inside a rectangle, clipped to a tile
+   */
+  void StrokeRect(float x0, float y0, float x1, float y1, const Rgba& color, int tile_x0, int tile_y0,
+                  int tile_x1, int tile_y1);
+
+  /**
+   * Fills the pixels whose centers are inside a circle, clipped to a tile.
+   * Circles smaller than a pixel still cover the pixel their center is in.
+   */
+  void FillCircle(float center_x, float center_y, float radius, const Rgba& color, int tile_x0, int tile_y0,
+                  int tile_x1, int tile_y1);
+};
+
+}  // namespace idealgas
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "particle_store.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace idealgas {
+
+using std::vector;
+
+/**
+ * Uniform grid broadphase over a box, in any number of dimensions and at any precision.
+ * Particles are bucketed into square cells sized from the largest particle radius, so any
+ * two particles that can touch are always in the same or neighbouring cells: the 3^D cells
+ * around a particle's. Cells are numbered along the first axis fastest, so the neighbouring
+ * cells along it, which this calls a row, are next to each other in memory.
+ *
+ * Only BasicSpatialGrid<2, float>, <2, double>, <3, float> and <3, double> are compiled, in
+ * spatial_grid.cc.
+ */
+template <glm::length_t D, typename T>
+class BasicSpatialGrid {
+ public:
+  typedef glm::vec<D, T> Vector;
+
+  //a cell's coordinate along each axis, or a count of cells along each axis
+  typedef std::array<int, D> Cell;
+
+  BasicSpatialGrid();
+
+  /**
+   * Rebuilds the grid from the current particle positions
+   * @param particles the particles to bucket
+   * @param min lowest corner of the area covered by the grid
+   * @param size length of each side of the area covered by the grid
+   * @param margin how far apart two particles' edges can be and still be candidates
+   */
+  void Rebuild(const BasicParticleStore<D, T>& particles, const Vector& min, const Vector& size, T margin = 0);
+
+  /**
+   * Rebuilds the grid over only some columns, the cells along the first axis, of a larger grid,
+   * e.g. one slab of a container split between processes. Particles are put in columns exactly
+   * as the larger grid would, and GetNumCells and GetCellRange count columns from first_column.
+   * @param particles the particles to bucket, all in the columns covered
+   * @param min lowest corner of the larger grid
+   * @param cell_size
+   * @param num_cells cells of the larger grid along each axis
+   * @param first_column first column covered
+   * @param end_column one past the last column covered
+   */
+  void RebuildColumns(const BasicParticleStore<D, T>& particles, const Vector& min, T cell_size, const Cell& num_cells,
+                      int first_column, int end_column);
+
+  /**
+   * Picks the cell size Rebuild uses
+   * @param max_radius largest particle radius
+   * @param num_particles
+   * @param size length of each side of the area covered by the grid
+   * @param margin how far apart two particles' edges can be and still be candidates
+   * @return the cell size
+   */
+  static T ChooseCellSize(T max_radius, size_t num_particles, const Vector& size, T margin = 0);
+
+  /**
+   * Gets the cell a coordinate falls in along one axis, clamped to the grid
+   * @param coordinate position along the axis
+   * @param min lowest edge of the grid along the axis
+   * @param cell_size
+   * @param count number of cells along the axis
+   * @return the cell's coordinate
+   */
+  static int GetCellCoordinate(T coordinate, T min, T cell_size, int count);
+
+  /**
+   * Finds every particle in the same or a neighbouring cell as the given particle
+   * with a higher index than it
+   * @param index index of the particle we are finding candidates for
+   * @param candidates filled with the candidate indices in ascending order
+   */
+  void FindCandidates(size_t index, vector<size_t>& candidates) const;
+
+  /**
+   * Finds every pair of touching particles in the same or neighbouring cells: the pairs a
+   * FindCandidates loop over every particle would find touching, by the same arithmetic as
+   * the narrowphase. The cells are walked in order over the positions the rebuild copied
+   * into cell order, so memory is read front to back rather than once per particle index.
+   * @param first filled with the lower index of each pair
+   * @param second filled with the higher index of each pair. Pairs are ascending by first,
+   * then by second, the order the sequential schedule resolves them in.
+   */
+  void FindTouchingPairs(vector<uint32_t>& first, vector<uint32_t>& second);
+
+  T GetCellSize() const;
+
+  /**
+   * Gets the cells along one axis. Along the first, only the columns covered are counted.
+   * @param axis
+   */
+  int GetNumCells(glm::length_t axis) const;
+
+  /**
+   * Gets the indices of the particles in one cell
+   * @param cell the cell's coordinates, with columns counted from the first one covered
+   * @param begin set to the index in GetCellParticles() of the cell's first particle
+   * @param end set to one past the index of the cell's last particle
+   */
+  void GetCellRange(const Cell& cell, size_t& begin, size_t& end) const;
+
+  /**
+   * Gets the particle indices grouped by cell, ascending within each cell
+   */
+  const vector<size_t>& GetCellParticles() const;
+
+ private:
+  Vector min_;
+  T cell_size_;
+  Cell num_cells_;
+
+  //first column covered, and the columns of the whole grid, when only some columns are covered
+  int first_column_;
+  int total_columns_;
+
+  //the cell each particle was put in, by particle index
+  vector<size_t> particle_cells_;
+
+  //cell_starts_[c] to cell_starts_[c + 1] is the range of cell c in cell_particles_
+  vector<size_t> cell_starts_;
+
+  //particle indices grouped by cell, ascending within each cell
+  vector<size_t> cell_particles_;
+
+  //where the next particle of each cell goes while rebuilding
+  vector<size_t> next_slots_;
+
+  //each particle's position and radius in cell_particles_ order
+  std::array<vector<T>, D> cell_position_;
+  vector<T> cell_radius_;
+
+  //the touching pairs as first << 32 | second, so sorting them puts them in resolution order
+  vector<uint64_t> pair_keys_;
+
+  //the rows FindTouchingPairs checks each cell against, as the offset of every axis but the first
+  vector<Cell> forward_rows_;
+
+  /**
+   * Gets the first cell of a row
+   * @param cell coordinates of any cell, whose first coordinate is ignored
+   * @param inside set to whether the row is in the grid
+   */
+  size_t GetRowStart(const Cell& cell, bool& inside) const;
+
+  /**
+   * Adds the pairs one particle makes with the touching particles in a range of cell_particles_
+   * @param slot the particle's place in cell_particles_
+   * @param begin
+   * @param end
+   */
+  void AddTouchingPairs(size_t slot, size_t begin, size_t end);
+
+  //caps on the number of cells, so tiny radii don't make a huge grid
+  static const int kMaxCellsPerParticle = 4;
+  static const int kMinMaxCells = 1024;
+};
+
+typedef BasicSpatialGrid<2, float> SpatialGrid;
+
+extern template class BasicSpatialGrid<2, float>;
+extern template class BasicSpatialGrid<2, double>;
+extern template class BasicSpatialGrid<3, float>;
+extern template class BasicSpatialGrid<3, double>;
+
+}  // namespace idealgas
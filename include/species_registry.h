@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace idealgas {
+
+using std::string;
+using std::vector;
+
+/**
+ * A kind of particle. Every particle of a species shares its mass, radius and color.
+ */
+struct Species {
+
+  /**
+   * Species constructor
+   * @param name the name of the species, also used as its color
+   * @param mass
+   * @param radius
+   */
+  Species(const string& name, float mass, float radius);
+
+  string name;
+  float mass;
+  float radius;
+};
+
+/**
+ * Maps small integer species ids to their species, so particles only need to
+ * store an id. Also keeps the collision coefficient for every pair of species.
+ */
+class SpeciesRegistry {
+ public:
+
+  SpeciesRegistry();
+
+  /**
+   * Gets the id of a species, adding it if no species has the same name, mass and radius
+   * @param name
+   * @param mass
+   * @param radius
+   * @return the species id
+   */
+  int Register(const string& name, float mass, float radius);
+
+  /**
+   * Gets the id of a species, adding it if it isn't registered yet
+   * @param species
+   * @return the species id
+   */
+  int Register(const Species& species);
+
+  /**
+   * Finds the first species with the given name
+   * @param name
+   * @return the species id, or -1 if there is no species with that name
+   */
+  int FindSpecies(const string& name) const;
+
+  const Species& GetSpecies(int species_id) const;
+
+  size_t Size() const;
+
+  /**
+   * Gets the mass factor 2 * m2 / (m1 + m2) used when a particle of the first species
+   * collides with one of the second
+   * @param species_id1 species of the particle whose velocity is changing
+   * @param species_id2 species of the particle it collided with
+   * @return the collision coefficient
+   */
+  float GetCollisionCoefficient(int species_id1, int species_id2) const;
+
+  /**
+   * Gets the table of collision coefficients, indexed by species_id1 * Size() + species_id2
+   */
+  const vector<float>& GetCollisionCoefficients() const;
+
+ private:
+  vector<Species> species_;
+
+  //collision coefficient for every ordered pair of species
+  vector<float> collision_coefficients_;
+
+  /**
+   * Recalculates collision_coefficients_ after a species is added
+   */
+  void UpdateCollisionCoefficients();
+};
+
+}  // namespace idealgas
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace idealgas {
+
+using std::vector;
+
+/**
+ * How the counts of several frames are combined into one distribution
+ */
+enum class DistributionView {
+  //the mean count of each bin per frame
+  kMovingAverage,
+  //the mean count per frame of each bin and every slower one
+  kCumulative
+};
+
+/**
+ * Counts of every species' speeds in fixed bins, for each of the latest frames. Counting
+ * a frame only increments a bin per particle; the counts are only combined over a window
+ * of frames when a distribution is asked for.
+ */
+class SpeedDistribution {
+ public:
+
+  SpeedDistribution();
+
+  /**
+   * SpeedDistribution constructor
+   * @param num_species
+   * @param num_bins bins of equal width from 0 to max_speed
+   * @param max_speed top of the last bin. Faster speeds are counted in the last bin.
+   * @param capacity most frames kept
+   * @throws invalid_argument if num_bins or capacity is 0, or max_speed isn't positive
+   */
+  SpeedDistribution(size_t num_species, size_t num_bins, float max_speed, size_t capacity);
+
+  /**
+   * Counts one frame's speeds, dropping the oldest frame if every frame is in use
+   * @param species species id of each particle
+   * @param speeds speed of each particle
+   */
+  void AddFrame(const vector<int>& species, const vector<float>& speeds);
+
+  /**
+   * Combines a species' counts over the latest frames
+   * @param species_id
+   * @param num_frames how many of the latest frames to combine
+   * @param view
+   * @return one value per bin
+   * @throws invalid_argument if the species isn't counted, or num_frames is 0 or more than the frames kept
+   */
+  vector<double> GetDistribution(int species_id, size_t num_frames, DistributionView view) const;
+
+  /**
+   * Gets the counts of one of the frames kept, without combining or copying them
+   * @param frames_ago 0 for the latest frame
+   * @return num_species * num_bins counts, by species id then bin
+   * @throws invalid_argument if that frame isn't kept
+   */
+  const int* GetFrameCounts(size_t frames_ago) const;
+
+  /**
+   * Gets how many frames are kept
+   */
+  size_t GetNumFrames() const;
+
+  size_t GetCapacity() const;
+
+  size_t GetNumSpecies() const;
+
+  size_t GetNumBins() const;
+
+  float GetMaxSpeed() const;
+
+  /**
+   * Drops every frame
+   */
+  void Clear();
+
+ private:
+  size_t num_species_;
+  size_t num_bins_;
+  float max_speed_;
+
+  //bins per unit of speed
+  float bin_scale_;
+
+  size_t capacity_;
+
+  //every frame's counts, by frame slot, then species, then bin
+  vector<int> counts_;
+
+  //slot of the latest frame, and how many frames are kept
+  size_t latest_;
+  size_t num_frames_;
+};
+
+}  // namespace idealgas
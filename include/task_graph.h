@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace idealgas {
+
+using std::vector;
+
+/**
+ * The tasks of a piece of work and which ones have to finish before others can start.
+ * Tasks are only numbers; whoever runs the graph decides what each one does, so a graph
+ * can be built once and run again every frame. A task can only depend on tasks added
+ * before it, so running the tasks in the order they were added is always valid.
+ */
+class TaskGraph {
+ public:
+
+  TaskGraph();
+
+  /**
+   * Adds a task with no dependencies yet
+   * @return the task's number, counting up from 0
+   */
+  size_t AddTask();
+
+  /**
+   * Makes one task wait for another to finish
+   * @param before
+   * @param after
+   * @throws invalid_argument if either task doesn't exist, or before wasn't added first
+   */
+  void AddDependency(size_t before, size_t after);
+
+  size_t Size() const;
+
+  /**
+   * Gets the tasks that wait for a task
+   * @param task
+   */
+  const vector<size_t>& GetSuccessors(size_t task) const;
+
+  /**
+   * Gets how many tasks a task waits for
+   * @param task
+   */
+  size_t GetNumDependencies(size_t task) const;
+
+  /**
+   * Removes every task
+   */
+  void Clear();
+
+ private:
+  vector<vector<size_t>> successors_;
+  vector<size_t> num_dependencies_;
+};
+
+}  // namespace idealgas
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "task_graph.h"
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace idealgas {
+
+using std::vector;
+
+/**
+ * A fixed set of worker threads that split loops and task graphs between them.
+ * The thread calling ParallelFor or RunGraph works too, so a pool of n threads
+ * starts n - 1 workers.
+ */
+class ThreadPool {
+ public:
+
+  /**
+   * ThreadPool constructor
+   * @param num_threads total number of threads to run loops on, including the caller
+   */
+  explicit ThreadPool(size_t num_threads);
+
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * Runs a task over every index in [0, count), split into chunks that are
+   * handed out to the threads. Returns once every chunk is done. Calls made
+   * from inside a task run on the calling thread alone. If a chunk throws, the
+   * chunks not started yet are skipped, and the exception is rethrown once the
+   * running ones are done.
+   * @param count number of indices
+   * @param task called as task(begin, end, thread_index) for each chunk
+   */
+  void ParallelFor(size_t count, const std::function<void(size_t, size_t, size_t)>& task);
+
+  /**
+   * Runs every task of a graph, each once all of the tasks it depends on are done.
+   * Returns once every task is done. Each thread keeps its own queue of ready tasks
+   * and runs the newest first, so a task that becomes ready usually runs straight after
+   * the one it waited for, on the same thread. Threads with nothing left steal the
+   * oldest task from another thread's queue, and threads with nothing to steal sleep
+   * until a task is readied. Calls made from inside a task, or on a pool with one
+   * thread, run the tasks in the order they were added. If a task throws, the tasks
+   * not started yet are skipped, and the exception is rethrown once the graph is done.
+   * @param graph
+   * @param task called as task(task_number, thread_index) for each task
+   */
+  void RunGraph(const TaskGraph& graph, const std::function<void(size_t, size_t)>& task);
+
+  size_t GetNumThreads() const;
+
+ private:
+  vector<std::thread> workers_;
+
+  //only one loop runs at a time
+  std::mutex loop_mutex_;
+
+  std::mutex mutex_;
+  std::condition_variable work_ready_;
+  std::condition_variable work_done_;
+
+  //bumped for every loop, so workers know when there is new work
+  size_t generation_;
+  bool stopping_;
+
+  //the loop currently running, or null when running a graph
+  const std::function<void(size_t, size_t, size_t)>* task_;
+  size_t count_;
+  size_t chunk_size_;
+  std::atomic<size_t> next_index_;
+  size_t busy_workers_;
+
+  //chunks per thread, so uneven chunks still balance out
+  static const size_t kChunksPerThread = 4;
+
+  /**
+   * One thread's ready tasks. The owner takes from the back and thieves from the front.
+   */
+  struct WorkQueue {
+    std::mutex mutex;
+    vector<size_t> tasks;
+    size_t front;
+  };
+
+  //the graph currently running
+  const TaskGraph* graph_;
+  const std::function<void(size_t, size_t)>* graph_task_;
+
+  //one queue per thread, by thread index
+  vector<WorkQueue> queues_;
+
+  //dependencies each task of the graph is still waiting for, grown to the biggest graph run
+  std::unique_ptr<std::atomic<size_t>[]> waiting_;
+  size_t waiting_capacity_;
+
+  //tasks of the graph not finished yet
+  std::atomic<size_t> num_unfinished_;
+
+  //tasks pushed to a queue and not taken yet. Threads with nothing to take wait on
+  //task_ready_ until this is above 0 or the graph is done.
+  std::atomic<size_t> num_ready_;
+  std::mutex idle_mutex_;
+  std::condition_variable task_ready_;
+
+  //the first exception a task of the current loop or graph threw, guarded by mutex_
+  std::exception_ptr error_;
+  std::atomic<bool> failed_;
+
+  /**
+   * The loop each worker thread runs until the pool is destroyed
+   * @param thread_index index passed to tasks run by this worker
+   */
+  void WorkerLoop(size_t thread_index);
+
+  /**
+   * Takes chunks of the current loop and runs them until there are none left
+   * @param thread_index index passed to the task
+   */
+  void RunChunks(size_t thread_index);
+
+  /**
+   * Runs ready tasks of the current graph until every task is finished
+   * @param thread_index index passed to the task, and the queue this thread owns
+   */
+  void RunGraphTasks(size_t thread_index);
+
+  /**
+   * Takes the newest task from this thread's queue, or the oldest from another thread's
+   * @param thread_index
+   * @param task set to the task taken
+   * @return false if every queue was empty
+   */
+  bool TakeTask(size_t thread_index, size_t& task);
+
+  /**
+   * Adds a ready task to the back of a thread's queue, and wakes a sleeping thread
+   * if this thread already has another task to run first
+   * @param thread_index
+   * @param task
+   */
+  void PushTask(size_t thread_index, size_t task);
+
+  /**
+   * Wakes every thread sleeping in RunGraphTasks
+   */
+  void WakeIdleThreads();
+
+  /**
+   * Keeps the exception being handled, if it is the first of the current loop or graph,
+   * and stops any more tasks from starting
+   */
+  void RecordError();
+
+  /**
+   * Rethrows the exception RecordError kept, if any, and clears it for the next loop
+   */
+  void RethrowError();
+};
+
+}  // namespace idealgas
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "trajectory_writer.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace idealgas {
+
+using std::string;
+using std::vector;
+
+/**
+ * Reads frames back from a trajectory file written by TrajectoryWriter. Any frame can
+ * be read by decoding forward from the keyframe of its chunk, and reading frames in
+ * order only decodes each frame once.
+ */
+class TrajectoryReader {
+ public:
+
+  /**
+   * Opens a trajectory file and reads its header and chunk index
+   * @param path
+   */
+  explicit TrajectoryReader(const string& path);
+
+  size_t GetNumFrames() const;
+
+  size_t GetNumParticles() const;
+
+  const TrajectoryHeader& GetHeader() const;
+
+  /**
+   * Reads one frame. Values come back rounded to the steps they were written with.
+   * @param frame index of the frame, from 0
+   * @param x
+   * @param y
+   * @param vx
+   * @param vy
+   */
+  void ReadFrame(size_t frame, vector<float>& x, vector<float>& y, vector<float>& vx, vector<float>& vy);
+
+ private:
+  std::ifstream file_;
+  TrajectoryHeader header_;
+  vector<uint64_t> chunk_offsets_;
+
+  //the last decoded frame, as quantised x, y, vx and vy arrays back to back
+  vector<int32_t> current_;
+  size_t current_frame_;
+  bool has_current_;
+
+  vector<uint8_t> encoded_;
+
+  /**
+   * Decodes the frame at the file's read position on top of current_
+   * @param keyframe if the frame is stored whole
+   */
+  void DecodeNextFrame(bool keyframe);
+};
+
+}  // namespace idealgas
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "particle_store.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace idealgas {
+
+using std::string;
+using std::vector;
+
+/**
+ * The start of a trajectory file. Frames follow it in chunks that each begin with a
+ * keyframe, and the file ends with the offset of every chunk.
+ */
+struct TrajectoryHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t frames_per_chunk;
+  uint64_t num_particles;
+  uint64_t num_frames;
+
+  //size of one quantisation step of positions and velocities
+  float position_step;
+  float velocity_step;
+
+  //where the chunk offsets start, after the last frame
+  uint64_t index_offset;
+};
+
+/**
+ * Writes particle positions and velocities to a trajectory file on a background
+ * thread. Each frame is quantised to fixed steps, stored as the difference from
+ * the previous frame, and packed into variable-length integers. The first frame
+ * of every chunk is stored whole, so a reader can start at any chunk.
+ */
+class TrajectoryWriter {
+ public:
+
+  /**
+   * TrajectoryWriter constructor. Starts the writer thread.
+   * @param path
+   * @param position_step positions are rounded to multiples of this
+   * @param velocity_step velocities are rounded to multiples of this
+   * @param frames_per_chunk frames between keyframes
+   * @param queue_capacity frames that can wait to be written before AddFrame blocks
+   */
+  explicit TrajectoryWriter(const string& path, float position_step = kDefaultPositionStep,
+                            float velocity_step = kDefaultVelocityStep,
+                            uint32_t frames_per_chunk = kDefaultFramesPerChunk,
+                            size_t queue_capacity = kDefaultQueueCapacity);
+
+  /**
+   * Writes the remaining frames and the index, if Close hasn't been called
+   */
+  ~TrajectoryWriter();
+
+  TrajectoryWriter(const TrajectoryWriter&) = delete;
+
+  TrajectoryWriter& operator=(const TrajectoryWriter&) = delete;
+
+  /**
+   * Copies the particles' positions and velocities and queues them to be written.
+   * Only waits if the queue is full.
+   * @param particles must hold the same number of particles every frame
+   */
+  void AddFrame(const ParticleStore& particles);
+
+  /**
+   * Waits for every queued frame to be written, then writes the index and closes the file.
+   * Throws any error the writer thread ran into.
+   */
+  void Close();
+
+  static constexpr float kDefaultPositionStep = 1.0f / 256;
+  static constexpr float kDefaultVelocityStep = 1.0f / 4096;
+  static const uint32_t kDefaultFramesPerChunk = 64;
+  static const size_t kDefaultQueueCapacity = 8;
+  static const uint32_t kVersion = 1;
+  static const char kMagic[8];
+
+ private:
+  /**
+   * A copy of one frame, waiting to be written
+   */
+  struct FrameBuffer {
+    vector<float> x;
+    vector<float> y;
+    vector<float> vx;
+    vector<float> vy;
+  };
+
+  std::ofstream file_;
+  TrajectoryHeader header_;
+
+  //frames passed to AddFrame so far
+  size_t frames_added_;
+
+  //every buffer is either free or queued, so there are never more than queue_capacity copies
+  vector<FrameBuffer> buffers_;
+  vector<size_t> free_buffers_;
+  std::deque<size_t> queued_buffers_;
+
+  std::mutex mutex_;
+  std::condition_variable buffer_freed_;
+  std::condition_variable frame_queued_;
+  bool stopping_;
+  bool closed_;
+
+  //the first error the writer thread hit, thrown on the next AddFrame or Close
+  std::exception_ptr error_;
+
+  //only used by the writer thread
+  vector<int32_t> previous_;
+  vector<uint8_t> encoded_;
+  vector<uint64_t> chunk_offsets_;
+  uint64_t offset_;
+
+  std::thread thread_;
+
+  /**
+   * Writes queued frames until stopped and the queue is empty
+   */
+  void Run();
+
+  /**
+   * Quantises, delta-encodes and writes one frame
+   * @param buffer
+   * @throws runtime_error if the file can't be written, or the encoded frame doesn't fit its 32-bit size
+   */
+  void WriteFrame(const FrameBuffer& buffer);
+
+  /**
+   * Appends one array to encoded_ as zigzag varints of the change in each quantised value
+   * @param values
+   * @param step
+   * @param previous the quantised values of the last frame, updated to this frame's
+   * @param keyframe if the values are stored whole instead of as changes
+   */
+  void EncodeArray(const vector<float>& values, float step, int32_t* previous, bool keyframe);
+
+  /**
+   * Throws the writer thread's error, if it had one
+   */
+  void RethrowError();
+};
+
+}  // namespace idealgas
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace idealgas {
+
+using std::vector;
+
+/**
+ * Moves messages between the processes of a distributed simulation. Each process
+ * has a rank from 0 to GetNumRanks() - 1, and all communication is done in
+ * exchanges, so a transport only has to implement one operation.
+ */
+class Transport {
+ public:
+
+  virtual ~Transport() {}
+
+  virtual int GetRank() const = 0;
+
+  virtual int GetNumRanks() const = 0;
+
+  /**
+   * Sends one message to each of some ranks and receives one message back from each.
+   * Every listed rank must call Exchange listing this rank at the same time, and no rank
+   * may wait on its own sends before receiving, so two ranks sending big messages to
+   * each other never deadlock.
+   * @param ranks the ranks to exchange with, not including this one
+   * @param outgoing the message to send to each rank, in the same order
+   * @param incoming set to the message received from each rank, in the same order
+   * @throws runtime_error if a message can't be sent or received
+   */
+  virtual void Exchange(const vector<int>& ranks, const vector<vector<uint8_t>>& outgoing,
+                        vector<vector<uint8_t>>& incoming) = 0;
+};
+
+}  // namespace idealgas
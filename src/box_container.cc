@@ -0,0 +1,181 @@
+#include "box_container.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace idealgas {
+
+template <glm::length_t D, typename T>
+BoxContainer<D, T>::BoxContainer(const Vector& size) : size_(size), rng_(1), rng_counter_(0) {
+  for (glm::length_t axis = 0; axis < D; axis++) {
+    if (!(size[axis] > 0)) {
+      throw std::invalid_argument("Every side of the box has to be positive.");
+    }
+  }
+}
+
+template <glm::length_t D, typename T>
+BoxContainer<D, T>::BoxContainer(const Vector& size, const vector<pair<Species, int>>& species_counts,
+                                 uint64_t seed) : BoxContainer(size) {
+  rng_ = Philox(seed);
+  for (size_t i = 0; i < species_counts.size(); i++) {
+    AddSpecies(species_counts.at(i).first);
+  }
+  for (size_t i = 0; i < species_counts.size(); i++) {
+    GenerateParticles(particles_.species_registry.Register(species_counts.at(i).first), species_counts.at(i).second);
+  }
+}
+
+template <glm::length_t D, typename T>
+int BoxContainer<D, T>::AddSpecies(const Species& species) {
+  int species_id = particles_.species_registry.Register(species);
+  size_t num_species = particles_.species_registry.Size();
+  coefficients_.resize(num_species * num_species);
+  for (size_t i = 0; i < num_species; i++) {
+    for (size_t j = 0; j < num_species; j++) {
+      coefficients_[i * num_species + j] =
+          GetCollisionCoefficient(T(particles_.species_registry.GetSpecies(int(i)).mass),
+                                  T(particles_.species_registry.GetSpecies(int(j)).mass));
+    }
+  }
+  return species_id;
+}
+
+template <glm::length_t D, typename T>
+void BoxContainer<D, T>::AddParticle(int species_id, const Vector& position, const Vector& velocity) {
+  if (species_id < 0 || size_t(species_id) >= particles_.species_registry.Size()) {
+    throw std::invalid_argument("The species is not registered.");
+  }
+  particles_.Add(species_id, position, velocity);
+}
+
+template <glm::length_t D, typename T>
+size_t BoxContainer<D, T>::Size() const {
+  return particles_.Size();
+}
+
+template <glm::length_t D, typename T>
+typename BoxContainer<D, T>::Vector BoxContainer<D, T>::GetSize() const {
+  return size_;
+}
+
+template <glm::length_t D, typename T>
+typename BoxContainer<D, T>::Vector BoxContainer<D, T>::GetPosition(size_t index) const {
+  return particles_.GetPosition(index);
+}
+
+template <glm::length_t D, typename T>
+typename BoxContainer<D, T>::Vector BoxContainer<D, T>::GetVelocity(size_t index) const {
+  return particles_.GetVelocity(index);
+}
+
+template <glm::length_t D, typename T>
+int BoxContainer<D, T>::GetSpeciesId(size_t index) const {
+  return particles_.species.at(index);
+}
+
+template <glm::length_t D, typename T>
+const SpeciesRegistry& BoxContainer<D, T>::GetSpeciesRegistry() const {
+  return particles_.species_registry;
+}
+
+template <glm::length_t D, typename T>
+double BoxContainer<D, T>::GetKineticEnergy() const {
+  double kinetic_energy = 0;
+  for (size_t i = 0; i < Size(); i++) {
+    double speed_squared = 0;
+    for (glm::length_t axis = 0; axis < D; axis++) {
+      speed_squared += double(particles_.velocity[axis][i]) * double(particles_.velocity[axis][i]);
+    }
+    kinetic_energy += double(particles_.mass[i]) * speed_squared / 2;
+  }
+  return kinetic_energy;
+}
+
+template <glm::length_t D, typename T>
+void BoxContainer<D, T>::AdvanceOneFrame() {
+  HandleAllCollisions();
+  for (glm::length_t axis = 0; axis < D; axis++) {
+    vector<T>& positions = particles_.position[axis];
+    const vector<T>& velocities = particles_.velocity[axis];
+    for (size_t i = 0; i < Size(); i++) {
+      positions[i] += velocities[i];
+    }
+  }
+}
+
+template <glm::length_t D, typename T>
+void BoxContainer<D, T>::HandleAllCollisions() {
+  //only particles in neighbouring grid cells can have collided, and which ones touch only
+  //depends on the positions, so they are all found before any is resolved
+  grid_.Rebuild(particles_, Vector(T(0)), size_);
+  grid_.FindTouchingPairs(touching_first_, touching_second_);
+  for (size_t k = 0; k < touching_first_.size(); k++) {
+    ResolveCollision(touching_first_[k], touching_second_[k]);
+  }
+
+  //walls only touch one particle each, so they go after every pair is resolved
+  Vector lower = Vector(T(0));
+  for (size_t i = 0; i < Size(); i++) {
+    Vector velocity = GetVelocity(i);
+    if (ReflectOffWalls(GetPosition(i), velocity, particles_.radius[i], lower, size_) > 0) {
+      particles_.SetVelocity(i, velocity);
+    }
+  }
+}
+
+template <glm::length_t D, typename T>
+void BoxContainer<D, T>::ResolveCollision(size_t i, size_t j) {
+  Vector position = GetPosition(i);
+  Vector velocity = GetVelocity(i);
+  Vector other_position = GetPosition(j);
+  Vector other_velocity = GetVelocity(j);
+
+  //particles only bounce if they are moving towards each other
+  if (glm::dot(velocity - other_velocity, position - other_position) < 0) {
+    size_t num_species = particles_.species_registry.Size();
+    size_t species = size_t(particles_.species[i]);
+    size_t other_species = size_t(particles_.species[j]);
+    particles_.SetVelocity(i, GetVelocityAfterCollision(velocity, other_velocity, position, other_position,
+                                                        coefficients_[species * num_species + other_species]));
+    particles_.SetVelocity(j, GetVelocityAfterCollision(other_velocity, velocity, other_position, position,
+                                                        coefficients_[other_species * num_species + species]));
+  }
+}
+
+template <glm::length_t D, typename T>
+void BoxContainer<D, T>::GenerateParticles(int species_id, int num_particles) {
+  if (num_particles <= 0) {
+    return;
+  }
+
+  const Species& species = particles_.species_registry.GetSpecies(species_id);
+  T radius = T(species.radius);
+  if (species.radius < 1) {
+    throw std::invalid_argument("Species " + species.name + " does not fit in the box.");
+  }
+  for (glm::length_t axis = 0; axis < D; axis++) {
+    if (size_[axis] - 2 * radius < 1) {
+      throw std::invalid_argument("Species " + species.name + " does not fit in the box.");
+    }
+  }
+
+  //the same random words GasContainer uses in 2D
+  size_t first = particles_.Size();
+  particles_.Resize(first + size_t(num_particles));
+  Vector position;
+  Vector velocity;
+  for (int n = 0; n < num_particles; n++) {
+    BasicParticleStore<D, T>::GetRandomState(rng_, rng_counter_ + uint64_t(n), radius, Vector(T(0)), size_,
+                                             position, velocity);
+    particles_.Set(first + size_t(n), species_id, position, velocity);
+  }
+  rng_counter_ += uint64_t(num_particles);
+}
+
+template class BoxContainer<2, float>;
+template class BoxContainer<2, double>;
+template class BoxContainer<3, float>;
+template class BoxContainer<3, double>;
+
+}  // namespace idealgas
@@ -0,0 +1,215 @@
+#include "checkpoint.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace idealgas {
+
+namespace {
+
+//the header is written as raw bytes, so its layout must not depend on the compiler's padding
+static_assert(sizeof(CheckpointHeader) == 144, "CheckpointHeader must have no padding");
+
+const char kMagic[8] = {'I', 'G', 'A', 'S', 'C', 'K', 'P', 'T'};
+
+uint64_t AlignUp(uint64_t offset, uint64_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * Gets the bytes one species takes up in the species table
+ */
+uint64_t GetSpeciesEntrySize(const Species& species) {
+  return AlignUp(2 * sizeof(float) + sizeof(uint32_t) + species.name.size(), 4);
+}
+
+void WritePadding(std::ofstream& file, uint64_t& offset, uint64_t target) {
+  static const char zeros[Checkpoint::kAlignment] = {};
+  while (offset < target) {
+    uint64_t count = std::min<uint64_t>(target - offset, sizeof(zeros));
+    file.write(zeros, std::streamsize(count));
+    offset += count;
+  }
+}
+
+template <typename T>
+void WriteArray(std::ofstream& file, uint64_t& offset, const vector<T>& values) {
+  file.write(reinterpret_cast<const char*>(values.data()), std::streamsize(values.size() * sizeof(T)));
+  offset += values.size() * sizeof(T);
+}
+
+}  // namespace
+
+void Checkpoint::Save(const string& path, const CheckpointHeader& header, const ParticleStore& particles,
+                      const vector<float>& speeds) {
+  if (speeds.size() != particles.Size()) {
+    throw std::invalid_argument("There must be one speed per particle.");
+  }
+
+  //lay out the file: header, species table, then the aligned arrays
+  CheckpointHeader layout = header;
+  std::memcpy(layout.magic, kMagic, sizeof(kMagic));
+  layout.version = kVersion;
+  layout.byte_order = kByteOrder;
+  layout.num_particles = particles.Size();
+  layout.num_species = uint32_t(particles.species_registry.Size());
+  layout.species_offset = AlignUp(sizeof(CheckpointHeader), 8);
+  uint64_t offset = layout.species_offset;
+  for (size_t i = 0; i < particles.species_registry.Size(); i++) {
+    offset += GetSpeciesEntrySize(particles.species_registry.GetSpecies(int(i)));
+  }
+  for (int i = 0; i < kNumCheckpointArrays; i++) {
+    offset = AlignUp(offset, kAlignment);
+    layout.array_offsets[i] = offset;
+    offset += particles.Size() * sizeof(float);
+  }
+  layout.file_size = offset;
+
+  std::ofstream file(path.c_str(), std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Could not open " + path + " for writing.");
+  }
+  file.write(reinterpret_cast<const char*>(&layout), sizeof(layout));
+  offset = sizeof(layout);
+  WritePadding(file, offset, layout.species_offset);
+  for (size_t i = 0; i < particles.species_registry.Size(); i++) {
+    const Species& species = particles.species_registry.GetSpecies(int(i));
+    uint32_t name_length = uint32_t(species.name.size());
+    file.write(reinterpret_cast<const char*>(&species.mass), sizeof(float));
+    file.write(reinterpret_cast<const char*>(&species.radius), sizeof(float));
+    file.write(reinterpret_cast<const char*>(&name_length), sizeof(uint32_t));
+    file.write(species.name.data(), std::streamsize(name_length));
+    uint64_t entry_start = offset;
+    offset += 2 * sizeof(float) + sizeof(uint32_t) + name_length;
+    WritePadding(file, offset, entry_start + GetSpeciesEntrySize(species));
+  }
+
+  const vector<float>* float_arrays[] = {&particles.position[0], &particles.position[1], &particles.velocity[0], &particles.velocity[1],
+                                         &particles.mass, &particles.radius};
+  for (int i = 0; i < kNumCheckpointArrays; i++) {
+    WritePadding(file, offset, layout.array_offsets[i]);
+    if (i == kCheckpointSpecies) {
+      WriteArray(file, offset, particles.species);
+    } else if (i == kCheckpointSpeeds) {
+      WriteArray(file, offset, speeds);
+    } else {
+      WriteArray(file, offset, *float_arrays[i]);
+    }
+  }
+  if (!file) {
+    throw std::runtime_error("Could not write " + path + ".");
+  }
+}
+
+Checkpoint::Checkpoint(const string& path) : path_(path), file_(path.c_str(), std::ios::binary), size_(0) {
+  if (!file_) {
+    throw std::runtime_error("Could not open " + path + ".");
+  }
+  file_.seekg(0, std::ios::end);
+  std::streamoff size = file_.tellg();
+  if (size < std::streamoff(sizeof(CheckpointHeader))) {
+    throw std::runtime_error(path + " is too small to be a checkpoint.");
+  }
+  size_ = uint64_t(size);
+  Read(0, &header_, sizeof(header_));
+  Validate();
+}
+
+const CheckpointHeader& Checkpoint::GetHeader() const {
+  return header_;
+}
+
+void Checkpoint::Read(uint64_t offset, void* data, uint64_t size) {
+  file_.seekg(std::streamoff(offset));
+  file_.read(static_cast<char*>(data), std::streamsize(size));
+  if (!file_) {
+    throw std::runtime_error("Could not read " + path_ + ".");
+  }
+}
+
+void Checkpoint::Validate() {
+  if (std::memcmp(header_.magic, kMagic, sizeof(kMagic)) != 0) {
+    throw std::runtime_error("Not a checkpoint file.");
+  }
+  if (header_.version != kVersion) {
+    throw std::runtime_error("Unsupported checkpoint version.");
+  }
+  if (header_.byte_order != kByteOrder) {
+    throw std::runtime_error("Checkpoint was written on a machine with a different byte order.");
+  }
+  if (header_.file_size != size_) {
+    throw std::runtime_error("Checkpoint file is truncated.");
+  }
+
+  //sizes are compared against what is left of the file, so a crafted offset can't wrap around
+  if (header_.species_offset < sizeof(CheckpointHeader) || header_.species_offset > size_) {
+    throw std::runtime_error("Checkpoint species table is outside the file.");
+  }
+  uint64_t offset = header_.species_offset;
+  species_.clear();
+  for (uint32_t i = 0; i < header_.num_species; i++) {
+    if (size_ - offset < 2 * sizeof(float) + sizeof(uint32_t)) {
+      throw std::runtime_error("Checkpoint species table is truncated.");
+    }
+    float mass;
+    float radius;
+    uint32_t name_length;
+    Read(offset, &mass, sizeof(float));
+    Read(offset + sizeof(float), &radius, sizeof(float));
+    Read(offset + 2 * sizeof(float), &name_length, sizeof(uint32_t));
+    uint64_t entry_size = AlignUp(2 * sizeof(float) + sizeof(uint32_t) + uint64_t(name_length), 4);
+    if (size_ - offset < entry_size) {
+      throw std::runtime_error("Checkpoint species table is truncated.");
+    }
+    string name(name_length, '\0');
+    if (name_length > 0) {
+      Read(offset + 2 * sizeof(float) + sizeof(uint32_t), &name[0], name_length);
+    }
+    species_.push_back(Species(name, mass, radius));
+    offset += entry_size;
+  }
+
+  uint64_t array_size = header_.num_particles * sizeof(float);
+  if (header_.num_particles > size_ / sizeof(float)) {
+    throw std::runtime_error("Checkpoint particle arrays are truncated.");
+  }
+  for (int i = 0; i < kNumCheckpointArrays; i++) {
+    if (header_.array_offsets[i] % kAlignment != 0 || header_.array_offsets[i] < offset ||
+        header_.array_offsets[i] > size_ || size_ - header_.array_offsets[i] < array_size) {
+      throw std::runtime_error("Checkpoint particle arrays are truncated.");
+    }
+  }
+}
+
+void Checkpoint::Restore(ParticleStore& particles, vector<float>& speeds) {
+  particles = ParticleStore();
+  for (size_t i = 0; i < species_.size(); i++) {
+    if (particles.species_registry.Register(species_[i]) != int(i)) {
+      throw std::runtime_error("Checkpoint species table has a repeated species.");
+    }
+  }
+
+  //the arrays are whole blocks in the file, so each is one read
+  size_t count = size_t(header_.num_particles);
+  uint64_t array_size = uint64_t(count) * sizeof(float);
+  particles.Resize(count);
+  speeds.resize(count);
+  if (count == 0) {
+    return;
+  }
+  vector<float>* float_arrays[] = {&particles.position[0], &particles.position[1], &particles.velocity[0], &particles.velocity[1],
+                                   &particles.mass, &particles.radius};
+  for (int i = kCheckpointX; i <= kCheckpointRadius; i++) {
+    Read(header_.array_offsets[i], float_arrays[i]->data(), array_size);
+  }
+  Read(header_.array_offsets[kCheckpointSpecies], particles.species.data(), array_size);
+  Read(header_.array_offsets[kCheckpointSpeeds], speeds.data(), array_size);
+
+  for (size_t i = 0; i < count; i++) {
+    if (uint32_t(particles.species[i]) >= header_.num_species) {
+      throw std::runtime_error("Checkpoint particle has an unknown species.");
+    }
+  }
+}
+
+}  // namespace idealgas
@@ -0,0 +1,600 @@
+#include "distributed_container.h"
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace idealgas {
+
+namespace {
+
+/**
+ * A particle as it is sent between ranks
+ */
+struct ParticleRecord {
+  uint64_t id;
+  float x;
+  float y;
+  float vx;
+  float vy;
+  float speed;
+  int32_t species;
+};
+
+void AppendBytes(vector<uint8_t>& message, const void* data, size_t size) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  message.insert(message.end(), bytes, bytes + size);
+}
+
+void AppendRecord(vector<uint8_t>& message, const ParticleStore& particles, const vector<uint64_t>& ids,
+                  const vector<float>& speeds, size_t i) {
+  ParticleRecord record = {ids[i], particles.position[0][i], particles.position[1][i], particles.velocity[0][i], particles.velocity[1][i], speeds[i],
+                           int32_t(particles.species[i])};
+  AppendBytes(message, &record, sizeof(record));
+}
+
+/**
+ * Reads the particle records from offset to the end of a message
+ */
+void ReadRecords(const vector<uint8_t>& message, size_t offset, vector<ParticleRecord>& records) {
+  if ((message.size() - offset) % sizeof(ParticleRecord) != 0) {
+    throw std::runtime_error("Received a malformed particle message.");
+  }
+  size_t first = records.size();
+  records.resize(first + (message.size() - offset) / sizeof(ParticleRecord));
+  if (records.size() > first) {
+    std::memcpy(&records[first], message.data() + offset, message.size() - offset);
+  }
+}
+
+}  // namespace
+
+DistributedContainer::DistributedContainer(int length, int height, int margins_left, int margins_top,
+                                           const vector<pair<Species, int>>& species_counts, uint64_t seed,
+                                           std::shared_ptr<Transport> transport) :
+                                           container_height_(height), container_length_(length),
+                                           margins_top_(margins_top), margins_left_(margins_left),
+                                           transport_(transport), num_particles_(0), num_frames_(0) {
+  //the grid a single-process GasContainer would use, which only depends on the largest radius
+  //and the number of particles
+  float max_radius = 0;
+  for (size_t i = 0; i < species_counts.size(); i++) {
+    if (species_counts.at(i).second > 0) {
+      max_radius = std::max(max_radius, species_counts.at(i).first.radius);
+      num_particles_ += size_t(species_counts.at(i).second);
+    }
+  }
+  cell_size_ = SpatialGrid::ChooseCellSize(max_radius, num_particles_, vec2(length, height));
+  num_columns_ = std::max(int(std::ceil(float(length) / cell_size_)), 1);
+  num_rows_ = std::max(int(std::ceil(float(height) / cell_size_)), 1);
+
+  //ranks only exchange with their neighbours, which needs every slab to be at least two columns wide
+  int num_ranks = transport_->GetNumRanks();
+  if (num_ranks > 1 && num_columns_ < 2 * num_ranks) {
+    throw std::invalid_argument("The container is too narrow to split between " + std::to_string(num_ranks) +
+                                " ranks.");
+  }
+  for (int rank = 0; rank <= num_ranks; rank++) {
+    slab_starts_.push_back(int(int64_t(rank) * num_columns_ / num_ranks));
+  }
+
+  //every rank generates every particle, in the same order as GasContainer, and keeps the ones in its slab
+  Philox rng(seed);
+  uint64_t counter = 0;
+  int rank = transport_->GetRank();
+  for (size_t k = 0; k < species_counts.size(); k++) {
+    int species_id = particles_.species_registry.Register(species_counts.at(k).first);
+    int num_species_particles = species_counts.at(k).second;
+    if (num_species_particles <= 0) {
+      continue;
+    }
+
+    const Species& species = particles_.species_registry.GetSpecies(species_id);
+    if (species.radius < 1 || length - 2 * species.radius < 1 || height - 2 * species.radius < 1) {
+      throw std::invalid_argument("Species " + species.name + " does not fit in the container.");
+    }
+    vec2 position;
+    vec2 velocity;
+    for (int i = 0; i < num_species_particles; i++) {
+      ParticleStore::GetRandomState(rng, counter + uint64_t(i), species.radius, vec2(margins_left, margins_top),
+                                    vec2(length, height), position, velocity);
+      if (GetOwner(GetColumn(position.x)) == rank) {
+        particles_.Add(species_id, position, velocity);
+        ids_.push_back(counter + uint64_t(i));
+        velocities_.push_back(glm::length(velocity));
+      }
+    }
+    counter += uint64_t(num_species_particles);
+  }
+  work_.species_registry = particles_.species_registry;
+
+  RankTotals totals = RankTotals();
+  totals.min_speed = std::numeric_limits<float>::infinity();
+  totals.max_speed = -std::numeric_limits<float>::infinity();
+  for (size_t i = 0; i < velocities_.size(); i++) {
+    totals.min_speed = std::min(totals.min_speed, velocities_[i]);
+    totals.max_speed = std::max(totals.max_speed, velocities_[i]);
+  }
+  MigrateParticles(totals);
+  SetUpHistograms();
+}
+
+const ParticleStore& DistributedContainer::GetParticleStore() const {
+  return particles_;
+}
+
+const vector<uint64_t>& DistributedContainer::GetParticleIds() const {
+  return ids_;
+}
+
+const vector<Histogram>& DistributedContainer::GetHistograms() const {
+  return histograms_;
+}
+
+const ObservablesHistory& DistributedContainer::GetObservables() const {
+  return observables_;
+}
+
+size_t DistributedContainer::GetNumParticles() const {
+  return num_particles_;
+}
+
+int DistributedContainer::GetFirstColumn() const {
+  return slab_starts_[size_t(transport_->GetRank())];
+}
+
+int DistributedContainer::GetEndColumn() const {
+  return slab_starts_[size_t(transport_->GetRank()) + 1];
+}
+
+int DistributedContainer::GetLength() const {
+  return container_length_;
+}
+
+int DistributedContainer::GetHeight() const {
+  return container_height_;
+}
+
+int DistributedContainer::GetMarginsLeft() const {
+  return margins_left_;
+}
+
+int DistributedContainer::GetMarginsTop() const {
+  return margins_top_;
+}
+
+const SpeciesRegistry& DistributedContainer::GetSpeciesRegistry() const {
+  return particles_.species_registry;
+}
+
+void DistributedContainer::AdvanceOneFrame() {
+  RankTotals totals = RankTotals();
+  GatherHalo();
+  for (int color = 0; color < 9; color++) {
+    totals.particle_collisions += ResolveColor(color);
+    ExchangeVelocities(color);
+  }
+  for (size_t i = 0; i < particles_.Size(); i++) {
+    particles_.velocity[0][i] = work_.velocity[0][work_owned_[i]];
+    particles_.velocity[1][i] = work_.velocity[1][work_owned_[i]];
+  }
+
+  //walls only touch one particle each, so every rank does its own
+  WallBounds walls = {float(margins_left_), float(container_length_ + margins_left_),
+                      float(margins_top_), float(container_height_ + margins_top_)};
+  kernels_.ReflectWalls(particles_, 0, particles_.Size(), walls, velocities_.data(), totals.wall_impulses);
+  totals.min_speed = std::numeric_limits<float>::infinity();
+  totals.max_speed = -std::numeric_limits<float>::infinity();
+  double twice_kinetic_energy = 0;
+  for (size_t i = 0; i < velocities_.size(); i++) {
+    totals.min_speed = std::min(totals.min_speed, velocities_[i]);
+    totals.max_speed = std::max(totals.max_speed, velocities_[i]);
+    double mass = particles_.mass[i];
+    double vx = particles_.velocity[0][i];
+    double vy = particles_.velocity[1][i];
+    twice_kinetic_energy += mass * (vx * vx + vy * vy);
+    totals.momentum_x += mass * vx;
+    totals.momentum_y += mass * vy;
+  }
+  totals.kinetic_energy = twice_kinetic_energy / 2;
+  kernels_.Integrate(particles_, 0, particles_.Size());
+
+  MigrateParticles(totals);
+  RecordObservables();
+  FillHistograms();
+}
+
+int DistributedContainer::GetColumn(float x) const {
+  return SpatialGrid::GetCellCoordinate(x, float(margins_left_), cell_size_, num_columns_);
+}
+
+int DistributedContainer::GetOwner(int column) const {
+  return int(std::upper_bound(slab_starts_.begin(), slab_starts_.end(), column) - slab_starts_.begin()) - 1;
+}
+
+void DistributedContainer::GetWorkColumns(int rank, int& first, int& end) const {
+  first = std::max(slab_starts_[size_t(rank)] - 1, 0);
+  end = std::min(slab_starts_[size_t(rank) + 1] + 1, num_columns_);
+}
+
+int DistributedContainer::GetWriter(int column, int color) const {
+  //a cell's collisions change particles in its own and the neighbouring columns, and exactly one
+  //of any three neighbouring columns has the color
+  for (int writer_column = column - 1; writer_column <= column + 1; writer_column++) {
+    if (writer_column >= 0 && writer_column < num_columns_ && writer_column % 3 == color % 3) {
+      return GetOwner(writer_column);
+    }
+  }
+  return -1;
+}
+
+void DistributedContainer::UseNeighbourRanks() {
+  exchange_ranks_.clear();
+  int rank = transport_->GetRank();
+  if (rank > 0) {
+    exchange_ranks_.push_back(rank - 1);
+  }
+  if (rank + 1 < transport_->GetNumRanks()) {
+    exchange_ranks_.push_back(rank + 1);
+  }
+  outgoing_.resize(exchange_ranks_.size());
+  for (size_t k = 0; k < outgoing_.size(); k++) {
+    outgoing_[k].clear();
+  }
+}
+
+void DistributedContainer::UseAllRanks() {
+  exchange_ranks_.clear();
+  for (int rank = 0; rank < transport_->GetNumRanks(); rank++) {
+    if (rank != transport_->GetRank()) {
+      exchange_ranks_.push_back(rank);
+    }
+  }
+  outgoing_.resize(exchange_ranks_.size());
+  for (size_t k = 0; k < outgoing_.size(); k++) {
+    outgoing_[k].clear();
+  }
+}
+
+void DistributedContainer::Exchange() {
+  transport_->Exchange(exchange_ranks_, outgoing_, incoming_);
+}
+
+void DistributedContainer::GatherHalo() {
+  //send each neighbour the particles in its halo columns
+  UseNeighbourRanks();
+  for (size_t k = 0; k < exchange_ranks_.size(); k++) {
+    int first;
+    int end;
+    GetWorkColumns(exchange_ranks_[k], first, end);
+    for (size_t i = 0; i < particles_.Size(); i++) {
+      int column = GetColumn(particles_.position[0][i]);
+      if (column >= first && column < end) {
+        AppendRecord(outgoing_[k], particles_, ids_, velocities_, i);
+      }
+    }
+  }
+  Exchange();
+  vector<ParticleRecord> halo;
+  for (size_t k = 0; k < incoming_.size(); k++) {
+    ReadRecords(incoming_[k], 0, halo);
+  }
+  std::sort(halo.begin(), halo.end(), [](const ParticleRecord& first, const ParticleRecord& second) {
+    return first.id < second.id;
+  });
+
+  //merge by id, so the work arrays are in the same order as a single-process container's
+  size_t num_work = particles_.Size() + halo.size();
+  work_.Resize(num_work);
+  work_ids_.resize(num_work);
+  work_columns_.resize(num_work);
+  work_owned_.resize(particles_.Size());
+  size_t owned = 0;
+  size_t next_halo = 0;
+  for (size_t w = 0; w < num_work; w++) {
+    if (next_halo == halo.size() || (owned < particles_.Size() && ids_[owned] < halo[next_halo].id)) {
+      work_.position[0][w] = particles_.position[0][owned];
+      work_.position[1][w] = particles_.position[1][owned];
+      work_.velocity[0][w] = particles_.velocity[0][owned];
+      work_.velocity[1][w] = particles_.velocity[1][owned];
+      work_.mass[w] = particles_.mass[owned];
+      work_.radius[w] = particles_.radius[owned];
+      work_.species[w] = particles_.species[owned];
+      work_ids_[w] = ids_[owned];
+      work_owned_[owned++] = w;
+    } else {
+      const ParticleRecord& record = halo[next_halo++];
+      const Species& species = work_.species_registry.GetSpecies(record.species);
+      work_.position[0][w] = record.x;
+      work_.position[1][w] = record.y;
+      work_.velocity[0][w] = record.vx;
+      work_.velocity[1][w] = record.vy;
+      work_.mass[w] = species.mass;
+      work_.radius[w] = species.radius;
+      work_.species[w] = record.species;
+      work_ids_[w] = record.id;
+    }
+    work_columns_[w] = GetColumn(work_.position[0][w]);
+  }
+
+  //the particles whose velocities may need exchanging after each color
+  int first;
+  int end;
+  GetWorkColumns(transport_->GetRank(), first, end);
+  shared_particles_.clear();
+  for (size_t w = 0; w < num_work; w++) {
+    if (work_columns_[w] <= GetFirstColumn() || work_columns_[w] >= GetEndColumn() - 1) {
+      shared_particles_.push_back(w);
+    }
+  }
+  grid_.RebuildColumns(work_, vec2(margins_left_, margins_top_), cell_size_, {{num_columns_, num_rows_}}, first, end);
+}
+
+size_t DistributedContainer::ResolveColor(int color) {
+  //the same cells, and the same pairs in each cell, as GasContainer::HandleCellColoredCollisions
+  int first_work_column;
+  int end_work_column;
+  GetWorkColumns(transport_->GetRank(), first_work_column, end_work_column);
+  const vector<size_t>& cell_particles = grid_.GetCellParticles();
+  size_t num_collisions = 0;
+  int first_column = GetFirstColumn() + ((color % 3 - GetFirstColumn() % 3) + 3) % 3;
+  for (int column = first_column; column < GetEndColumn(); column += 3) {
+    for (int row = color / 3; row < num_rows_; row += 3) {
+      size_t begin = 0;
+      size_t end = 0;
+      grid_.GetCellRange({{column - first_work_column, row}}, begin, end);
+      candidate_first_.clear();
+      candidate_second_.clear();
+      for (size_t p = begin; p < end; p++) {
+        grid_.FindCandidates(cell_particles[p], candidates_);
+        for (size_t k = 0; k < candidates_.size(); k++) {
+          candidate_first_.push_back(uint32_t(cell_particles[p]));
+          candidate_second_.push_back(uint32_t(candidates_[k]));
+        }
+      }
+      kernels_.FindCollidingPairs(work_, candidate_first_, candidate_second_, candidate_first_.size(),
+                                  colliding_first_, colliding_second_);
+      num_collisions += kernels_.ResolveCollidingPairs(work_, colliding_first_, colliding_second_,
+                                                       colliding_first_.size());
+    }
+  }
+  return num_collisions;
+}
+
+void DistributedContainer::ExchangeVelocities(int color) {
+  //both ranks hold every particle of the columns they share, in the same order, so only
+  //velocities need sending
+  UseNeighbourRanks();
+  int rank = transport_->GetRank();
+  vector<int> shared_first(exchange_ranks_.size());
+  vector<int> shared_end(exchange_ranks_.size());
+  for (size_t k = 0; k < exchange_ranks_.size(); k++) {
+    int first;
+    int end;
+    GetWorkColumns(rank, first, end);
+    int neighbour_first;
+    int neighbour_end;
+    GetWorkColumns(exchange_ranks_[k], neighbour_first, neighbour_end);
+    shared_first[k] = std::max(first, neighbour_first);
+    shared_end[k] = std::min(end, neighbour_end);
+  }
+
+  for (size_t s = 0; s < shared_particles_.size(); s++) {
+    size_t w = shared_particles_[s];
+    int column = work_columns_[w];
+    for (size_t k = 0; k < exchange_ranks_.size(); k++) {
+      if (column >= shared_first[k] && column < shared_end[k] && GetWriter(column, color) == rank) {
+        AppendBytes(outgoing_[k], &work_.velocity[0][w], sizeof(float));
+        AppendBytes(outgoing_[k], &work_.velocity[1][w], sizeof(float));
+      }
+    }
+  }
+  Exchange();
+
+  for (size_t k = 0; k < exchange_ranks_.size(); k++) {
+    size_t offset = 0;
+    for (size_t s = 0; s < shared_particles_.size(); s++) {
+      size_t w = shared_particles_[s];
+      int column = work_columns_[w];
+      if (column >= shared_first[k] && column < shared_end[k] && GetWriter(column, color) == exchange_ranks_[k]) {
+        if (offset + 2 * sizeof(float) > incoming_[k].size()) {
+          throw std::runtime_error("Rank " + std::to_string(exchange_ranks_[k]) + " sent too few velocities.");
+        }
+        std::memcpy(&work_.velocity[0][w], incoming_[k].data() + offset, sizeof(float));
+        std::memcpy(&work_.velocity[1][w], incoming_[k].data() + offset + sizeof(float), sizeof(float));
+        offset += 2 * sizeof(float);
+      }
+    }
+  }
+}
+
+void DistributedContainer::MigrateParticles(const RankTotals& totals) {
+  //every message starts with the sender's totals, so they are reduced in the same exchange
+  UseAllRanks();
+  int rank = transport_->GetRank();
+  for (size_t k = 0; k < outgoing_.size(); k++) {
+    AppendBytes(outgoing_[k], &totals, sizeof(totals));
+  }
+
+  //particles can move more than one slab in a frame, so they are sent straight to their new rank
+  size_t num_kept = 0;
+  for (size_t i = 0; i < particles_.Size(); i++) {
+    int owner = GetOwner(GetColumn(particles_.position[0][i]));
+    if (owner == rank) {
+      particles_.position[0][num_kept] = particles_.position[0][i];
+      particles_.position[1][num_kept] = particles_.position[1][i];
+      particles_.velocity[0][num_kept] = particles_.velocity[0][i];
+      particles_.velocity[1][num_kept] = particles_.velocity[1][i];
+      particles_.mass[num_kept] = particles_.mass[i];
+      particles_.radius[num_kept] = particles_.radius[i];
+      particles_.species[num_kept] = particles_.species[i];
+      ids_[num_kept] = ids_[i];
+      velocities_[num_kept] = velocities_[i];
+      num_kept++;
+    } else {
+      size_t k = size_t(owner < rank ? owner : owner - 1);
+      AppendRecord(outgoing_[k], particles_, ids_, velocities_, i);
+    }
+  }
+  Exchange();
+
+  rank_totals_.resize(size_t(transport_->GetNumRanks()));
+  rank_totals_[size_t(rank)] = totals;
+  float min_speed = totals.min_speed;
+  float max_speed = totals.max_speed;
+  vector<ParticleRecord> arrived;
+  for (size_t k = 0; k < incoming_.size(); k++) {
+    if (incoming_[k].size() < sizeof(RankTotals)) {
+      throw std::runtime_error("Rank " + std::to_string(exchange_ranks_[k]) + " sent a malformed message.");
+    }
+    RankTotals& other = rank_totals_[size_t(exchange_ranks_[k])];
+    std::memcpy(&other, incoming_[k].data(), sizeof(RankTotals));
+    min_speed = std::min(min_speed, other.min_speed);
+    max_speed = std::max(max_speed, other.max_speed);
+    ReadRecords(incoming_[k], sizeof(RankTotals), arrived);
+  }
+  if (num_particles_ == 0) {
+    min_velocity_ = 0;
+    max_velocity_ = 0;
+  } else {
+    min_velocity_ = min_speed;
+    max_velocity_ = max_speed;
+  }
+
+  //append the arrivals, then merge them in by id
+  particles_.Resize(num_kept + arrived.size());
+  ids_.resize(num_kept + arrived.size());
+  velocities_.resize(num_kept + arrived.size());
+  if (arrived.empty()) {
+    return;
+  }
+  std::sort(arrived.begin(), arrived.end(), [](const ParticleRecord& first, const ParticleRecord& second) {
+    return first.id < second.id;
+  });
+  for (size_t a = 0; a < arrived.size(); a++) {
+    size_t i = num_kept + a;
+    const Species& species = particles_.species_registry.GetSpecies(arrived[a].species);
+    particles_.position[0][i] = arrived[a].x;
+    particles_.position[1][i] = arrived[a].y;
+    particles_.velocity[0][i] = arrived[a].vx;
+    particles_.velocity[1][i] = arrived[a].vy;
+    particles_.mass[i] = species.mass;
+    particles_.radius[i] = species.radius;
+    particles_.species[i] = arrived[a].species;
+    ids_[i] = arrived[a].id;
+    velocities_[i] = arrived[a].speed;
+  }
+  vector<size_t> order(ids_.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  std::inplace_merge(order.begin(), order.begin() + long(num_kept), order.end(),
+                     [this](size_t first, size_t second) { return ids_[first] < ids_[second]; });
+  ParticleStore sorted;
+  sorted.species_registry = particles_.species_registry;
+  sorted.Resize(order.size());
+  vector<uint64_t> sorted_ids(order.size());
+  vector<float> sorted_velocities(order.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    sorted.position[0][i] = particles_.position[0][order[i]];
+    sorted.position[1][i] = particles_.position[1][order[i]];
+    sorted.velocity[0][i] = particles_.velocity[0][order[i]];
+    sorted.velocity[1][i] = particles_.velocity[1][order[i]];
+    sorted.mass[i] = particles_.mass[order[i]];
+    sorted.radius[i] = particles_.radius[order[i]];
+    sorted.species[i] = particles_.species[order[i]];
+    sorted_ids[i] = ids_[order[i]];
+    sorted_velocities[i] = velocities_[order[i]];
+  }
+  particles_ = sorted;
+  ids_.swap(sorted_ids);
+  velocities_.swap(sorted_velocities);
+}
+
+void DistributedContainer::RecordObservables() {
+  num_frames_++;
+  RankTotals sum = RankTotals();
+  for (size_t r = 0; r < rank_totals_.size(); r++) {
+    const RankTotals& totals = rank_totals_[r];
+    sum.wall_impulses.left += totals.wall_impulses.left;
+    sum.wall_impulses.right += totals.wall_impulses.right;
+    sum.wall_impulses.top += totals.wall_impulses.top;
+    sum.wall_impulses.bottom += totals.wall_impulses.bottom;
+    sum.wall_impulses.num_bounces += totals.wall_impulses.num_bounces;
+    sum.kinetic_energy += totals.kinetic_energy;
+    sum.momentum_x += totals.momentum_x;
+    sum.momentum_y += totals.momentum_y;
+    sum.particle_collisions += totals.particle_collisions;
+  }
+
+  //the same as GasContainer::RecordObservables
+  FrameObservables frame = FrameObservables();
+  frame.frame = num_frames_;
+  frame.num_frames = 1;
+  frame.kinetic_energy = sum.kinetic_energy;
+  frame.temperature = num_particles_ == 0 ? 0 : sum.kinetic_energy / double(num_particles_);
+  frame.momentum_x = sum.momentum_x;
+  frame.momentum_y = sum.momentum_y;
+  frame.pressure_left = sum.wall_impulses.left / container_height_;
+  frame.pressure_right = sum.wall_impulses.right / container_height_;
+  frame.pressure_top = sum.wall_impulses.top / container_length_;
+  frame.pressure_bottom = sum.wall_impulses.bottom / container_length_;
+  frame.pressure = (sum.wall_impulses.left + sum.wall_impulses.right + sum.wall_impulses.top +
+                    sum.wall_impulses.bottom) / (2.0 * (container_length_ + container_height_));
+  frame.particle_collisions = double(sum.particle_collisions);
+  frame.wall_collisions = double(sum.wall_impulses.num_bounces);
+  observables_.Add(frame);
+}
+
+void DistributedContainer::SetUpHistograms() {
+  int length = int(margins_left_ * .8);
+  int segments = 10;
+  histograms_ = vector<Histogram>();
+  if (particles_.species_registry.Size() == 0) {
+    return;
+  }
+  int height = int(container_height_ * .9 / particles_.species_registry.Size());
+  for (size_t i = 0; i < particles_.species_registry.Size(); i++) {
+    histograms_.emplace_back(particles_.species_registry.GetSpecies(int(i)).name, length, height,
+                             max_velocity_, min_velocity_, vector<float>(), segments);
+  }
+  FillHistograms();
+}
+
+void DistributedContainer::FillHistograms() {
+  for (size_t i = 0; i < histograms_.size(); i++) {
+    histograms_.at(i).Reset(max_velocity_, min_velocity_);
+  }
+  for (size_t i = 0; i < particles_.Size(); i++) {
+    histograms_[particles_.species[i]].AddVelocity(velocities_[i]);
+  }
+
+  //every rank counted its own particles over the same range, so the bars just add up
+  UseAllRanks();
+  for (size_t h = 0; h < histograms_.size(); h++) {
+    vector<pair<int, int>> distribution = histograms_.at(h).GetVelocityDistribution();
+    for (size_t bar = 0; bar < distribution.size(); bar++) {
+      int32_t count = distribution[bar].second;
+      for (size_t k = 0; k < outgoing_.size(); k++) {
+        AppendBytes(outgoing_[k], &count, sizeof(count));
+      }
+    }
+  }
+  Exchange();
+  for (size_t k = 0; k < incoming_.size(); k++) {
+    size_t offset = 0;
+    for (size_t h = 0; h < histograms_.size(); h++) {
+      size_t num_bars = histograms_.at(h).GetVelocityDistribution().size();
+      for (size_t bar = 0; bar < num_bars; bar++) {
+        if (offset + sizeof(int32_t) > incoming_[k].size()) {
+          throw std::runtime_error("Rank " + std::to_string(exchange_ranks_[k]) + " sent too few histogram bars.");
+        }
+        int32_t count;
+        std::memcpy(&count, incoming_[k].data() + offset, sizeof(count));
+        histograms_.at(h).AddCount(int(bar), count);
+        offset += sizeof(count);
+      }
+    }
+  }
+}
+
+}  // namespace idealgas
@@ -0,0 +1,177 @@
+#include "ensemble.h"
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+
+namespace idealgas {
+
+EnsembleMember::EnsembleMember(int length, int height, const vector<pair<Species, int>>& species_counts,
+                               uint64_t seed) : length(length), height(height), species_counts(species_counts),
+                                                seed(seed), collision_schedule(CollisionSchedule::kSequential) {}
+
+Ensemble::Ensemble(const vector<EnsembleMember>& members, size_t num_threads, size_t num_bins) :
+                   thread_pool_(num_threads), num_frames_(0) {
+  if (members.empty()) {
+    throw std::invalid_argument("An ensemble needs at least one member.");
+  }
+  if (num_bins == 0) {
+    throw std::invalid_argument("The speed distribution needs at least one bin.");
+  }
+
+  //each member runs on one thread, so the pool splits the members rather than their particles
+  members_.reserve(members.size());
+  for (size_t i = 0; i < members.size(); i++) {
+    const EnsembleMember& member = members.at(i);
+    members_.emplace_back(member.length, member.height, 0, 0, member.species_counts, member.seed);
+    members_.back().SetCollisionSchedule(member.collision_schedule);
+    //the ensemble counts every member's speeds itself
+    members_.back().SetSpeedCounting(false);
+  }
+
+  //sorted by size, so the members sharing a group's lanes have about as many particles each
+  vector<size_t> laned_members;
+  for (size_t i = 0; i < members_.size(); i++) {
+    if (members_.at(i).GetParticleStore().Size() <= kMaxLanedParticles) {
+      laned_members.push_back(i);
+    } else {
+      solo_members_.push_back(i);
+    }
+  }
+  std::stable_sort(laned_members.begin(), laned_members.end(), [this](size_t first, size_t second) {
+    return members_.at(first).GetParticleStore().Size() < members_.at(second).GetParticleStore().Size();
+  });
+  for (size_t begin = 0; begin < laned_members.size(); begin += MemberLanes::kNumLanes) {
+    size_t end = std::min(begin + MemberLanes::kNumLanes, laned_members.size());
+    lane_groups_.emplace_back(laned_members.begin() + std::ptrdiff_t(begin),
+                              laned_members.begin() + std::ptrdiff_t(end));
+    lanes_.emplace_back(members_.at(laned_members.at(end - 1)).GetParticleStore().Size());
+  }
+
+  //the members' particles never change species, so only their speeds are gathered every frame
+  float max_speed = 0;
+  for (size_t i = 0; i < members_.size(); i++) {
+    const GasContainer& member = members_.at(i);
+    const ParticleStore& particles = member.GetParticleStore();
+    offsets_.push_back(species_.size());
+    for (size_t k = 0; k < particles.Size(); k++) {
+      species_.push_back(species_registry_.Register(member.GetSpeciesRegistry().GetSpecies(particles.species[k])));
+    }
+    max_speed = std::max(max_speed, member.GetSpeedDistribution().GetMaxSpeed());
+  }
+  offsets_.push_back(species_.size());
+  speeds_.resize(species_.size());
+  speed_distribution_ = SpeedDistribution(species_registry_.Size(), num_bins, max_speed, kSpeedHistoryFrames);
+}
+
+void Ensemble::AdvanceOneFrame() {
+  //only capture what fits in std::function's own storage, so starting the loop doesn't allocate
+  thread_pool_.ParallelFor(lane_groups_.size() + solo_members_.size(), [this](size_t begin, size_t end, size_t) {
+    for (size_t task = begin; task < end; task++) {
+      if (task < lane_groups_.size()) {
+        AdvanceLaneGroup(task);
+      } else {
+        size_t i = solo_members_[task - lane_groups_.size()];
+        members_[i].AdvanceOneFrame();
+        GatherSpeeds(i);
+      }
+    }
+  });
+  num_frames_++;
+  RecordFrame();
+}
+
+size_t Ensemble::Size() const {
+  return members_.size();
+}
+
+const GasContainer& Ensemble::GetMember(size_t index) const {
+  return members_.at(index);
+}
+
+const SpeciesRegistry& Ensemble::GetSpeciesRegistry() const {
+  return species_registry_;
+}
+
+const ObservablesHistory& Ensemble::GetObservables() const {
+  return observables_;
+}
+
+const SpeedDistribution& Ensemble::GetSpeedDistribution() const {
+  return speed_distribution_;
+}
+
+vector<double> Ensemble::GetAverageDistribution(int species_id, size_t num_frames, DistributionView view) const {
+  vector<double> distribution = speed_distribution_.GetDistribution(species_id, num_frames, view);
+  for (size_t bin = 0; bin < distribution.size(); bin++) {
+    distribution[bin] /= double(members_.size());
+  }
+  return distribution;
+}
+
+void Ensemble::AdvanceLaneGroup(size_t group) {
+  //the particle collisions need each member's own grid, but the walls and the move don't
+  //depend on other particles, so they run over every member of the group at once
+  const vector<size_t>& group_members = lane_groups_[group];
+  MemberLanes& lanes = lanes_[group];
+  for (size_t lane = 0; lane < group_members.size(); lane++) {
+    members_[group_members[lane]].StartLanedFrame(lanes, lane);
+  }
+  kernels_.ReflectAndIntegrateLanes(lanes);
+  for (size_t lane = 0; lane < group_members.size(); lane++) {
+    members_[group_members[lane]].FinishLanedFrame(lanes, lane);
+    GatherSpeeds(group_members[lane]);
+  }
+}
+
+void Ensemble::GatherSpeeds(size_t index) {
+  //the member's wall pass already worked the speeds out
+  const vector<float>& speeds = members_[index].GetSpeeds();
+  std::copy(speeds.begin(), speeds.end(), speeds_.begin() + std::ptrdiff_t(offsets_[index]));
+}
+
+void Ensemble::RecordFrame() {
+  //in member order, so the averages don't depend on which thread ran which member
+  FrameObservables average = FrameObservables();
+  double temperature = 0;
+  double pressure_left = 0;
+  double pressure_right = 0;
+  double pressure_top = 0;
+  double pressure_bottom = 0;
+  double pressure = 0;
+  double num_particles = 0;
+  double heights = 0;
+  double lengths = 0;
+  for (size_t i = 0; i < members_.size(); i++) {
+    const FrameObservables& frame = members_[i].GetObservables().GetFrame(0);
+    AddObservables(frame, average);
+
+    //temperature and pressure are weighted like the members were one gas: temperature by
+    //particles, and each pressure by the length of wall it was measured over
+    double member_particles = double(members_[i].GetParticleStore().Size());
+    double height = members_[i].GetHeight();
+    double length = members_[i].GetLength();
+    temperature += frame.temperature * member_particles;
+    pressure_left += frame.pressure_left * height;
+    pressure_right += frame.pressure_right * height;
+    pressure_top += frame.pressure_top * length;
+    pressure_bottom += frame.pressure_bottom * length;
+    pressure += frame.pressure * 2 * (height + length);
+    num_particles += member_particles;
+    heights += height;
+    lengths += length;
+  }
+  DivideObservables(average, double(members_.size()));
+  average.temperature = num_particles > 0 ? temperature / num_particles : 0;
+  average.pressure_left = pressure_left / heights;
+  average.pressure_right = pressure_right / heights;
+  average.pressure_top = pressure_top / lengths;
+  average.pressure_bottom = pressure_bottom / lengths;
+  average.pressure = pressure / (2 * (heights + lengths));
+  average.frame = num_frames_;
+  average.num_frames = 1;
+  observables_.Add(average);
+
+  speed_distribution_.AddFrame(species_, speeds_);
+}
+
+}  // namespace idealgas
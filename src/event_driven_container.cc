@@ -0,0 +1,339 @@
+#include "event_driven_container.h"
+
+namespace idealgas {
+
+bool EventDrivenContainer::Event::operator>(const Event& event) const {
+  return time > event.time;
+}
+
+EventDrivenContainer::EventDrivenContainer(int length, int height, int margins_left, int margins_top,
+                                           const vector<Particle>& particles) :
+                                           container_height_(height), container_length_(length),
+                                           margins_top_(margins_top), margins_left_(margins_left),
+                                           paused_(false), time_(0), particles_(particles),
+                                           num_events_processed_(0) {
+  particle_times_.assign(particles_.Size(), 0);
+  event_counts_.assign(particles_.Size(), 0);
+  particle_cells_.assign(particles_.Size(), 0);
+
+  //cells at least as wide as the largest particle, and about one particle per cell
+  float max_radius = 0;
+  for (size_t i = 0; i < particles_.Size(); i++) {
+    max_radius = std::max(max_radius, particles_.radius[i]);
+  }
+  float area_per_particle = float(length) * float(height) / float(std::max(particles_.Size(), size_t(1)));
+  cell_size_ = std::max(std::max(2 * max_radius, std::sqrt(area_per_particle)), 1.0f);
+  num_columns_ = std::max(int(std::ceil(float(length) / cell_size_)), 1);
+  num_rows_ = std::max(int(std::ceil(float(height) / cell_size_)), 1);
+
+  RebuildEvents();
+  UpdateHistograms();
+}
+
+const ParticleStore& EventDrivenContainer::GetParticleStore() const {
+  return particles_;
+}
+
+const vector<Histogram>& EventDrivenContainer::GetHistograms() const {
+  return histograms_;
+}
+
+int EventDrivenContainer::GetLength() const {
+  return container_length_;
+}
+
+int EventDrivenContainer::GetHeight() const {
+  return container_height_;
+}
+
+int EventDrivenContainer::GetMarginsLeft() const {
+  return margins_left_;
+}
+
+int EventDrivenContainer::GetMarginsTop() const {
+  return margins_top_;
+}
+
+void EventDrivenContainer::AdvanceOneFrame() {
+  if (paused_) {
+    return;
+  }
+
+  double frame_end = time_ + 1;
+  while (!events_.empty() && events_.top().time <= frame_end) {
+    Event event = events_.top();
+    events_.pop();
+
+    //skip predictions made before either particle's latest event
+    if (event_counts_[event.particle] != event.particle_count
+        || (event.type == EventType::kParticle && event_counts_[event.other] != event.other_count)) {
+      continue;
+    }
+
+    MoveParticleTo(event.particle, event.time);
+    if (event.type == EventType::kParticle) {
+      MoveParticleTo(event.other, event.time);
+    }
+    ProcessEvent(event);
+    num_events_processed_++;
+  }
+
+  for (uint32_t i = 0; i < particles_.Size(); i++) {
+    MoveParticleTo(i, frame_end);
+  }
+  time_ = frame_end;
+
+  //stale events pile up in the queue, so clear them out once in a while
+  if (events_.size() > kMaxQueuedEventsPerParticle * std::max(particles_.Size(), size_t(1))) {
+    RebuildEvents();
+  }
+  UpdateHistograms();
+}
+
+void EventDrivenContainer::RebuildEvents() {
+  events_ = std::priority_queue<Event, vector<Event>, std::greater<Event>>();
+  cells_.assign(size_t(num_columns_) * size_t(num_rows_), vector<uint32_t>());
+  for (uint32_t i = 0; i < particles_.Size(); i++) {
+    int cell = GetCellCoordinate(particles_.position[1][i], float(margins_top_), num_rows_) * num_columns_
+               + GetCellCoordinate(particles_.position[0][i], float(margins_left_), num_columns_);
+    particle_cells_[i] = cell;
+    cells_[cell].push_back(i);
+  }
+  for (uint32_t i = 0; i < particles_.Size(); i++) {
+    PredictEvents(i, time_);
+  }
+}
+
+void EventDrivenContainer::MoveParticleTo(uint32_t particle, double time) {
+  double elapsed = time - particle_times_[particle];
+  particles_.position[0][particle] = float(double(particles_.position[0][particle]) + double(particles_.velocity[0][particle]) * elapsed);
+  particles_.position[1][particle] = float(double(particles_.position[1][particle]) + double(particles_.velocity[1][particle]) * elapsed);
+  particle_times_[particle] = time;
+}
+
+void EventDrivenContainer::PredictEvents(uint32_t particle, double time) {
+  double x = particles_.position[0][particle];
+  double y = particles_.position[1][particle];
+  double vx = particles_.velocity[0][particle];
+  double vy = particles_.velocity[1][particle];
+  double radius = particles_.radius[particle];
+
+  //walls, from the side of the particle facing them
+  if (vx > 0) {
+    QueueEvent(time + std::max((container_length_ + margins_left_ - radius - x) / vx, 0.0), EventType::kWallX,
+               particle, particle);
+  } else if (vx < 0) {
+    QueueEvent(time + std::max((margins_left_ + radius - x) / vx, 0.0), EventType::kWallX, particle, particle);
+  }
+  if (vy > 0) {
+    QueueEvent(time + std::max((container_height_ + margins_top_ - radius - y) / vy, 0.0), EventType::kWallY,
+               particle, particle);
+  } else if (vy < 0) {
+    QueueEvent(time + std::max((margins_top_ + radius - y) / vy, 0.0), EventType::kWallY, particle, particle);
+  }
+
+  //leaving the current cell, unless it's at the edge of the grid on that side
+  int column = particle_cells_[particle] % num_columns_;
+  int row = particle_cells_[particle] / num_columns_;
+  double cell_exit = std::numeric_limits<double>::infinity();
+  int next_cell = -1;
+  if (vx > 0 && column < num_columns_ - 1) {
+    cell_exit = (margins_left_ + double(column + 1) * cell_size_ - x) / vx;
+    next_cell = particle_cells_[particle] + 1;
+  } else if (vx < 0 && column > 0) {
+    cell_exit = (margins_left_ + double(column) * cell_size_ - x) / vx;
+    next_cell = particle_cells_[particle] - 1;
+  }
+  if (vy > 0 && row < num_rows_ - 1 && (margins_top_ + double(row + 1) * cell_size_ - y) / vy < cell_exit) {
+    cell_exit = (margins_top_ + double(row + 1) * cell_size_ - y) / vy;
+    next_cell = particle_cells_[particle] + num_columns_;
+  } else if (vy < 0 && row > 0 && (margins_top_ + double(row) * cell_size_ - y) / vy < cell_exit) {
+    cell_exit = (margins_top_ + double(row) * cell_size_ - y) / vy;
+    next_cell = particle_cells_[particle] - num_columns_;
+  }
+  if (next_cell >= 0) {
+    QueueEvent(time + std::max(cell_exit, 0.0), EventType::kCell, particle, uint32_t(next_cell));
+  }
+
+  //particles in this and the neighbouring cells
+  for (int neighbour_row = std::max(row - 1, 0); neighbour_row <= std::min(row + 1, num_rows_ - 1); neighbour_row++) {
+    for (int neighbour_column = std::max(column - 1, 0);
+         neighbour_column <= std::min(column + 1, num_columns_ - 1); neighbour_column++) {
+      const vector<uint32_t>& cell = cells_[size_t(neighbour_row) * size_t(num_columns_) + size_t(neighbour_column)];
+      for (size_t k = 0; k < cell.size(); k++) {
+        if (cell[k] != particle) {
+          PredictCollision(particle, cell[k], time);
+        }
+      }
+    }
+  }
+}
+
+void EventDrivenContainer::PredictCollision(uint32_t particle, uint32_t other, double time) {
+  //the other particle may not have been moved up to this time yet
+  double other_elapsed = time - particle_times_[other];
+  double dx = particles_.position[0][other] + particles_.velocity[0][other] * other_elapsed - particles_.position[0][particle];
+  double dy = particles_.position[1][other] + particles_.velocity[1][other] * other_elapsed - particles_.position[1][particle];
+  double dvx = double(particles_.velocity[0][other]) - particles_.velocity[0][particle];
+  double dvy = double(particles_.velocity[1][other]) - particles_.velocity[1][particle];
+
+  //only particles moving towards each other can collide
+  double approach = dx * dvx + dy * dvy;
+  if (approach >= 0) {
+    return;
+  }
+
+  //solve |d + dv * t| = radius sum for the first time it happens
+  double radii = double(particles_.radius[particle]) + particles_.radius[other];
+  double gap = dx * dx + dy * dy - radii * radii;
+  if (gap <= 0) {
+    QueueEvent(time, EventType::kParticle, particle, other);
+    return;
+  }
+  double speed_squared = dvx * dvx + dvy * dvy;
+  double discriminant = approach * approach - speed_squared * gap;
+  if (discriminant < 0) {
+    return;
+  }
+  QueueEvent(time + (-approach - std::sqrt(discriminant)) / speed_squared, EventType::kParticle, particle, other);
+}
+
+void EventDrivenContainer::ProcessEvent(const Event& event) {
+  uint32_t particle = event.particle;
+  switch (event.type) {
+    case EventType::kParticle: {
+      uint32_t other = event.other;
+      vec2 position = vec2(particles_.position[0][particle], particles_.position[1][particle]);
+      vec2 velocity = vec2(particles_.velocity[0][particle], particles_.velocity[1][particle]);
+      vec2 other_position = vec2(particles_.position[0][other], particles_.position[1][other]);
+      vec2 other_velocity = vec2(particles_.velocity[0][other], particles_.velocity[1][other]);
+      if (glm::dot(velocity - other_velocity, position - other_position) < 0) {
+        const SpeciesRegistry& registry = particles_.species_registry;
+        vec2 new_velocity = Particle::GetNewVelocity(
+            velocity, other_velocity, position, other_position,
+            registry.GetCollisionCoefficient(particles_.species[particle], particles_.species[other]));
+        vec2 new_other_velocity = Particle::GetNewVelocity(
+            other_velocity, velocity, other_position, position,
+            registry.GetCollisionCoefficient(particles_.species[other], particles_.species[particle]));
+        particles_.velocity[0][particle] = new_velocity.x;
+        particles_.velocity[1][particle] = new_velocity.y;
+        particles_.velocity[0][other] = new_other_velocity.x;
+        particles_.velocity[1][other] = new_other_velocity.y;
+      }
+      event_counts_[particle]++;
+      event_counts_[other]++;
+      PredictEvents(particle, event.time);
+      PredictEvents(other, event.time);
+      return;
+    }
+    case EventType::kWallX:
+      particles_.velocity[0][particle] = -particles_.velocity[0][particle];
+      break;
+    case EventType::kWallY:
+      particles_.velocity[1][particle] = -particles_.velocity[1][particle];
+      break;
+    case EventType::kCell: {
+      vector<uint32_t>& old_cell = cells_[particle_cells_[particle]];
+      old_cell.erase(std::find(old_cell.begin(), old_cell.end(), particle));
+      particle_cells_[particle] = int(event.other);
+      cells_[event.other].push_back(particle);
+      break;
+    }
+  }
+  event_counts_[particle]++;
+  PredictEvents(particle, event.time);
+}
+
+void EventDrivenContainer::QueueEvent(double time, EventType type, uint32_t particle, uint32_t other) {
+  Event event = {time, type, particle, other, event_counts_[particle],
+                 type == EventType::kParticle ? event_counts_[other] : 0};
+  events_.push(event);
+}
+
+int EventDrivenContainer::GetCellCoordinate(float coordinate, float min, int count) const {
+  //particles slightly past the walls still go in the edge cells
+  int cell = int(std::floor((coordinate - min) / cell_size_));
+  return std::min(std::max(cell, 0), count - 1);
+}
+
+vector<Particle> EventDrivenContainer::GetParticles() {
+  vector<Particle> particles = vector<Particle>();
+  particles.reserve(particles_.Size());
+  for (size_t i = 0; i < particles_.Size(); i++) {
+    particles.push_back(particles_.GetParticle(i));
+  }
+  return particles;
+}
+
+vector<float> EventDrivenContainer::GetVelocitiesOfSpecies(int species_id) {
+  vector<float> to_return = vector<float>();
+  for (size_t i = 0; i < particles_.Size(); i++) {
+    if (particles_.species[i] == species_id) {
+      to_return.push_back(velocities_[i]);
+    }
+  }
+  return to_return;
+}
+
+const SpeciesRegistry& EventDrivenContainer::GetSpeciesRegistry() const {
+  return particles_.species_registry;
+}
+
+double EventDrivenContainer::GetTime() const {
+  return time_;
+}
+
+size_t EventDrivenContainer::GetNumEventsProcessed() const {
+  return num_events_processed_;
+}
+
+bool EventDrivenContainer::GetPaused() {
+  return paused_;
+}
+
+void EventDrivenContainer::SetPaused(bool paused) {
+  paused_ = paused;
+}
+
+void EventDrivenContainer::SetUpHistograms() {
+  int length = int(margins_left_ * .8);
+  int segments = 10;
+  histograms_ = vector<Histogram>();
+  if (particles_.species_registry.Size() == 0) {
+    return;
+  }
+  int height = int(container_height_ * .9 / particles_.species_registry.Size());
+  for (size_t i = 0; i < particles_.species_registry.Size(); i++) {
+    histograms_.emplace_back(particles_.species_registry.GetSpecies(int(i)).name, length, height,
+                             max_velocity_, min_velocity_, vector<float>(), segments);
+  }
+  FillHistograms();
+}
+
+void EventDrivenContainer::UpdateHistograms() {
+  velocities_.resize(particles_.Size());
+  max_velocity_ = particles_.Size() == 0 ? 0 : -std::numeric_limits<float>::infinity();
+  min_velocity_ = particles_.Size() == 0 ? 0 : std::numeric_limits<float>::infinity();
+  for (size_t i = 0; i < particles_.Size(); i++) {
+    velocities_[i] = glm::length(vec2(particles_.velocity[0][i], particles_.velocity[1][i]));
+    max_velocity_ = std::max(max_velocity_, velocities_[i]);
+    min_velocity_ = std::min(min_velocity_, velocities_[i]);
+  }
+
+  if (histograms_.size() != particles_.species_registry.Size()) {
+    SetUpHistograms();
+    return;
+  }
+  FillHistograms();
+}
+
+void EventDrivenContainer::FillHistograms() {
+  for (size_t i = 0; i < histograms_.size(); i++) {
+    histograms_.at(i).Reset(max_velocity_, min_velocity_);
+  }
+  for (size_t i = 0; i < particles_.Size(); i++) {
+    histograms_[particles_.species[i]].AddVelocity(velocities_[i]);
+  }
+}
+
+}  // namespace idealgas
@@ -0,0 +1,122 @@
+#include "frame_subscription.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace idealgas {
+
+SubscriptionOptions::SubscriptionOptions() : positions(false), velocities(false), speed_counts(false),
+                                             observables(false), capacity(64),
+                                             overflow_policy(OverflowPolicy::kDropFrames) {}
+
+FrameRecord::FrameRecord() : frame(0), num_bins(0), max_speed(0), observables() {}
+
+FrameSubscription::FrameSubscription(const SubscriptionOptions& options, size_t num_particles,
+                                     size_t num_speed_counts) : options_(options), write_count_(0),
+                                                                dropped_frames_(0), read_count_(0) {
+  if (options.capacity == 0) {
+    throw std::invalid_argument("A subscription has to hold at least one frame.");
+  }
+
+  //reserve every buffer up front, so the first frames don't allocate either
+  records_.resize(options.capacity);
+  for (size_t i = 0; i < records_.size(); i++) {
+    FrameRecord& record = records_.at(i);
+    if (options.positions) {
+      record.x.reserve(num_particles);
+      record.y.reserve(num_particles);
+      record.species.reserve(num_particles);
+    }
+    if (options.velocities) {
+      record.vx.reserve(num_particles);
+      record.vy.reserve(num_particles);
+    }
+    if (options.speed_counts) {
+      record.speed_counts.reserve(num_speed_counts);
+    }
+  }
+}
+
+const SubscriptionOptions& FrameSubscription::GetOptions() const {
+  return options_;
+}
+
+const FrameRecord* FrameSubscription::Peek() const {
+  uint64_t read_count = read_count_.load(std::memory_order_relaxed);
+  //acquire, so the frame's contents are visible once its count is
+  if (read_count == write_count_.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  return &records_[read_count % records_.size()];
+}
+
+void FrameSubscription::Pop() {
+  uint64_t read_count = read_count_.load(std::memory_order_relaxed);
+  if (read_count == write_count_.load(std::memory_order_acquire)) {
+    throw std::logic_error("There is no frame to pop.");
+  }
+  //release, so the consumer is done reading the slot before the container can reuse it
+  read_count_.store(read_count + 1, std::memory_order_release);
+}
+
+size_t FrameSubscription::Size() const {
+  uint64_t read_count = read_count_.load(std::memory_order_acquire);
+  return size_t(write_count_.load(std::memory_order_acquire) - read_count);
+}
+
+bool FrameSubscription::IsFull() const {
+  return Size() >= records_.size();
+}
+
+uint64_t FrameSubscription::GetDroppedFrames() const {
+  return dropped_frames_.load(std::memory_order_relaxed);
+}
+
+FrameRecord* FrameSubscription::BeginWrite() {
+  uint64_t write_count = write_count_.load(std::memory_order_relaxed);
+  if (write_count - read_count_.load(std::memory_order_acquire) >= records_.size()) {
+    dropped_frames_.store(dropped_frames_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  return &records_[write_count % records_.size()];
+}
+
+void FrameSubscription::EndWrite() {
+  write_count_.store(write_count_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+FrameSubscribers::FrameSubscribers() {}
+
+FrameSubscribers::FrameSubscribers(const FrameSubscribers&) {}
+
+FrameSubscribers& FrameSubscribers::operator=(const FrameSubscribers&) {
+  return *this;
+}
+
+FrameSubscribers& FrameSubscribers::operator=(FrameSubscribers&&) {
+  //the other container's subscriptions stay with it, and its frames keep going to them
+  return *this;
+}
+
+void FrameSubscribers::Add(const std::shared_ptr<FrameSubscription>& subscription) {
+  subscriptions_.push_back(subscription);
+}
+
+bool FrameSubscribers::Remove(const std::shared_ptr<FrameSubscription>& subscription) {
+  vector<std::shared_ptr<FrameSubscription>>::iterator it = std::find(subscriptions_.begin(),
+                                                                      subscriptions_.end(), subscription);
+  if (it == subscriptions_.end()) {
+    return false;
+  }
+  subscriptions_.erase(it);
+  return true;
+}
+
+size_t FrameSubscribers::Size() const {
+  return subscriptions_.size();
+}
+
+FrameSubscription& FrameSubscribers::At(size_t index) const {
+  return *subscriptions_.at(index);
+}
+
+}  // namespace idealgas
@@ -1,162 +1,982 @@
 #include "gas_container.h"
+#include "checkpoint.h"
+#include "profiler.h"
+#include <stdexcept>
 
 namespace idealgas {
 
-GasContainer::GasContainer() {
+const vector<Species> GasContainer::kDefaultSpecies = {Species("white", 1.0, 5.0),
+                                                       Species("blue", 3.0, 8.0),
+                                                       Species("red", 5.0, 10.0)};
+
+GasContainer::GasContainer() : rng_(uint64_t(time(0))) {
   container_length_ = kDefaultLength;
   container_height_ = kDefaultHeight;
   margins_left_ = kDefaultLeftMargins;
   margins_top_ = kDefaultTopMargins;
-  particles_ = vector<Particle>();
-  paused_ = false;
-  //https://www.geeksforgeeks.org/rand-and-srand-in-ccpp/
-  srand(static_cast<unsigned int>(time(0)));
+  particles_ = ParticleStore();
+  SetNumThreads(1);
 
-  GenerateParticles(kDefaultNumParticles, kDefaultNumParticles, kDefaultNumParticles);
+  int num_particles = kDefaultNumParticles;
+  vector<pair<Species, int>> species_counts = vector<pair<Species, int>>();
+  for (size_t i = 0; i < kDefaultSpecies.size(); i++) {
+    species_counts.emplace_back(kDefaultSpecies.at(i), num_particles);
+  }
+  GenerateParticles(species_counts, Placement::kRandom);
   SetUpHistograms();
 }
 
 GasContainer::GasContainer(int length, int height, int margins_left, int margins_top, vector<Particle> particles) :
-                          container_length_(length), container_height_(height), margins_left_(margins_left),
-                          margins_top_(margins_top), particles_(move(particles)) {
-  paused_ = false;
+                          container_height_(height), container_length_(length), margins_top_(margins_top),
+                          margins_left_(margins_left), rng_(kDefaultSeed), particles_(particles) {
+  SetNumThreads(1);
+  for (size_t i = 0; i < particles_.Size(); i++) {
+    velocities_.push_back(glm::length(vec2(particles_.velocity[0][i], particles_.velocity[1][i])));
+  }
+  UpdateVelocityRange();
+  SetUpHistograms();
+}
+
+GasContainer::GasContainer(int length, int height, int margins_left, int margins_top,
+                           const vector<pair<Species, int>>& species_counts, uint64_t seed,
+                           size_t num_threads, Placement placement) :
+                          container_height_(height), container_length_(length), margins_top_(margins_top),
+                          margins_left_(margins_left), rng_(seed) {
+  SetNumThreads(num_threads);
+  GenerateParticles(species_counts, placement);
   SetUpHistograms();
 }
 
-void GasContainer::Display() const {
-  //draw the particles
-  for (size_t i = 0; i < particles_.size(); i++) {
-    particles_.at(i).DrawParticle();
+const ParticleStore& GasContainer::GetParticleStore() const {
+  return particles_;
+}
+
+const vector<Histogram>& GasContainer::GetHistograms() const {
+  CountPendingSpeeds();
+  if (histograms_stale_) {
+    FillHistograms();
   }
+  return histograms_;
+}
 
-  //draw the container
-  ci::gl::color(ci::Color("white"));
-  ci::gl::drawStrokedRect(ci::Rectf(vec2(margins_left_, margins_top_),
-                                    vec2(container_length_ + margins_left_, container_height_ + margins_top_)));
+void GasContainer::SetHistogramWindow(size_t num_frames, DistributionView view) {
+  if (num_frames == 0 || num_frames > kSpeedHistoryFrames) {
+    throw std::invalid_argument("The histogram window has to be between 1 frame and every frame kept.");
+  }
+  histogram_window_ = num_frames;
+  histogram_view_ = view;
+  histograms_stale_ = true;
+}
 
-  //draw the histograms
-  white_histogram_.DrawHistogram(vec2(margins_left_ * .1, margins_top_ + container_height_ * .3));
-  blue_histogram_.DrawHistogram(vec2(margins_left_ * .1, margins_top_ + container_height_ * .65));
-  red_histogram_.DrawHistogram(vec2(margins_left_ * .1, margins_top_ + container_height_));
+size_t GasContainer::GetHistogramWindow() const {
+  return histogram_window_;
+}
+
+DistributionView GasContainer::GetHistogramView() const {
+  return histogram_view_;
+}
+
+const SpeedDistribution& GasContainer::GetSpeedDistribution() const {
+  CountPendingSpeeds();
+  return speed_distribution_;
+}
+
+int GasContainer::GetLength() const {
+  return container_length_;
+}
+
+int GasContainer::GetHeight() const {
+  return container_height_;
+}
+
+int GasContainer::GetMarginsLeft() const {
+  return margins_left_;
+}
+
+int GasContainer::GetMarginsTop() const {
+  return margins_top_;
+}
+
+void GasContainer::SaveCheckpoint(const string& path) const {
+  CheckpointHeader header = CheckpointHeader();
+  header.length = container_length_;
+  header.height = container_height_;
+  header.margins_left = margins_left_;
+  header.margins_top = margins_top_;
+  header.collision_schedule = uint32_t(collision_schedule_);
+  header.rng_seed = rng_.GetSeed();
+  header.rng_counter = rng_counter_;
+  Checkpoint::Save(path, header, particles_, velocities_);
+}
+
+GasContainer GasContainer::LoadCheckpoint(const string& path) {
+  Checkpoint checkpoint(path);
+  const CheckpointHeader& header = checkpoint.GetHeader();
+  if (header.collision_schedule > uint32_t(CollisionSchedule::kNeighbourList)) {
+    throw std::runtime_error("Checkpoint has an unknown collision schedule.");
+  }
+
+  GasContainer container(header.length, header.height, header.margins_left, header.margins_top, vector<Particle>());
+  checkpoint.Restore(container.particles_, container.velocities_);
+  container.rng_ = Philox(header.rng_seed);
+  container.rng_counter_ = header.rng_counter;
+  container.collision_schedule_ = CollisionSchedule(header.collision_schedule);
+  container.UpdateVelocityRange();
+  container.SetUpHistograms();
+  return container;
 }
 
 void GasContainer::AdvanceOneFrame() {
   if (!paused_) {
-    HandleAllCollisions();
-    for (size_t i = 0; i < particles_.size(); i++) {
-      particles_.at(i).UpdateParticle();
+    IDEALGAS_PROFILE_SCOPE("AdvanceOneFrame");
+    if (frame_pipeline_ == FramePipeline::kTaskGraph) {
+      RunFrameGraph();
+    } else {
+      HandleAllCollisions();
+      IDEALGAS_PROFILE_SCOPE("Integrate");
+      ForEachParticle([this](size_t begin, size_t end, size_t) {
+        kernels_.Integrate(particles_, begin, end);
+      });
     }
     UpdateHistograms();
+    RecordObservables();
+    PublishFrame();
+  }
+}
+
+const ObservablesHistory& GasContainer::GetObservables() const {
+  return observables_;
+}
+
+std::shared_ptr<FrameSubscription> GasContainer::Subscribe(const SubscriptionOptions& options) {
+  std::shared_ptr<FrameSubscription> subscription = std::make_shared<FrameSubscription>(
+      options, particles_.Size(), speed_distribution_.GetNumSpecies() * speed_distribution_.GetNumBins());
+  subscribers_.Add(subscription);
+  return subscription;
+}
+
+bool GasContainer::Unsubscribe(const std::shared_ptr<FrameSubscription>& subscription) {
+  return subscribers_.Remove(subscription);
+}
+
+bool GasContainer::IsBackpressured() const {
+  for (size_t i = 0; i < subscribers_.Size(); i++) {
+    const FrameSubscription& subscription = subscribers_.At(i);
+    if (subscription.GetOptions().overflow_policy == OverflowPolicy::kBackpressure && subscription.IsFull()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void GasContainer::PublishFrame() {
+  if (subscribers_.Size() == 0) {
+    return;
+  }
+
+  IDEALGAS_PROFILE_SCOPE("PublishFrame");
+  for (size_t i = 0; i < subscribers_.Size(); i++) {
+    FrameSubscription& subscription = subscribers_.At(i);
+    FrameRecord* record = subscription.BeginWrite();
+    if (record == nullptr) {
+      continue;
+    }
+
+    //assigning into the slot's buffers reuses them, so this only allocates if particles were added
+    const SubscriptionOptions& options = subscription.GetOptions();
+    record->frame = num_frames_;
+    if (options.positions) {
+      record->x.assign(particles_.position[0].begin(), particles_.position[0].end());
+      record->y.assign(particles_.position[1].begin(), particles_.position[1].end());
+      record->species.assign(particles_.species.begin(), particles_.species.end());
+    }
+    if (options.velocities) {
+      record->vx.assign(particles_.velocity[0].begin(), particles_.velocity[0].end());
+      record->vy.assign(particles_.velocity[1].begin(), particles_.velocity[1].end());
+    }
+    if (options.speed_counts) {
+      CountPendingSpeeds();
+      const int* counts = speed_distribution_.GetFrameCounts(0);
+      record->speed_counts.assign(counts, counts + speed_distribution_.GetNumSpecies() *
+                                                   speed_distribution_.GetNumBins());
+      record->num_bins = speed_distribution_.GetNumBins();
+      record->max_speed = speed_distribution_.GetMaxSpeed();
+    }
+    if (options.observables) {
+      record->observables = observables_.GetFrame(0);
+    }
+    subscription.EndWrite();
   }
 }
 
 void GasContainer::HandleAllCollisions() {
-  for (size_t i = 0; i < particles_.size(); i++) {
-    Particle current_particle = particles_.at(i);
-    float current_x = current_particle.GetPosition().x;
-    float current_y = current_particle.GetPosition().y;
-    float current_radius = current_particle.GetRadius();
-    for (size_t j = i + 1; j < particles_.size(); j++) {
-
-      //check for collisions with other particles
-      if (current_particle.HasCollided(particles_.at(j))) {
-        pair<vec2, vec2> new_velocities = current_particle.GetVelocitiesAfterCollision(particles_.at(j));
-        particles_.at(i).SetVelocity(new_velocities.first);
-        particles_.at(j).SetVelocity(new_velocities.second);
-        velocities_.at(j) = glm::length(new_velocities.second);
+  IDEALGAS_PROFILE_SCOPE("HandleAllCollisions");
+  HandleParticleCollisions();
+
+  //walls only touch one particle each, so they go after every pair is resolved
+  IDEALGAS_PROFILE_SCOPE("ReflectWalls");
+  ForEachParticle([this](size_t begin, size_t end, size_t thread_index) {
+    ReflectWallsRange(begin, end, collision_scratch_.at(thread_index));
+  });
+}
+
+void GasContainer::HandleParticleCollisions() {
+  //the wall pass overwrites the speeds, so any the task graph left to count are counted first
+  CountPendingSpeeds();
+  ResetScratch();
+  if (collision_schedule_ == CollisionSchedule::kNeighbourList) {
+    HandleNeighbourListCollisions();
+  } else {
+    //only particles in neighbouring grid cells can have collided
+    grid_.Rebuild(particles_, vec2(margins_left_, margins_top_), vec2(container_length_, container_height_));
+
+    if (collision_schedule_ == CollisionSchedule::kCellColored) {
+      HandleCellColoredCollisions();
+      EqualizeScratchCapacity();
+    } else {
+      ResolveSequentialCollisions();
+    }
+  }
+}
+
+void GasContainer::StartLanedFrame(MemberLanes& lanes, size_t lane) {
+  if (lane >= MemberLanes::kNumLanes || lanes.NumSlots() < particles_.Size()) {
+    throw std::invalid_argument("The container's particles don't fit in the lane.");
+  }
+  HandleParticleCollisions();
+
+  lanes.sizes[lane] = int32_t(particles_.Size());
+  lanes.left[lane] = float(margins_left_);
+  lanes.right[lane] = float(container_length_ + margins_left_);
+  lanes.top[lane] = float(margins_top_);
+  lanes.bottom[lane] = float(container_height_ + margins_top_);
+  for (size_t k = 0; k < particles_.Size(); k++) {
+    size_t i = k * MemberLanes::kNumLanes + lane;
+    lanes.x[i] = particles_.position[0][k];
+    lanes.y[i] = particles_.position[1][k];
+    lanes.vx[i] = particles_.velocity[0][k];
+    lanes.vy[i] = particles_.velocity[1][k];
+    lanes.mass[i] = particles_.mass[k];
+    lanes.radius[i] = particles_.radius[k];
+  }
+}
+
+void GasContainer::FinishLanedFrame(const MemberLanes& lanes, size_t lane) {
+  for (size_t k = 0; k < particles_.Size(); k++) {
+    size_t i = k * MemberLanes::kNumLanes + lane;
+    particles_.position[0][k] = lanes.x[i];
+    particles_.position[1][k] = lanes.y[i];
+    particles_.velocity[0][k] = lanes.vx[i];
+    particles_.velocity[1][k] = lanes.vy[i];
+    velocities_[k] = lanes.speeds[i];
+  }
+
+  //the lane's totals stand in for the first thread's wall pass; the others were reset
+  const WallPassTotals& lane_totals = lanes.totals[lane];
+  CollisionScratch& totals = collision_scratch_.at(0);
+  totals.wall_impulses = lane_totals.wall_impulses;
+  totals.kinetic_energy = lane_totals.kinetic_energy;
+  totals.momentum_x = lane_totals.momentum_x;
+  totals.momentum_y = lane_totals.momentum_y;
+  totals.min_speed = lane_totals.min_speed;
+  totals.max_speed = lane_totals.max_speed;
+
+  UpdateHistograms();
+  RecordObservables();
+  PublishFrame();
+}
+
+void GasContainer::ResetScratch() {
+  for (size_t i = 0; i < collision_scratch_.size(); i++) {
+    collision_scratch_.at(i).num_particle_collisions = 0;
+    ResetWallTotals(collision_scratch_.at(i));
+  }
+}
+
+void GasContainer::ResetWallTotals(CollisionScratch& totals) {
+  totals.min_speed = std::numeric_limits<float>::infinity();
+  totals.max_speed = -std::numeric_limits<float>::infinity();
+  totals.wall_impulses = WallImpulses();
+  totals.kinetic_energy = 0;
+  totals.momentum_x = 0;
+  totals.momentum_y = 0;
+}
+
+void GasContainer::ResolveSequentialCollisions() {
+  //which pairs touch only depends on the positions, so they are found in cell order, where
+  //memory is read front to back, then resolved in index order with the current velocities
+  CollisionScratch& scratch = collision_scratch_.at(0);
+  grid_.FindTouchingPairs(scratch.colliding_first, scratch.colliding_second);
+  scratch.num_particle_collisions += kernels_.ResolveCollidingPairs(particles_, scratch.colliding_first,
+                                                                    scratch.colliding_second,
+                                                                    scratch.colliding_first.size());
+}
+
+void GasContainer::ReflectWallsRange(size_t begin, size_t end, CollisionScratch& totals) {
+  WallBounds walls = {float(margins_left_), float(container_length_ + margins_left_),
+                      float(margins_top_), float(container_height_ + margins_top_)};
+  kernels_.ReflectWalls(particles_, begin, end, walls, velocities_.data(), totals.wall_impulses);
+
+  //find the speed range, energy and momentum while the velocities just written are still in cache
+  double twice_kinetic_energy = 0;
+  double momentum_x = 0;
+  double momentum_y = 0;
+  for (size_t i = begin; i < end; i++) {
+    totals.min_speed = std::min(totals.min_speed, velocities_[i]);
+    totals.max_speed = std::max(totals.max_speed, velocities_[i]);
+    double mass = particles_.mass[i];
+    double vx = particles_.velocity[0][i];
+    double vy = particles_.velocity[1][i];
+    twice_kinetic_energy += mass * (vx * vx + vy * vy);
+    momentum_x += mass * vx;
+    momentum_y += mass * vy;
+  }
+  totals.kinetic_energy += twice_kinetic_energy / 2;
+  totals.momentum_x += momentum_x;
+  totals.momentum_y += momentum_y;
+}
+
+void GasContainer::RunFrameGraph() {
+  IDEALGAS_PROFILE_SCOPE("RunFrameGraph");
+  size_t num_chunks = (particles_.Size() + kFrameChunkSize - 1) / kFrameChunkSize;
+  if (frame_tasks_.empty() || frame_graph_schedule_ != collision_schedule_ ||
+      frame_graph_threads_ != GetNumThreads() || frame_graph_chunks_ != num_chunks) {
+    BuildFrameGraph(num_chunks);
+  }
+
+  ResetScratch();
+  if (collision_schedule_ == CollisionSchedule::kNeighbourList) {
+    //the rebuild check and the rebuild are parallel loops of their own, so they go before the graph
+    if (NeighbourListsNeedRebuild()) {
+      RebuildNeighbourLists();
+    }
+    neighbour_stats_.num_passes++;
+  }
+
+  RunGraph(frame_graph_, [this](size_t task, size_t thread_index) {
+    RunFrameTask(task, thread_index);
+  });
+
+  //add up the chunks' wall pass totals in chunk order, so they don't depend on which thread ran which chunk
+  CollisionScratch& totals = collision_scratch_.at(0);
+  for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+    const CollisionScratch& chunk_totals = chunk_scratch_.at(chunk);
+    totals.min_speed = std::min(totals.min_speed, chunk_totals.min_speed);
+    totals.max_speed = std::max(totals.max_speed, chunk_totals.max_speed);
+    totals.wall_impulses.left += chunk_totals.wall_impulses.left;
+    totals.wall_impulses.right += chunk_totals.wall_impulses.right;
+    totals.wall_impulses.top += chunk_totals.wall_impulses.top;
+    totals.wall_impulses.bottom += chunk_totals.wall_impulses.bottom;
+    totals.wall_impulses.num_bounces += chunk_totals.wall_impulses.num_bounces;
+    totals.kinetic_energy += chunk_totals.kinetic_energy;
+    totals.momentum_x += chunk_totals.momentum_x;
+    totals.momentum_y += chunk_totals.momentum_y;
+  }
+  if (collision_schedule_ == CollisionSchedule::kCellColored) {
+    EqualizeScratchCapacity();
+  }
+}
+
+void GasContainer::BuildFrameGraph(size_t num_chunks) {
+  frame_graph_.Clear();
+  frame_tasks_.clear();
+  frame_graph_schedule_ = collision_schedule_;
+  frame_graph_threads_ = GetNumThreads();
+  frame_graph_chunks_ = num_chunks;
+  chunk_scratch_.resize(num_chunks);
+
+  FrameTask count_speeds = {FrameTaskKind::kCountSpeeds, 0, 0};
+  frame_tasks_.push_back(count_speeds);
+  size_t counted = frame_graph_.AddTask();
+
+  //every collision task waits for the one before it, except the ones of a single color
+  size_t collided;
+  if (collision_schedule_ == CollisionSchedule::kNeighbourList) {
+    FrameTask resolve = {FrameTaskKind::kResolvePairs, 0, 0};
+    frame_tasks_.push_back(resolve);
+    collided = frame_graph_.AddTask();
+  } else {
+    FrameTask rebuild = {FrameTaskKind::kRebuildGrid, 0, 0};
+    frame_tasks_.push_back(rebuild);
+    collided = frame_graph_.AddTask();
+    if (collision_schedule_ == CollisionSchedule::kCellColored) {
+      size_t num_color_chunks = frame_graph_threads_ * kColorChunksPerThread;
+      for (int color = 0; color < 9; color++) {
+        FrameTask join = {FrameTaskKind::kJoin, 0, 0};
+        vector<size_t> color_tasks;
+        for (size_t chunk = 0; chunk < num_color_chunks; chunk++) {
+          FrameTask resolve = {FrameTaskKind::kResolveColorCells, color, chunk};
+          frame_tasks_.push_back(resolve);
+          color_tasks.push_back(frame_graph_.AddTask());
+          frame_graph_.AddDependency(collided, color_tasks.back());
+        }
+        frame_tasks_.push_back(join);
+        size_t joined = frame_graph_.AddTask();
+        for (size_t k = 0; k < color_tasks.size(); k++) {
+          frame_graph_.AddDependency(color_tasks.at(k), joined);
+        }
+        collided = joined;
+      }
+    } else {
+      FrameTask resolve = {FrameTaskKind::kResolvePairs, 0, 0};
+      frame_tasks_.push_back(resolve);
+      size_t resolved = frame_graph_.AddTask();
+      frame_graph_.AddDependency(collided, resolved);
+      collided = resolved;
+    }
+  }
+
+  //the wall pass overwrites the speeds, so it waits for the last frame's to be counted too
+  FrameTask join = {FrameTaskKind::kJoin, 0, 0};
+  frame_tasks_.push_back(join);
+  size_t walls_ready = frame_graph_.AddTask();
+  frame_graph_.AddDependency(counted, walls_ready);
+  frame_graph_.AddDependency(collided, walls_ready);
+
+  //each chunk is integrated once its own walls are done, while other chunks are still on theirs
+  for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+    FrameTask walls = {FrameTaskKind::kReflectWalls, 0, chunk};
+    frame_tasks_.push_back(walls);
+    size_t reflected = frame_graph_.AddTask();
+    frame_graph_.AddDependency(walls_ready, reflected);
+    FrameTask integrate = {FrameTaskKind::kIntegrate, 0, chunk};
+    frame_tasks_.push_back(integrate);
+    frame_graph_.AddDependency(reflected, frame_graph_.AddTask());
+  }
+}
+
+void GasContainer::RunFrameTask(size_t task, size_t thread_index) {
+  const FrameTask& frame_task = frame_tasks_[task];
+  size_t begin = frame_task.chunk * kFrameChunkSize;
+  size_t end = std::min(begin + kFrameChunkSize, particles_.Size());
+  switch (frame_task.kind) {
+    case FrameTaskKind::kCountSpeeds: {
+      IDEALGAS_PROFILE_SCOPE("CountSpeeds");
+      CountPendingSpeeds();
+      break;
+    }
+    case FrameTaskKind::kRebuildGrid: {
+      IDEALGAS_PROFILE_SCOPE("RebuildGrid");
+      grid_.Rebuild(particles_, vec2(margins_left_, margins_top_), vec2(container_length_, container_height_));
+      break;
+    }
+    case FrameTaskKind::kResolvePairs: {
+      IDEALGAS_PROFILE_SCOPE("ResolvePairs");
+      if (collision_schedule_ == CollisionSchedule::kNeighbourList) {
+        ResolveNeighbourListPairs();
+      } else {
+        ResolveSequentialCollisions();
+      }
+      break;
+    }
+    case FrameTaskKind::kResolveColorCells: {
+      IDEALGAS_PROFILE_SCOPE("ResolveColorCells");
+      //the grid is only known once it is rebuilt, so each chunk works out its cells when it runs
+      size_t num_color_columns;
+      size_t num_color_rows;
+      GetColorSize(frame_task.color, num_color_columns, num_color_rows);
+      size_t num_cells = num_color_columns * num_color_rows;
+      size_t num_color_chunks = frame_graph_threads_ * kColorChunksPerThread;
+      ResolveColorCells(frame_task.color, num_cells * frame_task.chunk / num_color_chunks,
+                        num_cells * (frame_task.chunk + 1) / num_color_chunks, thread_index);
+      break;
+    }
+    case FrameTaskKind::kJoin: {
+      break;
+    }
+    case FrameTaskKind::kReflectWalls: {
+      IDEALGAS_PROFILE_SCOPE("ReflectWalls");
+      CollisionScratch& totals = chunk_scratch_[frame_task.chunk];
+      ResetWallTotals(totals);
+      ReflectWallsRange(begin, end, totals);
+      break;
+    }
+    case FrameTaskKind::kIntegrate: {
+      IDEALGAS_PROFILE_SCOPE("Integrate");
+      kernels_.Integrate(particles_, begin, end);
+      break;
+    }
+  }
+}
+
+void GasContainer::CountPendingSpeeds() const {
+  if (speeds_pending_) {
+    speed_distribution_.AddFrame(particles_.species, velocities_);
+    speeds_pending_ = false;
+  }
+}
+
+void GasContainer::HandleCellColoredCollisions() {
+  //cells of one color are 3 cells apart, so the neighbourhoods they write to never overlap
+  for (int color = 0; color < 9; color++) {
+    size_t num_color_columns;
+    size_t num_color_rows;
+    GetColorSize(color, num_color_columns, num_color_rows);
+
+    //only capture what fits in std::function's own storage, so starting the loop doesn't allocate
+    ParallelFor(num_color_columns * num_color_rows, [this, color](size_t begin_cell, size_t end_cell,
+                                                                  size_t thread_index) {
+      ResolveColorCells(color, begin_cell, end_cell, thread_index);
+    });
+  }
+}
+
+void GasContainer::GetColorSize(int color, size_t& num_color_columns, size_t& num_color_rows) const {
+  num_color_columns = size_t(std::max((grid_.GetNumCells(0) - color % 3 + 2) / 3, 0));
+  num_color_rows = size_t(std::max((grid_.GetNumCells(1) - color / 3 + 2) / 3, 0));
+}
+
+void GasContainer::ResolveColorCells(int color, size_t begin_cell, size_t end_cell, size_t thread_index) {
+  size_t num_color_columns;
+  size_t num_color_rows;
+  GetColorSize(color, num_color_columns, num_color_rows);
+  const vector<size_t>& cell_particles = grid_.GetCellParticles();
+  CollisionScratch& scratch = collision_scratch_.at(thread_index);
+  for (size_t k = begin_cell; k < end_cell; k++) {
+    int column = color % 3 + 3 * int(k % num_color_columns);
+    int row = color / 3 + 3 * int(k / num_color_columns);
+    size_t begin = 0;
+    size_t end = 0;
+    grid_.GetCellRange({{column, row}}, begin, end);
+    scratch.candidate_first.clear();
+    scratch.candidate_second.clear();
+    for (size_t p = begin; p < end; p++) {
+      AppendCandidatePairs(cell_particles[p], scratch);
+    }
+    ResolveCandidatePairs(scratch);
+  }
+}
+
+void GasContainer::HandleNeighbourListCollisions() {
+  if (NeighbourListsNeedRebuild()) {
+    RebuildNeighbourLists();
+  }
+  neighbour_stats_.num_passes++;
+  ResolveNeighbourListPairs();
+}
+
+void GasContainer::ResolveNeighbourListPairs() {
+  //the same pairs, in the same order, as kSequential, with the candidates read from the lists
+  CollisionScratch& scratch = collision_scratch_.at(0);
+  for (size_t block_begin = 0; block_begin < particles_.Size(); block_begin += kCollisionBlockSize) {
+    size_t block_end = std::min(block_begin + kCollisionBlockSize, particles_.Size());
+    scratch.candidate_first.clear();
+    scratch.candidate_second.clear();
+    for (size_t i = block_begin; i < block_end; i++) {
+      for (size_t k = neighbour_starts_[i]; k < neighbour_starts_[i + 1]; k++) {
+        scratch.candidate_first.push_back(uint32_t(i));
+        scratch.candidate_second.push_back(neighbours_[k]);
       }
     }
+    ResolveCandidatePairs(scratch);
+  }
+}
 
-    //check for collisions with horizontal walls
-    if ((current_x - current_radius <= margins_left_ && current_particle.GetVelocity().x < 0)
-        || (current_x + current_radius >= container_length_ + margins_left_ && current_particle.GetVelocity().x > 0)) {
-      particles_.at(i).HandleHorizontalWallCollision();
+bool GasContainer::NeighbourListsNeedRebuild() {
+  if (neighbour_lists_stale_ || neighbour_x_.size() != particles_.Size()) {
+    return true;
+  }
+
+  for (size_t i = 0; i < collision_scratch_.size(); i++) {
+    collision_scratch_.at(i).max_displacement_squared = 0;
+  }
+  ForEachParticle([this](size_t begin, size_t end, size_t thread_index) {
+    float max_displacement_squared = 0;
+    for (size_t i = begin; i < end; i++) {
+      float dx = particles_.position[0][i] - neighbour_x_[i];
+      float dy = particles_.position[1][i] - neighbour_y_[i];
+      max_displacement_squared = std::max(max_displacement_squared, dx * dx + dy * dy);
+    }
+    CollisionScratch& scratch = collision_scratch_.at(thread_index);
+    scratch.max_displacement_squared = std::max(scratch.max_displacement_squared, max_displacement_squared);
+  });
+
+  //two particles moving straight at each other close the gap by twice the largest displacement
+  float max_displacement_squared = 0;
+  for (size_t i = 0; i < collision_scratch_.size(); i++) {
+    max_displacement_squared = std::max(max_displacement_squared, collision_scratch_.at(i).max_displacement_squared);
+  }
+  float half_skin = neighbour_skin_ / 2;
+  return max_displacement_squared > half_skin * half_skin;
+}
+
+void GasContainer::RebuildNeighbourLists() {
+  grid_.Rebuild(particles_, vec2(margins_left_, margins_top_), vec2(container_length_, container_height_),
+                neighbour_skin_);
+
+  //count each particle's neighbours first, so every list can be filled in place in parallel
+  size_t num_particles = particles_.Size();
+  neighbour_starts_.assign(num_particles + 1, 0);
+  ForEachParticle([this](size_t begin, size_t end, size_t thread_index) {
+    CollisionScratch& scratch = collision_scratch_.at(thread_index);
+    for (size_t i = begin; i < end; i++) {
+      grid_.FindCandidates(i, scratch.candidates);
+      size_t count = 0;
+      for (size_t k = 0; k < scratch.candidates.size(); k++) {
+        count += IsNeighbour(i, scratch.candidates[k]);
+      }
+      neighbour_starts_[i + 1] = count;
     }
+  });
+  for (size_t i = 0; i < num_particles; i++) {
+    neighbour_starts_[i + 1] += neighbour_starts_[i];
+  }
 
-    //check for collisions with vertical walls
-    if ((current_y - current_radius <= margins_top_ && current_particle.GetVelocity().y < 0)
-        || (current_y + current_radius >= container_height_ + margins_top_ && current_particle.GetVelocity().y > 0)) {
-      particles_.at(i).HandleVerticalWallCollision();
+  neighbours_.resize(neighbour_starts_[num_particles]);
+  ForEachParticle([this](size_t begin, size_t end, size_t thread_index) {
+    CollisionScratch& scratch = collision_scratch_.at(thread_index);
+    for (size_t i = begin; i < end; i++) {
+      grid_.FindCandidates(i, scratch.candidates);
+      size_t next = neighbour_starts_[i];
+      for (size_t k = 0; k < scratch.candidates.size(); k++) {
+        if (IsNeighbour(i, scratch.candidates[k])) {
+          neighbours_[next++] = uint32_t(scratch.candidates[k]);
+        }
+      }
     }
+  });
+
+  neighbour_x_.assign(particles_.position[0].begin(), particles_.position[0].end());
+  neighbour_y_.assign(particles_.position[1].begin(), particles_.position[1].end());
+  neighbour_lists_stale_ = false;
+  neighbour_stats_.num_rebuilds++;
+  neighbour_stats_.num_pairs = neighbours_.size();
+}
 
-    velocities_.at(i) = glm::length(particles_.at(i).GetVelocity());
+bool GasContainer::IsNeighbour(size_t i, size_t j) const {
+  float dx = particles_.position[0][i] - particles_.position[0][j];
+  float dy = particles_.position[1][i] - particles_.position[1][j];
+  float reach = particles_.radius[i] + particles_.radius[j] + neighbour_skin_;
+  return dx * dx + dy * dy <= reach * reach;
+}
+
+void GasContainer::EqualizeScratchCapacity() {
+  size_t candidates = 0;
+  size_t candidate_pairs = 0;
+  size_t colliding_pairs = 0;
+  for (size_t i = 0; i < collision_scratch_.size(); i++) {
+    const CollisionScratch& scratch = collision_scratch_.at(i);
+    candidates = std::max(candidates, scratch.candidates.capacity());
+    candidate_pairs = std::max(candidate_pairs, std::max(scratch.candidate_first.capacity(),
+                                                         scratch.candidate_second.capacity()));
+    colliding_pairs = std::max(colliding_pairs, std::max(scratch.colliding_first.capacity(),
+                                                         scratch.colliding_second.capacity()));
+  }
+  for (size_t i = 0; i < collision_scratch_.size(); i++) {
+    CollisionScratch& scratch = collision_scratch_.at(i);
+    scratch.candidates.reserve(candidates);
+    scratch.candidate_first.reserve(candidate_pairs);
+    scratch.candidate_second.reserve(candidate_pairs);
+    scratch.colliding_first.reserve(colliding_pairs);
+    scratch.colliding_second.reserve(colliding_pairs);
   }
 }
 
-void GasContainer::GenerateParticles(int num_white_particles, int num_blue_particles, int num_red_particles) {
-  GenerateWhiteParticles(num_white_particles);
-  GenerateBlueParticles(num_blue_particles);
-  GenerateRedParticles(num_red_particles);
+void GasContainer::AppendCandidatePairs(size_t i, CollisionScratch& scratch) const {
+  grid_.FindCandidates(i, scratch.candidates);
+  for (size_t k = 0; k < scratch.candidates.size(); k++) {
+    scratch.candidate_first.push_back(uint32_t(i));
+    scratch.candidate_second.push_back(uint32_t(scratch.candidates[k]));
+  }
+}
 
-  max_velocity_ = *std::max_element(velocities_.begin(), velocities_.end());
-  min_velocity_ = *std::min_element(velocities_.begin(), velocities_.end());
+void GasContainer::ResolveCandidatePairs(CollisionScratch& scratch) {
+  kernels_.FindCollidingPairs(particles_, scratch.candidate_first, scratch.candidate_second,
+                              scratch.candidate_first.size(), scratch.colliding_first, scratch.colliding_second);
+  scratch.num_particle_collisions += kernels_.ResolveCollidingPairs(particles_, scratch.colliding_first,
+                                                                    scratch.colliding_second,
+                                                                    scratch.colliding_first.size());
+}
+
+void GasContainer::SetNumThreads(size_t num_threads) {
+  if (num_threads > 1) {
+    thread_pool_ = std::make_shared<ThreadPool>(num_threads);
+  } else {
+    thread_pool_.reset();
+  }
+  collision_scratch_.resize(std::max(num_threads, size_t(1)));
+}
+
+size_t GasContainer::GetNumThreads() const {
+  return thread_pool_ ? thread_pool_->GetNumThreads() : 1;
+}
+
+void GasContainer::SetCollisionSchedule(CollisionSchedule schedule) {
+  collision_schedule_ = schedule;
+}
+
+void GasContainer::SetNeighbourSkin(float skin) {
+  if (!(skin >= 0)) {
+    throw std::invalid_argument("The neighbour skin can't be negative.");
+  }
+  neighbour_skin_ = skin;
+  neighbour_lists_stale_ = true;
+}
+
+float GasContainer::GetNeighbourSkin() const {
+  return neighbour_skin_;
+}
+
+const NeighbourListStats& GasContainer::GetNeighbourListStats() const {
+  return neighbour_stats_;
+}
+
+void GasContainer::SetSimdLevel(SimdLevel level) {
+  kernels_ = SimdKernels(level);
+}
+
+SimdLevel GasContainer::GetSimdLevel() const {
+  return kernels_.GetLevel();
+}
+
+void GasContainer::SetFramePipeline(FramePipeline pipeline) {
+  frame_pipeline_ = pipeline;
+}
+
+FramePipeline GasContainer::GetFramePipeline() const {
+  return frame_pipeline_;
 }
 
-void GasContainer::GenerateWhiteParticles(int num_particles) {
-  Particle p_white = kWhiteParticle;
-  for (int i = 0; i < num_particles; i++) {
-    p_white.InitializeParticle(container_length_, container_height_, margins_left_, margins_top_);
-    particles_.push_back(p_white.Copy());
-    velocities_.push_back(glm::length(p_white.GetVelocity()));
+void GasContainer::ParallelFor(size_t count, const std::function<void(size_t, size_t, size_t)>& task) {
+  if (thread_pool_) {
+    thread_pool_->ParallelFor(count, task);
+  } else if (count > 0) {
+    task(0, count, 0);
   }
 }
 
-void GasContainer::GenerateBlueParticles(int num_particles) {
-  Particle p_blue = kBlueParticle;
-  for (int i = 0; i < num_particles; i++) {
-    p_blue.InitializeParticle(container_length_, container_height_, margins_left_, margins_top_);
-    particles_.push_back(p_blue.Copy());
-    velocities_.push_back(glm::length(p_blue.GetVelocity()));
+void GasContainer::ForEachParticle(const std::function<void(size_t, size_t, size_t)>& task) {
+  ParallelFor(particles_.Size(), task);
+}
+
+void GasContainer::RunGraph(const TaskGraph& graph, const std::function<void(size_t, size_t)>& task) {
+  if (thread_pool_) {
+    thread_pool_->RunGraph(graph, task);
+  } else {
+    for (size_t i = 0; i < graph.Size(); i++) {
+      task(i, 0);
+    }
   }
 }
 
-void GasContainer::GenerateRedParticles(int num_particles) {
-  Particle p_red = kRedParticle;
-  for (int i = 0; i < num_particles; i++) {
-    p_red.InitializeParticle(container_length_, container_height_, margins_left_, margins_top_);
-    particles_.push_back(p_red.Copy());
-    velocities_.push_back(glm::length(p_red.GetVelocity()));
+void GasContainer::GenerateParticles(const vector<pair<Species, int>>& species_counts, Placement placement) {
+  //reserve every species' particles up front, so growing the arrays never copies them
+  size_t num_particles = particles_.Size();
+  for (size_t i = 0; i < species_counts.size(); i++) {
+    num_particles += size_t(std::max(species_counts.at(i).second, 0));
   }
+  particles_.Reserve(num_particles);
+  velocities_.reserve(num_particles);
+
+  for (size_t i = 0; i < species_counts.size(); i++) {
+    int species_id = particles_.species_registry.Register(species_counts.at(i).first);
+    GenerateParticles(species_id, species_counts.at(i).second);
+  }
+  ParticlePlacer placer(float(margins_left_), float(margins_top_), float(container_length_),
+                        float(container_height_), rng_);
+  placer.Place(placement, particles_);
+
+  UpdateVelocityRange();
+}
+
+void GasContainer::GenerateParticles(int species_id, int num_particles) {
+  if (num_particles <= 0) {
+    return;
+  }
+
+  const Species& species = particles_.species_registry.GetSpecies(species_id);
+  if (species.radius < 1 || container_length_ - 2 * species.radius < 1 || container_height_ - 2 * species.radius < 1) {
+    throw std::invalid_argument("Species " + species.name + " does not fit in the container.");
+  }
+
+  size_t first = particles_.Size();
+  uint64_t first_counter = rng_counter_;
+  particles_.Resize(first + size_t(num_particles));
+  velocities_.resize(first + size_t(num_particles));
+  ParallelFor(size_t(num_particles), [&](size_t begin, size_t end, size_t) {
+    vec2 position;
+    vec2 velocity;
+    for (size_t i = begin; i < end; i++) {
+      ParticleStore::GetRandomState(rng_, first_counter + i, species.radius, vec2(margins_left_, margins_top_),
+                                    vec2(container_length_, container_height_), position, velocity);
+      particles_.Set(first + i, species_id, position, velocity);
+      velocities_[first + i] = glm::length(velocity);
+    }
+  });
+  rng_counter_ += uint64_t(num_particles);
 }
 
 vector<float> GasContainer::GetVelocitiesOfParticleColor(const string &color) {
+  //several species can share a color, so mark which ones match before looping over particles
+  vector<bool> matching_species = vector<bool>(particles_.species_registry.Size(), false);
+  for (size_t i = 0; i < matching_species.size(); i++) {
+    matching_species.at(i) = particles_.species_registry.GetSpecies(int(i)).name == color;
+  }
+
+  vector<float> to_return = vector<float>();
+  for (size_t i = 0; i < particles_.Size(); i++) {
+    if (matching_species.at(particles_.species[i])) {
+      to_return.push_back(glm::length(vec2(particles_.velocity[0][i], particles_.velocity[1][i])));
+    }
+  }
+  return to_return;
+}
+
+vector<float> GasContainer::GetVelocitiesOfSpecies(int species_id) {
   vector<float> to_return = vector<float>();
-  for (size_t i = 0; i < particles_.size(); i++) {
-    if (particles_.at(i).GetColor() == color) {
-      to_return.push_back(glm::length(particles_.at(i).GetVelocity()));
+  for (size_t i = 0; i < particles_.Size(); i++) {
+    if (particles_.species[i] == species_id) {
+      to_return.push_back(glm::length(vec2(particles_.velocity[0][i], particles_.velocity[1][i])));
     }
   }
   return to_return;
 }
 
+const SpeciesRegistry& GasContainer::GetSpeciesRegistry() const {
+  return particles_.species_registry;
+}
+
+uint64_t GasContainer::GetSeed() const {
+  return rng_.GetSeed();
+}
+
+const vector<float>& GasContainer::GetSpeeds() const {
+  return velocities_;
+}
+
+void GasContainer::SetSpeedCounting(bool enabled) {
+  speed_counting_ = enabled;
+}
+
+bool GasContainer::GetSpeedCounting() const {
+  return speed_counting_;
+}
+
 void GasContainer::SetUpHistograms() {
   int length = int(margins_left_ * .8);
-  int height = int(container_height_ * .3);
   int segments = 10;
-  white_histogram_ = Histogram("white", length, height, max_velocity_, min_velocity_,
-                               GetVelocitiesOfParticleColor("white"), segments);
-  blue_histogram_ = Histogram("blue", length, height, max_velocity_, min_velocity_,
-                              GetVelocitiesOfParticleColor("blue"), segments);
-  red_histogram_ = Histogram("red", length, height, max_velocity_, min_velocity_,
-                             GetVelocitiesOfParticleColor("red"), segments);
-  white_histogram_.SetUp();
-  blue_histogram_.SetUp();
-  red_histogram_.SetUp();
+  histograms_ = vector<Histogram>();
+  histograms_stale_ = false;
+  speeds_pending_ = false;
+  if (particles_.species_registry.Size() == 0) {
+    return;
+  }
+  int height = int(container_height_ * .9 / particles_.species_registry.Size());
+  for (size_t i = 0; i < particles_.species_registry.Size(); i++) {
+    histograms_.emplace_back(particles_.species_registry.GetSpecies(int(i)).name, length, height,
+                             max_velocity_, min_velocity_, vector<float>(), segments);
+  }
+
+  float max_speed = max_velocity_ > 0 ? kSpeedRangeScale * max_velocity_ : 1;
+  speed_distribution_ = SpeedDistribution(particles_.species_registry.Size(), size_t(segments), max_speed,
+                                          kSpeedHistoryFrames);
+  speed_distribution_.AddFrame(particles_.species, velocities_);
+  FillHistograms();
 }
 
-void GasContainer::UpdateHistograms() {
+void GasContainer::UpdateVelocityRange() {
+  if (velocities_.empty()) {
+    max_velocity_ = 0;
+    min_velocity_ = 0;
+    return;
+  }
   max_velocity_ = *std::max_element(velocities_.begin(), velocities_.end());
   min_velocity_ = *std::min_element(velocities_.begin(), velocities_.end());
-  white_histogram_.Update(GetVelocitiesOfParticleColor("white"), max_velocity_, min_velocity_);
-  white_histogram_.FindVelocityDistribution();
-  blue_histogram_.Update(GetVelocitiesOfParticleColor("blue"), max_velocity_, min_velocity_);
-  blue_histogram_.FindVelocityDistribution();
-  red_histogram_.Update(GetVelocitiesOfParticleColor("red"), max_velocity_, min_velocity_);
-  red_histogram_.FindVelocityDistribution();
+}
+
+void GasContainer::RecordObservables() {
+  num_frames_++;
+  size_t num_particle_collisions = 0;
+  WallImpulses impulses = WallImpulses();
+  double kinetic_energy = 0;
+  double momentum_x = 0;
+  double momentum_y = 0;
+  for (size_t i = 0; i < collision_scratch_.size(); i++) {
+    const CollisionScratch& scratch = collision_scratch_.at(i);
+    num_particle_collisions += scratch.num_particle_collisions;
+    impulses.left += scratch.wall_impulses.left;
+    impulses.right += scratch.wall_impulses.right;
+    impulses.top += scratch.wall_impulses.top;
+    impulses.bottom += scratch.wall_impulses.bottom;
+    impulses.num_bounces += scratch.wall_impulses.num_bounces;
+    kinetic_energy += scratch.kinetic_energy;
+    momentum_x += scratch.momentum_x;
+    momentum_y += scratch.momentum_y;
+  }
+
+  //a frame is one unit of time, so the momentum a wall takes in a frame is its force
+  FrameObservables frame = FrameObservables();
+  frame.frame = num_frames_;
+  frame.num_frames = 1;
+  frame.kinetic_energy = kinetic_energy;
+  frame.temperature = particles_.Size() == 0 ? 0 : kinetic_energy / double(particles_.Size());
+  frame.momentum_x = momentum_x;
+  frame.momentum_y = momentum_y;
+  frame.pressure_left = impulses.left / container_height_;
+  frame.pressure_right = impulses.right / container_height_;
+  frame.pressure_top = impulses.top / container_length_;
+  frame.pressure_bottom = impulses.bottom / container_length_;
+  frame.pressure = (impulses.left + impulses.right + impulses.top + impulses.bottom) /
+                   (2.0 * (container_length_ + container_height_));
+  frame.particle_collisions = double(num_particle_collisions);
+  frame.wall_collisions = double(impulses.num_bounces);
+  observables_.Add(frame);
+}
+
+void GasContainer::UpdateHistograms() {
+  IDEALGAS_PROFILE_SCOPE("UpdateHistograms");
+  //the wall pass found each thread's speed range
+  if (particles_.Size() == 0) {
+    max_velocity_ = 0;
+    min_velocity_ = 0;
+  } else {
+    min_velocity_ = collision_scratch_.at(0).min_speed;
+    max_velocity_ = collision_scratch_.at(0).max_speed;
+    for (size_t i = 1; i < collision_scratch_.size(); i++) {
+      min_velocity_ = std::min(min_velocity_, collision_scratch_.at(i).min_speed);
+      max_velocity_ = std::max(max_velocity_, collision_scratch_.at(i).max_speed);
+    }
+  }
+  //the task graph counts them at the start of the next frame instead, alongside the broadphase
+  if (!speed_counting_) {
+    speeds_pending_ = false;
+  } else if (frame_pipeline_ == FramePipeline::kTaskGraph) {
+    speeds_pending_ = true;
+  } else {
+    speed_distribution_.AddFrame(particles_.species, velocities_);
+  }
+  histograms_stale_ = true;
+}
+
+void GasContainer::FillHistograms() const {
+  histograms_stale_ = false;
+  size_t num_frames = std::min(histogram_window_, speed_distribution_.GetNumFrames());
+  if (num_frames > 1) {
+    for (size_t i = 0; i < histograms_.size(); i++) {
+      vector<double> distribution = speed_distribution_.GetDistribution(int(i), num_frames, histogram_view_);
+      histograms_.at(i).Reset(speed_distribution_.GetMaxSpeed(), 0);
+      for (size_t bar = 0; bar < distribution.size(); bar++) {
+        histograms_.at(i).AddCount(int(bar), distribution.at(bar));
+      }
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < histograms_.size(); i++) {
+    histograms_.at(i).Reset(max_velocity_, min_velocity_);
+  }
+  for (size_t i = 0; i < particles_.Size(); i++) {
+    histograms_[particles_.species[i]].AddVelocity(velocities_[i]);
+  }
 }
 
 vector<Particle> GasContainer::GetParticles() {
-  return particles_;
+  vector<Particle> particles = vector<Particle>();
+  particles.reserve(particles_.Size());
+  for (size_t i = 0; i < particles_.Size(); i++) {
+    particles.push_back(particles_.GetParticle(i));
+  }
+  return particles;
 }
 
 bool GasContainer::GetPaused() {
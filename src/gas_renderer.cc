@@ -0,0 +1,80 @@
+#include "gas_renderer.h"
+#include "profiler.h"
+
+namespace idealgas {
+
+void GasRenderer::DrawContainer(const GasContainer& container) {
+  const ParticleStore& particles = container.GetParticleStore();
+  DrawScene(particles.position[0], particles.position[1], particles.radius, particles.species, particles.species_registry,
+            container.GetHistograms(), container.GetLength(), container.GetHeight(), container.GetMarginsLeft(),
+            container.GetMarginsTop());
+}
+
+void GasRenderer::DrawContainer(const EventDrivenContainer& container) {
+  const ParticleStore& particles = container.GetParticleStore();
+  DrawScene(particles.position[0], particles.position[1], particles.radius, particles.species, particles.species_registry,
+            container.GetHistograms(), container.GetLength(), container.GetHeight(), container.GetMarginsLeft(),
+            container.GetMarginsTop());
+}
+
+void GasRenderer::DrawSnapshot(const SimulationSnapshot& snapshot) {
+  vector<Histogram> histograms;
+  snapshot.BuildHistograms(histograms);
+  DrawScene(snapshot.x, snapshot.y, snapshot.radius, snapshot.species, snapshot.species_registry,
+            histograms, snapshot.length, snapshot.height, snapshot.margins_left, snapshot.margins_top);
+}
+
+void GasRenderer::DrawScene(const vector<float>& x, const vector<float>& y, const vector<float>& radius,
+                            const vector<int>& species, const SpeciesRegistry& species_registry,
+                            const vector<Histogram>& histograms, int length, int height, int margins_left,
+                            int margins_top) {
+  IDEALGAS_PROFILE_SCOPE("GasRenderer::DrawScene");
+
+  //draw the particles, only switching colors when the species changes
+  int current_species = -1;
+  for (size_t i = 0; i < x.size(); i++) {
+    if (species[i] != current_species) {
+      current_species = species[i];
+      ci::gl::color(ci::Color(species_registry.GetSpecies(current_species).name.c_str()));
+    }
+    ci::gl::drawSolidCircle(vec2(x[i], y[i]), radius[i]);
+  }
+
+  //draw the container
+  ci::gl::color(ci::Color("white"));
+  ci::gl::drawStrokedRect(ci::Rectf(vec2(margins_left, margins_top),
+                                    vec2(length + margins_left, height + margins_top)));
+
+  //draw the histograms, stacked down the left margin
+  for (size_t i = 0; i < histograms.size(); i++) {
+    float bottom = float(i + 1) / float(histograms.size());
+    DrawHistogram(histograms.at(i), vec2(margins_left * .1, margins_top + height * bottom));
+  }
+}
+
+void GasRenderer::DrawHistogram(const Histogram& histogram, const vec2& corner) {
+  if (corner.x < 0 || corner.y < 0) {
+    throw std::invalid_argument("Corner cannot be negative.");
+  }
+
+  int length = histogram.GetLength();
+  int height = histogram.GetHeight();
+  const vector<double>& bar_heights = histogram.GetBarHeights();
+  ci::Rectf rectangle = ci::Rectf(corner, vec2(corner.x + float(length), corner.y - float(height)));
+  ci::gl::color(ci::Color(histogram.GetColor().c_str()));
+  ci::gl::drawStrokedRect(rectangle);
+  float bar_length = float(length) / float(bar_heights.size());
+
+  for (size_t i = 0; i < bar_heights.size(); i++) {
+    vec2 bottom_left_corner = vec2(corner.x + float(float(i) * bar_length), corner.y);
+    vec2 top_right_corner = vec2(corner.x + float(float(i + 1) * bar_length),
+                                 corner.y - float(height / 30) * float(bar_heights.at(i)));
+    ci::Rectf bar = ci::Rectf(bottom_left_corner, top_right_corner);
+    ci::gl::drawSolidRect(bar);
+  }
+
+  ci::gl::drawString("Speed", vec2(corner.x, corner.y + 5));
+  ci::gl::drawString("F\nr\ne\nq\nu\ne\nn\nc\ny", vec2(corner.x - 10, corner.y - height * .75));
+}
+
+}  // namespace idealgas
@@ -1,25 +1,23 @@
 #include "gas_simulation_app.h"
+#include "profiler.h"
 
 namespace idealgas {
 
-IdealGasApp::IdealGasApp() {
+IdealGasApp::IdealGasApp() : simulation_(GasContainer()) {
   ci::app::setWindowSize(kWindowSize, kWindowSize);
 }
 
 void IdealGasApp::draw() {
+  IDEALGAS_PROFILE_SCOPE("IdealGasApp::draw");
   ci::Color background_color("black");
   ci::gl::clear(background_color);
 
-  container_.Display();
-}
-
-void IdealGasApp::update() {
-  container_.AdvanceOneFrame();
+  GasRenderer::DrawSnapshot(simulation_.GetLatestSnapshot());
 }
 
 void IdealGasApp::keyUp(KeyEvent event) {
   if (event.getCode() == KeyEvent::KEY_SPACE) {
-    container_.SetPaused(!container_.GetPaused());
+    simulation_.SetPaused(!simulation_.GetPaused());
   }
 }
 
@@ -7,42 +7,20 @@ Histogram::Histogram() {}
 Histogram::Histogram(const string& color, int length, int height, float max_velocity,
                      float min_velocity, const vector<float>& velocities, int num_segments) :
                       color_(color), length_(length), height_(height),
-                      max_velocity_(max_velocity), min_velocity_(min_velocity), velocities_(velocities),
-                      num_segments_(num_segments) {
+                      max_velocity_(max_velocity), min_velocity_(min_velocity), num_segments_(num_segments),
+                      velocities_(velocities) {
   if (num_segments < 1 || max_velocity < min_velocity) {
     throw std::invalid_argument("One or more parameters were invalid");
   }
 }
 
 Histogram::Histogram(const vector<float>& velocities, float max_velocity, float min_velocity, int num_segments) :
-                      velocities_(velocities), max_velocity_(max_velocity), min_velocity_(min_velocity), num_segments_(num_segments) {
+                      max_velocity_(max_velocity), min_velocity_(min_velocity), num_segments_(num_segments), velocities_(velocities) {
   if (num_segments < 1 || max_velocity < min_velocity) {
     throw std::invalid_argument("One or more parameters were invalid");
   }
 }
 
-void Histogram::DrawHistogram(const vec2& corner) const {
-  if (corner.x < 0 || corner.y < 0) {
-    throw std::invalid_argument("Corner cannot be negative.");
-  }
-
-  ci::Rectf rectangle = ci::Rectf(corner, vec2(corner.x + float(length_), corner.y - float(height_)));
-  ci::gl::color(ci::Color(color_.c_str()));
-  ci::gl::drawStrokedRect(rectangle);
-  float bar_length = float(length_) / num_segments_;
-
-  for (int i = 0; i < num_segments_; i++) {
-    vec2 bottom_left_corner = vec2(corner.x + float(float(i) * bar_length), corner.y);
-    vec2 top_right_corner = vec2(corner.x + float(float(i + 1) * bar_length),
-                                 corner.y - float(height_ / 30) * float(velocity_distribution_.at(i).second));
-    ci::Rectf bar = ci::Rectf(bottom_left_corner, top_right_corner);
-    ci::gl::drawSolidRect(bar);
-  }
-
-  ci::gl::drawString("Speed", vec2(corner.x, corner.y + 5));
-  ci::gl::drawString("F\nr\ne\nq\nu\ne\nn\nc\ny", vec2(corner.x - 10, corner.y - height_ * .75));
-}
-
 void Histogram::Update(const vector<float>& new_velocities) {
   velocities_ = new_velocities;
 }
@@ -54,25 +32,57 @@ void Histogram::Update(const vector<float>& new_velocities, float max_velocity,
 }
 
 void Histogram::SetUp() {
-  velocity_distribution_ = vector<pair<int, int>>();
-  for (int i = 0; i < num_segments_; i++) {
-    velocity_distribution_.emplace_back(i, 0);
-  }
+  bar_heights_.assign(size_t(num_segments_), 0);
   bar_range_ = (max_velocity_ - min_velocity_) / float(num_segments_);
   std::sort(velocities_.begin(), velocities_.end());
 }
 
 void Histogram::FindVelocityDistribution() {
-  int current_bar = 0;
-  SetUp();
-  for (size_t i = 0; i < velocities_.size() && current_bar < num_segments_; i) {
-    if (velocities_.at(i) <= (bar_range_ * float(current_bar + 1)) + min_velocity_) {
-      velocity_distribution_.at(current_bar).second = velocity_distribution_.at(current_bar).second + 1;
-      i++;
-    } else {
-      current_bar++;
-    }
+  Reset(max_velocity_, min_velocity_);
+  for (size_t i = 0; i < velocities_.size(); i++) {
+    AddVelocity(velocities_[i]);
+  }
+}
+
+void Histogram::Reset(float max_velocity, float min_velocity) {
+  max_velocity_ = max_velocity;
+  min_velocity_ = min_velocity;
+  bar_range_ = (max_velocity_ - min_velocity_) / float(num_segments_);
+  bar_heights_.assign(size_t(num_segments_), 0);
+}
+
+void Histogram::AddVelocity(float velocity) {
+  int bar = GetBar(velocity);
+  if (bar < num_segments_) {
+    bar_heights_[bar]++;
+  }
+}
+
+void Histogram::AddCount(int bar, double count) {
+  if (bar < 0 || bar >= num_segments_) {
+    throw std::invalid_argument("The bar is not in the histogram.");
   }
+  bar_heights_.at(size_t(bar)) += count;
+}
+
+int Histogram::GetBar(float velocity) const {
+  if (std::isnan(velocity)) {
+    return num_segments_;
+  }
+  if (!(bar_range_ > 0)) {
+    return velocity <= min_velocity_ ? 0 : num_segments_;
+  }
+
+  //estimate the bar, then step to the exact one using the same bar tops as the ordered walk
+  float estimate = std::ceil((velocity - min_velocity_) / bar_range_) - 1;
+  int bar = int(std::min(std::max(estimate, 0.0f), float(num_segments_)));
+  while (bar > 0 && velocity <= bar_range_ * float(bar) + min_velocity_) {
+    bar--;
+  }
+  while (bar < num_segments_ && velocity > bar_range_ * float(bar + 1) + min_velocity_) {
+    bar++;
+  }
+  return bar;
 }
 
 vector<float> Histogram::GetVelocities() {
@@ -83,8 +93,29 @@ float Histogram::GetBarRange() {
   return bar_range_;
 }
 
-vector<pair<int, int>> Histogram::GetVelocityDistribution() {
-  return vector<pair<int, int>>(velocity_distribution_);
+vector<pair<int, int>> Histogram::GetVelocityDistribution() const {
+  vector<pair<int, int>> distribution = vector<pair<int, int>>();
+  distribution.reserve(bar_heights_.size());
+  for (size_t i = 0; i < bar_heights_.size(); i++) {
+    distribution.emplace_back(int(i), int(std::lround(bar_heights_[i])));
+  }
+  return distribution;
+}
+
+const vector<double>& Histogram::GetBarHeights() const {
+  return bar_heights_;
+}
+
+const string& Histogram::GetColor() const {
+  return color_;
+}
+
+int Histogram::GetLength() const {
+  return length_;
+}
+
+int Histogram::GetHeight() const {
+  return height_;
 }
 
 }
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "observables.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace idealgas {
+
+void AddObservables(const FrameObservables& frame, FrameObservables& total) {
+  total.kinetic_energy += frame.kinetic_energy;
+  total.temperature += frame.temperature;
+  total.momentum_x += frame.momentum_x;
+  total.momentum_y += frame.momentum_y;
+  total.pressure_left += frame.pressure_left;
+  total.pressure_right += frame.pressure_right;
+  total.pressure_top += frame.pressure_top;
+  total.pressure_bottom += frame.pressure_bottom;
+  total.pressure += frame.pressure;
+  total.particle_collisions += frame.particle_collisions;
+  total.wall_collisions += frame.wall_collisions;
+}
+
+void DivideObservables(FrameObservables& total, double count) {
+  total.kinetic_energy /= count;
+  total.temperature /= count;
+  total.momentum_x /= count;
+  total.momentum_y /= count;
+  total.pressure_left /= count;
+  total.pressure_right /= count;
+  total.pressure_top /= count;
+  total.pressure_bottom /= count;
+  total.pressure /= count;
+  total.particle_collisions /= count;
+  total.wall_collisions /= count;
+}
+
+const size_t ObservablesHistory::kDefaultCapacity;
+
+ObservablesHistory::ObservablesHistory(size_t capacity) : next_(0), size_(0) {
+  if (capacity == 0) {
+    throw std::invalid_argument("The history has to keep at least one frame.");
+  }
+  frames_.resize(capacity);
+}
+
+void ObservablesHistory::Add(const FrameObservables& frame) {
+  frames_[next_] = frame;
+  next_ = (next_ + 1) % frames_.size();
+  size_ = std::min(size_ + 1, frames_.size());
+}
+
+const FrameObservables& ObservablesHistory::GetFrame(size_t frames_ago) const {
+  if (frames_ago >= size_) {
+    throw std::invalid_argument("That frame is not in the history.");
+  }
+  return frames_[(next_ + frames_.size() - 1 - frames_ago) % frames_.size()];
+}
+
+FrameObservables ObservablesHistory::GetAverage(size_t num_frames) const {
+  if (num_frames == 0 || num_frames > size_) {
+    throw std::invalid_argument("Can only average between 1 frame and every frame in the history.");
+  }
+
+  FrameObservables average = FrameObservables();
+  for (size_t i = 0; i < num_frames; i++) {
+    AddObservables(GetFrame(i), average);
+  }
+  DivideObservables(average, double(num_frames));
+  average.frame = GetFrame(0).frame;
+  average.num_frames = num_frames;
+  return average;
+}
+
+size_t ObservablesHistory::Size() const {
+  return size_;
+}
+
+size_t ObservablesHistory::GetCapacity() const {
+  return frames_.size();
+}
+
+void ObservablesHistory::Clear() {
+  next_ = 0;
+  size_ = 0;
+}
+
+}  // namespace idealgas
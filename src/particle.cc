@@ -1,4 +1,6 @@
 #include <particle.h>
+#include <particle_store.h>
+#include <physics.h>
 
 #include <utility>
 
@@ -41,19 +43,25 @@ pair<vec2, vec2> Particle::GetVelocitiesAfterCollision(const Particle& other) {
 }
 
 void Particle::HandleVerticalWallCollision() {
-  SetVelocity(vec2(velocity_.x, velocity_.y * -1));
+  ReflectAxis(velocity_, 1);
 }
 
 void Particle::HandleHorizontalWallCollision() {
-  SetVelocity(vec2(velocity_.x * -1, velocity_.y));
+  ReflectAxis(velocity_, 0);
 }
 
 void Particle::InitializeParticle(int container_length, int container_height, int margins_left, int margins_top) {
-  //sets position to some random value within the container, outside margins
-  position_ = vec2((rand() % int(container_length - 2 * radius_))
-                       + radius_ + margins_left, (rand() % int(container_height - 2 * radius_)) + margins_top + radius_);
-  //sets velocity to somewhere between -radius and +radius
-  velocity_ = vec2((rand() % int(radius_) - int(radius_ / 2)), (rand() % int(radius_)) - int(radius_ / 2));
+  std::array<uint32_t, 4> random_words = {{uint32_t(rand()), uint32_t(rand()), uint32_t(rand()), uint32_t(rand())}};
+  GetRandomState(random_words, radius_, container_length, container_height, margins_left, margins_top, position_,
+                 velocity_);
+}
+
+void Particle::GetRandomState(const std::array<uint32_t, 4>& random_words, float radius, int container_length,
+                              int container_height, int margins_left, int margins_top, vec2& position,
+                              vec2& velocity) {
+  //somewhere within the container, outside margins, moving at up to half the radius along each axis
+  ParticleStore::GetRandomState(random_words.data(), radius, vec2(margins_left, margins_top),
+                                vec2(container_length, container_height), position, velocity);
 }
 
 vec2 Particle::GetNewVelocity(const vec2& velocity1,
@@ -62,9 +70,15 @@ vec2 Particle::GetNewVelocity(const vec2& velocity1,
                               const vec2& position2,
                               const float& mass1,
                               const float& mass2) {
-  return velocity1 - (((2 * mass2) / (mass1 + mass2)) * (glm::dot((velocity1 - velocity2),(position1 - position2))
-                       / (glm::length(position1 - position2) * glm::length(position1 - position2)))
-                      * (position1 - position2));
+  return GetNewVelocity(velocity1, velocity2, position1, position2, GetCollisionCoefficient(mass1, mass2));
+}
+
+vec2 Particle::GetNewVelocity(const vec2& velocity1,
+                              const vec2& velocity2,
+                              const vec2& position1,
+                              const vec2& position2,
+                              float coefficient) {
+  return GetVelocityAfterCollision(velocity1, velocity2, position1, position2, coefficient);
 }
 
 bool Particle::HasCollided(const Particle& other) {
@@ -82,11 +96,6 @@ Particle Particle::Copy() {
   return Particle(position_, velocity_, color_, mass_, radius_);
 }
 
-void Particle::DrawParticle() const {
-  ci::gl::color(ci::Color(color_.c_str()));
-  ci::gl::drawSolidCircle(position_, radius_);
-}
-
 vec2 Particle::GetPosition() const {
   return position_;
 }
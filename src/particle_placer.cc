@@ -0,0 +1,255 @@
+#include "particle_placer.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+namespace idealgas {
+
+namespace {
+
+//space left between placed particles, so rounding never makes them touch
+const float kMinGap = 0.01f;
+
+//marks a cell that no longer takes darts, in place of its index in the open cells
+const uint32_t kClosedCell = 0xffffffff;
+
+/**
+ * A random position in one cell, to try placing a particle at
+ */
+struct Dart {
+  uint32_t cell;
+  int column;
+  int row;
+  float x;
+  float y;
+};
+
+}  // namespace
+
+ParticlePlacer::ParticlePlacer(float min_x, float min_y, float width, float height, const Philox& rng) :
+                               min_x_(min_x), min_y_(min_y), width_(width), height_(height), rng_(rng) {}
+
+void ParticlePlacer::Place(Placement placement, ParticleStore& particles) const {
+  if (placement == Placement::kJitteredLattice) {
+    PlaceOnJitteredLattice(particles);
+  } else if (placement == Placement::kPoissonDisk) {
+    PlacePoissonDisk(particles);
+  }
+}
+
+void ParticlePlacer::PlaceOnJitteredLattice(ParticleStore& particles) const {
+  size_t num_particles = particles.Size();
+  if (num_particles == 0) {
+    return;
+  }
+
+  //about square sites, at least one per particle
+  float max_radius = *std::max_element(particles.radius.begin(), particles.radius.end());
+  size_t num_columns = std::max(size_t(std::ceil(std::sqrt(double(num_particles) * width_ / height_))), size_t(1));
+  size_t num_rows = (num_particles + num_columns - 1) / num_columns;
+  float site_width = width_ / float(num_columns);
+  float site_height = height_ / float(num_rows);
+  if (std::min(site_width, site_height) < 2 * (max_radius + kMinGap)) {
+    throw std::invalid_argument("The particles do not fit on a lattice in the container.");
+  }
+
+  //partial Fisher-Yates shuffle, so particle i gets a random unused site and the species are mixed
+  vector<uint32_t> sites(num_columns * num_rows);
+  std::iota(sites.begin(), sites.end(), uint32_t(0));
+  for (size_t i = 0; i < num_particles; i++) {
+    size_t other = i + rng_.GetBlock(i, kShuffleStream)[0] % (sites.size() - i);
+    std::swap(sites[i], sites[other]);
+  }
+
+  for (size_t i = 0; i < num_particles; i++) {
+    std::array<uint32_t, 4> random_words = rng_.GetBlock(i, kJitterStream);
+    size_t column = sites[i] % num_columns;
+    size_t row = sites[i] / num_columns;
+    //how far the center can move from the middle of the site and stay kMinGap / 2 inside it
+    float reach_x = site_width / 2 - particles.radius[i] - kMinGap / 2;
+    float reach_y = site_height / 2 - particles.radius[i] - kMinGap / 2;
+    particles.position[0][i] = min_x_ + (float(column) + 0.5f) * site_width
+                     + (2 * Philox::ToUnitFloat(random_words[0]) - 1) * reach_x;
+    particles.position[1][i] = min_y_ + (float(row) + 0.5f) * site_height
+                     + (2 * Philox::ToUnitFloat(random_words[1]) - 1) * reach_y;
+  }
+}
+
+void ParticlePlacer::PlacePoissonDisk(ParticleStore& particles) const {
+  size_t num_particles = particles.Size();
+  if (num_particles == 0) {
+    return;
+  }
+
+  //cells at least as wide as two of the largest particles, so only neighbouring cells can overlap,
+  //and no more than kMaxCellsPerParticle of them so a dilute gas doesn't make a huge grid
+  float max_radius = *std::max_element(particles.radius.begin(), particles.radius.end());
+  float min_cell_size = 2 * (max_radius + kMinGap);
+  if (std::min(width_, height_) < min_cell_size) {
+    throw std::invalid_argument("The particles do not fit in the container.");
+  }
+  float cell_size = std::max(min_cell_size, std::sqrt(width_ * height_ / float(kMaxCellsPerParticle * num_particles)));
+  PlacementGrid grid;
+  grid.num_columns = std::max(int(width_ / cell_size), 1);
+  grid.num_rows = std::max(int(height_ / cell_size), 1);
+  grid.num_tile_columns = (grid.num_columns + int(kTileCells) - 1) / int(kTileCells);
+  float cell_width = width_ / float(grid.num_columns);
+  float cell_height = height_ / float(grid.num_rows);
+  size_t num_tiles = size_t(grid.num_tile_columns) * ((size_t(grid.num_rows) + kTileCells - 1) / kTileCells);
+  size_t num_cells = num_tiles * kCellsPerTile;
+  grid.cell_heads.assign(num_cells, -1);
+  grid.placed.reserve(num_particles);
+
+  //the tiles stick out past the grid, so only some cells are real
+  vector<uint32_t> grid_cells;
+  grid_cells.reserve(size_t(grid.num_columns) * size_t(grid.num_rows));
+  for (size_t cell = 0; cell < num_cells; cell++) {
+    int column;
+    int row;
+    grid.GetColumnAndRow(uint32_t(cell), column, row);
+    if (column < grid.num_columns && row < grid.num_rows) {
+      grid_cells.push_back(uint32_t(cell));
+    }
+  }
+
+  //largest species first, so the small particles fill the gaps left between the big ones
+  size_t num_species = particles.species_registry.Size();
+  vector<int> species_order(num_species);
+  std::iota(species_order.begin(), species_order.end(), 0);
+  std::stable_sort(species_order.begin(), species_order.end(), [&particles](int first, int second) {
+    return particles.species_registry.GetSpecies(first).radius > particles.species_registry.GetSpecies(second).radius;
+  });
+  vector<vector<uint32_t>> species_particles(num_species);
+  for (size_t i = 0; i < num_particles; i++) {
+    species_particles[particles.species[i]].push_back(uint32_t(i));
+  }
+
+  vector<size_t> tile_starts(num_tiles + 1);
+  vector<uint32_t> open_cells;
+  vector<uint32_t> open_indices(num_cells);
+  vector<int> misses(num_cells);
+  vector<Dart> darts;
+  vector<Dart> sorted_darts;
+  uint64_t dart = 0;
+  for (size_t k = 0; k < num_species; k++) {
+    //a cell that is full for larger particles may still have room for these
+    open_cells = grid_cells;
+    for (size_t open_index = 0; open_index < open_cells.size(); open_index++) {
+      open_indices[open_cells[open_index]] = uint32_t(open_index);
+    }
+    std::fill(misses.begin(), misses.end(), 0);
+
+    const vector<uint32_t>& to_place = species_particles[species_order[k]];
+    size_t num_placed = 0;
+    while (num_placed < to_place.size()) {
+      if (open_cells.empty()) {
+        throw std::invalid_argument("The particles do not fit in the container.");
+      }
+
+      //one dart per particle left, so a batch never places too many
+      float radius = particles.radius[to_place[num_placed]];
+      darts.resize(to_place.size() - num_placed);
+      std::fill(tile_starts.begin(), tile_starts.end(), 0);
+      for (size_t d = 0; d < darts.size(); d++) {
+        std::array<uint32_t, 4> random_words = rng_.GetBlock(dart++, kDartStream);
+        uint32_t cell = open_cells[size_t((uint64_t(random_words[0]) * open_cells.size()) >> 32)];
+        int column;
+        int row;
+        grid.GetColumnAndRow(cell, column, row);
+
+        //a random position in the cell that keeps the particle inside the walls
+        float left = std::max(min_x_ + float(column) * cell_width, min_x_ + radius);
+        float right = std::min(min_x_ + float(column + 1) * cell_width, min_x_ + width_ - radius);
+        float top = std::max(min_y_ + float(row) * cell_height, min_y_ + radius);
+        float bottom = std::min(min_y_ + float(row + 1) * cell_height, min_y_ + height_ - radius);
+        darts[d].cell = cell;
+        darts[d].column = column;
+        darts[d].row = row;
+        darts[d].x = left + Philox::ToUnitFloat(random_words[1]) * (right - left);
+        darts[d].y = top + Philox::ToUnitFloat(random_words[2]) * (bottom - top);
+        tile_starts[cell / kCellsPerTile + 1]++;
+      }
+
+      //counting sort by tile, so the grid is walked a few cache-sized tiles at a time
+      //instead of jumping to a random cell on every dart
+      for (size_t tile = 1; tile < tile_starts.size(); tile++) {
+        tile_starts[tile] += tile_starts[tile - 1];
+      }
+      sorted_darts.resize(darts.size());
+      for (size_t d = 0; d < darts.size(); d++) {
+        sorted_darts[tile_starts[darts[d].cell / kCellsPerTile]++] = darts[d];
+      }
+
+      for (size_t d = 0; d < sorted_darts.size(); d++) {
+        const Dart& current = sorted_darts[d];
+        uint32_t cell = current.cell;
+        if (open_indices[cell] == kClosedCell) {
+          continue;
+        }
+
+        if (!Overlaps(grid, current.x, current.y, radius, current.column, current.row)) {
+          uint32_t particle = to_place[num_placed++];
+          particles.position[0][particle] = current.x;
+          particles.position[1][particle] = current.y;
+          PlacedParticle placed = {current.x, current.y, radius, grid.cell_heads[cell]};
+          grid.cell_heads[cell] = int32_t(grid.placed.size());
+          grid.placed.push_back(placed);
+          misses[cell] = 0;
+        } else if (++misses[cell] == kMissesPerCell) {
+          //swap the last open cell into this one's place
+          uint32_t open_index = open_indices[cell];
+          open_cells[open_index] = open_cells.back();
+          open_indices[open_cells[open_index]] = open_index;
+          open_cells.pop_back();
+          open_indices[cell] = kClosedCell;
+        }
+      }
+    }
+  }
+}
+
+uint32_t ParticlePlacer::PlacementGrid::GetCell(int column, int row) const {
+  uint32_t tile = uint32_t(row) / kTileCells * uint32_t(num_tile_columns) + uint32_t(column) / kTileCells;
+  return tile * kCellsPerTile + uint32_t(row) % kTileCells * kTileCells + uint32_t(column) % kTileCells;
+}
+
+void ParticlePlacer::PlacementGrid::GetColumnAndRow(uint32_t cell, int& column, int& row) const {
+  uint32_t tile = cell / kCellsPerTile;
+  uint32_t cell_in_tile = cell % kCellsPerTile;
+  column = int(tile % uint32_t(num_tile_columns) * kTileCells + cell_in_tile % kTileCells);
+  row = int(tile / uint32_t(num_tile_columns) * kTileCells + cell_in_tile / kTileCells);
+}
+
+bool ParticlePlacer::Overlaps(const PlacementGrid& grid, float x, float y, float radius, int column, int row) const {
+  //the position's own cell first, since that is where an overlap is most likely
+  if (OverlapsCell(grid, grid.GetCell(column, row), x, y, radius)) {
+    return true;
+  }
+  for (int neighbour_row = std::max(row - 1, 0); neighbour_row <= std::min(row + 1, grid.num_rows - 1);
+       neighbour_row++) {
+    for (int neighbour_column = std::max(column - 1, 0);
+         neighbour_column <= std::min(column + 1, grid.num_columns - 1); neighbour_column++) {
+      if ((neighbour_row != row || neighbour_column != column) &&
+          OverlapsCell(grid, grid.GetCell(neighbour_column, neighbour_row), x, y, radius)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool ParticlePlacer::OverlapsCell(const PlacementGrid& grid, uint32_t cell, float x, float y, float radius) const {
+  for (int32_t other = grid.cell_heads[cell]; other >= 0; other = grid.placed[size_t(other)].next_in_cell) {
+    const PlacedParticle& placed = grid.placed[size_t(other)];
+    float dx = placed.x - x;
+    float dy = placed.y - y;
+    float min_distance = placed.radius + radius + kMinGap;
+    if (dx * dx + dy * dy <= min_distance * min_distance) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace idealgas
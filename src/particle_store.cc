@@ -0,0 +1,133 @@
+#include "particle_store.h"
+
+namespace idealgas {
+
+template <glm::length_t D, typename T>
+BasicParticleStore<D, T>::BasicParticleStore() {}
+
+template <>
+ParticleStore::BasicParticleStore(const vector<Particle>& particles) {
+  Reserve(particles.size());
+  for (size_t i = 0; i < particles.size(); i++) {
+    Add(particles.at(i));
+  }
+}
+
+template <>
+void ParticleStore::Add(const Particle& particle) {
+  int species_id = species_registry.Register(particle.GetColor(), particle.GetMass(), particle.GetRadius());
+  Add(species_id, particle.GetPosition(), particle.GetVelocity());
+}
+
+template <glm::length_t D, typename T>
+void BasicParticleStore<D, T>::Add(int species_id, const Vector& particle_position,
+                                   const Vector& particle_velocity) {
+  Resize(Size() + 1);
+  Set(Size() - 1, species_id, particle_position, particle_velocity);
+}
+
+template <glm::length_t D, typename T>
+void BasicParticleStore<D, T>::Set(size_t index, int species_id, const Vector& particle_position,
+                                   const Vector& particle_velocity) {
+  const Species& particle_species = species_registry.GetSpecies(species_id);
+  for (glm::length_t axis = 0; axis < D; axis++) {
+    position[axis][index] = particle_position[axis];
+    velocity[axis][index] = particle_velocity[axis];
+  }
+  mass[index] = T(particle_species.mass);
+  radius[index] = T(particle_species.radius);
+  species[index] = species_id;
+}
+
+template <glm::length_t D, typename T>
+void BasicParticleStore<D, T>::Reserve(size_t num_particles) {
+  for (glm::length_t axis = 0; axis < D; axis++) {
+    position[axis].reserve(num_particles);
+    velocity[axis].reserve(num_particles);
+  }
+  mass.reserve(num_particles);
+  radius.reserve(num_particles);
+  species.reserve(num_particles);
+}
+
+template <glm::length_t D, typename T>
+void BasicParticleStore<D, T>::Resize(size_t num_particles) {
+  for (glm::length_t axis = 0; axis < D; axis++) {
+    position[axis].resize(num_particles);
+    velocity[axis].resize(num_particles);
+  }
+  mass.resize(num_particles);
+  radius.resize(num_particles);
+  species.resize(num_particles);
+}
+
+template <glm::length_t D, typename T>
+size_t BasicParticleStore<D, T>::Size() const {
+  return species.size();
+}
+
+template <glm::length_t D, typename T>
+typename BasicParticleStore<D, T>::Vector BasicParticleStore<D, T>::GetPosition(size_t index) const {
+  Vector particle_position;
+  for (glm::length_t axis = 0; axis < D; axis++) {
+    particle_position[axis] = position[axis].at(index);
+  }
+  return particle_position;
+}
+
+template <glm::length_t D, typename T>
+typename BasicParticleStore<D, T>::Vector BasicParticleStore<D, T>::GetVelocity(size_t index) const {
+  Vector particle_velocity;
+  for (glm::length_t axis = 0; axis < D; axis++) {
+    particle_velocity[axis] = velocity[axis].at(index);
+  }
+  return particle_velocity;
+}
+
+template <glm::length_t D, typename T>
+void BasicParticleStore<D, T>::SetVelocity(size_t index, const Vector& particle_velocity) {
+  for (glm::length_t axis = 0; axis < D; axis++) {
+    velocity[axis][index] = particle_velocity[axis];
+  }
+}
+
+template <>
+Particle ParticleStore::GetParticle(size_t index) const {
+  const Species& particle_species = species_registry.GetSpecies(species.at(index));
+  return Particle(position[0].at(index), position[1].at(index), velocity[0].at(index), velocity[1].at(index),
+                  particle_species.name, particle_species.mass, particle_species.radius);
+}
+
+template <glm::length_t D, typename T>
+void BasicParticleStore<D, T>::GetRandomState(const uint32_t* random_words, T particle_radius, const Vector& lower,
+                                              const Vector& size, Vector& particle_position,
+                                              Vector& particle_velocity) {
+  for (glm::length_t axis = 0; axis < D; axis++) {
+    //somewhere within the box, at least a radius from the walls
+    particle_position[axis] = T(int(random_words[axis] % uint32_t(size[axis] - 2 * particle_radius)))
+                              + particle_radius + lower[axis];
+    //somewhere between -radius/2 and +radius/2
+    particle_velocity[axis] = T(int(random_words[D + axis] % uint32_t(particle_radius)) - int(particle_radius / 2));
+  }
+}
+
+template <glm::length_t D, typename T>
+void BasicParticleStore<D, T>::GetRandomState(const Philox& rng, uint64_t index, T particle_radius,
+                                              const Vector& lower, const Vector& size, Vector& particle_position,
+                                              Vector& particle_velocity) {
+  uint32_t random_words[2 * D];
+  for (glm::length_t word = 0; word < 2 * D; word += 4) {
+    std::array<uint32_t, 4> block = rng.GetBlock(index, uint64_t(word / 4));
+    for (glm::length_t k = word; k < 2 * D && k < word + 4; k++) {
+      random_words[k] = block[size_t(k - word)];
+    }
+  }
+  GetRandomState(random_words, particle_radius, lower, size, particle_position, particle_velocity);
+}
+
+template struct BasicParticleStore<2, float>;
+template struct BasicParticleStore<2, double>;
+template struct BasicParticleStore<3, float>;
+template struct BasicParticleStore<3, double>;
+
+}  // namespace idealgas
@@ -0,0 +1,52 @@
+#include "philox.h"
+
+namespace idealgas {
+
+namespace {
+
+//multipliers and key increments from Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3"
+const uint32_t kMultiplier0 = 0xD2511F53;
+const uint32_t kMultiplier1 = 0xCD9E8D57;
+const uint32_t kKeyIncrement0 = 0x9E3779B9;
+const uint32_t kKeyIncrement1 = 0xBB67AE85;
+
+}  // namespace
+
+Philox::Philox(uint64_t seed) : seed_(seed) {
+  key_[0] = uint32_t(seed);
+  key_[1] = uint32_t(seed >> 32);
+}
+
+uint64_t Philox::GetSeed() const {
+  return seed_;
+}
+
+std::array<uint32_t, 4> Philox::GetBlock(uint64_t index, uint64_t stream) const {
+  std::array<uint32_t, 4> counter = {{uint32_t(index), uint32_t(index >> 32),
+                                      uint32_t(stream), uint32_t(stream >> 32)}};
+  return Generate(counter, key_);
+}
+
+std::array<uint32_t, 4> Philox::Generate(const std::array<uint32_t, 4>& counter,
+                                         const std::array<uint32_t, 2>& key) {
+  std::array<uint32_t, 4> words = counter;
+  uint32_t key0 = key[0];
+  uint32_t key1 = key[1];
+  for (int round = 0; round < kRounds; round++) {
+    uint64_t product0 = uint64_t(kMultiplier0) * words[0];
+    uint64_t product1 = uint64_t(kMultiplier1) * words[2];
+    std::array<uint32_t, 4> next = {{uint32_t(product1 >> 32) ^ words[1] ^ key0, uint32_t(product1),
+                                     uint32_t(product0 >> 32) ^ words[3] ^ key1, uint32_t(product0)}};
+    words = next;
+    key0 += kKeyIncrement0;
+    key1 += kKeyIncrement1;
+  }
+  return words;
+}
+
+float Philox::ToUnitFloat(uint32_t word) {
+  //the top 24 bits fit a float's mantissa exactly, so the result never rounds up to 1
+  return float(word >> 8) * (1.0f / 16777216.0f);
+}
+
+}  // namespace idealgas
@@ -0,0 +1,176 @@
+#include "profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+namespace idealgas {
+
+namespace {
+
+int64_t GetSteadyNanoseconds() {
+  return int64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * Gets the sample at a percentile of sorted samples, by the nearest-rank method
+ */
+double GetPercentile(const vector<double>& sorted, double percentile) {
+  size_t rank = size_t(std::ceil(percentile / 100 * double(sorted.size())));
+  return sorted.at(std::min(std::max(rank, size_t(1)), sorted.size()) - 1);
+}
+
+/**
+ * Writes a phase name as a JSON string
+ */
+void WriteJsonString(std::ofstream& file, const char* text) {
+  file << '"';
+  for (const char* character = text; *character != '\0'; character++) {
+    if (*character == '"' || *character == '\\') {
+      file << '\\' << *character;
+    } else if (static_cast<unsigned char>(*character) < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", unsigned(static_cast<unsigned char>(*character)));
+      file << escaped;
+    } else {
+      file << *character;
+    }
+  }
+  file << '"';
+}
+
+}  // namespace
+
+const size_t Profiler::kEventsPerThread;
+
+Profiler::Profiler() : epoch_ns_(GetSteadyNanoseconds()) {}
+
+Profiler& Profiler::GetInstance() {
+  static Profiler profiler;
+  return profiler;
+}
+
+int64_t Profiler::Now() const {
+  return GetSteadyNanoseconds() - epoch_ns_;
+}
+
+void Profiler::Record(const char* name, int64_t start_ns, int64_t end_ns) {
+  ThreadBuffer& buffer = GetThreadBuffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  Event event = {name, start_ns, end_ns};
+  buffer.events[buffer.next] = event;
+  buffer.next = (buffer.next + 1) % kEventsPerThread;
+  buffer.num_recorded++;
+}
+
+Profiler::ThreadBuffer& Profiler::GetThreadBuffer() {
+  //the only allocation a thread makes for profiling, on its first timing
+  static thread_local ThreadBuffer* thread_buffer = nullptr;
+  if (thread_buffer == nullptr) {
+    std::shared_ptr<ThreadBuffer> buffer = std::make_shared<ThreadBuffer>();
+    buffer->events.resize(kEventsPerThread);
+    buffer->next = 0;
+    buffer->num_recorded = 0;
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    buffer->thread_index = buffers_.size();
+    buffers_.push_back(buffer);
+    thread_buffer = buffer.get();
+  }
+  return *thread_buffer;
+}
+
+void Profiler::CopyEvents(vector<Event>& events, vector<size_t>& thread_indices) const {
+  std::lock_guard<std::mutex> buffers_lock(buffers_mutex_);
+  for (size_t i = 0; i < buffers_.size(); i++) {
+    ThreadBuffer& buffer = *buffers_[i];
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+
+    //oldest first, which is where the next timing goes once the buffer has wrapped around
+    size_t count = std::min(buffer.num_recorded, kEventsPerThread);
+    size_t first = buffer.num_recorded > kEventsPerThread ? buffer.next : 0;
+    for (size_t k = 0; k < count; k++) {
+      events.push_back(buffer.events[(first + k) % kEventsPerThread]);
+      thread_indices.push_back(buffer.thread_index);
+    }
+  }
+}
+
+vector<PhaseStats> Profiler::GetStats() const {
+  vector<Event> events;
+  vector<size_t> thread_indices;
+  CopyEvents(events, thread_indices);
+
+  //the same name can be a different pointer in each file it is written in
+  std::map<string, vector<double>> durations;
+  for (size_t i = 0; i < events.size(); i++) {
+    durations[events[i].name].push_back(double(events[i].end_ns - events[i].start_ns) / 1e6);
+  }
+
+  vector<PhaseStats> stats;
+  for (std::map<string, vector<double>>::iterator phase = durations.begin(); phase != durations.end(); ++phase) {
+    vector<double>& samples = phase->second;
+    std::sort(samples.begin(), samples.end());
+    double total = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+      total += samples[i];
+    }
+    PhaseStats phase_stats;
+    phase_stats.name = phase->first;
+    phase_stats.count = samples.size();
+    phase_stats.mean_ms = total / double(samples.size());
+    phase_stats.p50_ms = GetPercentile(samples, 50);
+    phase_stats.p99_ms = GetPercentile(samples, 99);
+    phase_stats.max_ms = samples.back();
+    stats.push_back(phase_stats);
+  }
+  return stats;
+}
+
+void Profiler::WriteChromeTrace(const string& path) const {
+  vector<Event> events;
+  vector<size_t> thread_indices;
+  CopyEvents(events, thread_indices);
+
+  std::ofstream file(path.c_str());
+  if (!file) {
+    throw std::runtime_error("Could not open " + path + ".");
+  }
+
+  //complete ("X") events, with times in microseconds
+  file << "{\"traceEvents\":[";
+  char times[96];
+  for (size_t i = 0; i < events.size(); i++) {
+    file << (i == 0 ? "\n" : ",\n") << "{\"name\":";
+    WriteJsonString(file, events[i].name);
+    std::snprintf(times, sizeof(times), ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%zu}",
+                  double(events[i].start_ns) / 1e3, double(events[i].end_ns - events[i].start_ns) / 1e3,
+                  thread_indices[i]);
+    file << times;
+  }
+  file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  if (!file) {
+    throw std::runtime_error("Could not write " + path + ".");
+  }
+}
+
+void Profiler::Clear() {
+  std::lock_guard<std::mutex> buffers_lock(buffers_mutex_);
+  for (size_t i = 0; i < buffers_.size(); i++) {
+    std::lock_guard<std::mutex> lock(buffers_[i]->mutex);
+    buffers_[i]->next = 0;
+    buffers_[i]->num_recorded = 0;
+  }
+}
+
+ScopedTimer::ScopedTimer(const char* name) : name_(name), start_ns_(Profiler::GetInstance().Now()) {}
+
+ScopedTimer::~ScopedTimer() {
+  Profiler& profiler = Profiler::GetInstance();
+  profiler.Record(name_, start_ns_, profiler.Now());
+}
+
+}  // namespace idealgas
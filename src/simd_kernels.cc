@@ -0,0 +1,741 @@
+#include "simd_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define IDEALGAS_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace idealgas {
+
+namespace {
+
+//the kernels below all do the same float operations in the same order as this scalar code,
+//so every instruction set rounds the same way
+
+void IntegrateScalar(ParticleStore& particles, size_t begin, size_t end) {
+  float* x = particles.position[0].data();
+  float* y = particles.position[1].data();
+  const float* vx = particles.velocity[0].data();
+  const float* vy = particles.velocity[1].data();
+  for (size_t i = begin; i < end; i++) {
+    x[i] += vx[i];
+    y[i] += vy[i];
+  }
+}
+
+/**
+ * Adds the momentum one particle gives the walls it is about to bounce off, without bouncing it
+ */
+inline void AddWallImpulse(float x, float y, float radius, float vx, float vy, float mass, const WallBounds& walls,
+                           WallImpulses& impulses) {
+  //a bounce reverses the velocity into the wall, so the wall takes twice that momentum
+  if (x - radius <= walls.left && vx < 0) {
+    impulses.left -= 2.0 * double(mass) * double(vx);
+    impulses.num_bounces++;
+  } else if (x + radius >= walls.right && vx > 0) {
+    impulses.right += 2.0 * double(mass) * double(vx);
+    impulses.num_bounces++;
+  }
+  if (y - radius <= walls.top && vy < 0) {
+    impulses.top -= 2.0 * double(mass) * double(vy);
+    impulses.num_bounces++;
+  } else if (y + radius >= walls.bottom && vy > 0) {
+    impulses.bottom += 2.0 * double(mass) * double(vy);
+    impulses.num_bounces++;
+  }
+}
+
+/**
+ * Adds the momentum particles [begin, end) give the walls they are about to bounce off,
+ * without bouncing them
+ */
+void AddWallImpulses(const ParticleStore& particles, size_t begin, size_t end, const WallBounds& walls,
+                     WallImpulses& impulses) {
+  for (size_t i = begin; i < end; i++) {
+    AddWallImpulse(particles.position[0][i], particles.position[1][i], particles.radius[i], particles.velocity[0][i], particles.velocity[1][i],
+                   particles.mass[i], walls, impulses);
+  }
+}
+
+void ReflectWallsScalar(ParticleStore& particles, size_t begin, size_t end, const WallBounds& walls, float* speeds,
+                        WallImpulses& impulses) {
+  const float* x = particles.position[0].data();
+  const float* y = particles.position[1].data();
+  const float* radius = particles.radius.data();
+  float* vx = particles.velocity[0].data();
+  float* vy = particles.velocity[1].data();
+  AddWallImpulses(particles, begin, end, walls, impulses);
+  for (size_t i = begin; i < end; i++) {
+    //check for collisions with horizontal walls
+    if ((x[i] - radius[i] <= walls.left && vx[i] < 0) || (x[i] + radius[i] >= walls.right && vx[i] > 0)) {
+      vx[i] = -vx[i];
+    }
+
+    //check for collisions with vertical walls
+    if ((y[i] - radius[i] <= walls.top && vy[i] < 0) || (y[i] + radius[i] >= walls.bottom && vy[i] > 0)) {
+      vy[i] = -vy[i];
+    }
+
+    speeds[i] = std::sqrt(vx[i] * vx[i] + vy[i] * vy[i]);
+  }
+}
+
+WallBounds GetLaneWalls(const MemberLanes& lanes, size_t lane) {
+  WallBounds walls = {lanes.left[lane], lanes.right[lane], lanes.top[lane], lanes.bottom[lane]};
+  return walls;
+}
+
+void ResetLaneTotals(WallPassTotals& totals) {
+  totals.wall_impulses = WallImpulses();
+  totals.kinetic_energy = 0;
+  totals.momentum_x = 0;
+  totals.momentum_y = 0;
+  totals.min_speed = std::numeric_limits<float>::infinity();
+  totals.max_speed = -std::numeric_limits<float>::infinity();
+}
+
+/**
+ * Runs the lanes one container at a time, with the same operations a container does on its own
+ */
+void ReflectAndIntegrateLanesScalar(MemberLanes& lanes) {
+  const size_t num_lanes = MemberLanes::kNumLanes;
+  for (size_t lane = 0; lane < num_lanes; lane++) {
+    WallBounds walls = GetLaneWalls(lanes, lane);
+    WallPassTotals& totals = lanes.totals[lane];
+    ResetLaneTotals(totals);
+    double twice_kinetic_energy = 0;
+    for (size_t i = lane; i < size_t(lanes.sizes[lane]) * num_lanes; i += num_lanes) {
+      AddWallImpulse(lanes.x[i], lanes.y[i], lanes.radius[i], lanes.vx[i], lanes.vy[i], lanes.mass[i], walls,
+                     totals.wall_impulses);
+      if ((lanes.x[i] - lanes.radius[i] <= walls.left && lanes.vx[i] < 0) ||
+          (lanes.x[i] + lanes.radius[i] >= walls.right && lanes.vx[i] > 0)) {
+        lanes.vx[i] = -lanes.vx[i];
+      }
+      if ((lanes.y[i] - lanes.radius[i] <= walls.top && lanes.vy[i] < 0) ||
+          (lanes.y[i] + lanes.radius[i] >= walls.bottom && lanes.vy[i] > 0)) {
+        lanes.vy[i] = -lanes.vy[i];
+      }
+      lanes.speeds[i] = std::sqrt(lanes.vx[i] * lanes.vx[i] + lanes.vy[i] * lanes.vy[i]);
+
+      totals.min_speed = std::min(totals.min_speed, lanes.speeds[i]);
+      totals.max_speed = std::max(totals.max_speed, lanes.speeds[i]);
+      double mass = lanes.mass[i];
+      double vx = lanes.vx[i];
+      double vy = lanes.vy[i];
+      twice_kinetic_energy += mass * (vx * vx + vy * vy);
+      totals.momentum_x += mass * vx;
+      totals.momentum_y += mass * vy;
+
+      lanes.x[i] += lanes.vx[i];
+      lanes.y[i] += lanes.vy[i];
+    }
+    totals.kinetic_energy = twice_kinetic_energy / 2;
+  }
+}
+
+void FindCollidingPairsScalar(const ParticleStore& particles, const uint32_t* first, const uint32_t* second,
+                              size_t begin, size_t end, vector<uint32_t>& colliding_first,
+                              vector<uint32_t>& colliding_second) {
+  const float* x = particles.position[0].data();
+  const float* y = particles.position[1].data();
+  const float* radius = particles.radius.data();
+  for (size_t k = begin; k < end; k++) {
+    uint32_t i = first[k];
+    uint32_t j = second[k];
+    float dx = x[j] - x[i];
+    float dy = y[j] - y[i];
+    if (std::sqrt(dx * dx + dy * dy) <= radius[i] + radius[j]) {
+      colliding_first.push_back(i);
+      colliding_second.push_back(j);
+    }
+  }
+}
+
+size_t ResolveBatchScalar(ParticleStore& particles, const uint32_t* first, const uint32_t* second, size_t count) {
+  float* vx = particles.velocity[0].data();
+  float* vy = particles.velocity[1].data();
+  const int* species = particles.species.data();
+  const float* coefficients = particles.species_registry.GetCollisionCoefficients().data();
+  size_t num_species = particles.species_registry.Size();
+  size_t num_bounced = 0;
+  for (size_t k = 0; k < count; k++) {
+    uint32_t i = first[k];
+    uint32_t j = second[k];
+    vec2 position = vec2(particles.position[0][i], particles.position[1][i]);
+    vec2 velocity = vec2(vx[i], vy[i]);
+    vec2 other_position = vec2(particles.position[0][j], particles.position[1][j]);
+    vec2 other_velocity = vec2(vx[j], vy[j]);
+
+    //particles only bounce if they are moving towards each other
+    if (glm::dot(velocity - other_velocity, position - other_position) < 0) {
+      vec2 new_velocity = Particle::GetNewVelocity(velocity, other_velocity, position, other_position,
+                                                   coefficients[species[i] * num_species + species[j]]);
+      vec2 new_other_velocity = Particle::GetNewVelocity(other_velocity, velocity, other_position, position,
+                                                         coefficients[species[j] * num_species + species[i]]);
+      vx[i] = new_velocity.x;
+      vy[i] = new_velocity.y;
+      vx[j] = new_other_velocity.x;
+      vy[j] = new_other_velocity.y;
+      num_bounced++;
+    }
+  }
+  return num_bounced;
+}
+
+/**
+ * Copies the inputs of a batch of pairs into lane-ordered arrays, so the
+ * vector code can load them directly
+ */
+struct PairBatch {
+  float x1[16], y1[16], vx1[16], vy1[16], coefficient1[16];
+  float x2[16], y2[16], vx2[16], vy2[16], coefficient2[16];
+
+  void Gather(const ParticleStore& particles, const uint32_t* first, const uint32_t* second, size_t count,
+              size_t padded_count) {
+    const int* species = particles.species.data();
+    const float* coefficients = particles.species_registry.GetCollisionCoefficients().data();
+    size_t num_species = particles.species_registry.Size();
+    for (size_t k = 0; k < padded_count; k++) {
+      //padding lanes repeat the last pair, and are never written back
+      size_t pair = std::min(k, count - 1);
+      uint32_t i = first[pair];
+      uint32_t j = second[pair];
+      x1[k] = particles.position[0][i];
+      y1[k] = particles.position[1][i];
+      vx1[k] = particles.velocity[0][i];
+      vy1[k] = particles.velocity[1][i];
+      coefficient1[k] = coefficients[species[i] * num_species + species[j]];
+      x2[k] = particles.position[0][j];
+      y2[k] = particles.position[1][j];
+      vx2[k] = particles.velocity[0][j];
+      vy2[k] = particles.velocity[1][j];
+      coefficient2[k] = coefficients[species[j] * num_species + species[i]];
+    }
+  }
+
+  void Scatter(ParticleStore& particles, const uint32_t* first, const uint32_t* second, size_t count) const {
+    for (size_t k = 0; k < count; k++) {
+      particles.velocity[0][first[k]] = vx1[k];
+      particles.velocity[1][first[k]] = vy1[k];
+      particles.velocity[0][second[k]] = vx2[k];
+      particles.velocity[1][second[k]] = vy2[k];
+    }
+  }
+};
+
+#ifdef IDEALGAS_X86_SIMD
+
+//SSE2 is part of every x86-64 CPU, so these need no target attribute there
+
+void IntegrateSse2(ParticleStore& particles, size_t begin, size_t end) {
+  float* x = particles.position[0].data();
+  float* y = particles.position[1].data();
+  const float* vx = particles.velocity[0].data();
+  const float* vy = particles.velocity[1].data();
+  size_t i = begin;
+  for (; i + 4 <= end; i += 4) {
+    _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(vx + i)));
+    _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_loadu_ps(vy + i)));
+  }
+  IntegrateScalar(particles, i, end);
+}
+
+void ReflectWallsSse2(ParticleStore& particles, size_t begin, size_t end, const WallBounds& walls, float* speeds,
+                      WallImpulses& impulses) {
+  const float* x = particles.position[0].data();
+  const float* y = particles.position[1].data();
+  const float* radius = particles.radius.data();
+  float* vx = particles.velocity[0].data();
+  float* vy = particles.velocity[1].data();
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 sign = _mm_set1_ps(-0.0f);
+  const __m128 left = _mm_set1_ps(walls.left);
+  const __m128 right = _mm_set1_ps(walls.right);
+  const __m128 top = _mm_set1_ps(walls.top);
+  const __m128 bottom = _mm_set1_ps(walls.bottom);
+  size_t i = begin;
+  for (; i + 4 <= end; i += 4) {
+    __m128 px = _mm_loadu_ps(x + i);
+    __m128 py = _mm_loadu_ps(y + i);
+    __m128 r = _mm_loadu_ps(radius + i);
+    __m128 velocity_x = _mm_loadu_ps(vx + i);
+    __m128 velocity_y = _mm_loadu_ps(vy + i);
+
+    //flip the sign bit of any velocity heading into a wall the particle touches
+    __m128 hit_x = _mm_or_ps(_mm_and_ps(_mm_cmple_ps(_mm_sub_ps(px, r), left), _mm_cmplt_ps(velocity_x, zero)),
+                             _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(px, r), right), _mm_cmpgt_ps(velocity_x, zero)));
+    __m128 hit_y = _mm_or_ps(_mm_and_ps(_mm_cmple_ps(_mm_sub_ps(py, r), top), _mm_cmplt_ps(velocity_y, zero)),
+                             _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(py, r), bottom), _mm_cmpgt_ps(velocity_y, zero)));
+    //bounces are rare, so only the blocks that have one work out the impulses
+    if (_mm_movemask_ps(_mm_or_ps(hit_x, hit_y)) != 0) {
+      AddWallImpulses(particles, i, i + 4, walls, impulses);
+    }
+    velocity_x = _mm_xor_ps(velocity_x, _mm_and_ps(hit_x, sign));
+    velocity_y = _mm_xor_ps(velocity_y, _mm_and_ps(hit_y, sign));
+
+    _mm_storeu_ps(vx + i, velocity_x);
+    _mm_storeu_ps(vy + i, velocity_y);
+    _mm_storeu_ps(speeds + i, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(velocity_x, velocity_x),
+                                                     _mm_mul_ps(velocity_y, velocity_y))));
+  }
+  ReflectWallsScalar(particles, i, end, walls, speeds, impulses);
+}
+
+void FindCollidingPairsSse2(const ParticleStore& particles, const uint32_t* first, const uint32_t* second,
+                            size_t begin, size_t end, vector<uint32_t>& colliding_first,
+                            vector<uint32_t>& colliding_second) {
+  const float* x = particles.position[0].data();
+  const float* y = particles.position[1].data();
+  const float* radius = particles.radius.data();
+  size_t k = begin;
+  for (; k + 4 <= end; k += 4) {
+    const uint32_t* i = first + k;
+    const uint32_t* j = second + k;
+    __m128 dx = _mm_sub_ps(_mm_setr_ps(x[j[0]], x[j[1]], x[j[2]], x[j[3]]),
+                           _mm_setr_ps(x[i[0]], x[i[1]], x[i[2]], x[i[3]]));
+    __m128 dy = _mm_sub_ps(_mm_setr_ps(y[j[0]], y[j[1]], y[j[2]], y[j[3]]),
+                           _mm_setr_ps(y[i[0]], y[i[1]], y[i[2]], y[i[3]]));
+    __m128 radii = _mm_add_ps(_mm_setr_ps(radius[i[0]], radius[i[1]], radius[i[2]], radius[i[3]]),
+                              _mm_setr_ps(radius[j[0]], radius[j[1]], radius[j[2]], radius[j[3]]));
+    __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+    int mask = _mm_movemask_ps(_mm_cmple_ps(distance, radii));
+    for (int lane = 0; mask != 0; lane++, mask >>= 1) {
+      if (mask & 1) {
+        colliding_first.push_back(i[lane]);
+        colliding_second.push_back(j[lane]);
+      }
+    }
+  }
+  FindCollidingPairsScalar(particles, first, second, k, end, colliding_first, colliding_second);
+}
+
+size_t ResolveBatchSse2(ParticleStore& particles, const uint32_t* first, const uint32_t* second, size_t count) {
+  PairBatch batch;
+  size_t padded_count = (count + 3) / 4 * 4;
+  batch.Gather(particles, first, second, count, padded_count);
+  size_t num_bounced = 0;
+  const __m128 zero = _mm_setzero_ps();
+  for (size_t k = 0; k < padded_count; k += 4) {
+    __m128 x1 = _mm_loadu_ps(batch.x1 + k);
+    __m128 y1 = _mm_loadu_ps(batch.y1 + k);
+    __m128 vx1 = _mm_loadu_ps(batch.vx1 + k);
+    __m128 vy1 = _mm_loadu_ps(batch.vy1 + k);
+    __m128 x2 = _mm_loadu_ps(batch.x2 + k);
+    __m128 y2 = _mm_loadu_ps(batch.y2 + k);
+    __m128 vx2 = _mm_loadu_ps(batch.vx2 + k);
+    __m128 vy2 = _mm_loadu_ps(batch.vy2 + k);
+
+    //same steps as Particle::GetNewVelocity, once from each particle's side
+    __m128 dx1 = _mm_sub_ps(x1, x2);
+    __m128 dy1 = _mm_sub_ps(y1, y2);
+    __m128 dot1 = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(vx1, vx2), dx1), _mm_mul_ps(_mm_sub_ps(vy1, vy2), dy1));
+    __m128 length1 = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx1, dx1), _mm_mul_ps(dy1, dy1)));
+    __m128 scale1 = _mm_mul_ps(_mm_loadu_ps(batch.coefficient1 + k),
+                               _mm_div_ps(dot1, _mm_mul_ps(length1, length1)));
+
+    __m128 dx2 = _mm_sub_ps(x2, x1);
+    __m128 dy2 = _mm_sub_ps(y2, y1);
+    __m128 dot2 = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(vx2, vx1), dx2), _mm_mul_ps(_mm_sub_ps(vy2, vy1), dy2));
+    __m128 length2 = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx2, dx2), _mm_mul_ps(dy2, dy2)));
+    __m128 scale2 = _mm_mul_ps(_mm_loadu_ps(batch.coefficient2 + k),
+                               _mm_div_ps(dot2, _mm_mul_ps(length2, length2)));
+
+    //particles only bounce if they are moving towards each other
+    __m128 approaching = _mm_cmplt_ps(dot1, zero);
+    _mm_storeu_ps(batch.vx1 + k, _mm_or_ps(_mm_and_ps(approaching, _mm_sub_ps(vx1, _mm_mul_ps(scale1, dx1))),
+                                           _mm_andnot_ps(approaching, vx1)));
+    _mm_storeu_ps(batch.vy1 + k, _mm_or_ps(_mm_and_ps(approaching, _mm_sub_ps(vy1, _mm_mul_ps(scale1, dy1))),
+                                           _mm_andnot_ps(approaching, vy1)));
+    _mm_storeu_ps(batch.vx2 + k, _mm_or_ps(_mm_and_ps(approaching, _mm_sub_ps(vx2, _mm_mul_ps(scale2, dx2))),
+                                           _mm_andnot_ps(approaching, vx2)));
+    _mm_storeu_ps(batch.vy2 + k, _mm_or_ps(_mm_and_ps(approaching, _mm_sub_ps(vy2, _mm_mul_ps(scale2, dy2))),
+                                           _mm_andnot_ps(approaching, vy2)));
+
+    //padding lanes repeat the last pair, so they aren't counted
+    int bounced = _mm_movemask_ps(approaching) & ((1 << std::min(count - k, size_t(4))) - 1);
+    num_bounced += size_t(__builtin_popcount(unsigned(bounced)));
+  }
+  batch.Scatter(particles, first, second, count);
+  return num_bounced;
+}
+
+__attribute__((target("avx2")))
+void IntegrateAvx2(ParticleStore& particles, size_t begin, size_t end) {
+  float* x = particles.position[0].data();
+  float* y = particles.position[1].data();
+  const float* vx = particles.velocity[0].data();
+  const float* vy = particles.velocity[1].data();
+  size_t i = begin;
+  for (; i + 8 <= end; i += 8) {
+    _mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(vx + i)));
+    _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_loadu_ps(vy + i)));
+  }
+  IntegrateScalar(particles, i, end);
+}
+
+__attribute__((target("avx2")))
+void ReflectWallsAvx2(ParticleStore& particles, size_t begin, size_t end, const WallBounds& walls, float* speeds,
+                      WallImpulses& impulses) {
+  const float* x = particles.position[0].data();
+  const float* y = particles.position[1].data();
+  const float* radius = particles.radius.data();
+  float* vx = particles.velocity[0].data();
+  float* vy = particles.velocity[1].data();
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 sign = _mm256_set1_ps(-0.0f);
+  const __m256 left = _mm256_set1_ps(walls.left);
+  const __m256 right = _mm256_set1_ps(walls.right);
+  const __m256 top = _mm256_set1_ps(walls.top);
+  const __m256 bottom = _mm256_set1_ps(walls.bottom);
+  size_t i = begin;
+  for (; i + 8 <= end; i += 8) {
+    __m256 px = _mm256_loadu_ps(x + i);
+    __m256 py = _mm256_loadu_ps(y + i);
+    __m256 r = _mm256_loadu_ps(radius + i);
+    __m256 velocity_x = _mm256_loadu_ps(vx + i);
+    __m256 velocity_y = _mm256_loadu_ps(vy + i);
+
+    //flip the sign bit of any velocity heading into a wall the particle touches
+    __m256 hit_x = _mm256_or_ps(
+        _mm256_and_ps(_mm256_cmp_ps(_mm256_sub_ps(px, r), left, _CMP_LE_OQ), _mm256_cmp_ps(velocity_x, zero, _CMP_LT_OQ)),
+        _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(px, r), right, _CMP_GE_OQ), _mm256_cmp_ps(velocity_x, zero, _CMP_GT_OQ)));
+    __m256 hit_y = _mm256_or_ps(
+        _mm256_and_ps(_mm256_cmp_ps(_mm256_sub_ps(py, r), top, _CMP_LE_OQ), _mm256_cmp_ps(velocity_y, zero, _CMP_LT_OQ)),
+        _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(py, r), bottom, _CMP_GE_OQ), _mm256_cmp_ps(velocity_y, zero, _CMP_GT_OQ)));
+    //bounces are rare, so only the blocks that have one work out the impulses
+    if (_mm256_movemask_ps(_mm256_or_ps(hit_x, hit_y)) != 0) {
+      AddWallImpulses(particles, i, i + 8, walls, impulses);
+    }
+    velocity_x = _mm256_xor_ps(velocity_x, _mm256_and_ps(hit_x, sign));
+    velocity_y = _mm256_xor_ps(velocity_y, _mm256_and_ps(hit_y, sign));
+
+    _mm256_storeu_ps(vx + i, velocity_x);
+    _mm256_storeu_ps(vy + i, velocity_y);
+    _mm256_storeu_ps(speeds + i, _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(velocity_x, velocity_x),
+                                                              _mm256_mul_ps(velocity_y, velocity_y))));
+  }
+  ReflectWallsScalar(particles, i, end, walls, speeds, impulses);
+}
+
+/**
+ * Adds up two vectors of doubles, one per half of a vector of lanes, the way the scalar code
+ * adds up each lane
+ */
+__attribute__((target("avx2")))
+inline void AddLaneProducts(__m256d& low, __m256d& high, __m256d mass_low, __m256d mass_high, __m256d value_low,
+                            __m256d value_high) {
+  low = _mm256_add_pd(low, _mm256_mul_pd(mass_low, value_low));
+  high = _mm256_add_pd(high, _mm256_mul_pd(mass_high, value_high));
+}
+
+__attribute__((target("avx2")))
+void ReflectAndIntegrateLanesAvx2(MemberLanes& lanes) {
+  const size_t num_lanes = MemberLanes::kNumLanes;
+  float* x = lanes.x.data();
+  float* y = lanes.y.data();
+  float* vx = lanes.vx.data();
+  float* vy = lanes.vy.data();
+  const float* radius = lanes.radius.data();
+  const float* mass = lanes.mass.data();
+  float* speeds = lanes.speeds.data();
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 sign = _mm256_set1_ps(-0.0f);
+  const __m256 left = _mm256_loadu_ps(lanes.left);
+  const __m256 right = _mm256_loadu_ps(lanes.right);
+  const __m256 top = _mm256_loadu_ps(lanes.top);
+  const __m256 bottom = _mm256_loadu_ps(lanes.bottom);
+  const __m256i sizes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.sizes));
+  for (size_t lane = 0; lane < num_lanes; lane++) {
+    ResetLaneTotals(lanes.totals[lane]);
+  }
+
+  __m256 min_speed = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+  __m256 max_speed = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+  __m256d kinetic_low = _mm256_setzero_pd();
+  __m256d kinetic_high = _mm256_setzero_pd();
+  __m256d momentum_x_low = _mm256_setzero_pd();
+  __m256d momentum_x_high = _mm256_setzero_pd();
+  __m256d momentum_y_low = _mm256_setzero_pd();
+  __m256d momentum_y_high = _mm256_setzero_pd();
+  for (size_t slot = 0; slot < lanes.NumSlots(); slot++) {
+    size_t i = slot * num_lanes;
+    __m256 px = _mm256_loadu_ps(x + i);
+    __m256 py = _mm256_loadu_ps(y + i);
+    __m256 r = _mm256_loadu_ps(radius + i);
+    __m256 velocity_x = _mm256_loadu_ps(vx + i);
+    __m256 velocity_y = _mm256_loadu_ps(vy + i);
+
+    __m256 hit_x = _mm256_or_ps(
+        _mm256_and_ps(_mm256_cmp_ps(_mm256_sub_ps(px, r), left, _CMP_LE_OQ), _mm256_cmp_ps(velocity_x, zero, _CMP_LT_OQ)),
+        _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(px, r), right, _CMP_GE_OQ), _mm256_cmp_ps(velocity_x, zero, _CMP_GT_OQ)));
+    __m256 hit_y = _mm256_or_ps(
+        _mm256_and_ps(_mm256_cmp_ps(_mm256_sub_ps(py, r), top, _CMP_LE_OQ), _mm256_cmp_ps(velocity_y, zero, _CMP_LT_OQ)),
+        _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(py, r), bottom, _CMP_GE_OQ), _mm256_cmp_ps(velocity_y, zero, _CMP_GT_OQ)));
+    //empty slots have no velocity, so only real particles hit a wall
+    int hits = _mm256_movemask_ps(_mm256_or_ps(hit_x, hit_y));
+    for (size_t lane = 0; hits != 0; lane++, hits >>= 1) {
+      if ((hits & 1) != 0) {
+        size_t k = i + lane;
+        AddWallImpulse(x[k], y[k], radius[k], vx[k], vy[k], mass[k], GetLaneWalls(lanes, lane),
+                       lanes.totals[lane].wall_impulses);
+      }
+    }
+    velocity_x = _mm256_xor_ps(velocity_x, _mm256_and_ps(hit_x, sign));
+    velocity_y = _mm256_xor_ps(velocity_y, _mm256_and_ps(hit_y, sign));
+    __m256 speed = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(velocity_x, velocity_x),
+                                                _mm256_mul_ps(velocity_y, velocity_y)));
+    _mm256_storeu_ps(vx + i, velocity_x);
+    _mm256_storeu_ps(vy + i, velocity_y);
+    _mm256_storeu_ps(speeds + i, speed);
+    _mm256_storeu_ps(x + i, _mm256_add_ps(px, velocity_x));
+    _mm256_storeu_ps(y + i, _mm256_add_ps(py, velocity_y));
+
+    //empty slots are left out of the speed range, and add exactly zero to the sums
+    __m256 filled = _mm256_castsi256_ps(_mm256_cmpgt_epi32(sizes, _mm256_set1_epi32(int32_t(slot))));
+    min_speed = _mm256_blendv_ps(min_speed, _mm256_min_ps(min_speed, speed), filled);
+    max_speed = _mm256_blendv_ps(max_speed, _mm256_max_ps(max_speed, speed), filled);
+
+    __m256 m = _mm256_loadu_ps(mass + i);
+    __m256d mass_low = _mm256_cvtps_pd(_mm256_castps256_ps128(m));
+    __m256d mass_high = _mm256_cvtps_pd(_mm256_extractf128_ps(m, 1));
+    __m256d vx_low = _mm256_cvtps_pd(_mm256_castps256_ps128(velocity_x));
+    __m256d vx_high = _mm256_cvtps_pd(_mm256_extractf128_ps(velocity_x, 1));
+    __m256d vy_low = _mm256_cvtps_pd(_mm256_castps256_ps128(velocity_y));
+    __m256d vy_high = _mm256_cvtps_pd(_mm256_extractf128_ps(velocity_y, 1));
+    AddLaneProducts(kinetic_low, kinetic_high, mass_low, mass_high,
+                    _mm256_add_pd(_mm256_mul_pd(vx_low, vx_low), _mm256_mul_pd(vy_low, vy_low)),
+                    _mm256_add_pd(_mm256_mul_pd(vx_high, vx_high), _mm256_mul_pd(vy_high, vy_high)));
+    AddLaneProducts(momentum_x_low, momentum_x_high, mass_low, mass_high, vx_low, vx_high);
+    AddLaneProducts(momentum_y_low, momentum_y_high, mass_low, mass_high, vy_low, vy_high);
+  }
+
+  float lane_min[num_lanes];
+  float lane_max[num_lanes];
+  double twice_kinetic_energy[num_lanes];
+  double momentum_x[num_lanes];
+  double momentum_y[num_lanes];
+  _mm256_storeu_ps(lane_min, min_speed);
+  _mm256_storeu_ps(lane_max, max_speed);
+  _mm256_storeu_pd(twice_kinetic_energy, kinetic_low);
+  _mm256_storeu_pd(twice_kinetic_energy + 4, kinetic_high);
+  _mm256_storeu_pd(momentum_x, momentum_x_low);
+  _mm256_storeu_pd(momentum_x + 4, momentum_x_high);
+  _mm256_storeu_pd(momentum_y, momentum_y_low);
+  _mm256_storeu_pd(momentum_y + 4, momentum_y_high);
+  for (size_t lane = 0; lane < num_lanes; lane++) {
+    WallPassTotals& totals = lanes.totals[lane];
+    totals.min_speed = lane_min[lane];
+    totals.max_speed = lane_max[lane];
+    totals.kinetic_energy = twice_kinetic_energy[lane] / 2;
+    totals.momentum_x = momentum_x[lane];
+    totals.momentum_y = momentum_y[lane];
+  }
+}
+
+__attribute__((target("avx2")))
+void FindCollidingPairsAvx2(const ParticleStore& particles, const uint32_t* first, const uint32_t* second,
+                            size_t begin, size_t end, vector<uint32_t>& colliding_first,
+                            vector<uint32_t>& colliding_second) {
+  const float* x = particles.position[0].data();
+  const float* y = particles.position[1].data();
+  const float* radius = particles.radius.data();
+  size_t k = begin;
+  for (; k + 8 <= end; k += 8) {
+    __m256i i = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + k));
+    __m256i j = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(second + k));
+    __m256 dx = _mm256_sub_ps(_mm256_i32gather_ps(x, j, 4), _mm256_i32gather_ps(x, i, 4));
+    __m256 dy = _mm256_sub_ps(_mm256_i32gather_ps(y, j, 4), _mm256_i32gather_ps(y, i, 4));
+    __m256 radii = _mm256_add_ps(_mm256_i32gather_ps(radius, i, 4), _mm256_i32gather_ps(radius, j, 4));
+    __m256 distance = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+    int mask = _mm256_movemask_ps(_mm256_cmp_ps(distance, radii, _CMP_LE_OQ));
+    for (int lane = 0; mask != 0; lane++, mask >>= 1) {
+      if (mask & 1) {
+        colliding_first.push_back(first[k + lane]);
+        colliding_second.push_back(second[k + lane]);
+      }
+    }
+  }
+  FindCollidingPairsScalar(particles, first, second, k, end, colliding_first, colliding_second);
+}
+
+__attribute__((target("avx2")))
+size_t ResolveBatchAvx2(ParticleStore& particles, const uint32_t* first, const uint32_t* second, size_t count) {
+  PairBatch batch;
+  size_t padded_count = (count + 7) / 8 * 8;
+  batch.Gather(particles, first, second, count, padded_count);
+  size_t num_bounced = 0;
+  const __m256 zero = _mm256_setzero_ps();
+  for (size_t k = 0; k < padded_count; k += 8) {
+    __m256 x1 = _mm256_loadu_ps(batch.x1 + k);
+    __m256 y1 = _mm256_loadu_ps(batch.y1 + k);
+    __m256 vx1 = _mm256_loadu_ps(batch.vx1 + k);
+    __m256 vy1 = _mm256_loadu_ps(batch.vy1 + k);
+    __m256 x2 = _mm256_loadu_ps(batch.x2 + k);
+    __m256 y2 = _mm256_loadu_ps(batch.y2 + k);
+    __m256 vx2 = _mm256_loadu_ps(batch.vx2 + k);
+    __m256 vy2 = _mm256_loadu_ps(batch.vy2 + k);
+
+    //same steps as Particle::GetNewVelocity, once from each particle's side
+    __m256 dx1 = _mm256_sub_ps(x1, x2);
+    __m256 dy1 = _mm256_sub_ps(y1, y2);
+    __m256 dot1 = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(vx1, vx2), dx1),
+                                _mm256_mul_ps(_mm256_sub_ps(vy1, vy2), dy1));
+    __m256 length1 = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx1, dx1), _mm256_mul_ps(dy1, dy1)));
+    __m256 scale1 = _mm256_mul_ps(_mm256_loadu_ps(batch.coefficient1 + k),
+                                  _mm256_div_ps(dot1, _mm256_mul_ps(length1, length1)));
+
+    __m256 dx2 = _mm256_sub_ps(x2, x1);
+    __m256 dy2 = _mm256_sub_ps(y2, y1);
+    __m256 dot2 = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(vx2, vx1), dx2),
+                                _mm256_mul_ps(_mm256_sub_ps(vy2, vy1), dy2));
+    __m256 length2 = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx2, dx2), _mm256_mul_ps(dy2, dy2)));
+    __m256 scale2 = _mm256_mul_ps(_mm256_loadu_ps(batch.coefficient2 + k),
+                                  _mm256_div_ps(dot2, _mm256_mul_ps(length2, length2)));
+
+    //particles only bounce if they are moving towards each other
+    __m256 approaching = _mm256_cmp_ps(dot1, zero, _CMP_LT_OQ);
+    _mm256_storeu_ps(batch.vx1 + k, _mm256_blendv_ps(vx1, _mm256_sub_ps(vx1, _mm256_mul_ps(scale1, dx1)), approaching));
+    _mm256_storeu_ps(batch.vy1 + k, _mm256_blendv_ps(vy1, _mm256_sub_ps(vy1, _mm256_mul_ps(scale1, dy1)), approaching));
+    _mm256_storeu_ps(batch.vx2 + k, _mm256_blendv_ps(vx2, _mm256_sub_ps(vx2, _mm256_mul_ps(scale2, dx2)), approaching));
+    _mm256_storeu_ps(batch.vy2 + k, _mm256_blendv_ps(vy2, _mm256_sub_ps(vy2, _mm256_mul_ps(scale2, dy2)), approaching));
+
+    //padding lanes repeat the last pair, so they aren't counted
+    int bounced = _mm256_movemask_ps(approaching) & ((1 << std::min(count - k, size_t(8))) - 1);
+    num_bounced += size_t(__builtin_popcount(unsigned(bounced)));
+  }
+  batch.Scatter(particles, first, second, count);
+  return num_bounced;
+}
+
+#endif  // IDEALGAS_X86_SIMD
+
+}  // namespace
+
+MemberLanes::MemberLanes(size_t num_slots) : x(num_slots * kNumLanes), y(num_slots * kNumLanes),
+                                             vx(num_slots * kNumLanes), vy(num_slots * kNumLanes),
+                                             mass(num_slots * kNumLanes), radius(num_slots * kNumLanes),
+                                             speeds(num_slots * kNumLanes), sizes(), left(), right(), top(),
+                                             bottom(), totals() {}
+
+size_t MemberLanes::NumSlots() const {
+  return x.size() / kNumLanes;
+}
+
+SimdKernels::SimdKernels(SimdLevel level) : level_(std::min(level, GetBestSimdLevel())) {}
+
+SimdLevel SimdKernels::GetBestSimdLevel() {
+#ifdef IDEALGAS_X86_SIMD
+  if (__builtin_cpu_supports("avx2")) {
+    return SimdLevel::kAvx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return SimdLevel::kSse2;
+  }
+#endif
+  return SimdLevel::kScalar;
+}
+
+SimdLevel SimdKernels::GetLevel() const {
+  return level_;
+}
+
+void SimdKernels::Integrate(ParticleStore& particles, size_t begin, size_t end) const {
+#ifdef IDEALGAS_X86_SIMD
+  if (level_ == SimdLevel::kAvx2) {
+    IntegrateAvx2(particles, begin, end);
+    return;
+  }
+  if (level_ == SimdLevel::kSse2) {
+    IntegrateSse2(particles, begin, end);
+    return;
+  }
+#endif
+  IntegrateScalar(particles, begin, end);
+}
+
+void SimdKernels::ReflectWalls(ParticleStore& particles, size_t begin, size_t end, const WallBounds& walls,
+                               float* speeds, WallImpulses& impulses) const {
+#ifdef IDEALGAS_X86_SIMD
+  if (level_ == SimdLevel::kAvx2) {
+    ReflectWallsAvx2(particles, begin, end, walls, speeds, impulses);
+    return;
+  }
+  if (level_ == SimdLevel::kSse2) {
+    ReflectWallsSse2(particles, begin, end, walls, speeds, impulses);
+    return;
+  }
+#endif
+  ReflectWallsScalar(particles, begin, end, walls, speeds, impulses);
+}
+
+void SimdKernels::ReflectAndIntegrateLanes(MemberLanes& lanes) const {
+#ifdef IDEALGAS_X86_SIMD
+  if (level_ == SimdLevel::kAvx2) {
+    ReflectAndIntegrateLanesAvx2(lanes);
+    return;
+  }
+#endif
+  ReflectAndIntegrateLanesScalar(lanes);
+}
+
+void SimdKernels::FindCollidingPairs(const ParticleStore& particles, const vector<uint32_t>& first,
+                                     const vector<uint32_t>& second, size_t count,
+                                     vector<uint32_t>& colliding_first, vector<uint32_t>& colliding_second) const {
+  colliding_first.clear();
+  colliding_second.clear();
+#ifdef IDEALGAS_X86_SIMD
+  if (level_ == SimdLevel::kAvx2) {
+    FindCollidingPairsAvx2(particles, first.data(), second.data(), 0, count, colliding_first, colliding_second);
+    return;
+  }
+  if (level_ == SimdLevel::kSse2) {
+    FindCollidingPairsSse2(particles, first.data(), second.data(), 0, count, colliding_first, colliding_second);
+    return;
+  }
+#endif
+  FindCollidingPairsScalar(particles, first.data(), second.data(), 0, count, colliding_first, colliding_second);
+}
+
+size_t SimdKernels::ResolveCollidingPairs(ParticleStore& particles, const vector<uint32_t>& first,
+                                          const vector<uint32_t>& second, size_t count) const {
+  size_t num_bounced = 0;
+
+  //grow each batch until the next pair shares a particle with it, since that pair has to
+  //see the velocities the batch produces
+  size_t batch_begin = 0;
+  for (size_t k = 0; k < count; k++) {
+    bool shares_particle = k - batch_begin == kMaxBatchPairs;
+    for (size_t other = batch_begin; other < k && !shares_particle; other++) {
+      shares_particle = first[other] == first[k] || first[other] == second[k]
+                        || second[other] == first[k] || second[other] == second[k];
+    }
+    if (shares_particle) {
+      num_bounced += ResolveBatch(particles, first.data() + batch_begin, second.data() + batch_begin, k - batch_begin);
+      batch_begin = k;
+    }
+  }
+  if (count > batch_begin) {
+    num_bounced += ResolveBatch(particles, first.data() + batch_begin, second.data() + batch_begin,
+                                count - batch_begin);
+  }
+  return num_bounced;
+}
+
+size_t SimdKernels::ResolveBatch(ParticleStore& particles, const uint32_t* first, const uint32_t* second,
+                                 size_t count) const {
+#ifdef IDEALGAS_X86_SIMD
+  //a lone pair isn't worth packing into vectors
+  if (level_ == SimdLevel::kAvx2 && count > 1) {
+    return ResolveBatchAvx2(particles, first, second, count);
+  }
+  if (level_ == SimdLevel::kSse2 && count > 1) {
+    return ResolveBatchSse2(particles, first, second, count);
+  }
+#endif
+  return ResolveBatchScalar(particles, first, second, count);
+}
+
+}  // namespace idealgas
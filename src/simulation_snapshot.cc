@@ -0,0 +1,68 @@
+#include "simulation_snapshot.h"
+#include <algorithm>
+
+namespace idealgas {
+
+SimulationSnapshot::SimulationSnapshot() : histogram_window(1), histogram_view(DistributionView::kMovingAverage),
+                                           length(0), height(0), margins_left(0), margins_top(0), frame(0) {}
+
+void SimulationSnapshot::Capture(const GasContainer& container) {
+  CaptureState(container);
+  //only the counts are copied; binning the speeds again is left to BuildHistograms
+  speed_distribution = container.GetSpeedDistribution();
+  histogram_window = container.GetHistogramWindow();
+  histogram_view = container.GetHistogramView();
+  histograms.clear();
+}
+
+void SimulationSnapshot::Capture(const EventDrivenContainer& container) {
+  CaptureState(container);
+  speed_distribution.Clear();
+  histograms = container.GetHistograms();
+}
+
+template <typename Container>
+void SimulationSnapshot::CaptureState(const Container& container) {
+  //assigning keeps the vectors' memory, so a snapshot stops allocating once it has seen a frame
+  const ParticleStore& particles = container.GetParticleStore();
+  x.assign(particles.position[0].begin(), particles.position[0].end());
+  y.assign(particles.position[1].begin(), particles.position[1].end());
+  radius.assign(particles.radius.begin(), particles.radius.end());
+  species.assign(particles.species.begin(), particles.species.end());
+  species_registry = particles.species_registry;
+  length = container.GetLength();
+  height = container.GetHeight();
+  margins_left = container.GetMarginsLeft();
+  margins_top = container.GetMarginsTop();
+}
+
+void SimulationSnapshot::BuildHistograms(vector<Histogram>& result) const {
+  size_t num_frames = std::min(histogram_window, speed_distribution.GetNumFrames());
+  if (num_frames == 0) {
+    result = histograms;
+    return;
+  }
+
+  //the same boxes GasContainer gives its histograms, stacked down the left margin
+  size_t num_species = speed_distribution.GetNumSpecies();
+  int histogram_length = int(margins_left * .8);
+  int histogram_height = int(height * .9 / double(num_species));
+  int num_bins = int(speed_distribution.GetNumBins());
+  result.resize(num_species);
+  for (size_t i = 0; i < num_species; i++) {
+    const string& name = species_registry.GetSpecies(int(i)).name;
+    if (result[i].GetBarHeights().size() != size_t(num_bins) || result[i].GetColor() != name ||
+        result[i].GetLength() != histogram_length ||
+        result[i].GetHeight() != histogram_height) {
+      result[i] = Histogram(name, histogram_length, histogram_height, speed_distribution.GetMaxSpeed(), 0,
+                            vector<float>(), num_bins);
+    }
+    result[i].Reset(speed_distribution.GetMaxSpeed(), 0);
+    vector<double> distribution = speed_distribution.GetDistribution(int(i), num_frames, histogram_view);
+    for (size_t bar = 0; bar < distribution.size(); bar++) {
+      result[i].AddCount(int(bar), distribution[bar]);
+    }
+  }
+}
+
+}  // namespace idealgas
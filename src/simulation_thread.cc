@@ -0,0 +1,93 @@
+#include "simulation_thread.h"
+
+namespace idealgas {
+
+constexpr double SimulationThread::kDefaultFramesPerSecond;
+
+SimulationThread::SimulationThread(const GasContainer& container, double frames_per_second) :
+                                   container_(container), writing_(0), reading_(1), waiting_(2),
+                                   paused_(false), stopping_(false) {
+  if (frames_per_second < 0) {
+    throw std::invalid_argument("Frames per second cannot be negative.");
+  }
+  frame_period_ = std::chrono::steady_clock::duration::zero();
+  if (frames_per_second > 0) {
+    frame_period_ = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / frames_per_second));
+  }
+
+  //the reader sees the starting state until the first frame is done
+  snapshots_[reading_].Capture(container_);
+  thread_ = std::thread(&SimulationThread::Run, this);
+}
+
+SimulationThread::~SimulationThread() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  state_changed_.notify_all();
+  thread_.join();
+}
+
+const SimulationSnapshot& SimulationThread::GetLatestSnapshot() {
+  if (waiting_.load(std::memory_order_acquire) & kFreshSnapshot) {
+    reading_ = waiting_.exchange(reading_, std::memory_order_acq_rel) & kSlotMask;
+  }
+  return snapshots_[reading_];
+}
+
+bool SimulationThread::GetPaused() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return paused_;
+}
+
+void SimulationThread::SetPaused(bool paused) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    paused_ = paused;
+  }
+  state_changed_.notify_all();
+}
+
+void SimulationThread::Run() {
+  size_t frame = 0;
+  std::chrono::steady_clock::time_point next_frame = std::chrono::steady_clock::now();
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (paused_) {
+        state_changed_.wait(lock, [this] { return stopping_ || !paused_; });
+        //don't rush to catch up on the frames skipped while paused
+        next_frame = std::chrono::steady_clock::now();
+      }
+      if (stopping_) {
+        return;
+      }
+    }
+
+    container_.AdvanceOneFrame();
+    frame++;
+    Publish(frame);
+
+    if (frame_period_ != std::chrono::steady_clock::duration::zero()) {
+      //if the simulation fell behind, carry on from now instead of running frames back to back
+      next_frame += frame_period_;
+      std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+      if (next_frame < now) {
+        next_frame = now;
+      }
+      std::unique_lock<std::mutex> lock(mutex_);
+      state_changed_.wait_until(lock, next_frame, [this] { return stopping_ || paused_; });
+    }
+  }
+}
+
+void SimulationThread::Publish(size_t frame) {
+  SimulationSnapshot& snapshot = snapshots_[writing_];
+  snapshot.Capture(container_);
+  snapshot.frame = frame;
+  writing_ = waiting_.exchange(writing_ | kFreshSnapshot, std::memory_order_acq_rel) & kSlotMask;
+}
+
+}  // namespace idealgas
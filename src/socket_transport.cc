@@ -0,0 +1,212 @@
+#include "socket_transport.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace idealgas {
+
+namespace {
+
+#ifdef MSG_NOSIGNAL
+//a rank that has exited shouldn't kill the others with SIGPIPE
+const int kSendFlags = MSG_DONTWAIT | MSG_NOSIGNAL;
+#elif !defined(_WIN32)
+const int kSendFlags = MSG_DONTWAIT;
+#endif
+
+/**
+ * One message being sent to and one being received from a rank, during an exchange
+ */
+struct Transfer {
+  int socket;
+
+  //size of the outgoing message, sent before it
+  uint64_t send_size;
+  const vector<uint8_t>* send_data;
+
+  //bytes of the size and message sent so far
+  size_t sent;
+
+  uint8_t receive_header[sizeof(uint64_t)];
+  uint64_t receive_size;
+  vector<uint8_t>* receive_data;
+
+  //bytes of the size and message received so far
+  size_t received;
+
+  bool DoneSending() const {
+    return sent == sizeof(uint64_t) + send_data->size();
+  }
+
+  bool DoneReceiving() const {
+    return received >= sizeof(uint64_t) && received == sizeof(uint64_t) + receive_size;
+  }
+};
+
+}  // namespace
+
+SocketTransport::SocketTransport(int rank, const vector<int>& sockets) : rank_(rank), sockets_(sockets) {}
+
+vector<std::shared_ptr<SocketTransport>> SocketTransport::CreateGroup(int num_ranks) {
+  if (num_ranks < 1) {
+    throw std::invalid_argument("A group needs at least one rank.");
+  }
+
+#ifdef _WIN32
+  throw std::runtime_error("Socket transports are not supported on this platform.");
+#else
+  vector<vector<int>> sockets(size_t(num_ranks), vector<int>(size_t(num_ranks), -1));
+  for (int first = 0; first < num_ranks; first++) {
+    for (int second = first + 1; second < num_ranks; second++) {
+      int pair[2];
+      if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+        //close what was made so far
+        for (size_t rank = 0; rank < sockets.size(); rank++) {
+          for (size_t other = 0; other < sockets[rank].size(); other++) {
+            if (sockets[rank][other] >= 0) {
+              close(sockets[rank][other]);
+            }
+          }
+        }
+        throw std::runtime_error(std::string("Could not create a socket pair: ") + std::strerror(errno));
+      }
+      sockets[size_t(first)][size_t(second)] = pair[0];
+      sockets[size_t(second)][size_t(first)] = pair[1];
+    }
+  }
+
+  vector<std::shared_ptr<SocketTransport>> group;
+  for (int rank = 0; rank < num_ranks; rank++) {
+    group.push_back(std::shared_ptr<SocketTransport>(new SocketTransport(rank, sockets[size_t(rank)])));
+  }
+  return group;
+#endif
+}
+
+SocketTransport::~SocketTransport() {
+#ifndef _WIN32
+  for (size_t i = 0; i < sockets_.size(); i++) {
+    if (sockets_[i] >= 0) {
+      close(sockets_[i]);
+    }
+  }
+#endif
+}
+
+int SocketTransport::GetRank() const {
+  return rank_;
+}
+
+int SocketTransport::GetNumRanks() const {
+  return int(sockets_.size());
+}
+
+void SocketTransport::Exchange(const vector<int>& ranks, const vector<vector<uint8_t>>& outgoing,
+                               vector<vector<uint8_t>>& incoming) {
+  if (outgoing.size() != ranks.size()) {
+    throw std::invalid_argument("There must be one outgoing message per rank.");
+  }
+  incoming.resize(ranks.size());
+
+#ifdef _WIN32
+  throw std::runtime_error("Socket transports are not supported on this platform.");
+#else
+  vector<Transfer> transfers(ranks.size());
+  vector<pollfd> polled(ranks.size());
+  for (size_t k = 0; k < ranks.size(); k++) {
+    if (ranks[k] < 0 || ranks[k] >= GetNumRanks() || ranks[k] == rank_) {
+      throw std::invalid_argument("Can't exchange with rank " + std::to_string(ranks[k]) + ".");
+    }
+    Transfer& transfer = transfers[k];
+    transfer.socket = sockets_[size_t(ranks[k])];
+    transfer.send_size = outgoing[k].size();
+    transfer.send_data = &outgoing[k];
+    transfer.sent = 0;
+    transfer.receive_size = 0;
+    transfer.receive_data = &incoming[k];
+    transfer.received = 0;
+  }
+
+  while (true) {
+    size_t num_polled = 0;
+    for (size_t k = 0; k < transfers.size(); k++) {
+      short events = 0;
+      if (!transfers[k].DoneSending()) {
+        events |= POLLOUT;
+      }
+      if (!transfers[k].DoneReceiving()) {
+        events |= POLLIN;
+      }
+      polled[k].fd = transfers[k].socket;
+      polled[k].events = events;
+      polled[k].revents = 0;
+      num_polled += events != 0;
+    }
+    if (num_polled == 0) {
+      return;
+    }
+    if (poll(polled.data(), nfds_t(polled.size()), -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error(std::string("Could not wait on the sockets: ") + std::strerror(errno));
+    }
+
+    for (size_t k = 0; k < transfers.size(); k++) {
+      Transfer& transfer = transfers[k];
+      if ((polled[k].revents & POLLOUT) != 0) {
+        //the size first, then the message
+        const uint8_t* data;
+        size_t remaining;
+        if (transfer.sent < sizeof(uint64_t)) {
+          data = reinterpret_cast<const uint8_t*>(&transfer.send_size) + transfer.sent;
+          remaining = sizeof(uint64_t) - transfer.sent;
+        } else {
+          data = transfer.send_data->data() + (transfer.sent - sizeof(uint64_t));
+          remaining = transfer.send_data->size() - (transfer.sent - sizeof(uint64_t));
+        }
+        ssize_t written = send(transfer.socket, data, remaining, kSendFlags);
+        if (written > 0) {
+          transfer.sent += size_t(written);
+        } else if (written < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+          throw std::runtime_error("Could not send to rank " + std::to_string(ranks[k]) + ": " + std::strerror(errno));
+        }
+      }
+
+      if ((polled[k].revents & (POLLIN | POLLHUP | POLLERR)) != 0 && !transfer.DoneReceiving()) {
+        uint8_t* data;
+        size_t remaining;
+        if (transfer.received < sizeof(uint64_t)) {
+          data = transfer.receive_header + transfer.received;
+          remaining = sizeof(uint64_t) - transfer.received;
+        } else {
+          data = transfer.receive_data->data() + (transfer.received - sizeof(uint64_t));
+          remaining = transfer.receive_size - (transfer.received - sizeof(uint64_t));
+        }
+        ssize_t read = recv(transfer.socket, data, remaining, MSG_DONTWAIT);
+        if (read == 0) {
+          throw std::runtime_error("Rank " + std::to_string(ranks[k]) + " closed its connection.");
+        } else if (read < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+          throw std::runtime_error("Could not receive from rank " + std::to_string(ranks[k]) + ": " +
+                                   std::strerror(errno));
+        } else if (read > 0) {
+          transfer.received += size_t(read);
+          if (transfer.received == sizeof(uint64_t)) {
+            std::memcpy(&transfer.receive_size, transfer.receive_header, sizeof(uint64_t));
+            transfer.receive_data->resize(size_t(transfer.receive_size));
+          }
+        }
+      }
+    }
+  }
+#endif
+}
+
+}  // namespace idealgas
@@ -0,0 +1,416 @@
+#include "software_renderer.h"
+#include "profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+namespace idealgas {
+
+namespace {
+
+const Rgba kBackgroundColor = {0, 0, 0, 255};
+const Rgba kWallColor = {255, 255, 255, 255};
+
+/**
+ * A named color, as used in species names
+ */
+struct NamedColor {
+  const char* name;
+  Rgba color;
+};
+
+const NamedColor kNamedColors[] = {
+    {"white", {255, 255, 255, 255}}, {"black", {0, 0, 0, 255}},       {"red", {255, 0, 0, 255}},
+    {"green", {0, 128, 0, 255}},     {"lime", {0, 255, 0, 255}},      {"blue", {0, 0, 255, 255}},
+    {"yellow", {255, 255, 0, 255}},  {"cyan", {0, 255, 255, 255}},    {"magenta", {255, 0, 255, 255}},
+    {"orange", {255, 165, 0, 255}},  {"purple", {128, 0, 128, 255}},  {"pink", {255, 192, 203, 255}},
+    {"brown", {165, 42, 42, 255}},   {"gray", {128, 128, 128, 255}},  {"grey", {128, 128, 128, 255}}};
+
+/**
+ * Makes the table of the CRC-32 remainder of every byte, so checksums take one lookup per byte
+ */
+vector<uint32_t> MakeCrcTable() {
+  vector<uint32_t> table(256);
+  for (uint32_t n = 0; n < 256; n++) {
+    uint32_t c = n;
+    for (int k = 0; k < 8; k++) {
+      c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+    }
+    table[n] = c;
+  }
+  return table;
+}
+
+/**
+ * Updates a PNG chunk checksum with more bytes
+ * @param crc the checksum so far, starting from 0
+ * @param data
+ * @param size
+ * @return the new checksum
+ */
+uint32_t UpdateCrc(uint32_t crc, const uint8_t* data, size_t size) {
+  static const vector<uint32_t> table = MakeCrcTable();
+  crc = ~crc;
+  for (size_t i = 0; i < size; i++) {
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+void AppendBigEndian(vector<uint8_t>& bytes, uint32_t value) {
+  bytes.push_back(uint8_t(value >> 24));
+  bytes.push_back(uint8_t(value >> 16));
+  bytes.push_back(uint8_t(value >> 8));
+  bytes.push_back(uint8_t(value));
+}
+
+/**
+ * Writes one PNG chunk: its length, type, data and checksum
+ */
+void WriteChunk(std::ofstream& file, const char* type, const vector<uint8_t>& data) {
+  vector<uint8_t> chunk;
+  AppendBigEndian(chunk, uint32_t(data.size()));
+  chunk.insert(chunk.end(), type, type + 4);
+  chunk.insert(chunk.end(), data.begin(), data.end());
+  AppendBigEndian(chunk, UpdateCrc(0, chunk.data() + 4, chunk.size() - 4));
+  file.write(reinterpret_cast<const char*>(chunk.data()), std::streamsize(chunk.size()));
+}
+
+std::ofstream OpenForWriting(const string& path) {
+  std::ofstream file(path.c_str(), std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Could not open " + path + " for writing.");
+  }
+  return file;
+}
+
+}  // namespace
+
+SoftwareRenderer::SoftwareRenderer(int width, int height, size_t num_threads) :
+                                   width_(width), height_(height), scale_(1) {
+  if (width < 1 || height < 1) {
+    throw std::invalid_argument("Image size must be positive.");
+  }
+  pixels_.assign(size_t(width) * size_t(height) * 4, 0);
+  num_tile_columns_ = (width + kTileSize - 1) / kTileSize;
+  num_tile_rows_ = (height + kTileSize - 1) / kTileSize;
+  if (num_threads > 1) {
+    thread_pool_ = std::make_shared<ThreadPool>(num_threads);
+  }
+}
+
+void SoftwareRenderer::Render(const SimulationSnapshot& snapshot) {
+  IDEALGAS_PROFILE_SCOPE("SoftwareRenderer::Render");
+
+  //fit the container and a margin on every side into the image
+  float scene_width = float(snapshot.length + 2 * snapshot.margins_left);
+  float scene_height = float(snapshot.height + 2 * snapshot.margins_top);
+  scale_ = 1;
+  if (scene_width > 0 && scene_height > 0) {
+    scale_ = std::min(float(width_) / scene_width, float(height_) / scene_height);
+  }
+
+  species_colors_.resize(snapshot.species_registry.Size());
+  for (size_t i = 0; i < species_colors_.size(); i++) {
+    species_colors_[i] = GetNamedColor(snapshot.species_registry.GetSpecies(int(i)).name);
+  }
+  BinParticles(snapshot);
+  snapshot.BuildHistograms(histograms_);
+
+  size_t num_tiles = size_t(num_tile_columns_) * size_t(num_tile_rows_);
+  std::function<void(size_t, size_t, size_t)> task = [this, &snapshot](size_t begin, size_t end, size_t) {
+    for (size_t tile = begin; tile < end; tile++) {
+      RenderTile(snapshot, tile);
+    }
+  };
+  if (thread_pool_) {
+    thread_pool_->ParallelFor(num_tiles, task);
+  } else {
+    task(0, num_tiles, 0);
+  }
+}
+
+void SoftwareRenderer::BinParticles(const SimulationSnapshot& snapshot) {
+  size_t num_particles = snapshot.x.size();
+
+  //counting sort by species
+  species_starts_.assign(species_colors_.size() + 1, 0);
+  for (size_t i = 0; i < num_particles; i++) {
+    species_starts_[size_t(snapshot.species[i]) + 1]++;
+  }
+  for (size_t s = 1; s < species_starts_.size(); s++) {
+    species_starts_[s] += species_starts_[s - 1];
+  }
+  next_slots_.assign(species_starts_.begin(), species_starts_.end() - 1);
+  species_order_.resize(num_particles);
+  for (size_t i = 0; i < num_particles; i++) {
+    species_order_[next_slots_[size_t(snapshot.species[i])]++] = uint32_t(i);
+  }
+
+  //counting sort into every tile a particle touches, keeping the species order within each tile
+  size_t num_tiles = size_t(num_tile_columns_) * size_t(num_tile_rows_);
+  tile_starts_.assign(num_tiles + 1, 0);
+  for (int pass = 0; pass < 2; pass++) {
+    if (pass == 1) {
+      for (size_t t = 1; t < tile_starts_.size(); t++) {
+        tile_starts_[t] += tile_starts_[t - 1];
+      }
+      next_slots_.assign(tile_starts_.begin(), tile_starts_.end() - 1);
+      tile_particles_.resize(tile_starts_.back());
+    }
+    for (size_t n = 0; n < num_particles; n++) {
+      uint32_t i = species_order_[n];
+      float center_x = snapshot.x[i] * scale_;
+      float center_y = snapshot.y[i] * scale_;
+      float radius = std::max(snapshot.radius[i] * scale_, 1.0f);
+      int first_column, first_row, last_column, last_row;
+      GetTileRange(center_x - radius, center_y - radius, center_x + radius, center_y + radius, first_column,
+                   first_row, last_column, last_row);
+      for (int row = first_row; row <= last_row; row++) {
+        for (int column = first_column; column <= last_column; column++) {
+          size_t tile = size_t(row) * size_t(num_tile_columns_) + size_t(column);
+          if (pass == 0) {
+            tile_starts_[tile + 1]++;
+          } else {
+            tile_particles_[next_slots_[tile]++] = i;
+          }
+        }
+      }
+    }
+  }
+}
+
+void SoftwareRenderer::GetTileRange(float min_x, float min_y, float max_x, float max_y, int& first_column,
+                                    int& first_row, int& last_column, int& last_row) const {
+  first_column = int(std::min(std::max(std::floor(min_x / kTileSize), 0.0f), float(num_tile_columns_)));
+  first_row = int(std::min(std::max(std::floor(min_y / kTileSize), 0.0f), float(num_tile_rows_)));
+  last_column = int(std::min(std::max(std::floor(max_x / kTileSize), -1.0f), float(num_tile_columns_ - 1)));
+  last_row = int(std::min(std::max(std::floor(max_y / kTileSize), -1.0f), float(num_tile_rows_ - 1)));
+}
+
+void SoftwareRenderer::RenderTile(const SimulationSnapshot& snapshot, size_t tile) {
+  int tile_x0 = int(tile % size_t(num_tile_columns_)) * kTileSize;
+  int tile_y0 = int(tile / size_t(num_tile_columns_)) * kTileSize;
+  int tile_x1 = std::min(tile_x0 + kTileSize, width_);
+  int tile_y1 = std::min(tile_y0 + kTileSize, height_);
+  FillRect(float(tile_x0), float(tile_y0), float(tile_x1), float(tile_y1), kBackgroundColor, tile_x0, tile_y0,
+           tile_x1, tile_y1);
+
+  //the tile's particles are grouped by species, so the color only changes between batches
+  int current_species = -1;
+  Rgba color = kWallColor;
+  for (size_t n = tile_starts_[tile]; n < tile_starts_[tile + 1]; n++) {
+    uint32_t i = tile_particles_[n];
+    if (snapshot.species[i] != current_species) {
+      current_species = snapshot.species[i];
+      color = species_colors_[size_t(current_species)];
+    }
+    FillCircle(snapshot.x[i] * scale_, snapshot.y[i] * scale_, snapshot.radius[i] * scale_, color, tile_x0,
+               tile_y0, tile_x1, tile_y1);
+  }
+
+  //draw the container
+  StrokeRect(float(snapshot.margins_left) * scale_, float(snapshot.margins_top) * scale_,
+             float(snapshot.margins_left + snapshot.length) * scale_,
+             float(snapshot.margins_top + snapshot.height) * scale_, kWallColor, tile_x0, tile_y0, tile_x1, tile_y1);
+
+  //draw the histograms, stacked down the left margin, with the tallest bar filling its box
+  for (size_t h = 0; h < histograms_.size(); h++) {
+    const Histogram& histogram = histograms_.at(h);
+    float bottom = float(h + 1) / float(histograms_.size());
+    float left = float(snapshot.margins_left) * .1f * scale_;
+    float base = (float(snapshot.margins_top) + float(snapshot.height) * bottom) * scale_;
+    float length = float(histogram.GetLength()) * scale_;
+    float height = float(histogram.GetHeight()) * scale_;
+    if (left - 1 >= float(tile_x1) || left + length + 1 < float(tile_x0) || base - height - 1 >= float(tile_y1) ||
+        base + 1 < float(tile_y0)) {
+      continue;
+    }
+    Rgba histogram_color = GetNamedColor(histogram.GetColor());
+    StrokeRect(left, base - height, left + length, base, histogram_color, tile_x0, tile_y0, tile_x1, tile_y1);
+
+    const vector<double>& bar_heights = histogram.GetBarHeights();
+    double max_count = 0;
+    for (size_t bar = 0; bar < bar_heights.size(); bar++) {
+      max_count = std::max(max_count, bar_heights.at(bar));
+    }
+    if (!(max_count > 0)) {
+      continue;
+    }
+    float bar_length = length / float(bar_heights.size());
+    for (size_t bar = 0; bar < bar_heights.size(); bar++) {
+      float bar_height = height * float(bar_heights.at(bar) / max_count);
+      FillRect(left + float(bar) * bar_length, base - bar_height, left + float(bar + 1) * bar_length, base,
+               histogram_color, tile_x0, tile_y0, tile_x1, tile_y1);
+    }
+  }
+}
+
+void SoftwareRenderer::FillRect(float x0, float y0, float x1, float y1, const Rgba& color, int tile_x0,
+                                int tile_y0, int tile_x1, int tile_y1) {
+  //pixels whose centers are in [x0, x1) x [y0, y1)
+  int first_x = std::max(int(std::ceil(std::min(x0, x1) - .5f)), tile_x0);
+  int last_x = std::min(int(std::ceil(std::max(x0, x1) - .5f)) - 1, tile_x1 - 1);
+  int first_y = std::max(int(std::ceil(std::min(y0, y1) - .5f)), tile_y0);
+  int last_y = std::min(int(std::ceil(std::max(y0, y1) - .5f)) - 1, tile_y1 - 1);
+  for (int y = first_y; y <= last_y; y++) {
+    uint8_t* pixel = &pixels_[(size_t(y) * size_t(width_) + size_t(first_x)) * 4];
+    for (int x = first_x; x <= last_x; x++) {
+      pixel[0] = color.r;
+      pixel[1] = color.g;
+      pixel[2] = color.b;
+      pixel[3] = color.a;
+      pixel += 4;
+    }
+  }
+}
+
+void SoftwareRenderer::StrokeRect(float x0, float y0, float x1, float y1, const Rgba& color, int tile_x0,
+                                  int tile_y0, int tile_x1, int tile_y1) {
+  //each edge is the one row or column of pixels just inside it, so walls on the image's edge still show
+  FillRect(x0, y0, x1, y0 + 1, color, tile_x0, tile_y0, tile_x1, tile_y1);
+  FillRect(x0, y1 - 1, x1, y1, color, tile_x0, tile_y0, tile_x1, tile_y1);
+  FillRect(x0, y0, x0 + 1, y1, color, tile_x0, tile_y0, tile_x1, tile_y1);
+  FillRect(x1 - 1, y0, x1, y1, color, tile_x0, tile_y0, tile_x1, tile_y1);
+}
+
+void SoftwareRenderer::FillCircle(float center_x, float center_y, float radius, const Rgba& color, int tile_x0,
+                                  int tile_y0, int tile_x1, int tile_y1) {
+  //always cover the pixel the center is in, so tiny particles still show up
+  FillRect(std::floor(center_x), std::floor(center_y), std::floor(center_x) + 1, std::floor(center_y) + 1, color,
+           tile_x0, tile_y0, tile_x1, tile_y1);
+
+  int first_y = std::max(int(std::floor(center_y - radius)), tile_y0);
+  int last_y = std::min(int(std::ceil(center_y + radius)), tile_y1 - 1);
+  for (int y = first_y; y <= last_y; y++) {
+    float dy = float(y) + .5f - center_y;
+    float span_squared = radius * radius - dy * dy;
+    if (span_squared < 0) {
+      continue;
+    }
+    float half_span = std::sqrt(span_squared);
+    FillRect(center_x - half_span, float(y), center_x + half_span + 1e-6f, float(y) + 1, color, tile_x0, tile_y0,
+             tile_x1, tile_y1);
+  }
+}
+
+int SoftwareRenderer::GetWidth() const {
+  return width_;
+}
+
+int SoftwareRenderer::GetHeight() const {
+  return height_;
+}
+
+const vector<uint8_t>& SoftwareRenderer::GetPixels() const {
+  return pixels_;
+}
+
+Rgba SoftwareRenderer::GetPixel(int x, int y) const {
+  if (x < 0 || y < 0 || x >= width_ || y >= height_) {
+    throw std::invalid_argument("Pixel is outside the image.");
+  }
+  const uint8_t* pixel = &pixels_[(size_t(y) * size_t(width_) + size_t(x)) * 4];
+  Rgba color = {pixel[0], pixel[1], pixel[2], pixel[3]};
+  return color;
+}
+
+void SoftwareRenderer::WritePpm(const string& path) const {
+  std::ofstream file = OpenForWriting(path);
+  file << "P6\n" << width_ << " " << height_ << "\n255\n";
+  vector<uint8_t> row(size_t(width_) * 3);
+  for (int y = 0; y < height_; y++) {
+    const uint8_t* pixel = &pixels_[size_t(y) * size_t(width_) * 4];
+    for (int x = 0; x < width_; x++) {
+      row[size_t(x) * 3] = pixel[0];
+      row[size_t(x) * 3 + 1] = pixel[1];
+      row[size_t(x) * 3 + 2] = pixel[2];
+      pixel += 4;
+    }
+    file.write(reinterpret_cast<const char*>(row.data()), std::streamsize(row.size()));
+  }
+}
+
+void SoftwareRenderer::WritePng(const string& path) const {
+  std::ofstream file = OpenForWriting(path);
+  const uint8_t signature[] = {137, 80, 78, 71, 13, 10, 26, 10};
+  file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+  //8 bits per channel, RGBA, no interlacing
+  vector<uint8_t> header;
+  AppendBigEndian(header, uint32_t(width_));
+  AppendBigEndian(header, uint32_t(height_));
+  const uint8_t header_end[] = {8, 6, 0, 0, 0};
+  header.insert(header.end(), header_end, header_end + sizeof(header_end));
+  WriteChunk(file, "IHDR", header);
+
+  //every row starts with filter type 0, then the rows go in a zlib stream of stored deflate blocks
+  size_t row_size = size_t(width_) * 4 + 1;
+  size_t raw_size = row_size * size_t(height_);
+  const size_t kMaxStoredBlock = 65535;
+  vector<uint8_t> data;
+  data.reserve(raw_size + (raw_size / kMaxStoredBlock + 1) * 5 + 6);
+  data.push_back(0x78);
+  data.push_back(0x01);
+  uint32_t adler_a = 1;
+  uint32_t adler_b = 0;
+  size_t block_left = 0;
+  size_t raw_left = raw_size;
+  for (int y = 0; y < height_; y++) {
+    for (size_t n = 0; n < row_size; n++) {
+      if (block_left == 0) {
+        block_left = std::min(raw_left, kMaxStoredBlock);
+        data.push_back(raw_left == block_left ? 1 : 0);
+        data.push_back(uint8_t(block_left));
+        data.push_back(uint8_t(block_left >> 8));
+        data.push_back(uint8_t(~block_left));
+        data.push_back(uint8_t(~block_left >> 8));
+      }
+      uint8_t byte = n == 0 ? 0 : pixels_[size_t(y) * size_t(width_) * 4 + n - 1];
+      data.push_back(byte);
+      adler_a = (adler_a + byte) % 65521;
+      adler_b = (adler_b + adler_a) % 65521;
+      block_left--;
+      raw_left--;
+    }
+  }
+  AppendBigEndian(data, (adler_b << 16) | adler_a);
+  WriteChunk(file, "IDAT", data);
+  WriteChunk(file, "IEND", vector<uint8_t>());
+}
+
+void SoftwareRenderer::WriteImage(const string& path) const {
+  size_t dot = path.rfind('.');
+  string extension = dot == string::npos ? "" : path.substr(dot);
+  if (extension == ".png") {
+    WritePng(path);
+  } else if (extension == ".ppm") {
+    WritePpm(path);
+  } else {
+    throw std::invalid_argument("Image path must end in .png or .ppm.");
+  }
+}
+
+string SoftwareRenderer::GetFramePath(const string& path, size_t frame) {
+  char number[32];
+  std::snprintf(number, sizeof(number), "_%06lu", static_cast<unsigned long>(frame));
+  size_t dot = path.rfind('.');
+  size_t slash = path.find_last_of("/\\");
+  if (dot == string::npos || (slash != string::npos && dot < slash)) {
+    return path + number;
+  }
+  return path.substr(0, dot) + number + path.substr(dot);
+}
+
+Rgba SoftwareRenderer::GetNamedColor(const string& name) {
+  for (size_t i = 0; i < sizeof(kNamedColors) / sizeof(kNamedColors[0]); i++) {
+    if (name == kNamedColors[i].name) {
+      return kNamedColors[i].color;
+    }
+  }
+  return kWallColor;
+}
+
+}  // namespace idealgas
@@ -0,0 +1,272 @@
+#include "spatial_grid.h"
+#include <cmath>
+
+namespace idealgas {
+
+template <glm::length_t D, typename T>
+BasicSpatialGrid<D, T>::BasicSpatialGrid() : min_(T(0)), cell_size_(1), first_column_(0), total_columns_(1) {
+  num_cells_.fill(1);
+
+  //each pair of neighbouring rows is checked once, from the row whose offset to the other is
+  //positive along the last axis where they differ
+  size_t num_rows = 1;
+  for (glm::length_t axis = 1; axis < D; axis++) {
+    num_rows *= 3;
+  }
+  for (size_t row = 0; row < num_rows; row++) {
+    Cell offset = Cell();
+    size_t digits = row;
+    int last_offset = 0;
+    for (glm::length_t axis = 1; axis < D; axis++) {
+      offset[axis] = int(digits % 3) - 1;
+      digits /= 3;
+      last_offset = offset[axis] != 0 ? offset[axis] : last_offset;
+    }
+    if (last_offset > 0) {
+      forward_rows_.push_back(offset);
+    }
+  }
+}
+
+template <glm::length_t D, typename T>
+void BasicSpatialGrid<D, T>::Rebuild(const BasicParticleStore<D, T>& particles, const Vector& min, const Vector& size,
+                                     T margin) {
+  T max_radius = 0;
+  for (size_t i = 0; i < particles.Size(); i++) {
+    max_radius = std::max(max_radius, particles.radius[i]);
+  }
+  T cell_size = ChooseCellSize(max_radius, particles.Size(), size, margin);
+  Cell num_cells;
+  for (glm::length_t axis = 0; axis < D; axis++) {
+    num_cells[axis] = std::max(int(std::ceil(size[axis] / cell_size)), 1);
+  }
+  RebuildColumns(particles, min, cell_size, num_cells, 0, num_cells[0]);
+}
+
+template <glm::length_t D, typename T>
+void BasicSpatialGrid<D, T>::RebuildColumns(const BasicParticleStore<D, T>& particles, const Vector& min, T cell_size,
+                                            const Cell& num_cells, int first_column, int end_column) {
+  min_ = min;
+  cell_size_ = cell_size;
+  first_column_ = first_column;
+  total_columns_ = num_cells[0];
+  num_cells_ = num_cells;
+  num_cells_[0] = end_column - first_column;
+
+  //counting sort of the particles by cell
+  size_t num_grid_cells = 1;
+  for (glm::length_t axis = 0; axis < D; axis++) {
+    num_grid_cells *= size_t(num_cells_[axis]);
+  }
+  cell_starts_.assign(num_grid_cells + 1, 0);
+  particle_cells_.resize(particles.Size());
+  for (size_t i = 0; i < particles.Size(); i++) {
+    int column = GetCellCoordinate(particles.position[0][i], min_[0], cell_size_, total_columns_) - first_column_;
+    size_t cell = size_t(std::min(std::max(column, 0), num_cells_[0] - 1));
+    size_t stride = size_t(num_cells_[0]);
+    for (glm::length_t axis = 1; axis < D; axis++) {
+      cell += size_t(GetCellCoordinate(particles.position[axis][i], min_[axis], cell_size_, num_cells_[axis])) * stride;
+      stride *= size_t(num_cells_[axis]);
+    }
+    particle_cells_[i] = cell;
+    cell_starts_[cell + 1]++;
+  }
+  for (size_t cell = 0; cell < num_grid_cells; cell++) {
+    cell_starts_[cell + 1] += cell_starts_[cell];
+  }
+
+  //the positions go to the same slots as the indices, so the copy costs no extra scattered reads
+  next_slots_.assign(cell_starts_.begin(), cell_starts_.end() - 1);
+  cell_particles_.resize(particles.Size());
+  for (glm::length_t axis = 0; axis < D; axis++) {
+    cell_position_[axis].resize(particles.Size());
+  }
+  cell_radius_.resize(particles.Size());
+  for (size_t i = 0; i < particles.Size(); i++) {
+    size_t slot = next_slots_[particle_cells_[i]]++;
+    cell_particles_[slot] = i;
+    for (glm::length_t axis = 0; axis < D; axis++) {
+      cell_position_[axis][slot] = particles.position[axis][i];
+    }
+    cell_radius_[slot] = particles.radius[i];
+  }
+}
+
+template <glm::length_t D, typename T>
+T BasicSpatialGrid<D, T>::ChooseCellSize(T max_radius, size_t num_particles, const Vector& size, T margin) {
+  //two particles can only touch if they are within two of the largest radii of each other
+  T cell_size = std::max(2 * max_radius + margin, T(1));
+  T max_cells = std::max(T(kMaxCellsPerParticle) * T(num_particles), T(kMinMaxCells));
+  T num_cells = 1;
+  T volume = 1;
+  for (glm::length_t axis = 0; axis < D; axis++) {
+    num_cells *= size[axis] / cell_size;
+    volume *= size[axis];
+  }
+  if (num_cells > max_cells) {
+    cell_size = D == 2 ? std::sqrt(volume / max_cells) : std::pow(volume / max_cells, T(1) / T(D));
+  }
+  return cell_size;
+}
+
+template <glm::length_t D, typename T>
+int BasicSpatialGrid<D, T>::GetCellCoordinate(T coordinate, T min, T cell_size, int count) {
+  //particles slightly past the walls still go in the edge cells
+  int cell = int(std::floor((coordinate - min) / cell_size));
+  return std::min(std::max(cell, 0), count - 1);
+}
+
+template <glm::length_t D, typename T>
+size_t BasicSpatialGrid<D, T>::GetRowStart(const Cell& cell, bool& inside) const {
+  size_t start = 0;
+  size_t stride = size_t(num_cells_[0]);
+  inside = true;
+  for (glm::length_t axis = 1; axis < D; axis++) {
+    inside = inside && cell[axis] >= 0 && cell[axis] < num_cells_[axis];
+    start += size_t(cell[axis]) * stride;
+    stride *= size_t(num_cells_[axis]);
+  }
+  return start;
+}
+
+template <glm::length_t D, typename T>
+void BasicSpatialGrid<D, T>::FindCandidates(size_t index, vector<size_t>& candidates) const {
+  candidates.clear();
+  Cell cell;
+  size_t digits = particle_cells_[index];
+  for (glm::length_t axis = 0; axis < D; axis++) {
+    cell[axis] = int(digits % size_t(num_cells_[axis]));
+    digits /= size_t(num_cells_[axis]);
+  }
+  size_t first_column = size_t(std::max(cell[0] - 1, 0));
+  size_t last_column = size_t(std::min(cell[0] + 1, num_cells_[0] - 1));
+
+  //neighbouring cells in a row are next to each other in cell_particles_, so each of the 3^(D - 1)
+  //rows around the particle's is one range
+  size_t num_rows = 1;
+  for (glm::length_t axis = 1; axis < D; axis++) {
+    num_rows *= 3;
+  }
+  for (size_t row = 0; row < num_rows; row++) {
+    Cell neighbour = cell;
+    size_t offsets = row;
+    for (glm::length_t axis = 1; axis < D; axis++) {
+      neighbour[axis] += int(offsets % 3) - 1;
+      offsets /= 3;
+    }
+    bool inside;
+    size_t row_start = GetRowStart(neighbour, inside);
+    if (!inside) {
+      continue;
+    }
+    size_t end = cell_starts_[row_start + last_column + 1];
+    for (size_t k = cell_starts_[row_start + first_column]; k < end; k++) {
+      if (cell_particles_[k] > index) {
+        candidates.push_back(cell_particles_[k]);
+      }
+    }
+  }
+
+  //the collision loop depends on visiting particles in index order
+  std::sort(candidates.begin(), candidates.end());
+}
+
+template <glm::length_t D, typename T>
+void BasicSpatialGrid<D, T>::FindTouchingPairs(vector<uint32_t>& first, vector<uint32_t>& second) {
+  //each pair of neighbouring cells is checked once: the rest of a cell and the cell after it in
+  //its row are one range, and each row after it is another
+  pair_keys_.clear();
+  Cell cell = Cell();
+  for (size_t id = 0; id + 1 < cell_starts_.size(); id++) {
+    size_t begin = cell_starts_[id];
+    size_t end = cell_starts_[id + 1];
+    if (begin < end) {
+      size_t row_start = id - size_t(cell[0]);
+      size_t first_column = size_t(std::max(cell[0] - 1, 0));
+      size_t last_column = size_t(std::min(cell[0] + 1, num_cells_[0] - 1));
+      size_t right_end = cell_starts_[row_start + last_column + 1];
+      for (size_t slot = begin; slot < end; slot++) {
+        AddTouchingPairs(slot, slot + 1, right_end);
+      }
+      for (size_t row = 0; row < forward_rows_.size(); row++) {
+        Cell neighbour = cell;
+        for (glm::length_t axis = 1; axis < D; axis++) {
+          neighbour[axis] += forward_rows_[row][axis];
+        }
+        bool inside;
+        size_t neighbour_start = GetRowStart(neighbour, inside);
+        if (inside) {
+          for (size_t slot = begin; slot < end; slot++) {
+            AddTouchingPairs(slot, cell_starts_[neighbour_start + first_column],
+                             cell_starts_[neighbour_start + last_column + 1]);
+          }
+        }
+      }
+    }
+
+    //step to the next cell's coordinates, first axis fastest
+    for (glm::length_t axis = 0; axis < D && ++cell[axis] == num_cells_[axis]; axis++) {
+      cell[axis] = 0;
+    }
+  }
+
+  std::sort(pair_keys_.begin(), pair_keys_.end());
+  first.resize(pair_keys_.size());
+  second.resize(pair_keys_.size());
+  for (size_t k = 0; k < pair_keys_.size(); k++) {
+    first[k] = uint32_t(pair_keys_[k] >> 32);
+    second[k] = uint32_t(pair_keys_[k]);
+  }
+}
+
+template <glm::length_t D, typename T>
+void BasicSpatialGrid<D, T>::AddTouchingPairs(size_t slot, size_t begin, size_t end) {
+  uint64_t index = cell_particles_[slot];
+  T radius = cell_radius_[slot];
+  Vector position;
+  for (glm::length_t axis = 0; axis < D; axis++) {
+    position[axis] = cell_position_[axis][slot];
+  }
+  for (size_t k = begin; k < end; k++) {
+    //negating the offsets or swapping the radii changes nothing, so this is exactly the narrowphase's test
+    T distance_squared = 0;
+    for (glm::length_t axis = 0; axis < D; axis++) {
+      T offset = cell_position_[axis][k] - position[axis];
+      distance_squared = axis == 0 ? offset * offset : distance_squared + offset * offset;
+    }
+    if (std::sqrt(distance_squared) <= radius + cell_radius_[k]) {
+      uint64_t other = cell_particles_[k];
+      pair_keys_.push_back(index < other ? index << 32 | other : other << 32 | index);
+    }
+  }
+}
+
+template <glm::length_t D, typename T>
+T BasicSpatialGrid<D, T>::GetCellSize() const {
+  return cell_size_;
+}
+
+template <glm::length_t D, typename T>
+int BasicSpatialGrid<D, T>::GetNumCells(glm::length_t axis) const {
+  return num_cells_.at(size_t(axis));
+}
+
+template <glm::length_t D, typename T>
+void BasicSpatialGrid<D, T>::GetCellRange(const Cell& cell, size_t& begin, size_t& end) const {
+  bool inside;
+  size_t id = GetRowStart(cell, inside) + size_t(cell[0]);
+  begin = cell_starts_.at(id);
+  end = cell_starts_.at(id + 1);
+}
+
+template <glm::length_t D, typename T>
+const vector<size_t>& BasicSpatialGrid<D, T>::GetCellParticles() const {
+  return cell_particles_;
+}
+
+template class BasicSpatialGrid<2, float>;
+template class BasicSpatialGrid<2, double>;
+template class BasicSpatialGrid<3, float>;
+template class BasicSpatialGrid<3, double>;
+
+}  // namespace idealgas
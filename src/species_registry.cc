@@ -0,0 +1,62 @@
+#include "species_registry.h"
+#include "physics.h"
+
+namespace idealgas {
+
+Species::Species(const string& name, float mass, float radius) :
+                 name(name), mass(mass), radius(radius) {}
+
+SpeciesRegistry::SpeciesRegistry() {}
+
+int SpeciesRegistry::Register(const string& name, float mass, float radius) {
+  for (size_t i = 0; i < species_.size(); i++) {
+    if (species_.at(i).name == name && species_.at(i).mass == mass && species_.at(i).radius == radius) {
+      return int(i);
+    }
+  }
+  species_.emplace_back(name, mass, radius);
+  UpdateCollisionCoefficients();
+  return int(species_.size() - 1);
+}
+
+int SpeciesRegistry::Register(const Species& species) {
+  return Register(species.name, species.mass, species.radius);
+}
+
+int SpeciesRegistry::FindSpecies(const string& name) const {
+  for (size_t i = 0; i < species_.size(); i++) {
+    if (species_.at(i).name == name) {
+      return int(i);
+    }
+  }
+  return -1;
+}
+
+const Species& SpeciesRegistry::GetSpecies(int species_id) const {
+  return species_.at(species_id);
+}
+
+size_t SpeciesRegistry::Size() const {
+  return species_.size();
+}
+
+float SpeciesRegistry::GetCollisionCoefficient(int species_id1, int species_id2) const {
+  return collision_coefficients_.at(size_t(species_id1) * species_.size() + size_t(species_id2));
+}
+
+const vector<float>& SpeciesRegistry::GetCollisionCoefficients() const {
+  return collision_coefficients_;
+}
+
+void SpeciesRegistry::UpdateCollisionCoefficients() {
+  collision_coefficients_.resize(species_.size() * species_.size());
+  for (size_t i = 0; i < species_.size(); i++) {
+    for (size_t j = 0; j < species_.size(); j++) {
+      float mass1 = species_.at(i).mass;
+      float mass2 = species_.at(j).mass;
+      collision_coefficients_.at(i * species_.size() + j) = idealgas::GetCollisionCoefficient(mass1, mass2);
+    }
+  }
+}
+
+}  // namespace idealgas
@@ -0,0 +1,94 @@
+#include "speed_distribution.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace idealgas {
+
+SpeedDistribution::SpeedDistribution() : num_species_(0), num_bins_(1), max_speed_(1), bin_scale_(1), capacity_(1),
+                                         counts_(), latest_(0), num_frames_(0) {}
+
+SpeedDistribution::SpeedDistribution(size_t num_species, size_t num_bins, float max_speed, size_t capacity) :
+                                     num_species_(num_species), num_bins_(num_bins), max_speed_(max_speed),
+                                     capacity_(capacity), latest_(0), num_frames_(0) {
+  if (num_bins == 0 || capacity == 0 || !(max_speed > 0)) {
+    throw std::invalid_argument("One or more parameters were invalid");
+  }
+  bin_scale_ = float(num_bins) / max_speed;
+  counts_.resize(capacity * num_species * num_bins);
+}
+
+void SpeedDistribution::AddFrame(const vector<int>& species, const vector<float>& speeds) {
+  latest_ = num_frames_ == 0 ? 0 : (latest_ + 1) % capacity_;
+  num_frames_ = std::min(num_frames_ + 1, capacity_);
+  int* frame_counts = counts_.data() + latest_ * num_species_ * num_bins_;
+  std::fill(frame_counts, frame_counts + num_species_ * num_bins_, 0);
+
+  float last_bin = float(num_bins_ - 1);
+  for (size_t i = 0; i < speeds.size(); i++) {
+    //the comparison is false for NaN too, which goes in the last bin like speeds past the top
+    float bin = speeds[i] * bin_scale_;
+    if (!(bin < last_bin)) {
+      bin = last_bin;
+    }
+    frame_counts[size_t(species[i]) * num_bins_ + size_t(bin)]++;
+  }
+}
+
+vector<double> SpeedDistribution::GetDistribution(int species_id, size_t num_frames, DistributionView view) const {
+  if (species_id < 0 || size_t(species_id) >= num_species_) {
+    throw std::invalid_argument("That species is not counted.");
+  }
+  if (num_frames == 0 || num_frames > num_frames_) {
+    throw std::invalid_argument("Can only combine between 1 frame and every frame kept.");
+  }
+
+  vector<double> distribution = vector<double>(num_bins_, 0);
+  for (size_t k = 0; k < num_frames; k++) {
+    size_t slot = (latest_ + capacity_ - k) % capacity_;
+    const int* frame_counts = counts_.data() + (slot * num_species_ + size_t(species_id)) * num_bins_;
+    for (size_t bin = 0; bin < num_bins_; bin++) {
+      distribution[bin] += frame_counts[bin];
+    }
+  }
+  for (size_t bin = 0; bin < num_bins_; bin++) {
+    distribution[bin] /= double(num_frames);
+    if (view == DistributionView::kCumulative && bin > 0) {
+      distribution[bin] += distribution[bin - 1];
+    }
+  }
+  return distribution;
+}
+
+const int* SpeedDistribution::GetFrameCounts(size_t frames_ago) const {
+  if (frames_ago >= num_frames_) {
+    throw std::invalid_argument("That frame is not kept.");
+  }
+  return counts_.data() + ((latest_ + capacity_ - frames_ago) % capacity_) * num_species_ * num_bins_;
+}
+
+size_t SpeedDistribution::GetNumFrames() const {
+  return num_frames_;
+}
+
+size_t SpeedDistribution::GetCapacity() const {
+  return capacity_;
+}
+
+size_t SpeedDistribution::GetNumSpecies() const {
+  return num_species_;
+}
+
+size_t SpeedDistribution::GetNumBins() const {
+  return num_bins_;
+}
+
+float SpeedDistribution::GetMaxSpeed() const {
+  return max_speed_;
+}
+
+void SpeedDistribution::Clear() {
+  latest_ = 0;
+  num_frames_ = 0;
+}
+
+}  // namespace idealgas
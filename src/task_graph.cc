@@ -0,0 +1,39 @@
+#include "task_graph.h"
+#include <stdexcept>
+
+namespace idealgas {
+
+TaskGraph::TaskGraph() {}
+
+size_t TaskGraph::AddTask() {
+  successors_.emplace_back();
+  num_dependencies_.push_back(0);
+  return successors_.size() - 1;
+}
+
+void TaskGraph::AddDependency(size_t before, size_t after) {
+  if (after >= Size() || before >= after) {
+    throw std::invalid_argument("A task can only depend on a task added before it.");
+  }
+  successors_[before].push_back(after);
+  num_dependencies_[after]++;
+}
+
+size_t TaskGraph::Size() const {
+  return successors_.size();
+}
+
+const vector<size_t>& TaskGraph::GetSuccessors(size_t task) const {
+  return successors_.at(task);
+}
+
+size_t TaskGraph::GetNumDependencies(size_t task) const {
+  return num_dependencies_.at(task);
+}
+
+void TaskGraph::Clear() {
+  successors_.clear();
+  num_dependencies_.clear();
+}
+
+}  // namespace idealgas
@@ -0,0 +1,275 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+namespace idealgas {
+
+namespace {
+
+//set on the pool's own threads while they run a task, so nested loops don't deadlock
+thread_local bool in_pool_task = false;
+
+}  // namespace
+
+ThreadPool::ThreadPool(size_t num_threads) : generation_(0), stopping_(false), task_(nullptr),
+                                             count_(0), chunk_size_(1), next_index_(0), busy_workers_(0),
+                                             graph_(nullptr), graph_task_(nullptr),
+                                             queues_(std::max(num_threads, size_t(1))), waiting_capacity_(0),
+                                             num_unfinished_(0), num_ready_(0), failed_(false) {
+  for (size_t i = 1; i < num_threads; i++) {
+    workers_.emplace_back(&ThreadPool::WorkerLoop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  work_ready_.notify_all();
+  for (size_t i = 0; i < workers_.size(); i++) {
+    workers_.at(i).join();
+  }
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t, size_t, size_t)>& task) {
+  if (count == 0) {
+    return;
+  }
+  if (workers_.empty() || in_pool_task || count == 1) {
+    task(0, count, 0);
+    return;
+  }
+
+  std::lock_guard<std::mutex> loop_lock(loop_mutex_);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    count_ = count;
+    chunk_size_ = std::max(count / (GetNumThreads() * kChunksPerThread), size_t(1));
+    next_index_.store(0);
+    busy_workers_ = workers_.size();
+    generation_++;
+  }
+  work_ready_.notify_all();
+
+  RunChunks(0);
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    work_done_.wait(lock, [this] { return busy_workers_ == 0; });
+    task_ = nullptr;
+  }
+  RethrowError();
+}
+
+void ThreadPool::RunGraph(const TaskGraph& graph, const std::function<void(size_t, size_t)>& task) {
+  if (workers_.empty() || in_pool_task) {
+    for (size_t i = 0; i < graph.Size(); i++) {
+      task(i, 0);
+    }
+    return;
+  }
+  if (graph.Size() == 0) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> loop_lock(loop_mutex_);
+  if (waiting_capacity_ < graph.Size()) {
+    waiting_.reset(new std::atomic<size_t>[graph.Size()]);
+    waiting_capacity_ = graph.Size();
+  }
+  //a task is only ever in one queue, so no queue outgrows the graph
+  for (size_t i = 0; i < queues_.size(); i++) {
+    queues_[i].tasks.clear();
+    queues_[i].tasks.reserve(graph.Size());
+    queues_[i].front = 0;
+  }
+
+  //the tasks that are ready straight away start in the caller's queue, lowest number at the back
+  //so the caller takes it first, and the workers steal the rest
+  for (size_t i = graph.Size(); i-- > 0;) {
+    waiting_[i].store(graph.GetNumDependencies(i), std::memory_order_relaxed);
+    if (graph.GetNumDependencies(i) == 0) {
+      queues_[0].tasks.push_back(i);
+    }
+  }
+  num_ready_.store(queues_[0].tasks.size());
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = nullptr;
+    graph_ = &graph;
+    graph_task_ = &task;
+    num_unfinished_.store(graph.Size());
+    busy_workers_ = workers_.size();
+    generation_++;
+  }
+  work_ready_.notify_all();
+
+  RunGraphTasks(0);
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    work_done_.wait(lock, [this] { return busy_workers_ == 0; });
+    graph_ = nullptr;
+    graph_task_ = nullptr;
+  }
+  RethrowError();
+}
+
+size_t ThreadPool::GetNumThreads() const {
+  return workers_.size() + 1;
+}
+
+void ThreadPool::WorkerLoop(size_t thread_index) {
+  size_t seen_generation = 0;
+  while (true) {
+    bool running_graph;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_ready_.wait(lock, [this, seen_generation] { return stopping_ || generation_ != seen_generation; });
+      if (stopping_) {
+        return;
+      }
+      seen_generation = generation_;
+      running_graph = graph_ != nullptr;
+    }
+
+    if (running_graph) {
+      RunGraphTasks(thread_index);
+    } else {
+      RunChunks(thread_index);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      busy_workers_--;
+    }
+    work_done_.notify_one();
+  }
+}
+
+void ThreadPool::RunChunks(size_t thread_index) {
+  in_pool_task = true;
+  while (!failed_.load(std::memory_order_relaxed)) {
+    size_t begin = next_index_.fetch_add(chunk_size_);
+    if (begin >= count_) {
+      break;
+    }
+    try {
+      (*task_)(begin, std::min(begin + chunk_size_, count_), thread_index);
+    } catch (...) {
+      RecordError();
+    }
+  }
+  in_pool_task = false;
+}
+
+void ThreadPool::RunGraphTasks(size_t thread_index) {
+  in_pool_task = true;
+  while (num_unfinished_.load(std::memory_order_acquire) > 0) {
+    size_t task;
+    if (!TakeTask(thread_index, task)) {
+      //sleep until a running task readies another one, or the last one finishes
+      std::unique_lock<std::mutex> lock(idle_mutex_);
+      task_ready_.wait(lock, [this] {
+        return num_ready_.load(std::memory_order_acquire) > 0 || num_unfinished_.load(std::memory_order_acquire) == 0;
+      });
+      continue;
+    }
+
+    //after a task throws, the rest are still retired without running, so the graph finishes
+    if (!failed_.load(std::memory_order_relaxed)) {
+      try {
+        (*graph_task_)(task, thread_index);
+      } catch (...) {
+        RecordError();
+      }
+    }
+
+    //the last dependency to finish readies the task, in reverse so the first successor is taken first
+    const vector<size_t>& successors = graph_->GetSuccessors(task);
+    for (size_t i = successors.size(); i-- > 0;) {
+      if (waiting_[successors[i]].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        PushTask(thread_index, successors[i]);
+      }
+    }
+    if (num_unfinished_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      WakeIdleThreads();
+    }
+  }
+  in_pool_task = false;
+}
+
+bool ThreadPool::TakeTask(size_t thread_index, size_t& task) {
+  for (size_t k = 0; k < queues_.size(); k++) {
+    WorkQueue& queue = queues_[(thread_index + k) % queues_.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.size() == queue.front) {
+      continue;
+    }
+    if (k == 0) {
+      task = queue.tasks.back();
+      queue.tasks.pop_back();
+    } else {
+      task = queue.tasks[queue.front++];
+    }
+    num_ready_.fetch_sub(1, std::memory_order_acq_rel);
+    if (queue.tasks.size() == queue.front) {
+      queue.tasks.clear();
+      queue.front = 0;
+    }
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::PushTask(size_t thread_index, size_t task) {
+  //counted before it is queued, so num_ready_ is never below the tasks really queued
+  num_ready_.fetch_add(1, std::memory_order_acq_rel);
+  bool has_other_task;
+  {
+    WorkQueue& queue = queues_[thread_index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(task);
+    has_other_task = queue.tasks.size() - queue.front > 1;
+  }
+
+  //this thread runs its newest task itself, so only wake another when there are two
+  if (has_other_task) {
+    {
+      std::lock_guard<std::mutex> lock(idle_mutex_);
+    }
+    task_ready_.notify_one();
+  }
+}
+
+void ThreadPool::WakeIdleThreads() {
+  //taking the lock means no thread is between checking for tasks and starting to wait
+  {
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+  }
+  task_ready_.notify_all();
+}
+
+void ThreadPool::RecordError() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!error_) {
+    error_ = std::current_exception();
+  }
+  failed_.store(true, std::memory_order_relaxed);
+}
+
+void ThreadPool::RethrowError() {
+  std::exception_ptr error;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::swap(error, error_);
+    failed_.store(false, std::memory_order_relaxed);
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+}  // namespace idealgas
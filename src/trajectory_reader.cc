@@ -0,0 +1,126 @@
+#include "trajectory_reader.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace idealgas {
+
+TrajectoryReader::TrajectoryReader(const string& path) :
+                                   file_(path.c_str(), std::ios::binary), current_frame_(0), has_current_(false) {
+  if (!file_) {
+    throw std::runtime_error("Could not open " + path + ".");
+  }
+  if (!file_.read(reinterpret_cast<char*>(&header_), sizeof(header_)) ||
+      std::memcmp(header_.magic, TrajectoryWriter::kMagic, sizeof(header_.magic)) != 0) {
+    throw std::runtime_error(path + " is not a trajectory file.");
+  }
+  if (header_.version != TrajectoryWriter::kVersion) {
+    throw std::runtime_error("Unsupported trajectory version.");
+  }
+  if (header_.frames_per_chunk == 0 || header_.index_offset == 0) {
+    throw std::runtime_error("Trajectory file was not closed.");
+  }
+
+  //every frame takes at least its size and a byte per value, so a header that claims more
+  //frames or particles than fit before the index is damaged, and nothing is allocated for it
+  file_.seekg(0, std::ios::end);
+  uint64_t file_size = uint64_t(file_.tellg());
+  if (header_.index_offset < sizeof(header_) || header_.index_offset > file_size - sizeof(uint64_t)) {
+    throw std::runtime_error("Trajectory index is damaged.");
+  }
+  uint64_t frames_size = header_.index_offset - sizeof(header_);
+  if (header_.num_frames > frames_size / sizeof(uint32_t) || header_.num_particles > frames_size / 4) {
+    throw std::runtime_error("Trajectory header is damaged.");
+  }
+
+  uint64_t num_chunks = 0;
+  file_.seekg(std::streamoff(header_.index_offset));
+  file_.read(reinterpret_cast<char*>(&num_chunks), sizeof(num_chunks));
+  if (!file_ || num_chunks != (header_.num_frames + header_.frames_per_chunk - 1) / header_.frames_per_chunk ||
+      num_chunks > (file_size - header_.index_offset - sizeof(uint64_t)) / sizeof(uint64_t)) {
+    throw std::runtime_error("Trajectory index is damaged.");
+  }
+  chunk_offsets_.resize(size_t(num_chunks));
+  file_.read(reinterpret_cast<char*>(chunk_offsets_.data()), std::streamsize(num_chunks * sizeof(uint64_t)));
+  if (!file_) {
+    throw std::runtime_error("Trajectory index is damaged.");
+  }
+  current_.resize(size_t(4 * header_.num_particles));
+}
+
+size_t TrajectoryReader::GetNumFrames() const {
+  return size_t(header_.num_frames);
+}
+
+size_t TrajectoryReader::GetNumParticles() const {
+  return size_t(header_.num_particles);
+}
+
+const TrajectoryHeader& TrajectoryReader::GetHeader() const {
+  return header_;
+}
+
+void TrajectoryReader::ReadFrame(size_t frame, vector<float>& x, vector<float>& y, vector<float>& vx,
+                                 vector<float>& vy) {
+  if (frame >= header_.num_frames) {
+    throw std::invalid_argument("Frame is past the end of the trajectory.");
+  }
+
+  //carry on from the last frame if it is earlier in the same chunk, otherwise start at the keyframe
+  size_t chunk = frame / header_.frames_per_chunk;
+  if (!has_current_ || current_frame_ > frame || current_frame_ / header_.frames_per_chunk != chunk) {
+    file_.clear();
+    file_.seekg(std::streamoff(chunk_offsets_.at(chunk)));
+    DecodeNextFrame(true);
+    current_frame_ = chunk * header_.frames_per_chunk;
+    has_current_ = true;
+  }
+  while (current_frame_ < frame) {
+    DecodeNextFrame(false);
+    current_frame_++;
+  }
+
+  size_t num_particles = size_t(header_.num_particles);
+  vector<float>* arrays[] = {&x, &y, &vx, &vy};
+  for (size_t a = 0; a < 4; a++) {
+    float step = a < 2 ? header_.position_step : header_.velocity_step;
+    const int32_t* quantised = current_.data() + a * num_particles;
+    arrays[a]->resize(num_particles);
+    for (size_t i = 0; i < num_particles; i++) {
+      (*arrays[a])[i] = float(quantised[i]) * step;
+    }
+  }
+}
+
+void TrajectoryReader::DecodeNextFrame(bool keyframe) {
+  uint32_t size = 0;
+  file_.read(reinterpret_cast<char*>(&size), sizeof(size));
+  encoded_.resize(size);
+  file_.read(reinterpret_cast<char*>(encoded_.data()), std::streamsize(size));
+  if (!file_) {
+    has_current_ = false;
+    throw std::runtime_error("Trajectory frame is truncated.");
+  }
+
+  size_t position = 0;
+  for (size_t i = 0; i < current_.size(); i++) {
+    //undo the zigzag varint written by TrajectoryWriter
+    uint64_t zigzag = 0;
+    int shift = 0;
+    while (true) {
+      if (position >= encoded_.size() || shift > 63) {
+        has_current_ = false;
+        throw std::runtime_error("Trajectory frame is damaged.");
+      }
+      uint8_t byte = encoded_[position++];
+      zigzag |= uint64_t(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) {
+        break;
+      }
+      shift += 7;
+    }
+    int64_t change = int64_t(zigzag >> 1) ^ -int64_t(zigzag & 1);
+    current_[i] = int32_t(keyframe ? change : int64_t(current_[i]) + change);
+  }
+}
+
+}  // namespace idealgas
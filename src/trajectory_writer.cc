@@ -0,0 +1,222 @@
+#include "trajectory_writer.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace idealgas {
+
+constexpr float TrajectoryWriter::kDefaultPositionStep;
+constexpr float TrajectoryWriter::kDefaultVelocityStep;
+const char TrajectoryWriter::kMagic[8] = {'I', 'G', 'A', 'S', 'T', 'R', 'A', 'J'};
+
+namespace {
+
+//the header is written as raw bytes, so its layout must not depend on the compiler's padding
+static_assert(sizeof(TrajectoryHeader) == 48, "TrajectoryHeader must have no padding");
+
+/**
+ * Rounds a value to the nearest multiple of the step, clamped to what fits in 32 bits
+ */
+int32_t Quantise(float value, float step) {
+  double steps = std::floor(double(value) / double(step) + .5);
+  if (!(steps > -2147483647.0)) {
+    return -2147483647;
+  }
+  if (steps > 2147483647.0) {
+    return 2147483647;
+  }
+  return int32_t(steps);
+}
+
+/**
+ * Appends a signed value as a little-endian base-128 varint, with the sign in the lowest bit
+ * so small changes either way take one byte
+ */
+void AppendZigzagVarint(vector<uint8_t>& bytes, int64_t value) {
+  uint64_t zigzag = (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+  while (zigzag >= 0x80) {
+    bytes.push_back(uint8_t(zigzag) | 0x80);
+    zigzag >>= 7;
+  }
+  bytes.push_back(uint8_t(zigzag));
+}
+
+}  // namespace
+
+TrajectoryWriter::TrajectoryWriter(const string& path, float position_step, float velocity_step,
+                                   uint32_t frames_per_chunk, size_t queue_capacity) :
+                                   file_(path.c_str(), std::ios::binary), frames_added_(0), stopping_(false),
+                                   closed_(false), offset_(0) {
+  if (!(position_step > 0) || !(velocity_step > 0) || frames_per_chunk == 0 || queue_capacity == 0) {
+    throw std::invalid_argument("Steps, frames per chunk and queue capacity must be positive.");
+  }
+  if (!file_) {
+    throw std::runtime_error("Could not open " + path + " for writing.");
+  }
+
+  header_ = TrajectoryHeader();
+  std::memcpy(header_.magic, kMagic, sizeof(kMagic));
+  header_.version = kVersion;
+  header_.frames_per_chunk = frames_per_chunk;
+  header_.position_step = position_step;
+  header_.velocity_step = velocity_step;
+
+  //the counts and index offset aren't known yet, so the header is written again on Close
+  file_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+  offset_ = sizeof(header_);
+
+  buffers_.resize(queue_capacity);
+  for (size_t i = 0; i < queue_capacity; i++) {
+    free_buffers_.push_back(i);
+  }
+  thread_ = std::thread(&TrajectoryWriter::Run, this);
+}
+
+TrajectoryWriter::~TrajectoryWriter() {
+  if (!closed_) {
+    try {
+      Close();
+    } catch (...) {
+      //errors can't be reported from a destructor; Close reports them when called directly
+    }
+  }
+}
+
+void TrajectoryWriter::AddFrame(const ParticleStore& particles) {
+  size_t buffer_index;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (closed_) {
+      throw std::logic_error("Frames can't be added after Close.");
+    }
+    RethrowError();
+    if (frames_added_ == 0) {
+      header_.num_particles = particles.Size();
+    }
+    if (particles.Size() != header_.num_particles) {
+      throw std::invalid_argument("Every frame must have the same number of particles.");
+    }
+
+    //the only time the simulation waits is when every buffer is still queued
+    buffer_freed_.wait(lock, [this] { return !free_buffers_.empty() || error_; });
+    RethrowError();
+    buffer_index = free_buffers_.back();
+    free_buffers_.pop_back();
+    frames_added_++;
+  }
+
+  FrameBuffer& buffer = buffers_[buffer_index];
+  buffer.x.assign(particles.position[0].begin(), particles.position[0].end());
+  buffer.y.assign(particles.position[1].begin(), particles.position[1].end());
+  buffer.vx.assign(particles.velocity[0].begin(), particles.velocity[0].end());
+  buffer.vy.assign(particles.velocity[1].begin(), particles.velocity[1].end());
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queued_buffers_.push_back(buffer_index);
+  }
+  frame_queued_.notify_one();
+}
+
+void TrajectoryWriter::Close() {
+  if (closed_) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    closed_ = true;
+  }
+  frame_queued_.notify_one();
+  thread_.join();
+  RethrowError();
+
+  //the index goes after the last frame, then the header is filled in
+  header_.index_offset = offset_;
+  uint64_t num_chunks = chunk_offsets_.size();
+  file_.write(reinterpret_cast<const char*>(&num_chunks), sizeof(num_chunks));
+  file_.write(reinterpret_cast<const char*>(chunk_offsets_.data()),
+              std::streamsize(chunk_offsets_.size() * sizeof(uint64_t)));
+  file_.seekp(0);
+  file_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+  file_.close();
+  if (file_.fail()) {
+    throw std::runtime_error("Could not finish writing the trajectory.");
+  }
+}
+
+void TrajectoryWriter::Run() {
+  while (true) {
+    size_t buffer_index;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      frame_queued_.wait(lock, [this] { return stopping_ || !queued_buffers_.empty(); });
+      if (queued_buffers_.empty()) {
+        return;
+      }
+      buffer_index = queued_buffers_.front();
+      queued_buffers_.pop_front();
+    }
+
+    //after an error, frames are dropped so the simulation never waits on a broken writer
+    if (!error_) {
+      try {
+        WriteFrame(buffers_[buffer_index]);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = std::current_exception();
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      free_buffers_.push_back(buffer_index);
+    }
+    buffer_freed_.notify_one();
+  }
+}
+
+void TrajectoryWriter::WriteFrame(const FrameBuffer& buffer) {
+  size_t num_particles = buffer.x.size();
+  bool keyframe = header_.num_frames % header_.frames_per_chunk == 0;
+  if (keyframe) {
+    chunk_offsets_.push_back(offset_);
+  }
+  previous_.resize(4 * num_particles);
+
+  encoded_.clear();
+  EncodeArray(buffer.x, header_.position_step, previous_.data(), keyframe);
+  EncodeArray(buffer.y, header_.position_step, previous_.data() + num_particles, keyframe);
+  EncodeArray(buffer.vx, header_.velocity_step, previous_.data() + 2 * num_particles, keyframe);
+  EncodeArray(buffer.vy, header_.velocity_step, previous_.data() + 3 * num_particles, keyframe);
+
+  if (encoded_.size() > std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error("A trajectory frame can't take 4 GiB or more.");
+  }
+  uint32_t size = uint32_t(encoded_.size());
+  file_.write(reinterpret_cast<const char*>(&size), sizeof(size));
+  file_.write(reinterpret_cast<const char*>(encoded_.data()), std::streamsize(encoded_.size()));
+  if (!file_) {
+    throw std::runtime_error("Could not write a trajectory frame.");
+  }
+  offset_ += sizeof(size) + encoded_.size();
+  header_.num_frames++;
+}
+
+void TrajectoryWriter::EncodeArray(const vector<float>& values, float step, int32_t* previous, bool keyframe) {
+  for (size_t i = 0; i < values.size(); i++) {
+    int32_t quantised = Quantise(values[i], step);
+    int64_t change = keyframe ? int64_t(quantised) : int64_t(quantised) - int64_t(previous[i]);
+    AppendZigzagVarint(encoded_, change);
+    previous[i] = quantised;
+  }
+}
+
+void TrajectoryWriter::RethrowError() {
+  if (error_) {
+    std::rethrow_exception(error_);
+  }
+}
+
+}  // namespace idealgas
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Gets how many times operator new has been called by this test program so far, on any thread.
+ * The test program replaces the global operator new to count them.
+ */
+size_t GetAllocationCount();
@@ -0,0 +1,100 @@
+#include <catch2/catch.hpp>
+
+#include <box_container.h>
+#include <gas_container.h>
+#include <cmath>
+
+using idealgas::BoxContainer2d;
+using idealgas::BoxContainer2f;
+using idealgas::BoxContainer3d;
+using idealgas::BoxContainer3f;
+using idealgas::CollisionSchedule;
+using idealgas::GasContainer;
+using idealgas::ParticleStore;
+using idealgas::Species;
+using glm::dvec3;
+using glm::vec2;
+using glm::vec3;
+using std::pair;
+using std::vector;
+
+TEST_CASE("Test box container matches gas container in 2D") {
+  vector<pair<Species, int>> species_counts = {pair<Species, int>(Species("white", 1, 4), 200),
+                                               pair<Species, int>(Species("red", 5, 6), 50)};
+  GasContainer container = GasContainer(150, 150, 0, 0, species_counts, 7);
+  container.SetCollisionSchedule(CollisionSchedule::kSequential);
+  BoxContainer2f box = BoxContainer2f(vec2(150, 150), species_counts, 7);
+  REQUIRE(box.Size() == 250);
+
+  for (int frame = 0; frame < 30; frame++) {
+    container.AdvanceOneFrame();
+    box.AdvanceOneFrame();
+  }
+  const ParticleStore& particles = container.GetParticleStore();
+  bool all_match = true;
+  for (size_t i = 0; i < box.Size(); i++) {
+    all_match = all_match && box.GetPosition(i) == vec2(particles.position[0][i], particles.position[1][i]) &&
+                box.GetVelocity(i) == vec2(particles.velocity[0][i], particles.velocity[1][i]) &&
+                box.GetSpeciesId(i) == particles.species[i];
+  }
+  REQUIRE(all_match);
+}
+
+TEST_CASE("Test box container collisions in 3D") {
+  SECTION("Head-on collision of equal masses swaps velocities") {
+    BoxContainer3f box = BoxContainer3f(vec3(100, 100, 100));
+    int species_id = box.AddSpecies(Species("white", 1, 2));
+    box.AddParticle(species_id, vec3(49, 50, 50), vec3(1, 0, 0));
+    box.AddParticle(species_id, vec3(51, 50, 50), vec3(-1, 0, 0));
+    box.HandleAllCollisions();
+    REQUIRE(box.GetVelocity(0) == vec3(-1, 0, 0));
+    REQUIRE(box.GetVelocity(1) == vec3(1, 0, 0));
+  }
+
+  SECTION("Particles moving apart don't collide") {
+    BoxContainer3f box = BoxContainer3f(vec3(100, 100, 100));
+    int species_id = box.AddSpecies(Species("white", 1, 2));
+    box.AddParticle(species_id, vec3(50, 49, 50), vec3(0, -1, 0));
+    box.AddParticle(species_id, vec3(50, 51, 50), vec3(0, 1, 0));
+    box.HandleAllCollisions();
+    REQUIRE(box.GetVelocity(0) == vec3(0, -1, 0));
+    REQUIRE(box.GetVelocity(1) == vec3(0, 1, 0));
+  }
+
+  SECTION("Particle in a corner bounces off three walls") {
+    BoxContainer3f box = BoxContainer3f(vec3(100, 100, 100));
+    int species_id = box.AddSpecies(Species("white", 1, 2));
+    box.AddParticle(species_id, vec3(1, 99, 1), vec3(-1, 1, -1));
+    box.HandleAllCollisions();
+    REQUIRE(box.GetVelocity(0) == vec3(1, -1, 1));
+  }
+}
+
+TEST_CASE("Test box container keeps energy in 3D") {
+  vector<pair<Species, int>> species_counts = {pair<Species, int>(Species("white", 1, 4), 300),
+                                               pair<Species, int>(Species("red", 3, 6), 50)};
+  BoxContainer3d box = BoxContainer3d(dvec3(120, 100, 80), species_counts, 3);
+  double kinetic_energy = box.GetKineticEnergy();
+  REQUIRE(kinetic_energy > 0);
+  for (int frame = 0; frame < 200; frame++) {
+    box.AdvanceOneFrame();
+  }
+  REQUIRE(std::abs(box.GetKineticEnergy() - kinetic_energy) < 1e-9 * kinetic_energy);
+}
+
+TEST_CASE("Test box container invalid arguments") {
+  SECTION("Side isn't positive") {
+    REQUIRE_THROWS_AS(BoxContainer2d(glm::dvec2(100, 0)), std::invalid_argument);
+    REQUIRE_THROWS_AS(BoxContainer3f(vec3(100, 100, -5)), std::invalid_argument);
+  }
+
+  SECTION("Species doesn't fit") {
+    vector<pair<Species, int>> species_counts = {pair<Species, int>(Species("white", 1, 10), 1)};
+    REQUIRE_THROWS_AS(BoxContainer3f(vec3(100, 100, 20), species_counts, 1), std::invalid_argument);
+  }
+
+  SECTION("Species isn't registered") {
+    BoxContainer2f box = BoxContainer2f(vec2(100, 100));
+    REQUIRE_THROWS_AS(box.AddParticle(0, vec2(50, 50), vec2(0, 0)), std::invalid_argument);
+  }
+}
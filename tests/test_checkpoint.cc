@@ -0,0 +1,132 @@
+#include <catch2/catch.hpp>
+
+#include <checkpoint.h>
+#include <gas_container.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+using idealgas::Checkpoint;
+using idealgas::CheckpointHeader;
+using idealgas::CollisionSchedule;
+using idealgas::GasContainer;
+using idealgas::ParticleStore;
+using idealgas::Species;
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace {
+
+string ReadFile(const string& path) {
+  std::ifstream file(path.c_str(), std::ios::binary);
+  return string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const string& path, const string& contents) {
+  std::ofstream file(path.c_str(), std::ios::binary);
+  file.write(contents.data(), std::streamsize(contents.size()));
+}
+
+}  // namespace
+
+TEST_CASE("Test saving and loading checkpoints") {
+  vector<pair<Species, int>> species_counts = {pair<Species, int>(Species("white", 1, 3), 300),
+                                               pair<Species, int>(Species("purple", 4, 5), 100)};
+  GasContainer container = GasContainer(400, 300, 20, 10, species_counts, 6);
+  container.SetCollisionSchedule(CollisionSchedule::kCellColored);
+  for (int frame = 0; frame < 5; frame++) {
+    container.AdvanceOneFrame();
+  }
+  string path = "test_checkpoint.bin";
+  container.SaveCheckpoint(path);
+
+  SECTION("The loaded container is the saved one") {
+    GasContainer loaded = GasContainer::LoadCheckpoint(path);
+    const ParticleStore& saved_particles = container.GetParticleStore();
+    const ParticleStore& loaded_particles = loaded.GetParticleStore();
+    REQUIRE(loaded.GetLength() == 400);
+    REQUIRE(loaded.GetHeight() == 300);
+    REQUIRE(loaded.GetMarginsLeft() == 20);
+    REQUIRE(loaded.GetMarginsTop() == 10);
+    REQUIRE(loaded_particles.position[0] == saved_particles.position[0]);
+    REQUIRE(loaded_particles.position[1] == saved_particles.position[1]);
+    REQUIRE(loaded_particles.velocity[0] == saved_particles.velocity[0]);
+    REQUIRE(loaded_particles.velocity[1] == saved_particles.velocity[1]);
+    REQUIRE(loaded_particles.mass == saved_particles.mass);
+    REQUIRE(loaded_particles.radius == saved_particles.radius);
+    REQUIRE(loaded_particles.species == saved_particles.species);
+    REQUIRE(loaded.GetSpeciesRegistry().Size() == 2);
+    REQUIRE(loaded.GetSpeciesRegistry().GetSpecies(1).name == "purple");
+    REQUIRE(loaded.GetSpeciesRegistry().GetSpecies(1).mass == 4);
+    REQUIRE(loaded.GetVelocitiesOfSpecies(0) == container.GetVelocitiesOfSpecies(0));
+    REQUIRE(loaded.GetSeed() == 6);
+  }
+
+  SECTION("A loaded container carries on exactly like the saved one") {
+    GasContainer loaded = GasContainer::LoadCheckpoint(path);
+    for (int frame = 0; frame < 10; frame++) {
+      container.AdvanceOneFrame();
+      loaded.AdvanceOneFrame();
+    }
+    REQUIRE(loaded.GetParticleStore().position[0] == container.GetParticleStore().position[0]);
+    REQUIRE(loaded.GetParticleStore().velocity[1] == container.GetParticleStore().velocity[1]);
+  }
+
+  SECTION("Particle arrays are aligned in the file") {
+    Checkpoint checkpoint(path);
+    const CheckpointHeader& header = checkpoint.GetHeader();
+    REQUIRE(header.num_particles == 400);
+    REQUIRE(header.num_species == 2);
+    REQUIRE(header.rng_seed == 6);
+    REQUIRE(header.rng_counter == 400);
+    for (int i = 0; i < idealgas::kNumCheckpointArrays; i++) {
+      REQUIRE(header.array_offsets[i] % Checkpoint::kAlignment == 0);
+    }
+  }
+
+  SECTION("Files that aren't checkpoints") {
+    string contents = ReadFile(path);
+    string bad_path = "test_checkpoint_bad.bin";
+
+    WriteFile(bad_path, "not a checkpoint");
+    REQUIRE_THROWS_AS(GasContainer::LoadCheckpoint(bad_path), std::runtime_error);
+
+    string wrong_magic = contents;
+    wrong_magic[0] = 'X';
+    WriteFile(bad_path, wrong_magic);
+    REQUIRE_THROWS_AS(GasContainer::LoadCheckpoint(bad_path), std::runtime_error);
+
+    WriteFile(bad_path, contents.substr(0, contents.size() - 4));
+    REQUIRE_THROWS_AS(GasContainer::LoadCheckpoint(bad_path), std::runtime_error);
+
+    //a species offset that would wrap around when the entry size is added to it
+    string bad_offset = contents;
+    CheckpointHeader header;
+    std::memcpy(&header, bad_offset.data(), sizeof(header));
+    header.species_offset = UINT64_MAX - 4;
+    std::memcpy(&bad_offset[0], &header, sizeof(header));
+    WriteFile(bad_path, bad_offset);
+    REQUIRE_THROWS_AS(GasContainer::LoadCheckpoint(bad_path), std::runtime_error);
+
+    header.species_offset = 8;
+    std::memcpy(&bad_offset[0], &header, sizeof(header));
+    WriteFile(bad_path, bad_offset);
+    REQUIRE_THROWS_AS(GasContainer::LoadCheckpoint(bad_path), std::runtime_error);
+
+    std::remove(bad_path.c_str());
+    REQUIRE_THROWS_AS(GasContainer::LoadCheckpoint(bad_path), std::runtime_error);
+  }
+
+  std::remove(path.c_str());
+}
+
+TEST_CASE("Test empty checkpoint") {
+  GasContainer container = GasContainer(100, 100, 0, 0, vector<idealgas::Particle>());
+  string path = "test_checkpoint_empty.bin";
+  container.SaveCheckpoint(path);
+  GasContainer loaded = GasContainer::LoadCheckpoint(path);
+  std::remove(path.c_str());
+  REQUIRE(loaded.GetParticleStore().Size() == 0);
+}
@@ -0,0 +1,147 @@
+#include <catch2/catch.hpp>
+
+#include <distributed_container.h>
+#include <gas_container.h>
+#include <socket_transport.h>
+#include <thread>
+
+using idealgas::DistributedContainer;
+using idealgas::FrameObservables;
+using idealgas::GasContainer;
+using idealgas::Histogram;
+using idealgas::ParticleStore;
+using idealgas::SocketTransport;
+using idealgas::Species;
+using std::pair;
+using std::vector;
+
+namespace {
+
+/**
+ * The state of every rank's particles after a distributed run
+ */
+struct DistributedRun {
+  vector<vector<uint64_t>> ids;
+  vector<ParticleStore> particles;
+  vector<vector<Histogram>> histograms;
+  vector<FrameObservables> observables;
+};
+
+DistributedRun RunDistributed(const vector<pair<Species, int>>& species_counts, int num_ranks, int num_frames) {
+  vector<std::shared_ptr<SocketTransport>> group = SocketTransport::CreateGroup(num_ranks);
+  DistributedRun run;
+  run.ids.resize(size_t(num_ranks));
+  run.particles.resize(size_t(num_ranks));
+  run.histograms.resize(size_t(num_ranks));
+  run.observables.resize(size_t(num_ranks));
+
+  //each rank on its own thread, as it would be in its own process
+  vector<std::thread> threads;
+  for (int rank = 0; rank < num_ranks; rank++) {
+    threads.emplace_back([&, rank]() {
+      DistributedContainer container(300, 300, 10, 20, species_counts, 11, group.at(size_t(rank)));
+      for (int frame = 0; frame < num_frames; frame++) {
+        container.AdvanceOneFrame();
+      }
+      run.ids.at(size_t(rank)) = container.GetParticleIds();
+      run.particles.at(size_t(rank)) = container.GetParticleStore();
+      run.histograms.at(size_t(rank)) = container.GetHistograms();
+      run.observables.at(size_t(rank)) = container.GetObservables().GetFrame(0);
+    });
+  }
+  for (size_t i = 0; i < threads.size(); i++) {
+    threads.at(i).join();
+  }
+  return run;
+}
+
+}  // namespace
+
+TEST_CASE("Test distributed runs match a single-process run") {
+  vector<pair<Species, int>> species_counts = vector<pair<Species, int>>();
+  species_counts.emplace_back(Species("white", 1.0, 3.0), 1500);
+  species_counts.emplace_back(Species("red", 5.0, 4.0), 500);
+  GasContainer reference = GasContainer(300, 300, 10, 20, species_counts, 11);
+  reference.SetCollisionSchedule(idealgas::CollisionSchedule::kCellColored);
+  for (int frame = 0; frame < 30; frame++) {
+    reference.AdvanceOneFrame();
+  }
+  const ParticleStore& expected = reference.GetParticleStore();
+
+  int num_ranks = GENERATE(1, 2, 3, 5);
+  DistributedRun run = RunDistributed(species_counts, num_ranks, 30);
+  vector<bool> seen = vector<bool>(expected.Size(), false);
+  for (size_t rank = 0; rank < run.ids.size(); rank++) {
+    const ParticleStore& particles = run.particles.at(rank);
+    for (size_t i = 0; i < particles.Size(); i++) {
+      uint64_t id = run.ids.at(rank).at(i);
+      REQUIRE(!seen.at(id));
+      seen.at(id) = true;
+      REQUIRE(particles.position[0].at(i) == expected.position[0].at(id));
+      REQUIRE(particles.position[1].at(i) == expected.position[1].at(id));
+      REQUIRE(particles.velocity[0].at(i) == expected.velocity[0].at(id));
+      REQUIRE(particles.velocity[1].at(i) == expected.velocity[1].at(id));
+      REQUIRE(particles.species.at(i) == expected.species.at(id));
+    }
+  }
+  REQUIRE(std::count(seen.begin(), seen.end(), true) == long(expected.Size()));
+
+  //every rank has the histograms of every particle
+  for (size_t rank = 0; rank < run.histograms.size(); rank++) {
+    for (size_t h = 0; h < reference.GetHistograms().size(); h++) {
+      Histogram expected_histogram = reference.GetHistograms().at(h);
+      REQUIRE(run.histograms.at(rank).at(h).GetVelocityDistribution() == expected_histogram.GetVelocityDistribution());
+      REQUIRE(run.histograms.at(rank).at(h).GetBarRange() == expected_histogram.GetBarRange());
+    }
+  }
+
+  //every rank has the same observables, and they only differ from the reference's by rounding
+  const FrameObservables& expected_observables = reference.GetObservables().GetFrame(0);
+  for (size_t rank = 0; rank < run.observables.size(); rank++) {
+    const FrameObservables& observables = run.observables.at(rank);
+    REQUIRE(observables.frame == 30);
+    REQUIRE(observables.kinetic_energy == run.observables.at(0).kinetic_energy);
+    REQUIRE(observables.pressure == run.observables.at(0).pressure);
+    REQUIRE(observables.kinetic_energy == Approx(expected_observables.kinetic_energy));
+    REQUIRE(observables.temperature == Approx(expected_observables.temperature));
+    REQUIRE(observables.momentum_x == Approx(expected_observables.momentum_x).margin(1e-6));
+    REQUIRE(observables.momentum_y == Approx(expected_observables.momentum_y).margin(1e-6));
+    REQUIRE(observables.pressure_left == Approx(expected_observables.pressure_left));
+    REQUIRE(observables.pressure_bottom == Approx(expected_observables.pressure_bottom));
+    REQUIRE(observables.pressure == Approx(expected_observables.pressure));
+    REQUIRE(observables.particle_collisions == expected_observables.particle_collisions);
+    REQUIRE(observables.wall_collisions == expected_observables.wall_collisions);
+  }
+}
+
+TEST_CASE("Test distributed container slabs") {
+  vector<pair<Species, int>> species_counts = vector<pair<Species, int>>();
+  species_counts.emplace_back(Species("red", 5.0, 10.0), 100);
+
+  SECTION("Slabs cover every column once") {
+    vector<std::shared_ptr<SocketTransport>> group = SocketTransport::CreateGroup(2);
+    vector<int> first_columns(2);
+    vector<int> end_columns(2);
+    vector<size_t> num_particles(2);
+    vector<std::thread> threads;
+    for (int rank = 0; rank < 2; rank++) {
+      threads.emplace_back([&, rank]() {
+        DistributedContainer container(200, 100, 0, 0, species_counts, 3, group.at(size_t(rank)));
+        first_columns.at(size_t(rank)) = container.GetFirstColumn();
+        end_columns.at(size_t(rank)) = container.GetEndColumn();
+        num_particles.at(size_t(rank)) = container.GetNumParticles();
+      });
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+      threads.at(i).join();
+    }
+    REQUIRE(first_columns == vector<int>{0, 5});
+    REQUIRE(end_columns == vector<int>{5, 10});
+    REQUIRE(num_particles == vector<size_t>{100, 100});
+  }
+
+  SECTION("Slabs narrower than two columns throw") {
+    vector<std::shared_ptr<SocketTransport>> group = SocketTransport::CreateGroup(6);
+    REQUIRE_THROWS_AS(DistributedContainer(200, 100, 0, 0, species_counts, 3, group.at(0)), std::invalid_argument);
+  }
+}
@@ -0,0 +1,165 @@
+#include <catch2/catch.hpp>
+
+#include <ensemble.h>
+
+using idealgas::Ensemble;
+using idealgas::EnsembleMember;
+using idealgas::FrameObservables;
+using idealgas::GasContainer;
+using idealgas::ParticleStore;
+using idealgas::Species;
+using std::pair;
+using std::vector;
+
+/**
+ * Makes members of different sizes and mixes, all with the same two species
+ */
+vector<EnsembleMember> MakeMembers() {
+  vector<EnsembleMember> members;
+  for (int i = 0; i < 5; i++) {
+    vector<pair<Species, int>> species_counts = {pair<Species, int>(Species("white", 1, 4), 40 + 10 * i),
+                                                 pair<Species, int>(Species("red", 5, 6), 5 * i)};
+    members.emplace_back(100 + 10 * i, 100, species_counts, 11 + i);
+  }
+  return members;
+}
+
+TEST_CASE("Test ensemble members match containers run on their own") {
+  vector<EnsembleMember> members = MakeMembers();
+  Ensemble ensemble(members, 2);
+  REQUIRE(ensemble.Size() == 5);
+
+  vector<GasContainer> containers;
+  for (size_t i = 0; i < members.size(); i++) {
+    containers.emplace_back(members[i].length, members[i].height, 0, 0, members[i].species_counts, members[i].seed);
+  }
+  for (int frame = 0; frame < 20; frame++) {
+    ensemble.AdvanceOneFrame();
+    for (size_t i = 0; i < containers.size(); i++) {
+      containers[i].AdvanceOneFrame();
+    }
+  }
+
+  bool all_match = true;
+  for (size_t i = 0; i < containers.size(); i++) {
+    const ParticleStore& expected = containers[i].GetParticleStore();
+    const ParticleStore& actual = ensemble.GetMember(i).GetParticleStore();
+    all_match = all_match && actual.position[0] == expected.position[0] && actual.position[1] == expected.position[1] &&
+                actual.velocity[0] == expected.velocity[0] && actual.velocity[1] == expected.velocity[1];
+  }
+  REQUIRE(all_match);
+
+  //the members' wall passes ran interleaved, and still add up the same observables
+  for (size_t i = 0; i < containers.size(); i++) {
+    const FrameObservables& expected = containers[i].GetObservables().GetFrame(0);
+    const FrameObservables& actual = ensemble.GetMember(i).GetObservables().GetFrame(0);
+    REQUIRE(actual.kinetic_energy == expected.kinetic_energy);
+    REQUIRE(actual.momentum_x == expected.momentum_x);
+    REQUIRE(actual.pressure == expected.pressure);
+    REQUIRE(actual.wall_collisions == expected.wall_collisions);
+    REQUIRE(ensemble.GetMember(i).GetSpeeds() == containers[i].GetSpeeds());
+  }
+}
+
+TEST_CASE("Test ensemble members too big for the lanes") {
+  vector<EnsembleMember> members = MakeMembers();
+  vector<pair<Species, int>> species_counts = {pair<Species, int>(Species("white", 1, 2), 1100)};
+  members.emplace(members.begin() + 2, 300, 300, species_counts, 7);
+  Ensemble ensemble(members, 2);
+
+  vector<GasContainer> containers;
+  for (size_t i = 0; i < members.size(); i++) {
+    containers.emplace_back(members[i].length, members[i].height, 0, 0, members[i].species_counts, members[i].seed);
+  }
+  for (int frame = 0; frame < 10; frame++) {
+    ensemble.AdvanceOneFrame();
+    for (size_t i = 0; i < containers.size(); i++) {
+      containers[i].AdvanceOneFrame();
+    }
+  }
+
+  bool all_match = true;
+  for (size_t i = 0; i < containers.size(); i++) {
+    const ParticleStore& expected = containers[i].GetParticleStore();
+    const ParticleStore& actual = ensemble.GetMember(i).GetParticleStore();
+    all_match = all_match && actual.position[0] == expected.position[0] && actual.velocity[1] == expected.velocity[1] &&
+                ensemble.GetMember(i).GetObservables().GetFrame(0).pressure ==
+                containers[i].GetObservables().GetFrame(0).pressure;
+  }
+  REQUIRE(all_match);
+  REQUIRE(ensemble.GetSpeedDistribution().GetNumFrames() == 10);
+}
+
+TEST_CASE("Test ensemble averages") {
+  Ensemble ensemble(MakeMembers(), 3);
+  for (int frame = 0; frame < 5; frame++) {
+    ensemble.AdvanceOneFrame();
+  }
+
+  SECTION("Observables are those of the members as one gas") {
+    double kinetic_energy = 0;
+    double wall_collisions = 0;
+    double wall_momentum = 0;
+    double perimeter = 0;
+    double left_momentum = 0;
+    double heights = 0;
+    size_t num_particles = 0;
+    for (size_t i = 0; i < ensemble.Size(); i++) {
+      const GasContainer& member = ensemble.GetMember(i);
+      const FrameObservables& frame = member.GetObservables().GetFrame(0);
+      kinetic_energy += frame.kinetic_energy;
+      wall_collisions += frame.wall_collisions;
+      wall_momentum += frame.pressure * 2 * (member.GetLength() + member.GetHeight());
+      perimeter += 2 * (member.GetLength() + member.GetHeight());
+      left_momentum += frame.pressure_left * member.GetHeight();
+      heights += member.GetHeight();
+      num_particles += member.GetParticleStore().Size();
+    }
+    const FrameObservables& average = ensemble.GetObservables().GetFrame(0);
+    REQUIRE(average.frame == 5);
+    REQUIRE(average.num_frames == 1);
+    REQUIRE(average.kinetic_energy == Approx(kinetic_energy / 5));
+    REQUIRE(average.wall_collisions == Approx(wall_collisions / 5));
+    REQUIRE(average.temperature == Approx(kinetic_energy / double(num_particles)));
+    REQUIRE(average.pressure == Approx(wall_momentum / perimeter));
+    REQUIRE(average.pressure_left == Approx(left_momentum / heights));
+    REQUIRE(ensemble.GetObservables().Size() == 5);
+  }
+
+  SECTION("Speed counts cover every member's particles") {
+    REQUIRE(ensemble.GetSpeciesRegistry().Size() == 2);
+    REQUIRE(ensemble.GetSpeedDistribution().GetNumFrames() == 5);
+    int white = ensemble.GetSpeciesRegistry().FindSpecies("white");
+    int red = ensemble.GetSpeciesRegistry().FindSpecies("red");
+
+    double white_total = 0;
+    for (double count : ensemble.GetAverageDistribution(white)) {
+      white_total += count;
+    }
+    double red_total = 0;
+    for (double count : ensemble.GetAverageDistribution(red, 3)) {
+      red_total += count;
+    }
+    REQUIRE(white_total == Approx((40 + 50 + 60 + 70 + 80) / 5.0));
+    REQUIRE(red_total == Approx((0 + 5 + 10 + 15 + 20) / 5.0));
+
+    //the members leave the counting to the ensemble
+    REQUIRE(ensemble.GetMember(0).GetSpeedDistribution().GetNumFrames() == 1);
+  }
+}
+
+TEST_CASE("Test ensemble invalid arguments") {
+  SECTION("No members") {
+    REQUIRE_THROWS_AS(Ensemble(vector<EnsembleMember>(), 1), std::invalid_argument);
+  }
+
+  SECTION("No bins") {
+    REQUIRE_THROWS_AS(Ensemble(MakeMembers(), 1, 0), std::invalid_argument);
+  }
+
+  SECTION("Species that isn't counted") {
+    Ensemble ensemble(MakeMembers(), 1);
+    ensemble.AdvanceOneFrame();
+    REQUIRE_THROWS_AS(ensemble.GetAverageDistribution(2), std::invalid_argument);
+  }
+}
@@ -0,0 +1,72 @@
+#include <catch2/catch.hpp>
+
+#include <event_driven_container.h>
+#include <gas_container.h>
+
+using idealgas::EventDrivenContainer;
+using idealgas::GasContainer;
+using idealgas::Particle;
+using idealgas::Species;
+using glm::vec2;
+using std::pair;
+using std::vector;
+
+TEST_CASE("Test event-driven free flight") {
+  vector<Particle> particles = vector<Particle>();
+  particles.push_back(Particle(vec2(10, 10), vec2(1, 2), "black", 1.0, 1.0));
+  EventDrivenContainer container = EventDrivenContainer(100, 100, 0, 0, particles);
+  container.AdvanceOneFrame();
+  REQUIRE(container.GetParticles().at(0).GetPosition() == vec2(11, 12));
+  REQUIRE(container.GetTime() == 1);
+}
+
+TEST_CASE("Test event-driven wall collision happens mid-frame") {
+  vector<Particle> particles = vector<Particle>();
+  particles.push_back(Particle(vec2(95, 50), vec2(8, 0), "black", 1.0, 1.0));
+  EventDrivenContainer container = EventDrivenContainer(100, 100, 0, 0, particles);
+  container.AdvanceOneFrame();
+  REQUIRE(container.GetParticles().at(0).GetVelocity() == vec2(-8, 0));
+  REQUIRE(container.GetParticles().at(0).GetPosition() == vec2(95, 50));
+}
+
+TEST_CASE("Test event-driven particle collision happens at contact") {
+  vector<Particle> particles = vector<Particle>();
+  particles.push_back(Particle(vec2(40, 50), vec2(4, 0), "black", 1.0, 1.0));
+  particles.push_back(Particle(vec2(48, 50), vec2(-4, 0), "black", 1.0, 1.0));
+  EventDrivenContainer container = EventDrivenContainer(100, 100, 0, 0, particles);
+  container.AdvanceOneFrame();
+  REQUIRE(container.GetParticles().at(0).GetVelocity() == vec2(-4, 0));
+  REQUIRE(container.GetParticles().at(1).GetVelocity() == vec2(4, 0));
+  REQUIRE(container.GetParticles().at(0).GetPosition() == vec2(42, 50));
+  REQUIRE(container.GetParticles().at(1).GetPosition() == vec2(46, 50));
+  REQUIRE(container.GetNumEventsProcessed() >= 1);
+}
+
+TEST_CASE("Test event-driven gas conserves energy and stays in the box") {
+  vector<pair<Species, int>> species_counts = vector<pair<Species, int>>();
+  species_counts.emplace_back(Species("white", 1.0, 3.0), 300);
+  species_counts.emplace_back(Species("red", 5.0, 5.0), 50);
+  vector<Particle> particles = GasContainer(400, 400, 20, 30, species_counts, 5).GetParticles();
+  EventDrivenContainer container = EventDrivenContainer(400, 400, 20, 30, particles);
+
+  double initial_energy = 0;
+  for (size_t i = 0; i < particles.size(); i++) {
+    initial_energy += 0.5 * particles.at(i).GetMass() * glm::dot(particles.at(i).GetVelocity(),
+                                                                 particles.at(i).GetVelocity());
+  }
+  for (int frame = 0; frame < 200; frame++) {
+    container.AdvanceOneFrame();
+  }
+
+  double energy = 0;
+  vector<Particle> result = container.GetParticles();
+  for (size_t i = 0; i < result.size(); i++) {
+    energy += 0.5 * result.at(i).GetMass() * glm::dot(result.at(i).GetVelocity(), result.at(i).GetVelocity());
+    REQUIRE(result.at(i).GetPosition().x >= 20 - 0.01);
+    REQUIRE(result.at(i).GetPosition().x <= 420 + 0.01);
+    REQUIRE(result.at(i).GetPosition().y >= 30 - 0.01);
+    REQUIRE(result.at(i).GetPosition().y <= 430 + 0.01);
+  }
+  REQUIRE(energy == Approx(initial_energy).epsilon(1e-3));
+  REQUIRE(container.GetVelocitiesOfSpecies(1).size() == 50);
+}
@@ -0,0 +1,143 @@
+#include <catch2/catch.hpp>
+
+#include <frame_subscription.h>
+#include <thread>
+
+using idealgas::FrameRecord;
+using idealgas::FrameSubscribers;
+using idealgas::FrameSubscription;
+using idealgas::SubscriptionOptions;
+using std::shared_ptr;
+
+/**
+ * Writes a frame numbered frame into the subscription, if there is room
+ * @return false if the frame was dropped
+ */
+bool PublishTestFrame(FrameSubscription& subscription, uint64_t frame) {
+  FrameRecord* record = subscription.BeginWrite();
+  if (record == nullptr) {
+    return false;
+  }
+  record->frame = frame;
+  record->x.assign(1, float(frame));
+  subscription.EndWrite();
+  return true;
+}
+
+TEST_CASE("Test FrameSubscription hands frames over in order") {
+  SubscriptionOptions options = SubscriptionOptions();
+  options.capacity = 3;
+  FrameSubscription subscription(options, 1, 0);
+  REQUIRE(subscription.Peek() == nullptr);
+  REQUIRE(subscription.Size() == 0);
+
+  REQUIRE(PublishTestFrame(subscription, 1));
+  REQUIRE(PublishTestFrame(subscription, 2));
+  REQUIRE(subscription.Size() == 2);
+  REQUIRE(subscription.Peek()->frame == 1);
+  REQUIRE(subscription.Peek()->x.at(0) == 1);
+  subscription.Pop();
+  REQUIRE(subscription.Peek()->frame == 2);
+  subscription.Pop();
+  REQUIRE(subscription.Peek() == nullptr);
+  REQUIRE(subscription.GetDroppedFrames() == 0);
+}
+
+TEST_CASE("Test FrameSubscription drops frames when full") {
+  SubscriptionOptions options = SubscriptionOptions();
+  options.capacity = 2;
+  FrameSubscription subscription(options, 1, 0);
+  REQUIRE(PublishTestFrame(subscription, 1));
+  REQUIRE(PublishTestFrame(subscription, 2));
+  REQUIRE(subscription.IsFull());
+  REQUIRE_FALSE(PublishTestFrame(subscription, 3));
+  REQUIRE(subscription.GetDroppedFrames() == 1);
+
+  //the consumer still sees the frames it had room for, and gets new ones once it catches up
+  subscription.Pop();
+  REQUIRE_FALSE(subscription.IsFull());
+  REQUIRE(PublishTestFrame(subscription, 4));
+  REQUIRE(subscription.Peek()->frame == 2);
+  subscription.Pop();
+  REQUIRE(subscription.Peek()->frame == 4);
+}
+
+TEST_CASE("Test FrameSubscription between two threads") {
+  SubscriptionOptions options = SubscriptionOptions();
+  options.capacity = 4;
+  FrameSubscription subscription(options, 1, 0);
+  const uint64_t kNumFrames = 20000;
+
+  std::thread producer([&subscription, kNumFrames]() {
+    for (uint64_t frame = 1; frame <= kNumFrames; frame++) {
+      PublishTestFrame(subscription, frame);
+    }
+  });
+
+  //every frame the consumer gets is whole and newer than the last, and the rest were counted as dropped
+  uint64_t num_received = 0;
+  uint64_t last_frame = 0;
+  bool in_order = true;
+  while (last_frame < kNumFrames && num_received + subscription.GetDroppedFrames() < kNumFrames) {
+    const FrameRecord* record = subscription.Peek();
+    if (record == nullptr) {
+      std::this_thread::yield();
+      continue;
+    }
+    in_order = in_order && record->frame > last_frame && record->x.at(0) == float(record->frame);
+    last_frame = record->frame;
+    num_received++;
+    subscription.Pop();
+  }
+  producer.join();
+  while (subscription.Peek() != nullptr) {
+    in_order = in_order && subscription.Peek()->frame > last_frame;
+    last_frame = subscription.Peek()->frame;
+    num_received++;
+    subscription.Pop();
+  }
+
+  REQUIRE(in_order);
+  REQUIRE(num_received + subscription.GetDroppedFrames() == kNumFrames);
+}
+
+TEST_CASE("Test FrameSubscription invalid arguments") {
+  SubscriptionOptions options = SubscriptionOptions();
+  SECTION("Capacity is 0") {
+    options.capacity = 0;
+    REQUIRE_THROWS_AS(FrameSubscription(options, 1, 0), std::invalid_argument);
+  }
+
+  SECTION("Popping with no frames") {
+    FrameSubscription subscription(options, 1, 0);
+    REQUIRE_THROWS_AS(subscription.Pop(), std::logic_error);
+  }
+}
+
+TEST_CASE("Test FrameSubscribers aren't copied") {
+  SubscriptionOptions options = SubscriptionOptions();
+  shared_ptr<FrameSubscription> subscription = std::make_shared<FrameSubscription>(options, 1, 0);
+  FrameSubscribers subscribers = FrameSubscribers();
+  subscribers.Add(subscription);
+
+  FrameSubscribers copy = subscribers;
+  REQUIRE(copy.Size() == 0);
+  copy = subscribers;
+  REQUIRE(copy.Size() == 0);
+  FrameSubscribers moved = std::move(subscribers);
+  REQUIRE(moved.Size() == 1);
+  REQUIRE(&moved.At(0) == subscription.get());
+
+  //move-assigning keeps the subscriptions already there, and leaves the moved ones where they were
+  shared_ptr<FrameSubscription> other = std::make_shared<FrameSubscription>(options, 1, 0);
+  copy.Add(other);
+  copy = std::move(moved);
+  REQUIRE(copy.Size() == 1);
+  REQUIRE(&copy.At(0) == other.get());
+  REQUIRE(moved.Size() == 1);
+  REQUIRE(&moved.At(0) == subscription.get());
+
+  REQUIRE(moved.Remove(subscription));
+  REQUIRE_FALSE(moved.Remove(subscription));
+  REQUIRE(moved.Size() == 0);
+}
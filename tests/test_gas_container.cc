@@ -1,9 +1,15 @@
 #include <catch2/catch.hpp>
 
+#include "allocation_counter.h"
 #include <gas_container.h>
+#include <cmath>
 
+using idealgas::FrameObservables;
 using idealgas::GasContainer;
+using idealgas::MemberLanes;
 using idealgas::Particle;
+using idealgas::ParticleStore;
+using idealgas::Species;
 using glm::vec2;
 using std::pair;
 using std::string;
@@ -127,3 +133,639 @@ TEST_CASE("Test GetVelocitiesOfParticleColor") {
   GasContainer container = GasContainer(100, 100, 0, 0, particles);
   REQUIRE(container.GetVelocitiesOfParticleColor("black") == vector<float>{1, 1});
 }
+
+TEST_CASE("Test generating particles from species") {
+  vector<pair<Species, int>> species_counts = vector<pair<Species, int>>();
+  species_counts.emplace_back(Species("white", 1.0, 5.0), 10);
+  species_counts.emplace_back(Species("red", 5.0, 10.0), 4);
+  GasContainer container = GasContainer(200, 200, 0, 0, species_counts);
+  REQUIRE(container.GetParticles().size() == 14);
+  REQUIRE(container.GetSpeciesRegistry().Size() == 2);
+  REQUIRE(container.GetVelocitiesOfParticleColor("red").size() == 4);
+  REQUIRE(container.GetVelocitiesOfSpecies(0).size() == 10);
+  REQUIRE(container.GetParticles().at(13).GetRadius() == 10);
+}
+
+/**
+ * All-pairs version of the collision rules, used as a reference for the broadphase:
+ * pairs are resolved one at a time in index order, then particles bounce off walls
+ */
+void HandleAllCollisionsAllPairs(vector<Particle>& particles, int length, int height) {
+  for (size_t i = 0; i < particles.size(); i++) {
+    for (size_t j = i + 1; j < particles.size(); j++) {
+      if (particles.at(i).HasCollided(particles.at(j))) {
+        pair<vec2, vec2> new_velocities = particles.at(i).GetVelocitiesAfterCollision(particles.at(j));
+        particles.at(i).SetVelocity(new_velocities.first);
+        particles.at(j).SetVelocity(new_velocities.second);
+      }
+    }
+  }
+  for (size_t i = 0; i < particles.size(); i++) {
+    vec2 position = particles.at(i).GetPosition();
+    vec2 velocity = particles.at(i).GetVelocity();
+    float radius = particles.at(i).GetRadius();
+    if ((position.x - radius <= 0 && velocity.x < 0) || (position.x + radius >= length && velocity.x > 0)) {
+      particles.at(i).HandleHorizontalWallCollision();
+    }
+    if ((position.y - radius <= 0 && velocity.y < 0) || (position.y + radius >= height && velocity.y > 0)) {
+      particles.at(i).HandleVerticalWallCollision();
+    }
+  }
+  for (size_t i = 0; i < particles.size(); i++) {
+    particles.at(i).UpdateParticle();
+  }
+}
+
+/**
+ * The original all-pairs collision pass, from before pairs were resolved with current velocities.
+ * It reuses a stale copy of each particle for all of its pairs, and bounces it off the walls
+ * straight after them.
+ */
+void HandleAllCollisionsOriginal(vector<Particle>& particles, int length, int height) {
+  for (size_t i = 0; i < particles.size(); i++) {
+    Particle current_particle = particles.at(i);
+    vec2 position = current_particle.GetPosition();
+    float radius = current_particle.GetRadius();
+    for (size_t j = i + 1; j < particles.size(); j++) {
+      if (current_particle.HasCollided(particles.at(j))) {
+        pair<vec2, vec2> new_velocities = current_particle.GetVelocitiesAfterCollision(particles.at(j));
+        particles.at(i).SetVelocity(new_velocities.first);
+        particles.at(j).SetVelocity(new_velocities.second);
+      }
+    }
+    if ((position.x - radius <= 0 && current_particle.GetVelocity().x < 0)
+        || (position.x + radius >= length && current_particle.GetVelocity().x > 0)) {
+      particles.at(i).HandleHorizontalWallCollision();
+    }
+    if ((position.y - radius <= 0 && current_particle.GetVelocity().y < 0)
+        || (position.y + radius >= height && current_particle.GetVelocity().y > 0)) {
+      particles.at(i).HandleVerticalWallCollision();
+    }
+  }
+  for (size_t i = 0; i < particles.size(); i++) {
+    particles.at(i).UpdateParticle();
+  }
+}
+
+/**
+ * Adds up the momentum of every particle
+ */
+vec2 GetTotalMomentum(const vector<Particle>& particles) {
+  vec2 momentum = vec2(0, 0);
+  for (size_t i = 0; i < particles.size(); i++) {
+    momentum += particles.at(i).GetMass() * particles.at(i).GetVelocity();
+  }
+  return momentum;
+}
+
+TEST_CASE("Test a particle hitting two others in one frame keeps momentum") {
+  //particle 0 touches both of the others, and moves towards each of them
+  vector<Particle> particles = vector<Particle>();
+  particles.push_back(Particle(vec2(10, 10), vec2(1, 0), "black", 1.0, 1.0));
+  particles.push_back(Particle(vec2(11.5, 10), vec2(-1, 0), "black", 1.0, 1.0));
+  particles.push_back(Particle(vec2(10, 11.5), vec2(0, -1), "black", 1.0, 1.0));
+  vec2 momentum = GetTotalMomentum(particles);
+
+  SECTION("The original pass drops the first pair's change to particle 0") {
+    vector<Particle> original = particles;
+    HandleAllCollisionsOriginal(original, 100, 100);
+    REQUIRE(original.at(0).GetVelocity() == vec2(1, -1));
+    REQUIRE(GetTotalMomentum(original) != momentum);
+  }
+
+  SECTION("The container resolves the second pair with particle 0's new velocity") {
+    GasContainer container = GasContainer(100, 100, 0, 0, particles);
+    container.AdvanceOneFrame();
+    vector<Particle> result = container.GetParticles();
+    HandleAllCollisionsAllPairs(particles, 100, 100);
+    REQUIRE(result.at(0).GetVelocity() == vec2(-1, -1));
+    for (size_t i = 0; i < particles.size(); i++) {
+      REQUIRE(result.at(i).GetVelocity() == particles.at(i).GetVelocity());
+    }
+    REQUIRE(GetTotalMomentum(result) == momentum);
+  }
+}
+
+TEST_CASE("Test histograms count every particle of their species") {
+  vector<pair<Species, int>> species_counts = {pair<Species, int>(Species("white", 1, 2), 300),
+                                               pair<Species, int>(Species("red", 4, 3), 200)};
+  GasContainer container = GasContainer(400, 400, 0, 0, species_counts, 5);
+  for (int frame = 0; frame < 5; frame++) {
+    container.AdvanceOneFrame();
+  }
+
+  for (size_t i = 0; i < species_counts.size(); i++) {
+    vector<pair<int, int>> distribution = container.GetHistograms().at(i).GetVelocityDistribution();
+    int total = 0;
+    for (size_t bar = 0; bar < distribution.size(); bar++) {
+      total += distribution.at(bar).second;
+    }
+    REQUIRE(total == species_counts.at(i).second);
+  }
+}
+
+TEST_CASE("Test histograms over a window of frames") {
+  vector<pair<Species, int>> species_counts = {pair<Species, int>(Species("white", 1, 2), 30),
+                                               pair<Species, int>(Species("red", 4, 3), 20)};
+  GasContainer container = GasContainer(400, 400, 0, 0, species_counts, 5);
+  for (int frame = 0; frame < 20; frame++) {
+    container.AdvanceOneFrame();
+  }
+  const idealgas::SpeedDistribution& distribution = container.GetSpeedDistribution();
+  REQUIRE(distribution.GetNumFrames() == 21);
+
+  SECTION("A moving average matches the speed distribution") {
+    container.SetHistogramWindow(10);
+    for (size_t i = 0; i < species_counts.size(); i++) {
+      vector<double> expected = distribution.GetDistribution(int(i), 10, idealgas::DistributionView::kMovingAverage);
+      //the bars keep the average's fractions instead of rounding them to whole particles
+      REQUIRE(container.GetHistograms().at(i).GetBarHeights() == expected);
+      vector<pair<int, int>> bars = container.GetHistograms().at(i).GetVelocityDistribution();
+      REQUIRE(bars.size() == expected.size());
+      for (size_t bar = 0; bar < bars.size(); bar++) {
+        REQUIRE(bars.at(bar).second == int(std::lround(expected.at(bar))));
+      }
+    }
+  }
+
+  SECTION("The last cumulative bar counts every particle") {
+    container.SetHistogramWindow(20, idealgas::DistributionView::kCumulative);
+    for (size_t i = 0; i < species_counts.size(); i++) {
+      REQUIRE(container.GetHistograms().at(i).GetVelocityDistribution().back().second == species_counts.at(i).second);
+    }
+  }
+
+  SECTION("A window of 1 frame is the current frame's speeds") {
+    container.SetHistogramWindow(10);
+    container.GetHistograms();
+    container.SetHistogramWindow(1);
+    GasContainer reference = GasContainer(400, 400, 0, 0, species_counts, 5);
+    for (int frame = 0; frame < 20; frame++) {
+      reference.AdvanceOneFrame();
+    }
+    for (size_t i = 0; i < species_counts.size(); i++) {
+      REQUIRE(container.GetHistograms().at(i).GetVelocityDistribution() ==
+              reference.GetHistograms().at(i).GetVelocityDistribution());
+    }
+  }
+
+  SECTION("A window longer than the frames simulated uses every frame") {
+    GasContainer fresh = GasContainer(400, 400, 0, 0, species_counts, 5);
+    fresh.SetHistogramWindow(100, idealgas::DistributionView::kCumulative);
+    fresh.AdvanceOneFrame();
+    REQUIRE(fresh.GetHistograms().at(0).GetVelocityDistribution().back().second == 30);
+  }
+
+  SECTION("Windows that don't fit") {
+    REQUIRE_THROWS_AS(container.SetHistogramWindow(0), std::invalid_argument);
+    REQUIRE_THROWS_AS(container.SetHistogramWindow(100000), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Test broadphase matches all-pairs collisions") {
+  srand(7);
+  vector<Particle> particles = vector<Particle>();
+  for (int i = 0; i < 400; i++) {
+    Particle particle = Particle("white", float(1 + rand() % 3), float(2 + rand() % 4));
+    particle.InitializeParticle(150, 150, 0, 0);
+    particles.push_back(particle);
+  }
+  GasContainer container = GasContainer(150, 150, 0, 0, particles);
+  for (int frame = 0; frame < 50; frame++) {
+    container.AdvanceOneFrame();
+    HandleAllCollisionsAllPairs(particles, 150, 150);
+  }
+  vector<Particle> result = container.GetParticles();
+  for (size_t i = 0; i < particles.size(); i++) {
+    REQUIRE(result.at(i).GetPosition() == particles.at(i).GetPosition());
+    REQUIRE(result.at(i).GetVelocity() == particles.at(i).GetVelocity());
+  }
+}
+
+TEST_CASE("Test cell-colored collisions give the same results on any number of threads") {
+  vector<pair<Species, int>> species_counts = vector<pair<Species, int>>();
+  species_counts.emplace_back(Species("white", 1.0, 3.0), 1500);
+  species_counts.emplace_back(Species("red", 5.0, 4.0), 500);
+  vector<Particle> particles = GasContainer(300, 300, 0, 0, species_counts, 11).GetParticles();
+
+  GasContainer reference = GasContainer(300, 300, 0, 0, particles);
+  reference.SetCollisionSchedule(idealgas::CollisionSchedule::kCellColored);
+  for (int frame = 0; frame < 30; frame++) {
+    reference.AdvanceOneFrame();
+  }
+  vector<Particle> expected = reference.GetParticles();
+
+  size_t num_threads = GENERATE(2, 3, 8);
+  GasContainer container = GasContainer(300, 300, 0, 0, particles);
+  container.SetCollisionSchedule(idealgas::CollisionSchedule::kCellColored);
+  container.SetNumThreads(num_threads);
+  REQUIRE(container.GetNumThreads() == num_threads);
+  for (int frame = 0; frame < 30; frame++) {
+    container.AdvanceOneFrame();
+  }
+  vector<Particle> result = container.GetParticles();
+  for (size_t i = 0; i < expected.size(); i++) {
+    REQUIRE(result.at(i).GetPosition() == expected.at(i).GetPosition());
+    REQUIRE(result.at(i).GetVelocity() == expected.at(i).GetVelocity());
+  }
+}
+
+TEST_CASE("Test cell-colored collisions match the sequential path") {
+  vector<Particle> particles = vector<Particle>();
+  particles.push_back(Particle(vec2(4, 2), vec2(-1, 0), "black", 1.0, 1.0));
+  particles.push_back(Particle(vec2(2, 2), vec2(1, 0), "black", 1.0, 1.0));
+  particles.push_back(Particle(vec2(52, 52), vec2(1, 0), "black", 1.0, 1.0));
+  particles.push_back(Particle(vec2(54, 52), vec2(-3, -4), "black", 1.0, 1.0));
+  particles.push_back(Particle(vec2(99, 30), vec2(1, 1), "black", 1.0, 1.0));
+  particles.push_back(Particle(vec2(30, 1), vec2(1, -1), "black", 1.0, 1.0));
+  GasContainer sequential = GasContainer(100, 100, 0, 0, particles);
+  GasContainer colored = GasContainer(100, 100, 0, 0, particles);
+  colored.SetCollisionSchedule(idealgas::CollisionSchedule::kCellColored);
+  colored.SetNumThreads(4);
+  sequential.AdvanceOneFrame();
+  colored.AdvanceOneFrame();
+  for (size_t i = 0; i < particles.size(); i++) {
+    REQUIRE(colored.GetParticles().at(i).GetPosition() == sequential.GetParticles().at(i).GetPosition());
+    REQUIRE(colored.GetParticles().at(i).GetVelocity() == sequential.GetParticles().at(i).GetVelocity());
+  }
+  REQUIRE(colored.GetParticles().at(0).GetVelocity() == vec2(1, 0));
+  REQUIRE(colored.GetParticles().at(3).GetVelocity() == vec2(1, -4));
+}
+
+TEST_CASE("Test generated particles only depend on the seed") {
+  vector<pair<Species, int>> species_counts = vector<pair<Species, int>>();
+  species_counts.emplace_back(Species("white", 1.0, 3.0), 3000);
+  species_counts.emplace_back(Species("red", 5.0, 6.0), 1000);
+  GasContainer reference = GasContainer(500, 400, 30, 20, species_counts, 42);
+  const ParticleStore& expected = reference.GetParticleStore();
+  REQUIRE(reference.GetSeed() == 42);
+
+  SECTION("Same seed on any number of threads") {
+    size_t num_threads = GENERATE(1, 2, 3, 8);
+    GasContainer container = GasContainer(500, 400, 30, 20, species_counts, 42, num_threads);
+    const ParticleStore& particles = container.GetParticleStore();
+    REQUIRE(container.GetNumThreads() == num_threads);
+    REQUIRE(particles.position[0] == expected.position[0]);
+    REQUIRE(particles.position[1] == expected.position[1]);
+    REQUIRE(particles.velocity[0] == expected.velocity[0]);
+    REQUIRE(particles.velocity[1] == expected.velocity[1]);
+    REQUIRE(particles.species == expected.species);
+  }
+
+  SECTION("Generation does not use rand()") {
+    srand(9);
+    GasContainer container = GasContainer(500, 400, 30, 20, species_counts, 42);
+    REQUIRE(container.GetParticleStore().position[0] == expected.position[0]);
+  }
+
+  SECTION("Different seeds give different particles") {
+    GasContainer container = GasContainer(500, 400, 30, 20, species_counts, 43);
+    REQUIRE(container.GetParticleStore().position[0] != expected.position[0]);
+  }
+
+  SECTION("Particles start inside the container, outside the margins") {
+    for (size_t i = 0; i < expected.Size(); i++) {
+      REQUIRE(expected.position[0][i] >= 30 + expected.radius[i]);
+      REQUIRE(expected.position[0][i] < 530 - expected.radius[i]);
+      REQUIRE(expected.position[1][i] >= 20 + expected.radius[i]);
+      REQUIRE(expected.position[1][i] < 420 - expected.radius[i]);
+      REQUIRE(std::abs(expected.velocity[0][i]) <= expected.radius[i] / 2);
+      REQUIRE(std::abs(expected.velocity[1][i]) <= expected.radius[i] / 2);
+    }
+  }
+
+  SECTION("A species that does not fit") {
+    vector<pair<Species, int>> too_big = {pair<Species, int>(Species("red", 1.0, 300.0), 1)};
+    REQUIRE_THROWS_AS(GasContainer(500, 400, 0, 0, too_big), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Test neighbour lists give the same results as the sequential schedule") {
+  vector<pair<Species, int>> species_counts = vector<pair<Species, int>>();
+  species_counts.emplace_back(Species("white", 1.0, 3.0), 1500);
+  species_counts.emplace_back(Species("red", 5.0, 5.0), 300);
+  GasContainer reference = GasContainer(300, 300, 10, 20, species_counts, 13);
+  GasContainer container = GasContainer(300, 300, 10, 20, species_counts, 13);
+  container.SetCollisionSchedule(idealgas::CollisionSchedule::kNeighbourList);
+
+  float skin = GENERATE(0.0f, 3.0f, 30.0f);
+  container.SetNeighbourSkin(skin);
+  REQUIRE(container.GetNeighbourSkin() == skin);
+  for (int frame = 0; frame < 40; frame++) {
+    reference.AdvanceOneFrame();
+    container.AdvanceOneFrame();
+  }
+  REQUIRE(container.GetParticleStore().position[0] == reference.GetParticleStore().position[0]);
+  REQUIRE(container.GetParticleStore().position[1] == reference.GetParticleStore().position[1]);
+  REQUIRE(container.GetParticleStore().velocity[0] == reference.GetParticleStore().velocity[0]);
+  REQUIRE(container.GetParticleStore().velocity[1] == reference.GetParticleStore().velocity[1]);
+
+  const idealgas::NeighbourListStats& stats = container.GetNeighbourListStats();
+  REQUIRE(stats.num_passes == 40);
+  REQUIRE(stats.num_pairs > 0);
+  if (skin == 0) {
+    REQUIRE(stats.num_rebuilds == 40);
+  } else if (skin == 30) {
+    REQUIRE(stats.num_rebuilds < 20);
+  }
+}
+
+TEST_CASE("Test neighbour lists are rebuilt when the skin changes") {
+  vector<pair<Species, int>> species_counts = {pair<Species, int>(Species("white", 1.0, 3.0), 200)};
+  GasContainer container = GasContainer(200, 200, 0, 0, species_counts, 3);
+  container.SetCollisionSchedule(idealgas::CollisionSchedule::kNeighbourList);
+  container.SetNeighbourSkin(50);
+  container.AdvanceOneFrame();
+  container.AdvanceOneFrame();
+  REQUIRE(container.GetNeighbourListStats().num_rebuilds == 1);
+
+  container.SetNeighbourSkin(40);
+  container.AdvanceOneFrame();
+  REQUIRE(container.GetNeighbourListStats().num_rebuilds == 2);
+  REQUIRE_THROWS_AS(container.SetNeighbourSkin(-1), std::invalid_argument);
+}
+
+TEST_CASE("Test observables are gathered during the frame") {
+  SECTION("A wall bounce") {
+    vector<Particle> particles = vector<Particle>();
+    particles.push_back(Particle(1, 2, -1, 1, "black", 2.0, 1.0));
+    GasContainer container = GasContainer(100, 50, 0, 0, particles);
+    container.AdvanceOneFrame();
+    const FrameObservables& frame = container.GetObservables().GetFrame(0);
+    REQUIRE(frame.frame == 1);
+    REQUIRE(frame.wall_collisions == 1);
+    REQUIRE(frame.particle_collisions == 0);
+    REQUIRE(frame.pressure_left == Approx(4.0 / 50));
+    REQUIRE(frame.pressure_right == 0);
+    REQUIRE(frame.pressure == Approx(4.0 / 300));
+    REQUIRE(frame.kinetic_energy == Approx(2));
+    REQUIRE(frame.temperature == Approx(2));
+    REQUIRE(frame.momentum_x == Approx(2));
+    REQUIRE(frame.momentum_y == Approx(2));
+  }
+
+  SECTION("A collision between particles") {
+    vector<Particle> particles = vector<Particle>();
+    particles.push_back(Particle(vec2(40, 20), vec2(-1, 0), "black", 1.0, 1.0));
+    particles.push_back(Particle(vec2(38, 20), vec2(1, 0), "black", 3.0, 1.0));
+    GasContainer container = GasContainer(100, 100, 0, 0, particles);
+    container.AdvanceOneFrame();
+    const FrameObservables& frame = container.GetObservables().GetFrame(0);
+    REQUIRE(frame.particle_collisions == 1);
+    REQUIRE(frame.wall_collisions == 0);
+    REQUIRE(frame.pressure == 0);
+  }
+
+  SECTION("Energy and momentum match the particles on every schedule") {
+    vector<pair<Species, int>> species_counts = vector<pair<Species, int>>();
+    species_counts.emplace_back(Species("white", 1.0, 3.0), 600);
+    species_counts.emplace_back(Species("red", 5.0, 4.0), 200);
+    idealgas::CollisionSchedule schedule = GENERATE(idealgas::CollisionSchedule::kSequential,
+                                                    idealgas::CollisionSchedule::kCellColored,
+                                                    idealgas::CollisionSchedule::kNeighbourList);
+    size_t num_threads = GENERATE(1, 3);
+    GasContainer container = GasContainer(200, 200, 10, 10, species_counts, 9, num_threads);
+    container.SetCollisionSchedule(schedule);
+    for (int frame = 0; frame < 10; frame++) {
+      container.AdvanceOneFrame();
+    }
+
+    INFO("schedule " << int(schedule) << ", threads " << num_threads);
+    const ParticleStore& store = container.GetParticleStore();
+    double kinetic_energy = 0;
+    double momentum_x = 0;
+    for (size_t i = 0; i < store.Size(); i++) {
+      kinetic_energy += 0.5 * store.mass[i] * (store.velocity[0][i] * store.velocity[0][i] + store.velocity[1][i] * store.velocity[1][i]);
+      momentum_x += store.mass[i] * store.velocity[0][i];
+    }
+    const FrameObservables& frame = container.GetObservables().GetFrame(0);
+    REQUIRE(container.GetObservables().Size() == 10);
+    REQUIRE(frame.frame == 10);
+    REQUIRE(frame.kinetic_energy == Approx(kinetic_energy));
+    REQUIRE(frame.temperature == Approx(kinetic_energy / 800));
+    REQUIRE(frame.momentum_x == Approx(momentum_x).margin(1e-3));
+    REQUIRE(container.GetObservables().GetAverage(10).particle_collisions > 0);
+    REQUIRE(container.GetObservables().GetAverage(10).wall_collisions > 0);
+  }
+}
+
+TEST_CASE("Test frames don't allocate once every buffer has grown") {
+  vector<pair<Species, int>> species_counts = vector<pair<Species, int>>();
+  species_counts.emplace_back(Species("white", 1.0, 3.0), 1500);
+  species_counts.emplace_back(Species("red", 5.0, 4.0), 500);
+  idealgas::CollisionSchedule schedule = GENERATE(idealgas::CollisionSchedule::kSequential,
+                                                  idealgas::CollisionSchedule::kCellColored,
+                                                  idealgas::CollisionSchedule::kNeighbourList);
+  size_t num_threads = GENERATE(1, 3);
+  idealgas::FramePipeline pipeline = GENERATE(idealgas::FramePipeline::kPhases, idealgas::FramePipeline::kTaskGraph);
+  GasContainer container = GasContainer(300, 300, 10, 10, species_counts, 5, num_threads);
+  container.SetCollisionSchedule(schedule);
+  container.SetFramePipeline(pipeline);
+  for (int frame = 0; frame < 20; frame++) {
+    container.AdvanceOneFrame();
+  }
+
+  INFO("schedule " << int(schedule) << ", threads " << num_threads << ", pipeline " << int(pipeline));
+  size_t num_allocations = GetAllocationCount();
+  for (int frame = 0; frame < 20; frame++) {
+    container.AdvanceOneFrame();
+  }
+  REQUIRE(GetAllocationCount() - num_allocations == 0);
+}
+
+TEST_CASE("Test subscribing to frames") {
+  vector<pair<Species, int>> species_counts = vector<pair<Species, int>>();
+  species_counts.emplace_back(Species("white", 1.0, 3.0), 300);
+  species_counts.emplace_back(Species("red", 5.0, 4.0), 100);
+  GasContainer container = GasContainer(300, 300, 10, 10, species_counts, 5);
+
+  SECTION("Subscribers get the parts of each frame they asked for") {
+    idealgas::SubscriptionOptions positions_options = idealgas::SubscriptionOptions();
+    positions_options.positions = true;
+    idealgas::SubscriptionOptions everything_options = idealgas::SubscriptionOptions();
+    everything_options.velocities = true;
+    everything_options.speed_counts = true;
+    everything_options.observables = true;
+    std::shared_ptr<idealgas::FrameSubscription> positions = container.Subscribe(positions_options);
+    std::shared_ptr<idealgas::FrameSubscription> everything = container.Subscribe(everything_options);
+    container.AdvanceOneFrame();
+
+    const ParticleStore& particles = container.GetParticleStore();
+    const idealgas::FrameRecord* record = positions->Peek();
+    REQUIRE(record != nullptr);
+    REQUIRE(record->frame == 1);
+    REQUIRE(record->x == particles.position[0]);
+    REQUIRE(record->y == particles.position[1]);
+    REQUIRE(record->species == particles.species);
+    REQUIRE(record->vx.empty());
+    REQUIRE(record->speed_counts.empty());
+
+    record = everything->Peek();
+    REQUIRE(record != nullptr);
+    REQUIRE(record->x.empty());
+    REQUIRE(record->vx == particles.velocity[0]);
+    REQUIRE(record->vy == particles.velocity[1]);
+    const idealgas::SpeedDistribution& distribution = container.GetSpeedDistribution();
+    REQUIRE(record->num_bins == distribution.GetNumBins());
+    REQUIRE(record->max_speed == distribution.GetMaxSpeed());
+    REQUIRE(record->speed_counts == vector<int>(distribution.GetFrameCounts(0), distribution.GetFrameCounts(0) +
+                                                2 * distribution.GetNumBins()));
+    REQUIRE(record->observables.frame == 1);
+    REQUIRE(record->observables.kinetic_energy == container.GetObservables().GetFrame(0).kinetic_energy);
+
+    REQUIRE(container.Unsubscribe(positions));
+    container.AdvanceOneFrame();
+    REQUIRE(positions->Size() == 1);
+    REQUIRE(everything->Size() == 2);
+  }
+
+  SECTION("Full subscribers drop frames without holding up the container") {
+    idealgas::SubscriptionOptions options = idealgas::SubscriptionOptions();
+    options.observables = true;
+    options.capacity = 4;
+    std::shared_ptr<idealgas::FrameSubscription> dropping = container.Subscribe(options);
+    options.overflow_policy = idealgas::OverflowPolicy::kBackpressure;
+    std::shared_ptr<idealgas::FrameSubscription> backpressuring = container.Subscribe(options);
+
+    for (int frame = 0; frame < 4; frame++) {
+      REQUIRE_FALSE(container.IsBackpressured());
+      container.AdvanceOneFrame();
+    }
+    REQUIRE(container.IsBackpressured());
+    container.AdvanceOneFrame();
+    REQUIRE(dropping->GetDroppedFrames() == 1);
+    REQUIRE(backpressuring->GetDroppedFrames() == 1);
+
+    //only the backpressure subscriber holds the container back
+    backpressuring->Pop();
+    REQUIRE_FALSE(container.IsBackpressured());
+    container.AdvanceOneFrame();
+    REQUIRE(backpressuring->GetDroppedFrames() == 1);
+    REQUIRE(dropping->GetDroppedFrames() == 2);
+  }
+
+  SECTION("Copies of the container don't publish to its subscribers") {
+    std::shared_ptr<idealgas::FrameSubscription> subscription = container.Subscribe(idealgas::SubscriptionOptions());
+    GasContainer copy = container;
+    copy.AdvanceOneFrame();
+    REQUIRE(subscription->Size() == 0);
+    container.AdvanceOneFrame();
+    REQUIRE(subscription->Size() == 1);
+  }
+
+  SECTION("Assigning another container keeps only the subscriptions the container had") {
+    std::shared_ptr<idealgas::FrameSubscription> subscription = container.Subscribe(idealgas::SubscriptionOptions());
+    GasContainer other = GasContainer(300, 300, 10, 10, species_counts, 6);
+    std::shared_ptr<idealgas::FrameSubscription> other_subscription = other.Subscribe(idealgas::SubscriptionOptions());
+    container = std::move(other);
+    container.AdvanceOneFrame();
+    REQUIRE(subscription->Size() == 1);
+    REQUIRE(other_subscription->Size() == 0);
+  }
+}
+
+TEST_CASE("Test publishing frames doesn't allocate") {
+  vector<pair<Species, int>> species_counts = vector<pair<Species, int>>();
+  species_counts.emplace_back(Species("white", 1.0, 3.0), 1500);
+  species_counts.emplace_back(Species("red", 5.0, 4.0), 500);
+  GasContainer container = GasContainer(300, 300, 10, 10, species_counts, 5);
+  for (int frame = 0; frame < 20; frame++) {
+    container.AdvanceOneFrame();
+  }
+  idealgas::SubscriptionOptions options = idealgas::SubscriptionOptions();
+  options.positions = true;
+  options.velocities = true;
+  options.speed_counts = true;
+  options.observables = true;
+  options.capacity = 8;
+  std::shared_ptr<idealgas::FrameSubscription> subscription = container.Subscribe(options);
+
+  //the slots are reserved when subscribing, and frames are written into every one of them,
+  //then dropped once the subscriber stops reading
+  size_t num_allocations = GetAllocationCount();
+  for (int frame = 0; frame < 20; frame++) {
+    container.AdvanceOneFrame();
+    if (frame < 10 && subscription->Peek() != nullptr) {
+      subscription->Pop();
+    }
+  }
+  REQUIRE(subscription->GetDroppedFrames() > 0);
+  REQUIRE(GetAllocationCount() - num_allocations == 0);
+}
+
+TEST_CASE("Test the task graph pipeline gives the same frames as the phases") {
+  vector<pair<Species, int>> species_counts = vector<pair<Species, int>>();
+  species_counts.emplace_back(Species("white", 1.0, 2.0), 7000);
+  species_counts.emplace_back(Species("red", 5.0, 3.0), 3000);
+  idealgas::CollisionSchedule schedule = GENERATE(idealgas::CollisionSchedule::kSequential,
+                                                  idealgas::CollisionSchedule::kCellColored,
+                                                  idealgas::CollisionSchedule::kNeighbourList);
+  GasContainer phases = GasContainer(600, 600, 10, 10, species_counts, 9);
+  phases.SetCollisionSchedule(schedule);
+  GasContainer graph = GasContainer(600, 600, 10, 10, species_counts, 9);
+  graph.SetCollisionSchedule(schedule);
+  graph.SetFramePipeline(idealgas::FramePipeline::kTaskGraph);
+  GasContainer threaded_graph = GasContainer(600, 600, 10, 10, species_counts, 9, 3);
+  threaded_graph.SetCollisionSchedule(schedule);
+  threaded_graph.SetFramePipeline(idealgas::FramePipeline::kTaskGraph);
+  for (int frame = 0; frame < 15; frame++) {
+    phases.AdvanceOneFrame();
+    graph.AdvanceOneFrame();
+    threaded_graph.AdvanceOneFrame();
+  }
+
+  INFO("schedule " << int(schedule));
+  const ParticleStore& expected = phases.GetParticleStore();
+  REQUIRE(graph.GetParticleStore().position[0] == expected.position[0]);
+  REQUIRE(graph.GetParticleStore().velocity[1] == expected.velocity[1]);
+  REQUIRE(threaded_graph.GetParticleStore().position[0] == expected.position[0]);
+  REQUIRE(threaded_graph.GetParticleStore().position[1] == expected.position[1]);
+  REQUIRE(threaded_graph.GetParticleStore().velocity[0] == expected.velocity[0]);
+  REQUIRE(threaded_graph.GetParticleStore().velocity[1] == expected.velocity[1]);
+
+  //the speeds left to count at the end of the last frame are counted when the distribution is read
+  const idealgas::SpeedDistribution& distribution = threaded_graph.GetSpeedDistribution();
+  REQUIRE(distribution.GetNumFrames() == phases.GetSpeedDistribution().GetNumFrames());
+  REQUIRE(distribution.GetDistribution(1, 15, idealgas::DistributionView::kMovingAverage) ==
+          phases.GetSpeedDistribution().GetDistribution(1, 15, idealgas::DistributionView::kMovingAverage));
+
+  //the task graph adds up the observables in chunk order, so any number of threads gives the same ones
+  for (size_t frames_ago = 0; frames_ago < 15; frames_ago++) {
+    const FrameObservables& frame = graph.GetObservables().GetFrame(frames_ago);
+    const FrameObservables& threaded_frame = threaded_graph.GetObservables().GetFrame(frames_ago);
+    REQUIRE(threaded_frame.kinetic_energy == frame.kinetic_energy);
+    REQUIRE(threaded_frame.pressure == frame.pressure);
+    REQUIRE(threaded_frame.particle_collisions == frame.particle_collisions);
+    REQUIRE(frame.kinetic_energy == Approx(phases.GetObservables().GetFrame(frames_ago).kinetic_energy));
+    REQUIRE(frame.wall_collisions == phases.GetObservables().GetFrame(frames_ago).wall_collisions);
+  }
+}
+
+TEST_CASE("Test laned frames") {
+  vector<pair<Species, int>> species_counts = {pair<Species, int>(Species("white", 1, 3), 30)};
+  GasContainer laned(60, 60, 5, 5, species_counts, 4);
+  GasContainer alone(60, 60, 5, 5, species_counts, 4);
+
+  SECTION("A laned frame is the same as one advanced alone") {
+    MemberLanes lanes = MemberLanes(30);
+    idealgas::SimdKernels kernels = idealgas::SimdKernels();
+    for (int frame = 0; frame < 10; frame++) {
+      laned.StartLanedFrame(lanes, 3);
+      kernels.ReflectAndIntegrateLanes(lanes);
+      laned.FinishLanedFrame(lanes, 3);
+      alone.AdvanceOneFrame();
+    }
+    REQUIRE(laned.GetParticleStore().position[0] == alone.GetParticleStore().position[0]);
+    REQUIRE(laned.GetParticleStore().velocity[1] == alone.GetParticleStore().velocity[1]);
+    REQUIRE(laned.GetObservables().GetFrame(0).kinetic_energy == alone.GetObservables().GetFrame(0).kinetic_energy);
+    REQUIRE(laned.GetObservables().GetFrame(0).pressure == alone.GetObservables().GetFrame(0).pressure);
+    REQUIRE(laned.GetObservables().Size() == 10);
+  }
+
+  SECTION("Lanes the particles don't fit in") {
+    MemberLanes small_lanes = MemberLanes(29);
+    MemberLanes lanes = MemberLanes(30);
+    REQUIRE_THROWS_AS(laned.StartLanedFrame(small_lanes, 0), std::invalid_argument);
+    REQUIRE_THROWS_AS(laned.StartLanedFrame(lanes, MemberLanes::kNumLanes), std::invalid_argument);
+  }
+}
@@ -90,3 +90,89 @@ TEST_CASE("Test FindVelocityDistribution") {
     }
   }
 }
+
+TEST_CASE("Test Reset and AddVelocity") {
+  Histogram h = Histogram(vector<float>(), 4, 1, 3);
+
+  SECTION("Velocities on a bar's top go in that bar") {
+    h.Reset(4, 1);
+    h.AddVelocity(1);
+    h.AddVelocity(2);
+    h.AddVelocity(3);
+    h.AddVelocity(4);
+    REQUIRE(h.GetVelocityDistribution() == vector<pair<int, int>>{pair<int, int>(0, 2), pair<int, int>(1, 1), pair<int, int>(2, 1)});
+  }
+
+  SECTION("Velocities below the range go in the first bar and above it aren't counted") {
+    h.Reset(4, 1);
+    h.AddVelocity(0);
+    h.AddVelocity(5);
+    REQUIRE(h.GetVelocityDistribution() == vector<pair<int, int>>{pair<int, int>(0, 1), pair<int, int>(1, 0), pair<int, int>(2, 0)});
+  }
+
+  SECTION("Reset empties the bars") {
+    h.Reset(4, 1);
+    h.AddVelocity(2);
+    h.Reset(8, 2);
+    REQUIRE(h.GetBarRange() == 2.0);
+    REQUIRE(h.GetVelocityDistribution() == vector<pair<int, int>>{pair<int, int>(0, 0), pair<int, int>(1, 0), pair<int, int>(2, 0)});
+  }
+
+  SECTION("Empty range") {
+    h.Reset(2, 2);
+    h.AddVelocity(2);
+    h.AddVelocity(3);
+    REQUIRE(h.GetVelocityDistribution() == vector<pair<int, int>>{pair<int, int>(0, 1), pair<int, int>(1, 0), pair<int, int>(2, 0)});
+  }
+
+  SECTION("AddCount adds to one bar") {
+    h.Reset(4, 1);
+    h.AddVelocity(2);
+    h.AddCount(1, 5);
+    h.AddCount(2, 3);
+    REQUIRE(h.GetVelocityDistribution() == vector<pair<int, int>>{pair<int, int>(0, 1), pair<int, int>(1, 5), pair<int, int>(2, 3)});
+    REQUIRE_THROWS_AS(h.AddCount(3, 1), std::invalid_argument);
+  }
+
+  SECTION("Fractional counts keep their heights") {
+    h.Reset(4, 1);
+    h.AddCount(0, 0.25);
+    h.AddCount(1, 0.75);
+    h.AddCount(1, 0.5);
+    REQUIRE(h.GetBarHeights() == vector<double>{0.25, 1.25, 0});
+    REQUIRE(h.GetVelocityDistribution() == vector<pair<int, int>>{pair<int, int>(0, 0), pair<int, int>(1, 1), pair<int, int>(2, 0)});
+  }
+}
+
+TEST_CASE("Test FindVelocityDistribution matches walking the sorted velocities") {
+  srand(3);
+  vector<float> velocities;
+  for (int i = 0; i < 2000; i++) {
+    velocities.push_back(float(rand() % 1000) / 37.0f);
+  }
+  float max_velocity = *std::max_element(velocities.begin(), velocities.end());
+  float min_velocity = *std::min_element(velocities.begin(), velocities.end());
+  int num_segments = 13;
+
+  //the original binning: walk the bars in order over the sorted velocities
+  vector<float> sorted = velocities;
+  std::sort(sorted.begin(), sorted.end());
+  float bar_range = (max_velocity - min_velocity) / float(num_segments);
+  vector<pair<int, int>> expected;
+  for (int i = 0; i < num_segments; i++) {
+    expected.emplace_back(i, 0);
+  }
+  int current_bar = 0;
+  for (size_t i = 0; i < sorted.size() && current_bar < num_segments;) {
+    if (sorted.at(i) <= (bar_range * float(current_bar + 1)) + min_velocity) {
+      expected.at(current_bar).second++;
+      i++;
+    } else {
+      current_bar++;
+    }
+  }
+
+  Histogram h = Histogram(velocities, max_velocity, min_velocity, num_segments);
+  h.FindVelocityDistribution();
+  REQUIRE(h.GetVelocityDistribution() == expected);
+}
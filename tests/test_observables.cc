@@ -0,0 +1,86 @@
+#include <catch2/catch.hpp>
+
+#include <observables.h>
+
+using idealgas::FrameObservables;
+using idealgas::ObservablesHistory;
+
+/**
+ * Makes a frame whose observables are all the given value
+ */
+FrameObservables MakeFrame(uint64_t frame, double value) {
+  FrameObservables observables = FrameObservables();
+  observables.frame = frame;
+  observables.num_frames = 1;
+  observables.kinetic_energy = value;
+  observables.temperature = value;
+  observables.momentum_x = value;
+  observables.momentum_y = -value;
+  observables.pressure_left = value;
+  observables.pressure_right = value;
+  observables.pressure_top = value;
+  observables.pressure_bottom = value;
+  observables.pressure = value;
+  observables.particle_collisions = value;
+  observables.wall_collisions = value;
+  return observables;
+}
+
+TEST_CASE("Test ObservablesHistory keeps the latest frames") {
+  ObservablesHistory history = ObservablesHistory(3);
+  REQUIRE(history.Size() == 0);
+  REQUIRE(history.GetCapacity() == 3);
+  REQUIRE_THROWS_AS(history.GetFrame(0), std::invalid_argument);
+
+  for (uint64_t frame = 1; frame <= 5; frame++) {
+    history.Add(MakeFrame(frame, double(frame)));
+  }
+  REQUIRE(history.Size() == 3);
+  REQUIRE(history.GetFrame(0).frame == 5);
+  REQUIRE(history.GetFrame(1).frame == 4);
+  REQUIRE(history.GetFrame(2).frame == 3);
+  REQUIRE_THROWS_AS(history.GetFrame(3), std::invalid_argument);
+
+  history.Clear();
+  REQUIRE(history.Size() == 0);
+  history.Add(MakeFrame(6, 6));
+  REQUIRE(history.GetFrame(0).frame == 6);
+  REQUIRE(history.Size() == 1);
+}
+
+TEST_CASE("Test ObservablesHistory averages") {
+  ObservablesHistory history = ObservablesHistory(4);
+  for (uint64_t frame = 1; frame <= 6; frame++) {
+    history.Add(MakeFrame(frame, double(frame)));
+  }
+
+  SECTION("Over a window of the latest frames") {
+    FrameObservables average = history.GetAverage(2);
+    REQUIRE(average.frame == 6);
+    REQUIRE(average.num_frames == 2);
+    REQUIRE(average.kinetic_energy == 5.5);
+    REQUIRE(average.momentum_y == -5.5);
+    REQUIRE(average.pressure_bottom == 5.5);
+    REQUIRE(average.wall_collisions == 5.5);
+  }
+
+  SECTION("Over every frame kept") {
+    FrameObservables average = history.GetAverage(4);
+    REQUIRE(average.num_frames == 4);
+    REQUIRE(average.temperature == 4.5);
+    REQUIRE(average.pressure == 4.5);
+  }
+
+  SECTION("A window of one frame is that frame") {
+    REQUIRE(history.GetAverage(1).particle_collisions == 6);
+  }
+
+  SECTION("Windows that don't fit the history") {
+    REQUIRE_THROWS_AS(history.GetAverage(0), std::invalid_argument);
+    REQUIRE_THROWS_AS(history.GetAverage(5), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Test ObservablesHistory needs room for a frame") {
+  REQUIRE_THROWS_AS(ObservablesHistory(0), std::invalid_argument);
+}
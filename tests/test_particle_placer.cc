@@ -0,0 +1,140 @@
+#include <catch2/catch.hpp>
+
+#include <gas_container.h>
+#include <particle_placer.h>
+
+using idealgas::GasContainer;
+using idealgas::ParticlePlacer;
+using idealgas::ParticleStore;
+using idealgas::Philox;
+using idealgas::Placement;
+using idealgas::Species;
+using std::pair;
+using std::vector;
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+/**
+ * Builds a store of particles of the given species, all at the origin
+ */
+ParticleStore MakeParticles(const vector<pair<Species, int>>& species_counts) {
+  ParticleStore store;
+  for (size_t i = 0; i < species_counts.size(); i++) {
+    int species_id = store.species_registry.Register(species_counts.at(i).first);
+    for (int j = 0; j < species_counts.at(i).second; j++) {
+      store.Add(species_id, glm::vec2(0, 0), glm::vec2(1, 0));
+    }
+  }
+  return store;
+}
+
+/**
+ * Checks that every particle is inside the walls and touches no other particle
+ */
+bool IsOverlapFree(const ParticleStore& particles, float min_x, float min_y, float width, float height) {
+  for (size_t i = 0; i < particles.Size(); i++) {
+    float radius = particles.radius[i];
+    if (particles.position[0][i] < min_x + radius || particles.position[0][i] > min_x + width - radius ||
+        particles.position[1][i] < min_y + radius || particles.position[1][i] > min_y + height - radius) {
+      return false;
+    }
+    for (size_t j = i + 1; j < particles.Size(); j++) {
+      float dx = particles.position[0][i] - particles.position[0][j];
+      float dy = particles.position[1][i] - particles.position[1][j];
+      float min_distance = radius + particles.radius[j];
+      if (dx * dx + dy * dy <= min_distance * min_distance) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Gets the fraction of a container's area covered by particles
+ */
+double GetAreaFraction(const vector<pair<Species, int>>& species_counts, float width, float height) {
+  double area = 0;
+  for (size_t i = 0; i < species_counts.size(); i++) {
+    double radius = species_counts.at(i).first.radius;
+    area += kPi * radius * radius * species_counts.at(i).second;
+  }
+  return area / (double(width) * double(height));
+}
+
+}  // namespace
+
+TEST_CASE("Test jittered lattice placement") {
+  vector<pair<Species, int>> species_counts = {pair<Species, int>(Species("white", 1, 5), 600),
+                                               pair<Species, int>(Species("blue", 3, 8), 600),
+                                               pair<Species, int>(Species("red", 5, 10), 600)};
+  ParticleStore particles = MakeParticles(species_counts);
+  ParticlePlacer placer(40, 30, 870, 870, Philox(3));
+  placer.PlaceOnJitteredLattice(particles);
+
+  SECTION("Particles don't overlap at a dense area fraction") {
+    REQUIRE(GetAreaFraction(species_counts, 870, 870) > 0.45);
+    REQUIRE(IsOverlapFree(particles, 40, 30, 870, 870));
+  }
+
+  SECTION("Velocities are kept") {
+    REQUIRE(particles.velocity[0][17] == 1);
+    REQUIRE(particles.velocity[1][17] == 0);
+  }
+
+  SECTION("The same seed gives the same placement") {
+    ParticleStore again = MakeParticles(species_counts);
+    placer.Place(Placement::kJitteredLattice, again);
+    REQUIRE(again.position[0] == particles.position[0]);
+    REQUIRE(again.position[1] == particles.position[1]);
+  }
+
+  SECTION("Too many particles for the lattice") {
+    ParticleStore too_many = MakeParticles({pair<Species, int>(Species("red", 5, 10), 2000)});
+    REQUIRE_THROWS_AS(placer.PlaceOnJitteredLattice(too_many), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Test Poisson disk placement") {
+  vector<pair<Species, int>> species_counts = {pair<Species, int>(Species("white", 1, 2), 2500),
+                                               pair<Species, int>(Species("blue", 3, 5), 500),
+                                               pair<Species, int>(Species("red", 5, 9), 100)};
+  ParticleStore particles = MakeParticles(species_counts);
+  ParticlePlacer placer(0, 0, 500, 400, Philox(8));
+  placer.PlacePoissonDisk(particles);
+
+  SECTION("Particles don't overlap at a dense area fraction") {
+    REQUIRE(GetAreaFraction(species_counts, 500, 400) > 0.45);
+    REQUIRE(IsOverlapFree(particles, 0, 0, 500, 400));
+  }
+
+  SECTION("The same seed gives the same placement") {
+    ParticleStore again = MakeParticles(species_counts);
+    placer.Place(Placement::kPoissonDisk, again);
+    REQUIRE(again.position[0] == particles.position[0]);
+    REQUIRE(again.position[1] == particles.position[1]);
+  }
+
+  SECTION("Too many particles for the container") {
+    ParticleStore too_many = MakeParticles({pair<Species, int>(Species("red", 5, 9), 800)});
+    REQUIRE_THROWS_AS(placer.PlacePoissonDisk(too_many), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Test kRandom placement keeps the particles where they are") {
+  ParticleStore particles = MakeParticles({pair<Species, int>(Species("white", 1, 2), 10)});
+  ParticlePlacer(0, 0, 100, 100, Philox(1)).Place(Placement::kRandom, particles);
+  REQUIRE(particles.position[0] == vector<float>(10, 0));
+}
+
+TEST_CASE("Test placement from the GasContainer constructor") {
+  vector<pair<Species, int>> species_counts = {pair<Species, int>(Species("white", 1, 4), 350),
+                                               pair<Species, int>(Species("red", 5, 5), 250)};
+  Placement placement = GENERATE(Placement::kJitteredLattice, Placement::kPoissonDisk);
+  GasContainer container(300, 280, 25, 10, species_counts, 12, 1, placement);
+  REQUIRE(GetAreaFraction(species_counts, 300, 280) > 0.4);
+  REQUIRE(IsOverlapFree(container.GetParticleStore(), 25, 10, 300, 280));
+  REQUIRE(container.GetVelocitiesOfSpecies(1).size() == 250);
+}
@@ -0,0 +1,106 @@
+#include <catch2/catch.hpp>
+
+#include <particle_store.h>
+
+using idealgas::BasicParticleStore;
+using idealgas::Particle;
+using idealgas::ParticleStore;
+using glm::dvec3;
+using glm::vec2;
+using std::string;
+using std::vector;
+
+TEST_CASE("Test Add") {
+  ParticleStore store = ParticleStore();
+  store.Add(Particle(vec2(1, 2), vec2(3, 4), "blue", 5.0, 6.0));
+  REQUIRE(store.Size() == 1);
+  REQUIRE(store.position[0].at(0) == 1);
+  REQUIRE(store.position[1].at(0) == 2);
+  REQUIRE(store.velocity[0].at(0) == 3);
+  REQUIRE(store.velocity[1].at(0) == 4);
+  REQUIRE(store.mass.at(0) == 5);
+  REQUIRE(store.radius.at(0) == 6);
+  REQUIRE(store.species.at(0) == 0);
+}
+
+TEST_CASE("Test species ids") {
+  vector<Particle> particles = vector<Particle>();
+  particles.push_back(Particle(vec2(1, 1), vec2(1, 1), "blue", 1.0, 1.0));
+  particles.push_back(Particle(vec2(1, 1), vec2(1, 1), "red", 1.0, 1.0));
+  particles.push_back(Particle(vec2(1, 1), vec2(1, 1), "blue", 1.0, 1.0));
+  ParticleStore store = ParticleStore(particles);
+
+  SECTION("Species are interned") {
+    REQUIRE(store.species == vector<int>{0, 1, 0});
+    REQUIRE(store.species_registry.Size() == 2);
+    REQUIRE(store.species_registry.GetSpecies(1).name == "red");
+  }
+
+  SECTION("Adding by species id") {
+    store.Add(1, vec2(2, 3), vec2(4, 5));
+    REQUIRE(store.species.back() == 1);
+    REQUIRE(store.GetParticle(3).GetColor() == "red");
+  }
+}
+
+TEST_CASE("Test GetParticle") {
+  ParticleStore store = ParticleStore();
+  store.Add(Particle(vec2(1, 2), vec2(3, 4), "blue", 5.0, 6.0));
+  Particle particle = store.GetParticle(0);
+  REQUIRE(particle.GetPosition() == vec2(1, 2));
+  REQUIRE(particle.GetVelocity() == vec2(3, 4));
+  REQUIRE(particle.GetColor() == "blue");
+  REQUIRE(particle.GetMass() == 5);
+  REQUIRE(particle.GetRadius() == 6);
+}
+
+TEST_CASE("Test a 3D store") {
+  BasicParticleStore<3, double> store = BasicParticleStore<3, double>();
+  int species_id = store.species_registry.Register("blue", 5.0, 6.0);
+  store.Add(species_id, dvec3(1, 2, 3), dvec3(4, 5, 6));
+
+  SECTION("Each axis has its own array") {
+    REQUIRE(store.Size() == 1);
+    REQUIRE(store.position[2].at(0) == 3);
+    REQUIRE(store.velocity[2].at(0) == 6);
+    REQUIRE(store.mass.at(0) == 5);
+    REQUIRE(store.radius.at(0) == 6);
+  }
+
+  SECTION("Set and SetVelocity") {
+    store.Resize(2);
+    store.Set(1, species_id, dvec3(7, 8, 9), dvec3(0, 0, 0));
+    store.SetVelocity(0, dvec3(-1, -2, -3));
+    REQUIRE(store.GetPosition(1) == dvec3(7, 8, 9));
+    REQUIRE(store.GetVelocity(0) == dvec3(-1, -2, -3));
+  }
+}
+
+TEST_CASE("Test GetRandomState") {
+  SECTION("Inside the box, at least a radius from the walls") {
+    idealgas::Philox rng = idealgas::Philox(7);
+    for (uint64_t i = 0; i < 1000; i++) {
+      dvec3 position;
+      dvec3 velocity;
+      BasicParticleStore<3, double>::GetRandomState(rng, i, 4, dvec3(10, 20, 30), dvec3(50, 60, 70), position,
+                                                    velocity);
+      REQUIRE(position.x >= 14);
+      REQUIRE(position.x <= 56);
+      REQUIRE(position.y >= 24);
+      REQUIRE(position.z <= 96);
+      REQUIRE(std::abs(velocity.z) <= 2);
+    }
+  }
+
+  SECTION("2D matches Particle::GetRandomState") {
+    std::array<uint32_t, 4> words = {{123456789u, 987654321u, 55555u, 77777u}};
+    vec2 position;
+    vec2 velocity;
+    ParticleStore::GetRandomState(words.data(), 3, vec2(10, 0), vec2(100, 80), position, velocity);
+    vec2 particle_position;
+    vec2 particle_velocity;
+    Particle::GetRandomState(words, 3, 100, 80, 10, 0, particle_position, particle_velocity);
+    REQUIRE(particle_position == position);
+    REQUIRE(particle_velocity == velocity);
+  }
+}
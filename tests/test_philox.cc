@@ -0,0 +1,53 @@
+#include <catch2/catch.hpp>
+
+#include <philox.h>
+
+using idealgas::Philox;
+using std::array;
+
+TEST_CASE("Test Philox matches the published test vectors") {
+  SECTION("Zero counter and key") {
+    array<uint32_t, 4> counter = {{0, 0, 0, 0}};
+    array<uint32_t, 2> key = {{0, 0}};
+    array<uint32_t, 4> expected = {{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}};
+    REQUIRE(Philox::Generate(counter, key) == expected);
+  }
+
+  SECTION("All ones counter and key") {
+    array<uint32_t, 4> counter = {{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}};
+    array<uint32_t, 2> key = {{0xffffffff, 0xffffffff}};
+    array<uint32_t, 4> expected = {{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}};
+    REQUIRE(Philox::Generate(counter, key) == expected);
+  }
+
+  SECTION("Digits of pi") {
+    array<uint32_t, 4> counter = {{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}};
+    array<uint32_t, 2> key = {{0xa4093822, 0x299f31d0}};
+    array<uint32_t, 4> expected = {{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}};
+    REQUIRE(Philox::Generate(counter, key) == expected);
+  }
+}
+
+TEST_CASE("Test GetBlock") {
+  Philox rng = Philox(0x299f31d0a4093822ULL);
+
+  SECTION("The seed is the key") {
+    array<uint32_t, 4> counter = {{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}};
+    REQUIRE(rng.GetBlock(0x85a308d3243f6a88ULL, 0x0370734413198a2eULL) ==
+            Philox::Generate(counter, {{0xa4093822, 0x299f31d0}}));
+    REQUIRE(rng.GetSeed() == 0x299f31d0a4093822ULL);
+  }
+
+  SECTION("Blocks only depend on the seed and counter") {
+    REQUIRE(rng.GetBlock(7) == Philox(0x299f31d0a4093822ULL).GetBlock(7));
+    REQUIRE(rng.GetBlock(7) != rng.GetBlock(8));
+    REQUIRE(rng.GetBlock(7) != rng.GetBlock(7, 1));
+    REQUIRE(rng.GetBlock(7) != Philox(1).GetBlock(7));
+  }
+}
+
+TEST_CASE("Test ToUnitFloat") {
+  REQUIRE(Philox::ToUnitFloat(0) == 0.0f);
+  REQUIRE(Philox::ToUnitFloat(0x80000000) == 0.5f);
+  REQUIRE(Philox::ToUnitFloat(0xffffffff) < 1.0f);
+}
@@ -0,0 +1,133 @@
+#include <catch2/catch.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <gas_container.h>
+#include <profiler.h>
+#include <sstream>
+#include <thread>
+
+using idealgas::GasContainer;
+using idealgas::PhaseStats;
+using idealgas::Profiler;
+using idealgas::ScopedTimer;
+using idealgas::Species;
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace {
+
+/**
+ * Finds the statistics of one phase, or returns ones with a count of 0
+ */
+PhaseStats FindPhase(const string& name) {
+  vector<PhaseStats> stats = Profiler::GetInstance().GetStats();
+  for (size_t i = 0; i < stats.size(); i++) {
+    if (stats.at(i).name == name) {
+      return stats.at(i);
+    }
+  }
+  PhaseStats missing = PhaseStats();
+  missing.count = 0;
+  return missing;
+}
+
+}  // namespace
+
+TEST_CASE("Test profiler statistics") {
+  Profiler& profiler = Profiler::GetInstance();
+  profiler.Clear();
+
+  SECTION("Percentiles of known durations") {
+    for (int64_t ms = 1; ms <= 100; ms++) {
+      profiler.Record("test known durations", 1000000 * ms, 2000000 * ms);
+    }
+    PhaseStats stats = FindPhase("test known durations");
+    REQUIRE(stats.count == 100);
+    REQUIRE(stats.p50_ms == Approx(50));
+    REQUIRE(stats.p99_ms == Approx(99));
+    REQUIRE(stats.max_ms == Approx(100));
+    REQUIRE(stats.mean_ms == Approx(50.5));
+  }
+
+  SECTION("A scoped timer records once when it goes out of scope") {
+    {
+      ScopedTimer timer("test scoped timer");
+      REQUIRE(FindPhase("test scoped timer").count == 0);
+    }
+    REQUIRE(FindPhase("test scoped timer").count == 1);
+    REQUIRE(FindPhase("test scoped timer").p50_ms >= 0);
+  }
+
+  SECTION("Every thread's timings are counted") {
+    vector<std::thread> threads;
+    for (int thread = 0; thread < 4; thread++) {
+      threads.emplace_back([]() {
+        for (int i = 0; i < 250; i++) {
+          ScopedTimer timer("test threads");
+        }
+      });
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+      threads.at(i).join();
+    }
+    REQUIRE(FindPhase("test threads").count == 1000);
+  }
+
+  SECTION("Each thread only keeps its most recent timings") {
+    std::thread thread([&profiler]() {
+      for (size_t i = 0; i < Profiler::kEventsPerThread + 10; i++) {
+        profiler.Record("test wrap around", 0, int64_t(i));
+      }
+    });
+    thread.join();
+    PhaseStats stats = FindPhase("test wrap around");
+    REQUIRE(stats.count == Profiler::kEventsPerThread);
+    REQUIRE(stats.max_ms == Approx(double(Profiler::kEventsPerThread + 9) / 1e6));
+  }
+
+  SECTION("Clear empties the buffers") {
+    profiler.Record("test clear", 0, 1);
+    profiler.Clear();
+    REQUIRE(FindPhase("test clear").count == 0);
+  }
+}
+
+TEST_CASE("Test Chrome trace export") {
+  Profiler& profiler = Profiler::GetInstance();
+  profiler.Clear();
+  profiler.Record("test \"quoted\"", 1500, 4000);
+  string path = "test_profiler_trace.json";
+  profiler.WriteChromeTrace(path);
+
+  std::ifstream file(path.c_str());
+  std::stringstream contents;
+  contents << file.rdbuf();
+  file.close();
+  std::remove(path.c_str());
+  REQUIRE(contents.str().find("{\"traceEvents\":[") == 0);
+  REQUIRE(contents.str().find("{\"name\":\"test \\\"quoted\\\"\",\"ph\":\"X\",\"ts\":1.500,\"dur\":2.500,") !=
+          string::npos);
+  REQUIRE_THROWS_AS(profiler.WriteChromeTrace("no_such_directory/trace.json"), std::runtime_error);
+}
+
+TEST_CASE("Test frames are profiled only when profiling is compiled in") {
+  vector<pair<Species, int>> species_counts = vector<pair<Species, int>>();
+  species_counts.emplace_back(Species("white", 1.0, 3.0), 200);
+  GasContainer container = GasContainer(200, 200, 0, 0, species_counts, 5);
+  Profiler::GetInstance().Clear();
+  for (int frame = 0; frame < 10; frame++) {
+    container.AdvanceOneFrame();
+  }
+
+#ifdef IDEALGAS_PROFILING
+  size_t expected_count = 10;
+#else
+  size_t expected_count = 0;
+#endif
+  REQUIRE(FindPhase("AdvanceOneFrame").count == expected_count);
+  REQUIRE(FindPhase("HandleAllCollisions").count == expected_count);
+  REQUIRE(FindPhase("Integrate").count == expected_count);
+  REQUIRE(FindPhase("UpdateHistograms").count == expected_count);
+}
@@ -0,0 +1,231 @@
+#include <catch2/catch.hpp>
+
+#include <simd_kernels.h>
+#include <algorithm>
+
+using idealgas::MemberLanes;
+using idealgas::Particle;
+using idealgas::ParticleStore;
+using idealgas::SimdKernels;
+using idealgas::SimdLevel;
+using idealgas::WallBounds;
+using idealgas::WallImpulses;
+using idealgas::WallPassTotals;
+using glm::vec2;
+using std::vector;
+
+/**
+ * Makes a crowded store with particles poking past the walls of a 100 x 100 box
+ */
+ParticleStore MakeRandomStore(size_t num_particles) {
+  srand(3);
+  ParticleStore store = ParticleStore();
+  for (size_t i = 0; i < num_particles; i++) {
+    float radius = float(1 + rand() % 3);
+    vec2 position = vec2(float(rand() % 10400) / 100 - 2, float(rand() % 10400) / 100 - 2);
+    vec2 velocity = vec2(float(rand() % 600) / 100 - 3, float(rand() % 600) / 100 - 3);
+    store.Add(Particle(position, velocity, radius > 2 ? "red" : "white", radius, radius));
+  }
+  return store;
+}
+
+TEST_CASE("Test every SIMD level matches scalar") {
+  SimdLevel level = GENERATE(SimdLevel::kSse2, SimdLevel::kAvx2);
+  SimdKernels scalar = SimdKernels(SimdLevel::kScalar);
+  SimdKernels vectorised = SimdKernels(level);
+  ParticleStore expected = MakeRandomStore(1003);
+  ParticleStore result = MakeRandomStore(1003);
+
+  SECTION("Integrate") {
+    scalar.Integrate(expected, 1, 1003);
+    vectorised.Integrate(result, 1, 1003);
+    REQUIRE(result.position[0] == expected.position[0]);
+    REQUIRE(result.position[1] == expected.position[1]);
+  }
+
+  SECTION("ReflectWalls") {
+    WallBounds walls = {0, 100, 0, 100};
+    vector<float> expected_speeds = vector<float>(1003);
+    vector<float> speeds = vector<float>(1003);
+    WallImpulses expected_impulses = WallImpulses();
+    WallImpulses impulses = WallImpulses();
+    scalar.ReflectWalls(expected, 0, 1003, walls, expected_speeds.data(), expected_impulses);
+    vectorised.ReflectWalls(result, 0, 1003, walls, speeds.data(), impulses);
+    REQUIRE(result.velocity[0] == expected.velocity[0]);
+    REQUIRE(result.velocity[1] == expected.velocity[1]);
+    REQUIRE(speeds == expected_speeds);
+    REQUIRE(expected_impulses.num_bounces > 10);
+    REQUIRE(impulses.num_bounces == expected_impulses.num_bounces);
+    REQUIRE(impulses.left == expected_impulses.left);
+    REQUIRE(impulses.right == expected_impulses.right);
+    REQUIRE(impulses.top == expected_impulses.top);
+    REQUIRE(impulses.bottom == expected_impulses.bottom);
+  }
+
+  SECTION("FindCollidingPairs and ResolveCollidingPairs") {
+    vector<uint32_t> first;
+    vector<uint32_t> second;
+    for (uint32_t i = 0; i < 1003; i++) {
+      for (uint32_t j = i + 1; j < 1003; j++) {
+        first.push_back(i);
+        second.push_back(j);
+      }
+    }
+    vector<uint32_t> expected_first;
+    vector<uint32_t> expected_second;
+    vector<uint32_t> colliding_first;
+    vector<uint32_t> colliding_second;
+    scalar.FindCollidingPairs(expected, first, second, first.size(), expected_first, expected_second);
+    vectorised.FindCollidingPairs(result, first, second, first.size(), colliding_first, colliding_second);
+    REQUIRE(expected_first.size() > 100);
+    REQUIRE(colliding_first == expected_first);
+    REQUIRE(colliding_second == expected_second);
+
+    size_t expected_bounced = scalar.ResolveCollidingPairs(expected, expected_first, expected_second,
+                                                           expected_first.size());
+    size_t bounced = vectorised.ResolveCollidingPairs(result, colliding_first, colliding_second,
+                                                      colliding_first.size());
+    REQUIRE(expected_bounced > 0);
+    REQUIRE(bounced == expected_bounced);
+    REQUIRE(result.velocity[0] == expected.velocity[0]);
+    REQUIRE(result.velocity[1] == expected.velocity[1]);
+  }
+}
+
+TEST_CASE("Test ResolveCollidingPairs") {
+  SimdKernels kernels = SimdKernels();
+
+  SECTION("Pairs sharing a particle see each other's result") {
+    ParticleStore store = ParticleStore();
+    store.Add(Particle(vec2(4, 2), vec2(-1, 0), "black", 1.0, 1.0));
+    store.Add(Particle(vec2(2, 2), vec2(1, 1), "black", 1.0, 1.0));
+    store.Add(Particle(vec2(2, 4), vec2(0, -1), "black", 1.0, 1.0));
+    kernels.ResolveCollidingPairs(store, vector<uint32_t>{0, 1}, vector<uint32_t>{1, 2}, 2);
+    REQUIRE(store.GetParticle(0).GetVelocity() == vec2(1, 0));
+    REQUIRE(store.GetParticle(1).GetVelocity() == vec2(-1, -1));
+    REQUIRE(store.GetParticle(2).GetVelocity() == vec2(0, 1));
+  }
+
+  SECTION("Particles moving apart don't bounce") {
+    ParticleStore store = ParticleStore();
+    store.Add(Particle(vec2(0, 0), vec2(1, 0), "black", 1.0, 1.0));
+    store.Add(Particle(vec2(1, 0), vec2(1, 0), "black", 1.0, 1.0));
+    store.Add(Particle(vec2(10, 0), vec2(1, 0), "black", 1.0, 1.0));
+    store.Add(Particle(vec2(11, 0), vec2(-1, 0), "black", 1.0, 1.0));
+    REQUIRE(kernels.ResolveCollidingPairs(store, vector<uint32_t>{0, 2}, vector<uint32_t>{1, 3}, 2) == 1);
+    REQUIRE(store.GetParticle(0).GetVelocity() == vec2(1, 0));
+    REQUIRE(store.GetParticle(1).GetVelocity() == vec2(1, 0));
+    REQUIRE(store.GetParticle(2).GetVelocity() == vec2(-1, 0));
+    REQUIRE(store.GetParticle(3).GetVelocity() == vec2(1, 0));
+  }
+}
+
+TEST_CASE("Test ReflectWalls impulses") {
+  SimdLevel level = GENERATE(SimdLevel::kScalar, SimdLevel::kSse2, SimdLevel::kAvx2);
+  SimdKernels kernels = SimdKernels(level);
+  WallBounds walls = {0, 100, 0, 100};
+  vector<float> speeds = vector<float>(8);
+  WallImpulses impulses = WallImpulses();
+
+  //particles in the middle first, so the ones at the walls fill a whole vector of every level
+  ParticleStore store = ParticleStore();
+  for (int i = 0; i < 4; i++) {
+    store.Add(Particle(vec2(50, 50), vec2(1, 1), "black", 1.0, 1.0));
+  }
+
+  SECTION("Each wall takes twice the momentum into it") {
+    store.Add(Particle(vec2(1, 50), vec2(-2, 0), "black", 3.0, 1.0));
+    store.Add(Particle(vec2(99, 50), vec2(3, 1), "black", 1.0, 1.0));
+    store.Add(Particle(vec2(50, 1), vec2(1, -4), "black", 2.0, 1.0));
+    store.Add(Particle(vec2(50, 99), vec2(0, 5), "black", 1.0, 1.0));
+    kernels.ReflectWalls(store, 0, 8, walls, speeds.data(), impulses);
+    REQUIRE(impulses.left == 12);
+    REQUIRE(impulses.right == 6);
+    REQUIRE(impulses.top == 16);
+    REQUIRE(impulses.bottom == 10);
+    REQUIRE(impulses.num_bounces == 4);
+  }
+
+  SECTION("Particles moving away from a wall they touch give it nothing") {
+    store.Add(Particle(vec2(1, 50), vec2(2, 0), "black", 1.0, 1.0));
+    store.Add(Particle(vec2(99, 99), vec2(-1, -1), "black", 1.0, 1.0));
+    store.Add(Particle(vec2(50, 50), vec2(-1, 1), "black", 1.0, 1.0));
+    store.Add(Particle(vec2(1, 1), vec2(-1, -1), "black", 1.0, 1.0));
+    kernels.ReflectWalls(store, 0, 8, walls, speeds.data(), impulses);
+    REQUIRE(impulses.left == 2);
+    REQUIRE(impulses.right == 0);
+    REQUIRE(impulses.top == 2);
+    REQUIRE(impulses.bottom == 0);
+    REQUIRE(impulses.num_bounces == 2);
+  }
+}
+
+TEST_CASE("Test ReflectAndIntegrateLanes matches each container on its own") {
+  SimdLevel level = GENERATE(SimdLevel::kScalar, SimdLevel::kAvx2);
+  SimdKernels kernels = SimdKernels(level);
+  SimdKernels scalar = SimdKernels(SimdLevel::kScalar);
+
+  //containers of different sizes and walls, with the last lanes left empty
+  vector<size_t> sizes = {37, 61, 8, 0, 50};
+  vector<ParticleStore> stores;
+  MemberLanes lanes = MemberLanes(61);
+  for (size_t lane = 0; lane < sizes.size(); lane++) {
+    stores.push_back(MakeRandomStore(sizes[lane]));
+    lanes.sizes[lane] = int(sizes[lane]);
+    lanes.left[lane] = float(lane);
+    lanes.right[lane] = float(100 - lane);
+    lanes.top[lane] = float(2 * lane);
+    lanes.bottom[lane] = 100;
+    for (size_t k = 0; k < sizes[lane]; k++) {
+      size_t i = k * MemberLanes::kNumLanes + lane;
+      lanes.x[i] = stores.back().position[0][k];
+      lanes.y[i] = stores.back().position[1][k];
+      lanes.vx[i] = stores.back().velocity[0][k];
+      lanes.vy[i] = stores.back().velocity[1][k];
+      lanes.mass[i] = stores.back().mass[k];
+      lanes.radius[i] = stores.back().radius[k];
+    }
+  }
+  kernels.ReflectAndIntegrateLanes(lanes);
+
+  for (size_t lane = 0; lane < sizes.size(); lane++) {
+    ParticleStore& expected = stores[lane];
+    WallBounds walls = {lanes.left[lane], lanes.right[lane], lanes.top[lane], lanes.bottom[lane]};
+    vector<float> speeds = vector<float>(sizes[lane]);
+    WallImpulses impulses = WallImpulses();
+    scalar.ReflectWalls(expected, 0, sizes[lane], walls, speeds.data(), impulses);
+    scalar.Integrate(expected, 0, sizes[lane]);
+    double twice_kinetic_energy = 0;
+    for (size_t k = 0; k < sizes[lane]; k++) {
+      double mass = expected.mass[k];
+      double vx = expected.velocity[0][k];
+      double vy = expected.velocity[1][k];
+      twice_kinetic_energy += mass * (vx * vx + vy * vy);
+    }
+
+    bool all_match = true;
+    for (size_t k = 0; k < sizes[lane]; k++) {
+      size_t i = k * MemberLanes::kNumLanes + lane;
+      all_match = all_match && lanes.x[i] == expected.position[0][k] && lanes.y[i] == expected.position[1][k] &&
+                  lanes.vx[i] == expected.velocity[0][k] && lanes.vy[i] == expected.velocity[1][k] && lanes.speeds[i] == speeds[k];
+    }
+    INFO("lane " << lane);
+    REQUIRE(all_match);
+    const WallPassTotals& totals = lanes.totals[lane];
+    REQUIRE(totals.wall_impulses.num_bounces == impulses.num_bounces);
+    REQUIRE(totals.wall_impulses.left == impulses.left);
+    REQUIRE(totals.wall_impulses.right == impulses.right);
+    REQUIRE(totals.wall_impulses.top == impulses.top);
+    REQUIRE(totals.wall_impulses.bottom == impulses.bottom);
+    REQUIRE(totals.kinetic_energy == twice_kinetic_energy / 2);
+    if (sizes[lane] > 0) {
+      REQUIRE(totals.min_speed == *std::min_element(speeds.begin(), speeds.end()));
+      REQUIRE(totals.max_speed == *std::max_element(speeds.begin(), speeds.end()));
+    }
+  }
+
+  //the empty slots stay empty
+  REQUIRE(lanes.x[60 * MemberLanes::kNumLanes] == 0);
+  REQUIRE(lanes.speeds[60 * MemberLanes::kNumLanes + 7] == 0);
+  REQUIRE(lanes.totals[3].wall_impulses.num_bounces == 0);
+}
@@ -0,0 +1,87 @@
+#include <catch2/catch.hpp>
+
+#include <simulation_snapshot.h>
+
+using idealgas::EventDrivenContainer;
+using idealgas::DistributionView;
+using idealgas::GasContainer;
+using idealgas::Histogram;
+using idealgas::Particle;
+using idealgas::SimulationSnapshot;
+using idealgas::Species;
+using glm::vec2;
+using std::pair;
+using std::vector;
+
+TEST_CASE("Test Capture") {
+  vector<Particle> particles = {Particle(vec2(10, 20), vec2(1, 0), "white", 1, 2),
+                                Particle(vec2(50, 60), vec2(0, 1), "red", 5, 3)};
+
+  SECTION("From a GasContainer") {
+    GasContainer container = GasContainer(100, 120, 7, 9, particles);
+    SimulationSnapshot snapshot;
+    snapshot.Capture(container);
+    REQUIRE(snapshot.x == vector<float>{10, 50});
+    REQUIRE(snapshot.y == vector<float>{20, 60});
+    REQUIRE(snapshot.radius == vector<float>{2, 3});
+    REQUIRE(snapshot.species == vector<int>{0, 1});
+    REQUIRE(snapshot.species_registry.GetSpecies(1).name == "red");
+    REQUIRE(snapshot.speed_distribution.GetNumFrames() == 1);
+    REQUIRE(snapshot.length == 100);
+    REQUIRE(snapshot.height == 120);
+    REQUIRE(snapshot.margins_left == 7);
+    REQUIRE(snapshot.margins_top == 9);
+  }
+
+  SECTION("From an EventDrivenContainer") {
+    EventDrivenContainer container = EventDrivenContainer(100, 120, 0, 0, particles);
+    container.AdvanceOneFrame();
+    SimulationSnapshot snapshot;
+    snapshot.Capture(container);
+    REQUIRE(snapshot.x == vector<float>{11, 50});
+    REQUIRE(snapshot.y == vector<float>{20, 61});
+
+    //it builds its own histograms, so they are copied as they are
+    vector<Histogram> histograms;
+    snapshot.BuildHistograms(histograms);
+    REQUIRE(histograms.size() == 2);
+    REQUIRE(histograms.at(1).GetVelocityDistribution() == container.GetHistograms().at(1).GetVelocityDistribution());
+  }
+
+  SECTION("Capturing again replaces the old state") {
+    SimulationSnapshot snapshot;
+    snapshot.Capture(GasContainer(100, 120, 0, 0, particles));
+    snapshot.Capture(GasContainer(100, 120, 0, 0, vector<Particle>(1, particles.at(1))));
+    REQUIRE(snapshot.x == vector<float>{50});
+    REQUIRE(snapshot.species == vector<int>{0});
+  }
+}
+
+TEST_CASE("Test BuildHistograms") {
+  vector<pair<Species, int>> species_counts = {pair<Species, int>(Species("white", 1, 2), 60),
+                                               pair<Species, int>(Species("red", 4, 3), 40)};
+  GasContainer container = GasContainer(300, 200, 50, 0, species_counts, 3);
+  for (int frame = 0; frame < 8; frame++) {
+    container.AdvanceOneFrame();
+  }
+  size_t window = GENERATE(1, 5);
+  container.SetHistogramWindow(window, DistributionView::kCumulative);
+  SimulationSnapshot snapshot;
+  snapshot.Capture(container);
+
+  vector<Histogram> histograms;
+  snapshot.BuildHistograms(histograms);
+  REQUIRE(histograms.size() == 2);
+  for (size_t i = 0; i < histograms.size(); i++) {
+    INFO("window " << window << ", species " << i);
+    REQUIRE(histograms.at(i).GetColor() == container.GetHistograms().at(i).GetColor());
+    REQUIRE(histograms.at(i).GetLength() == container.GetHistograms().at(i).GetLength());
+    REQUIRE(histograms.at(i).GetHeight() == container.GetHistograms().at(i).GetHeight());
+    REQUIRE(histograms.at(i).GetBarHeights() ==
+            container.GetSpeedDistribution().GetDistribution(int(i), window, DistributionView::kCumulative));
+  }
+
+  //building again reuses the histograms, with the same result
+  snapshot.BuildHistograms(histograms);
+  REQUIRE(histograms.at(0).GetBarHeights().back() == 60);
+}
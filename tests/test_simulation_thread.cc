@@ -0,0 +1,85 @@
+#include <catch2/catch.hpp>
+
+#include <simulation_thread.h>
+
+using idealgas::GasContainer;
+using idealgas::Particle;
+using idealgas::SimulationSnapshot;
+using idealgas::SimulationThread;
+using idealgas::Species;
+using std::pair;
+using std::vector;
+
+namespace {
+
+/**
+ * Reads snapshots until one is at least the given frame, or a few seconds pass
+ */
+const SimulationSnapshot& WaitForFrame(SimulationThread& simulation, size_t frame) {
+  for (int i = 0; i < 5000 && simulation.GetLatestSnapshot().frame < frame; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return simulation.GetLatestSnapshot();
+}
+
+}  // namespace
+
+TEST_CASE("Test SimulationThread") {
+  vector<pair<Species, int>> species_counts = {pair<Species, int>(Species("white", 1, 3), 200),
+                                               pair<Species, int>(Species("red", 4, 5), 100)};
+  GasContainer container = GasContainer(300, 300, 0, 0, species_counts, 2);
+
+  SECTION("Snapshots match the container after the same number of frames") {
+    SimulationThread simulation(container, 0);
+    WaitForFrame(simulation, 10);
+    simulation.SetPaused(true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const SimulationSnapshot& snapshot = simulation.GetLatestSnapshot();
+    REQUIRE(snapshot.frame >= 10);
+
+    for (size_t frame = 0; frame < snapshot.frame; frame++) {
+      container.AdvanceOneFrame();
+    }
+    REQUIRE(snapshot.x == container.GetParticleStore().position[0]);
+    REQUIRE(snapshot.y == container.GetParticleStore().position[1]);
+    REQUIRE(snapshot.species == container.GetParticleStore().species);
+  }
+
+  SECTION("Every snapshot is a whole frame") {
+    SimulationThread simulation(container, 0);
+    size_t last_frame = 0;
+    for (int i = 0; i < 200; i++) {
+      const SimulationSnapshot& snapshot = simulation.GetLatestSnapshot();
+      REQUIRE(snapshot.x.size() == 300);
+      REQUIRE(snapshot.y.size() == 300);
+      REQUIRE(snapshot.species.size() == 300);
+      REQUIRE(snapshot.speed_distribution.GetNumSpecies() == 2);
+      REQUIRE(snapshot.frame >= last_frame);
+      last_frame = snapshot.frame;
+    }
+  }
+
+  SECTION("Pausing stops new frames") {
+    SimulationThread simulation(container, 0);
+    WaitForFrame(simulation, 1);
+    simulation.SetPaused(true);
+    REQUIRE(simulation.GetPaused());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    size_t paused_frame = simulation.GetLatestSnapshot().frame;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    REQUIRE(simulation.GetLatestSnapshot().frame == paused_frame);
+
+    simulation.SetPaused(false);
+    REQUIRE(WaitForFrame(simulation, paused_frame + 1).frame > paused_frame);
+  }
+
+  SECTION("Frames are limited to the frame rate") {
+    SimulationThread simulation(container, 100);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    REQUIRE(simulation.GetLatestSnapshot().frame <= 15);
+  }
+
+  SECTION("Negative frame rate") {
+    REQUIRE_THROWS_AS(SimulationThread(container, -1), std::invalid_argument);
+  }
+}
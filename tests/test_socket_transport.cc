@@ -0,0 +1,76 @@
+#include <catch2/catch.hpp>
+
+#include <socket_transport.h>
+#include <stdexcept>
+#include <thread>
+
+using idealgas::SocketTransport;
+using std::vector;
+
+TEST_CASE("Test socket transport exchanges") {
+  SECTION("Every rank gets the message each other rank sent it") {
+    vector<std::shared_ptr<SocketTransport>> group = SocketTransport::CreateGroup(3);
+    REQUIRE(group.at(1)->GetRank() == 1);
+    REQUIRE(group.at(1)->GetNumRanks() == 3);
+
+    vector<vector<vector<uint8_t>>> received(3);
+    vector<std::thread> threads;
+    for (int rank = 0; rank < 3; rank++) {
+      threads.emplace_back([&group, &received, rank]() {
+        vector<int> ranks;
+        vector<vector<uint8_t>> outgoing;
+        for (int other = 0; other < 3; other++) {
+          if (other != rank) {
+            ranks.push_back(other);
+            outgoing.push_back(vector<uint8_t>{uint8_t(rank), uint8_t(other)});
+          }
+        }
+        group.at(size_t(rank))->Exchange(ranks, outgoing, received.at(size_t(rank)));
+      });
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+      threads.at(i).join();
+    }
+
+    REQUIRE(received.at(0) == vector<vector<uint8_t>>{{1, 0}, {2, 0}});
+    REQUIRE(received.at(1) == vector<vector<uint8_t>>{{0, 1}, {2, 1}});
+    REQUIRE(received.at(2) == vector<vector<uint8_t>>{{0, 2}, {1, 2}});
+  }
+
+  SECTION("Messages bigger than the socket buffers don't deadlock") {
+    vector<std::shared_ptr<SocketTransport>> group = SocketTransport::CreateGroup(2);
+    vector<uint8_t> big_message(4 << 20);
+    for (size_t i = 0; i < big_message.size(); i++) {
+      big_message.at(i) = uint8_t(i * 7);
+    }
+
+    vector<vector<uint8_t>> received_by_first;
+    std::thread other([&group, &big_message]() {
+      vector<vector<uint8_t>> received;
+      group.at(1)->Exchange(vector<int>{0}, vector<vector<uint8_t>>{big_message}, received);
+    });
+    group.at(0)->Exchange(vector<int>{1}, vector<vector<uint8_t>>{big_message}, received_by_first);
+    other.join();
+    REQUIRE(received_by_first.at(0) == big_message);
+  }
+
+  SECTION("Empty messages") {
+    vector<std::shared_ptr<SocketTransport>> group = SocketTransport::CreateGroup(2);
+    vector<vector<uint8_t>> received_by_second;
+    std::thread other([&group, &received_by_second]() {
+      group.at(1)->Exchange(vector<int>{0}, vector<vector<uint8_t>>{vector<uint8_t>{5}}, received_by_second);
+    });
+    vector<vector<uint8_t>> received_by_first;
+    group.at(0)->Exchange(vector<int>{1}, vector<vector<uint8_t>>{vector<uint8_t>()}, received_by_first);
+    other.join();
+    REQUIRE(received_by_first == vector<vector<uint8_t>>{{5}});
+    REQUIRE(received_by_second == vector<vector<uint8_t>>{vector<uint8_t>()});
+  }
+
+  SECTION("Exchanging with itself throws") {
+    vector<std::shared_ptr<SocketTransport>> group = SocketTransport::CreateGroup(2);
+    vector<vector<uint8_t>> received;
+    REQUIRE_THROWS_AS(group.at(0)->Exchange(vector<int>{0}, vector<vector<uint8_t>>(1), received),
+                      std::invalid_argument);
+  }
+}
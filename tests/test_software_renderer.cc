@@ -0,0 +1,119 @@
+#include <catch2/catch.hpp>
+
+#include <software_renderer.h>
+#include <cstdio>
+#include <fstream>
+
+using idealgas::GasContainer;
+using idealgas::Particle;
+using idealgas::Rgba;
+using idealgas::SimulationSnapshot;
+using idealgas::SoftwareRenderer;
+using idealgas::Species;
+using glm::vec2;
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace {
+
+bool IsColor(const Rgba& pixel, uint8_t r, uint8_t g, uint8_t b) {
+  return pixel.r == r && pixel.g == g && pixel.b == b && pixel.a == 255;
+}
+
+}  // namespace
+
+TEST_CASE("Test Render") {
+  //a 100 x 100 container with no margins, drawn at 2 pixels per unit
+  vector<Particle> particles = {Particle(vec2(25, 25), vec2(0, 0), "red", 1, 5),
+                                Particle(vec2(70, 60), vec2(0, 0), "blue", 1, 3)};
+  SimulationSnapshot snapshot;
+  snapshot.Capture(GasContainer(100, 100, 0, 0, particles));
+  snapshot.speed_distribution.Clear();
+  snapshot.histograms.clear();
+  SoftwareRenderer renderer(200, 200);
+  renderer.Render(snapshot);
+
+  SECTION("Particles are filled circles in their species' color") {
+    REQUIRE(IsColor(renderer.GetPixel(50, 50), 255, 0, 0));
+    REQUIRE(IsColor(renderer.GetPixel(50 + 9, 50), 255, 0, 0));
+    REQUIRE(IsColor(renderer.GetPixel(50 + 11, 50), 0, 0, 0));
+    REQUIRE(IsColor(renderer.GetPixel(140, 120), 0, 0, 255));
+    REQUIRE(IsColor(renderer.GetPixel(140, 120 + 7), 0, 0, 0));
+  }
+
+  SECTION("The walls are drawn") {
+    REQUIRE(IsColor(renderer.GetPixel(0, 100), 255, 255, 255));
+    REQUIRE(IsColor(renderer.GetPixel(100, 199), 255, 255, 255));
+    REQUIRE(IsColor(renderer.GetPixel(100, 100), 0, 0, 0));
+  }
+
+  SECTION("Particles smaller than a pixel still show up") {
+    snapshot.radius.at(1) = .01f;
+    renderer.Render(snapshot);
+    REQUIRE(IsColor(renderer.GetPixel(140, 120), 0, 0, 255));
+    REQUIRE(IsColor(renderer.GetPixel(141, 121), 0, 0, 0));
+  }
+
+  SECTION("Pixels outside the image") {
+    REQUIRE_THROWS_AS(renderer.GetPixel(200, 0), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Test parallel tiles match one thread") {
+  vector<pair<Species, int>> species_counts = {pair<Species, int>(Species("white", 1, 3), 500),
+                                               pair<Species, int>(Species("red", 4, 6), 200)};
+  GasContainer container = GasContainer(400, 300, 150, 30, species_counts, 4);
+  container.AdvanceOneFrame();
+  SimulationSnapshot snapshot;
+  snapshot.Capture(container);
+
+  SoftwareRenderer single(333, 250);
+  single.Render(snapshot);
+  SoftwareRenderer parallel(333, 250, 4);
+  parallel.Render(snapshot);
+  REQUIRE(single.GetPixels() == parallel.GetPixels());
+}
+
+TEST_CASE("Test writing images") {
+  SoftwareRenderer renderer(3, 2);
+  SimulationSnapshot snapshot;
+  renderer.Render(snapshot);
+
+  SECTION("PPM") {
+    string path = "test_software_renderer.ppm";
+    renderer.WriteImage(path);
+    std::ifstream file(path.c_str(), std::ios::binary);
+    string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::remove(path.c_str());
+    REQUIRE(contents.substr(0, 11) == "P6\n3 2\n255\n");
+    REQUIRE(contents.size() == 11 + 3 * 2 * 3);
+  }
+
+  SECTION("PNG") {
+    string path = "test_software_renderer.png";
+    renderer.WriteImage(path);
+    std::ifstream file(path.c_str(), std::ios::binary);
+    string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::remove(path.c_str());
+    REQUIRE(contents.substr(1, 3) == "PNG");
+    REQUIRE(contents.substr(12, 4) == "IHDR");
+    //signature, IHDR, IDAT holding 2 rows of 13 bytes in one stored block, IEND
+    REQUIRE(contents.size() == 8 + 25 + (12 + 2 + 5 + 26 + 4) + 12);
+  }
+
+  SECTION("Unknown extension") {
+    REQUIRE_THROWS_AS(renderer.WriteImage("frame.bmp"), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Test GetFramePath") {
+  REQUIRE(SoftwareRenderer::GetFramePath("frames/run.png", 42) == "frames/run_000042.png");
+  REQUIRE(SoftwareRenderer::GetFramePath("run", 7) == "run_000007");
+  REQUIRE(SoftwareRenderer::GetFramePath("out.d/run", 1) == "out.d/run_000001");
+}
+
+TEST_CASE("Test GetNamedColor") {
+  REQUIRE(IsColor(SoftwareRenderer::GetNamedColor("blue"), 0, 0, 255));
+  REQUIRE(IsColor(SoftwareRenderer::GetNamedColor("unknown"), 255, 255, 255));
+}
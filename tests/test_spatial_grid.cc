@@ -0,0 +1,202 @@
+#include <catch2/catch.hpp>
+
+#include <spatial_grid.h>
+#include <cmath>
+
+using idealgas::BasicParticleStore;
+using idealgas::BasicSpatialGrid;
+using idealgas::Particle;
+using idealgas::ParticleStore;
+using idealgas::SpatialGrid;
+using glm::dvec3;
+using glm::vec2;
+using std::vector;
+
+TEST_CASE("Test Rebuild") {
+  SECTION("Cells sized from largest radius") {
+    vector<Particle> particles = vector<Particle>();
+    particles.push_back(Particle(vec2(10, 10), vec2(0, 0), "white", 1.0, 2.0));
+    particles.push_back(Particle(vec2(50, 50), vec2(0, 0), "red", 1.0, 5.0));
+    SpatialGrid grid = SpatialGrid();
+    grid.Rebuild(ParticleStore(particles), vec2(0, 0), vec2(100, 100));
+    REQUIRE(grid.GetCellSize() == 10);
+    REQUIRE(grid.GetNumCells(0) == 10);
+    REQUIRE(grid.GetNumCells(1) == 10);
+  }
+
+  SECTION("A margin widens the cells") {
+    vector<Particle> particles = vector<Particle>();
+    particles.push_back(Particle(vec2(50, 50), vec2(0, 0), "red", 1.0, 5.0));
+    SpatialGrid grid = SpatialGrid();
+    grid.Rebuild(ParticleStore(particles), vec2(0, 0), vec2(100, 100), 10);
+    REQUIRE(grid.GetCellSize() == 20);
+    REQUIRE(grid.GetNumCells(0) == 5);
+  }
+
+  SECTION("Tiny radii don't make a huge grid") {
+    vector<Particle> particles = vector<Particle>();
+    particles.push_back(Particle(vec2(10, 10), vec2(0, 0), "white", 1.0, 0.001f));
+    SpatialGrid grid = SpatialGrid();
+    grid.Rebuild(ParticleStore(particles), vec2(0, 0), vec2(100, 100));
+    REQUIRE(grid.GetCellSize() > 1);
+    REQUIRE(grid.GetNumCells(0) * grid.GetNumCells(1) <= 1024);
+  }
+}
+
+TEST_CASE("Test FindCandidates") {
+  vector<Particle> particles = vector<Particle>();
+  particles.push_back(Particle(vec2(5, 5), vec2(0, 0), "white", 1.0, 1.0));
+  particles.push_back(Particle(vec2(50, 50), vec2(0, 0), "white", 1.0, 1.0));
+  particles.push_back(Particle(vec2(6, 5), vec2(0, 0), "white", 1.0, 1.0));
+  particles.push_back(Particle(vec2(4, 6), vec2(0, 0), "white", 1.0, 1.0));
+  SpatialGrid grid = SpatialGrid();
+  grid.Rebuild(ParticleStore(particles), vec2(0, 0), vec2(100, 100));
+  vector<size_t> candidates;
+
+  SECTION("Only nearby particles with a higher index, in order") {
+    grid.FindCandidates(0, candidates);
+    REQUIRE(candidates == vector<size_t>{2, 3});
+  }
+
+  SECTION("Lower indices are skipped") {
+    grid.FindCandidates(3, candidates);
+    REQUIRE(candidates.empty());
+  }
+
+  SECTION("Particles outside the walls go in the edge cells") {
+    particles.push_back(Particle(vec2(-0.5f, 5), vec2(0, 0), "white", 1.0, 1.0));
+    grid.Rebuild(ParticleStore(particles), vec2(0, 0), vec2(100, 100));
+    grid.FindCandidates(0, candidates);
+    REQUIRE(candidates == vector<size_t>{2, 3, 4});
+  }
+
+  SECTION("Every colliding pair is a candidate") {
+    srand(1);
+    vector<Particle> random_particles = vector<Particle>();
+    for (int i = 0; i < 500; i++) {
+      Particle particle = Particle("white", 1.0, float(1 + rand() % 4));
+      particle.InitializeParticle(100, 100, 0, 0);
+      random_particles.push_back(particle);
+    }
+    grid.Rebuild(ParticleStore(random_particles), vec2(0, 0), vec2(100, 100));
+    for (size_t i = 0; i < random_particles.size(); i++) {
+      grid.FindCandidates(i, candidates);
+      for (size_t j = i + 1; j < random_particles.size(); j++) {
+        if (random_particles.at(i).HasCollided(random_particles.at(j))) {
+          REQUIRE(std::binary_search(candidates.begin(), candidates.end(), j));
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("Test FindTouchingPairs") {
+  SECTION("Touching pairs, ascending by index") {
+    vector<Particle> particles = vector<Particle>();
+    particles.push_back(Particle(vec2(50, 50), vec2(0, 0), "white", 1.0, 1.0));
+    particles.push_back(Particle(vec2(6, 5), vec2(0, 0), "white", 1.0, 1.0));
+    particles.push_back(Particle(vec2(51, 51), vec2(0, 0), "white", 1.0, 1.0));
+    particles.push_back(Particle(vec2(5, 5), vec2(0, 0), "white", 1.0, 1.0));
+    particles.push_back(Particle(vec2(30, 30), vec2(0, 0), "white", 1.0, 1.0));
+    SpatialGrid grid = SpatialGrid();
+    grid.Rebuild(ParticleStore(particles), vec2(0, 0), vec2(100, 100));
+    vector<uint32_t> first;
+    vector<uint32_t> second;
+    grid.FindTouchingPairs(first, second);
+    REQUIRE(first == vector<uint32_t>{0, 1});
+    REQUIRE(second == vector<uint32_t>{2, 3});
+  }
+
+  SECTION("The same pairs as the candidates that touch") {
+    srand(2);
+    vector<Particle> particles = vector<Particle>();
+    for (int i = 0; i < 2000; i++) {
+      Particle particle = Particle("white", 1.0, float(1 + rand() % 4));
+      particle.InitializeParticle(300, 200, 0, 0);
+      particles.push_back(particle);
+    }
+    ParticleStore store = ParticleStore(particles);
+    SpatialGrid grid = SpatialGrid();
+    grid.Rebuild(store, vec2(0, 0), vec2(300, 200));
+    vector<uint32_t> expected_first;
+    vector<uint32_t> expected_second;
+    vector<size_t> candidates;
+    for (size_t i = 0; i < store.Size(); i++) {
+      grid.FindCandidates(i, candidates);
+      for (size_t k = 0; k < candidates.size(); k++) {
+        size_t j = candidates[k];
+        float dx = store.position[0][j] - store.position[0][i];
+        float dy = store.position[1][j] - store.position[1][i];
+        if (std::sqrt(dx * dx + dy * dy) <= store.radius[i] + store.radius[j]) {
+          expected_first.push_back(uint32_t(i));
+          expected_second.push_back(uint32_t(j));
+        }
+      }
+    }
+
+    vector<uint32_t> first;
+    vector<uint32_t> second;
+    grid.FindTouchingPairs(first, second);
+    REQUIRE(first.size() > 100);
+    REQUIRE(first == expected_first);
+    REQUIRE(second == expected_second);
+  }
+}
+
+TEST_CASE("Test the 3D grid") {
+  //random spheres in a 60 x 40 x 50 box, checked against every pair
+  BasicParticleStore<3, double> store = BasicParticleStore<3, double>();
+  int small_species = store.species_registry.Register("white", 1.0, 1.0);
+  int large_species = store.species_registry.Register("red", 2.0, 3.0);
+  srand(3);
+  for (int i = 0; i < 1500; i++) {
+    dvec3 position = dvec3(rand() % 600 / 10.0, rand() % 400 / 10.0, rand() % 500 / 10.0);
+    store.Add(i % 5 == 0 ? large_species : small_species, position, dvec3(0, 0, 0));
+  }
+  BasicSpatialGrid<3, double> grid = BasicSpatialGrid<3, double>();
+  grid.Rebuild(store, dvec3(0, 0, 0), dvec3(60, 40, 50));
+
+  SECTION("Cells sized from largest radius") {
+    REQUIRE(grid.GetCellSize() == 6);
+    REQUIRE(grid.GetNumCells(0) == 10);
+    REQUIRE(grid.GetNumCells(1) == 7);
+    REQUIRE(grid.GetNumCells(2) == 9);
+  }
+
+  SECTION("Every touching pair is found, ascending by index") {
+    vector<uint32_t> expected_first;
+    vector<uint32_t> expected_second;
+    for (size_t i = 0; i < store.Size(); i++) {
+      for (size_t j = i + 1; j < store.Size(); j++) {
+        double dx = store.position[0][j] - store.position[0][i];
+        double dy = store.position[1][j] - store.position[1][i];
+        double dz = store.position[2][j] - store.position[2][i];
+        if (std::sqrt(dx * dx + dy * dy + dz * dz) <= store.radius[i] + store.radius[j]) {
+          expected_first.push_back(uint32_t(i));
+          expected_second.push_back(uint32_t(j));
+        }
+      }
+    }
+
+    vector<uint32_t> first;
+    vector<uint32_t> second;
+    grid.FindTouchingPairs(first, second);
+    REQUIRE(first.size() > 100);
+    REQUIRE(first == expected_first);
+    REQUIRE(second == expected_second);
+  }
+
+  SECTION("Every touching pair is a candidate") {
+    vector<size_t> candidates;
+    for (size_t i = 0; i < store.Size(); i++) {
+      grid.FindCandidates(i, candidates);
+      REQUIRE(std::is_sorted(candidates.begin(), candidates.end()));
+      for (size_t j = i + 1; j < store.Size(); j++) {
+        dvec3 offset = store.GetPosition(j) - store.GetPosition(i);
+        if (glm::length(offset) <= store.radius[i] + store.radius[j]) {
+          REQUIRE(std::binary_search(candidates.begin(), candidates.end(), j));
+        }
+      }
+    }
+  }
+}
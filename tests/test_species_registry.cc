@@ -0,0 +1,47 @@
+#include <catch2/catch.hpp>
+
+#include <species_registry.h>
+
+using idealgas::Species;
+using idealgas::SpeciesRegistry;
+
+TEST_CASE("Test Register") {
+  SpeciesRegistry registry = SpeciesRegistry();
+  int white = registry.Register("white", 1.0, 5.0);
+  int blue = registry.Register(Species("blue", 3.0, 8.0));
+
+  SECTION("Ids are assigned in order") {
+    REQUIRE(white == 0);
+    REQUIRE(blue == 1);
+    REQUIRE(registry.Size() == 2);
+  }
+
+  SECTION("Registering the same species again") {
+    REQUIRE(registry.Register("white", 1.0, 5.0) == white);
+    REQUIRE(registry.Size() == 2);
+  }
+
+  SECTION("Same name with a different radius is a new species") {
+    REQUIRE(registry.Register("white", 1.0, 2.0) == 2);
+    REQUIRE(registry.FindSpecies("white") == white);
+  }
+
+  SECTION("Unknown name") {
+    REQUIRE(registry.FindSpecies("red") == -1);
+  }
+}
+
+TEST_CASE("Test GetCollisionCoefficient") {
+  SpeciesRegistry registry = SpeciesRegistry();
+  int light = registry.Register("white", 1.0, 5.0);
+  int heavy = registry.Register("red", 3.0, 5.0);
+
+  SECTION("Same species") {
+    REQUIRE(registry.GetCollisionCoefficient(light, light) == 1.0);
+  }
+
+  SECTION("Different species") {
+    REQUIRE(registry.GetCollisionCoefficient(light, heavy) == 1.5);
+    REQUIRE(registry.GetCollisionCoefficient(heavy, light) == 0.5);
+  }
+}
@@ -0,0 +1,77 @@
+#include <catch2/catch.hpp>
+
+#include <speed_distribution.h>
+#include <cmath>
+
+using idealgas::DistributionView;
+using idealgas::SpeedDistribution;
+using std::vector;
+
+TEST_CASE("Test SpeedDistribution counts speeds into fixed bins") {
+  SpeedDistribution distribution = SpeedDistribution(2, 4, 8, 3);
+  vector<int> species = {0, 0, 0, 1, 1, 0};
+  vector<float> speeds = {0, 1.9f, 2, 7.9f, 8, 100};
+  distribution.AddFrame(species, speeds);
+  REQUIRE(distribution.GetNumFrames() == 1);
+
+  SECTION("Each speed goes in the bin it falls in, and speeds past the top go in the last bin") {
+    REQUIRE(distribution.GetDistribution(0, 1, DistributionView::kMovingAverage) == vector<double>{2, 1, 0, 1});
+    REQUIRE(distribution.GetDistribution(1, 1, DistributionView::kMovingAverage) == vector<double>{0, 0, 0, 2});
+  }
+
+  SECTION("NaN speeds go in the last bin") {
+    distribution.AddFrame(vector<int>{1}, vector<float>{std::nanf("")});
+    REQUIRE(distribution.GetDistribution(1, 1, DistributionView::kMovingAverage) == vector<double>{0, 0, 0, 1});
+  }
+
+  SECTION("Cumulative counts add up every slower bin") {
+    REQUIRE(distribution.GetDistribution(0, 1, DistributionView::kCumulative) == vector<double>{2, 3, 3, 4});
+  }
+
+  SECTION("A frame's raw counts are by species then bin") {
+    REQUIRE(distribution.GetNumSpecies() == 2);
+    const int* counts = distribution.GetFrameCounts(0);
+    REQUIRE(vector<int>(counts, counts + 8) == vector<int>{2, 1, 0, 1, 0, 0, 0, 2});
+    REQUIRE_THROWS_AS(distribution.GetFrameCounts(1), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Test SpeedDistribution combines the latest frames") {
+  SpeedDistribution distribution = SpeedDistribution(1, 2, 2, 3);
+  for (int frame = 0; frame < 5; frame++) {
+    //frame k puts k speeds in the first bin and one in the second
+    vector<float> speeds = vector<float>(size_t(frame), 0.5f);
+    speeds.push_back(1.5f);
+    distribution.AddFrame(vector<int>(speeds.size(), 0), speeds);
+  }
+  REQUIRE(distribution.GetNumFrames() == 3);
+
+  SECTION("Moving average over a window") {
+    REQUIRE(distribution.GetDistribution(0, 1, DistributionView::kMovingAverage) == vector<double>{4, 1});
+    REQUIRE(distribution.GetDistribution(0, 2, DistributionView::kMovingAverage) == vector<double>{3.5, 1});
+    REQUIRE(distribution.GetDistribution(0, 3, DistributionView::kMovingAverage) == vector<double>{3, 1});
+  }
+
+  SECTION("Cumulative over a window") {
+    REQUIRE(distribution.GetDistribution(0, 2, DistributionView::kCumulative) == vector<double>{3.5, 4.5});
+  }
+
+  SECTION("Windows that don't fit") {
+    REQUIRE_THROWS_AS(distribution.GetDistribution(0, 0, DistributionView::kMovingAverage), std::invalid_argument);
+    REQUIRE_THROWS_AS(distribution.GetDistribution(0, 4, DistributionView::kMovingAverage), std::invalid_argument);
+    REQUIRE_THROWS_AS(distribution.GetDistribution(1, 1, DistributionView::kMovingAverage), std::invalid_argument);
+  }
+
+  SECTION("Clear drops every frame") {
+    distribution.Clear();
+    REQUIRE(distribution.GetNumFrames() == 0);
+    distribution.AddFrame(vector<int>{0}, vector<float>{0});
+    REQUIRE(distribution.GetDistribution(0, 1, DistributionView::kMovingAverage) == vector<double>{1, 0});
+  }
+}
+
+TEST_CASE("Test SpeedDistribution rejects bad parameters") {
+  REQUIRE_THROWS_AS(SpeedDistribution(1, 0, 1, 1), std::invalid_argument);
+  REQUIRE_THROWS_AS(SpeedDistribution(1, 1, 0, 1), std::invalid_argument);
+  REQUIRE_THROWS_AS(SpeedDistribution(1, 1, 1, 0), std::invalid_argument);
+}
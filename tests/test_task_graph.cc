@@ -0,0 +1,40 @@
+#include <catch2/catch.hpp>
+
+#include <task_graph.h>
+
+using idealgas::TaskGraph;
+using std::vector;
+
+TEST_CASE("Test TaskGraph") {
+  TaskGraph graph = TaskGraph();
+  size_t first = graph.AddTask();
+  size_t second = graph.AddTask();
+  size_t third = graph.AddTask();
+  REQUIRE(graph.Size() == 3);
+  REQUIRE(first == 0);
+  REQUIRE(third == 2);
+
+  SECTION("Dependencies are kept as successors") {
+    graph.AddDependency(first, second);
+    graph.AddDependency(first, third);
+    graph.AddDependency(second, third);
+    REQUIRE(graph.GetSuccessors(first) == vector<size_t>{1, 2});
+    REQUIRE(graph.GetSuccessors(third).empty());
+    REQUIRE(graph.GetNumDependencies(first) == 0);
+    REQUIRE(graph.GetNumDependencies(third) == 2);
+  }
+
+  SECTION("Tasks can only depend on tasks added before them") {
+    REQUIRE_THROWS_AS(graph.AddDependency(second, first), std::invalid_argument);
+    REQUIRE_THROWS_AS(graph.AddDependency(second, second), std::invalid_argument);
+    REQUIRE_THROWS_AS(graph.AddDependency(first, 3), std::invalid_argument);
+  }
+
+  SECTION("Clearing removes every task") {
+    graph.AddDependency(first, second);
+    graph.Clear();
+    REQUIRE(graph.Size() == 0);
+    REQUIRE(graph.AddTask() == 0);
+    REQUIRE(graph.GetNumDependencies(0) == 0);
+  }
+}
@@ -0,0 +1,171 @@
+#include <catch2/catch.hpp>
+
+#include <thread_pool.h>
+#include <stdexcept>
+
+using idealgas::TaskGraph;
+using idealgas::ThreadPool;
+using std::vector;
+
+TEST_CASE("Test ParallelFor") {
+  SECTION("Every index is visited once") {
+    ThreadPool pool(4);
+    vector<int> visits = vector<int>(1000, 0);
+    pool.ParallelFor(visits.size(), [&visits](size_t begin, size_t end, size_t) {
+      for (size_t i = begin; i < end; i++) {
+        visits.at(i)++;
+      }
+    });
+    REQUIRE(visits == vector<int>(1000, 1));
+  }
+
+  SECTION("Thread indices are in range") {
+    ThreadPool pool(3);
+    std::atomic<size_t> max_index(0);
+    pool.ParallelFor(300, [&max_index](size_t, size_t, size_t thread_index) {
+      size_t current = max_index.load();
+      while (thread_index > current && !max_index.compare_exchange_weak(current, thread_index)) {
+      }
+    });
+    REQUIRE(pool.GetNumThreads() == 3);
+    REQUIRE(max_index.load() < 3);
+  }
+
+  SECTION("Nested loops run on the calling thread") {
+    ThreadPool pool(4);
+    vector<int> visits = vector<int>(100, 0);
+    pool.ParallelFor(10, [&](size_t begin, size_t end, size_t) {
+      for (size_t i = begin; i < end; i++) {
+        pool.ParallelFor(10, [&](size_t inner_begin, size_t inner_end, size_t) {
+          for (size_t j = inner_begin; j < inner_end; j++) {
+            visits.at(i * 10 + j)++;
+          }
+        });
+      }
+    });
+    REQUIRE(visits == vector<int>(100, 1));
+  }
+
+  SECTION("One thread") {
+    ThreadPool pool(1);
+    size_t total = 0;
+    pool.ParallelFor(10, [&total](size_t begin, size_t end, size_t) {
+      total += end - begin;
+    });
+    REQUIRE(total == 10);
+  }
+}
+
+/**
+ * Builds a graph of layers of tasks, where each task waits for two tasks of the layer before it
+ * @param num_layers
+ * @param layer_size
+ */
+TaskGraph MakeLayeredGraph(size_t num_layers, size_t layer_size) {
+  TaskGraph graph = TaskGraph();
+  for (size_t layer = 0; layer < num_layers; layer++) {
+    for (size_t k = 0; k < layer_size; k++) {
+      size_t task = graph.AddTask();
+      if (layer > 0) {
+        size_t previous_layer = task - k - layer_size;
+        graph.AddDependency(previous_layer + k, task);
+        graph.AddDependency(previous_layer + (k + 1) % layer_size, task);
+      }
+    }
+  }
+  return graph;
+}
+
+TEST_CASE("Test RunGraph") {
+  TaskGraph graph = MakeLayeredGraph(20, 16);
+  size_t num_threads = GENERATE(1, 2, 4);
+  ThreadPool pool(num_threads);
+
+  //each task records when it finished, and checks that every task it waits for finished before it started
+  vector<std::atomic<int>> finished(graph.Size());
+  std::atomic<int> next_order(1);
+  std::atomic<bool> in_order(true);
+  std::atomic<size_t> max_index(0);
+  vector<vector<size_t>> dependencies = vector<vector<size_t>>(graph.Size());
+  for (size_t task = 0; task < graph.Size(); task++) {
+    for (size_t k = 0; k < graph.GetSuccessors(task).size(); k++) {
+      dependencies.at(graph.GetSuccessors(task).at(k)).push_back(task);
+    }
+  }
+  for (int run = 0; run < 3; run++) {
+    for (size_t task = 0; task < finished.size(); task++) {
+      finished[task].store(0);
+    }
+    pool.RunGraph(graph, [&](size_t task, size_t thread_index) {
+      for (size_t k = 0; k < dependencies.at(task).size(); k++) {
+        if (finished[dependencies.at(task).at(k)].load() == 0) {
+          in_order.store(false);
+        }
+      }
+      size_t current = max_index.load();
+      while (thread_index > current && !max_index.compare_exchange_weak(current, thread_index)) {
+      }
+      finished[task].store(next_order.fetch_add(1));
+    });
+  }
+
+  INFO("threads " << num_threads);
+  REQUIRE(in_order.load());
+  REQUIRE(max_index.load() < num_threads);
+  bool all_finished = true;
+  for (size_t task = 0; task < finished.size(); task++) {
+    all_finished = all_finished && finished[task].load() > 0;
+  }
+  REQUIRE(all_finished);
+  REQUIRE(size_t(next_order.load()) == 3 * graph.Size() + 1);
+}
+
+TEST_CASE("Test RunGraph runs nested graphs in order on the calling thread") {
+  ThreadPool pool(4);
+  TaskGraph graph = MakeLayeredGraph(3, 4);
+  vector<vector<size_t>> orders = vector<vector<size_t>>(10);
+  pool.ParallelFor(10, [&](size_t begin, size_t end, size_t) {
+    for (size_t i = begin; i < end; i++) {
+      pool.RunGraph(graph, [&orders, i](size_t task, size_t thread_index) {
+        orders.at(i).push_back(task + thread_index);
+      });
+    }
+  });
+
+  vector<size_t> expected = vector<size_t>();
+  for (size_t task = 0; task < graph.Size(); task++) {
+    expected.push_back(task);
+  }
+  REQUIRE(orders == vector<vector<size_t>>(10, expected));
+}
+
+TEST_CASE("Test ThreadPool rethrows a task's exception once every thread is done") {
+  size_t num_threads = GENERATE(1, 2, 4);
+  ThreadPool pool(num_threads);
+  INFO("threads " << num_threads);
+
+  SECTION("From a loop") {
+    REQUIRE_THROWS_AS(pool.ParallelFor(1000, [](size_t begin, size_t end, size_t) {
+      if (begin <= 500 && 500 < end) {
+        throw std::runtime_error("chunk failed");
+      }
+    }), std::runtime_error);
+  }
+
+  SECTION("From a graph") {
+    TaskGraph graph = MakeLayeredGraph(10, 8);
+    REQUIRE_THROWS_AS(pool.RunGraph(graph, [](size_t task, size_t) {
+      if (task == 12) {
+        throw std::runtime_error("task failed");
+      }
+    }), std::runtime_error);
+  }
+
+  //the pool is left ready for the next graph
+  TaskGraph graph = MakeLayeredGraph(10, 8);
+  std::atomic<size_t> num_run(0);
+  pool.RunGraph(graph, [&num_run](size_t, size_t) {
+    num_run.fetch_add(1);
+  });
+  REQUIRE(num_run.load() == graph.Size());
+}
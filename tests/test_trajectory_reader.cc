@@ -0,0 +1,88 @@
+#include <catch2/catch.hpp>
+
+#include <gas_container.h>
+#include <trajectory_reader.h>
+#include <trajectory_writer.h>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+using idealgas::GasContainer;
+using idealgas::Species;
+using idealgas::TrajectoryReader;
+using idealgas::TrajectoryWriter;
+using std::pair;
+using std::string;
+using std::vector;
+
+TEST_CASE("Test reading a trajectory") {
+  srand(8);
+  vector<pair<Species, int>> species_counts = {pair<Species, int>(Species("white", 1, 3), 100)};
+  GasContainer container = GasContainer(200, 200, 0, 0, species_counts);
+  string path = "test_trajectory_reader.traj";
+  {
+    TrajectoryWriter writer(path, TrajectoryWriter::kDefaultPositionStep, TrajectoryWriter::kDefaultVelocityStep, 8);
+    for (int frame = 0; frame < 30; frame++) {
+      container.AdvanceOneFrame();
+      writer.AddFrame(container.GetParticleStore());
+    }
+  }
+
+  //every frame read in order, to compare the random reads against
+  TrajectoryReader sequential(path);
+  vector<vector<float>> xs(30), vys(30);
+  vector<float> y, vx;
+  for (size_t frame = 0; frame < 30; frame++) {
+    sequential.ReadFrame(frame, xs.at(frame), y, vx, vys.at(frame));
+  }
+
+  SECTION("Frames can be read in any order") {
+    TrajectoryReader reader(path);
+    vector<float> x, vy;
+    size_t order[] = {29, 3, 17, 18, 16, 0, 24, 23, 8};
+    for (size_t frame : order) {
+      reader.ReadFrame(frame, x, y, vx, vy);
+      REQUIRE(x == xs.at(frame));
+      REQUIRE(vy == vys.at(frame));
+    }
+  }
+
+  SECTION("Frames past the end") {
+    TrajectoryReader reader(path);
+    vector<float> x, vy;
+    REQUIRE_THROWS_AS(reader.ReadFrame(30, x, y, vx, vy), std::invalid_argument);
+  }
+
+  SECTION("Files that aren't trajectories") {
+    string bad_path = "test_trajectory_reader_bad.traj";
+    {
+      std::ofstream file(bad_path.c_str(), std::ios::binary);
+      file << "not a trajectory, just some text";
+    }
+    REQUIRE_THROWS_AS(TrajectoryReader(bad_path), std::runtime_error);
+    std::remove(bad_path.c_str());
+    REQUIRE_THROWS_AS(TrajectoryReader(bad_path), std::runtime_error);
+  }
+
+  SECTION("Headers that claim more than the file holds") {
+    string bad_path = "test_trajectory_reader_bad.traj";
+    vector<char> bytes;
+    {
+      std::ifstream file(path.c_str(), std::ios::binary);
+      bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    uint64_t num_particles = uint64_t(1) << 62;
+    std::memcpy(bytes.data() + offsetof(idealgas::TrajectoryHeader, num_particles), &num_particles,
+                sizeof(num_particles));
+    {
+      std::ofstream file(bad_path.c_str(), std::ios::binary);
+      file.write(bytes.data(), std::streamsize(bytes.size()));
+    }
+    REQUIRE_THROWS_AS(TrajectoryReader(bad_path), std::runtime_error);
+    std::remove(bad_path.c_str());
+  }
+
+  std::remove(path.c_str());
+}
@@ -0,0 +1,97 @@
+#include <catch2/catch.hpp>
+
+#include <gas_container.h>
+#include <trajectory_reader.h>
+#include <trajectory_writer.h>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+using idealgas::GasContainer;
+using idealgas::ParticleStore;
+using idealgas::Species;
+using idealgas::TrajectoryReader;
+using idealgas::TrajectoryWriter;
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace {
+
+float GetMaxError(const vector<float>& expected, const vector<float>& actual) {
+  float max_error = 0;
+  for (size_t i = 0; i < expected.size(); i++) {
+    max_error = std::max(max_error, std::fabs(expected.at(i) - actual.at(i)));
+  }
+  return max_error;
+}
+
+}  // namespace
+
+TEST_CASE("Test writing a trajectory") {
+  srand(7);
+  vector<pair<Species, int>> species_counts = {pair<Species, int>(Species("white", 1, 3), 250),
+                                               pair<Species, int>(Species("red", 4, 5), 50)};
+  GasContainer container = GasContainer(300, 300, 0, 0, species_counts);
+  string path = "test_trajectory_writer.traj";
+  float position_step = 1.0f / 64;
+  float velocity_step = 1.0f / 512;
+
+  //a small queue, so the simulation has to wait for the writer now and then
+  vector<ParticleStore> frames;
+  {
+    TrajectoryWriter writer(path, position_step, velocity_step, 16, 2);
+    for (int frame = 0; frame < 70; frame++) {
+      container.AdvanceOneFrame();
+      frames.push_back(container.GetParticleStore());
+      writer.AddFrame(container.GetParticleStore());
+    }
+    writer.Close();
+  }
+
+  SECTION("Frames read back to within half a step") {
+    TrajectoryReader reader(path);
+    REQUIRE(reader.GetNumFrames() == 70);
+    REQUIRE(reader.GetNumParticles() == 300);
+    vector<float> x, y, vx, vy;
+    for (size_t frame = 0; frame < frames.size(); frame++) {
+      reader.ReadFrame(frame, x, y, vx, vy);
+      REQUIRE(GetMaxError(frames.at(frame).position[0], x) <= position_step / 2);
+      REQUIRE(GetMaxError(frames.at(frame).position[1], y) <= position_step / 2);
+      REQUIRE(GetMaxError(frames.at(frame).velocity[0], vx) <= velocity_step / 2);
+      REQUIRE(GetMaxError(frames.at(frame).velocity[1], vy) <= velocity_step / 2);
+    }
+  }
+
+  SECTION("Changes between frames take less room than raw floats") {
+    std::ifstream file(path.c_str(), std::ios::binary | std::ios::ate);
+    size_t raw_size = 70 * 300 * 4 * sizeof(float);
+    REQUIRE(size_t(file.tellg()) < raw_size / 2);
+  }
+
+  std::remove(path.c_str());
+}
+
+TEST_CASE("Test trajectory writer errors") {
+  string path = "test_trajectory_writer_errors.traj";
+
+  SECTION("Particle count changes") {
+    GasContainer two = GasContainer(100, 100, 0, 0, vector<idealgas::Particle>(2));
+    GasContainer one = GasContainer(100, 100, 0, 0, vector<idealgas::Particle>(1));
+    TrajectoryWriter writer(path);
+    writer.AddFrame(two.GetParticleStore());
+    REQUIRE_THROWS_AS(writer.AddFrame(one.GetParticleStore()), std::invalid_argument);
+  }
+
+  SECTION("Invalid settings") {
+    REQUIRE_THROWS_AS(TrajectoryWriter(path, 0), std::invalid_argument);
+    REQUIRE_THROWS_AS(TrajectoryWriter(path, 1, 1, 0), std::invalid_argument);
+    REQUIRE_THROWS_AS(TrajectoryWriter(path, 1, 1, 1, 0), std::invalid_argument);
+  }
+
+  SECTION("Unwritable path") {
+    REQUIRE_THROWS_AS(TrajectoryWriter("no_such_directory/out.traj"), std::runtime_error);
+  }
+
+  std::remove(path.c_str());
+}